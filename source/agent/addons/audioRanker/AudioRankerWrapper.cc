@@ -9,7 +9,7 @@ using namespace v8;
 
 Nan::Persistent<Function> AudioRanker::constructor;
 
-AudioRanker::AudioRanker() {}
+AudioRanker::AudioRanker() : me(nullptr) {}
 AudioRanker::~AudioRanker() {}
 
 NAN_MODULE_INIT(AudioRanker::Init) {
@@ -19,6 +19,7 @@ NAN_MODULE_INIT(AudioRanker::Init) {
   tpl->InstanceTemplate()->SetInternalFieldCount(1);
 
   // Prototype
+  SETUP_EVENTED_PROTOTYPE_METHODS(tpl);
   Nan::SetPrototypeMethod(tpl, "close", close);
   Nan::SetPrototypeMethod(tpl, "addOutput", addOutput);
   Nan::SetPrototypeMethod(tpl, "addInput", addInput);
@@ -29,20 +30,12 @@ NAN_MODULE_INIT(AudioRanker::Init) {
 }
 
 NAN_METHOD(AudioRanker::New) {
-  if (info.Length() < 1) {
-    Nan::ThrowError("Wrong number of arguments");
-  }
-
   if (info.IsConstructCall()) {
     AudioRanker* obj = new AudioRanker();
 
-    obj->asyncResource_ = new Nan::AsyncResource("RankChange");
-    obj->callback_ = new Nan::Callback(info[0].As<Function>());
-    uv_async_init(uv_default_loop(), &obj->async_, &AudioRanker::Callback);
-
-    if (info.Length() > 2) {
-        bool detectMute = Nan::To<bool>(info[1]).FromJust();
-        int changeInterval = Nan::To<int>(info[2]).FromJust();
+    if (info.Length() > 1) {
+        bool detectMute = Nan::To<bool>(info[0]).FromJust();
+        int changeInterval = Nan::To<int>(info[1]).FromJust();
         obj->me = new owt_base::AudioRanker(obj, detectMute, changeInterval);
     } else {
         obj->me = new owt_base::AudioRanker(obj);
@@ -56,20 +49,14 @@ NAN_METHOD(AudioRanker::New) {
 }
 
 NAN_METHOD(AudioRanker::close) {
-  AudioRanker* obj = Nan::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
-
-  if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(&obj->async_))) {
-    uv_close(reinterpret_cast<uv_handle_t*>(&obj->async_), NULL);
-  }
+  AudioRanker* obj = node::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
 
   delete obj->me;
   obj->me = nullptr;
-  delete obj->callback_;
-  delete obj->asyncResource_;
 }
 
 NAN_METHOD(AudioRanker::addOutput) {
-  AudioRanker* obj = Nan::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
+  AudioRanker* obj = node::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
   owt_base::AudioRanker* me = obj->me;
 
   FrameDestination* param = node::ObjectWrap::Unwrap<FrameDestination>(
@@ -80,7 +67,7 @@ NAN_METHOD(AudioRanker::addOutput) {
 }
 
 NAN_METHOD(AudioRanker::addInput) {
-  AudioRanker* obj = Nan::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
+  AudioRanker* obj = node::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
   owt_base::AudioRanker* me = obj->me;
 
   FrameSource* param = node::ObjectWrap::Unwrap<FrameSource>(
@@ -97,7 +84,7 @@ NAN_METHOD(AudioRanker::addInput) {
 }
 
 NAN_METHOD(AudioRanker::removeInput) {
-  AudioRanker* obj = Nan::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
+  AudioRanker* obj = node::ObjectWrap::Unwrap<AudioRanker>(info.Holder());
   owt_base::AudioRanker* me = obj->me;
 
   Nan::Utf8String streamIdPara(Nan::To<v8::String>(info[0]).ToLocalChecked());
@@ -107,7 +94,6 @@ NAN_METHOD(AudioRanker::removeInput) {
 }
 
 void AudioRanker::onRankChange(std::vector<std::pair<std::string, std::string>> updates) {
-  boost::mutex::scoped_lock lock(mutex);
   std::ostringstream jsonChange;
   /*
    * The JS callback json
@@ -118,7 +104,6 @@ void AudioRanker::onRankChange(std::vector<std::pair<std::string, std::string>>
    *    ["streamIDn", "ownerIDn"]
    * ]
    */
-  jsonChange.str("");
   jsonChange << "[";
   for (size_t i = 0; i < updates.size(); i++) {
     jsonChange << "[\"" << updates[i].first << "\",\""
@@ -128,22 +113,6 @@ void AudioRanker::onRankChange(std::vector<std::pair<std::string, std::string>>
     }
   }
   jsonChange << "]";
-  this->jsonChanges.push(jsonChange.str());
-  async_.data = this;
-  uv_async_send(&async_);
+  // Replaces a ranking that is not delivered yet
+  notifyCoalescedAsyncEvent("rankchange", "", jsonChange.str());
 }
-
-NAUV_WORK_CB(AudioRanker::Callback) {
-  Nan::HandleScope scope;
-  AudioRanker* obj = reinterpret_cast<AudioRanker*>(async->data);
-  if (!obj || obj->me == NULL)
-    return;
-  boost::mutex::scoped_lock lock(obj->mutex);
-  while (!obj->jsonChanges.empty()) {
-    Local<Value> args[] = {Nan::New(obj->jsonChanges.front().c_str()).ToLocalChecked()};
-    obj->asyncResource_->runInAsyncScope(
-      Nan::GetCurrentContext()->Global(), obj->callback_->GetFunction(), 1, args);
-    obj->jsonChanges.pop();
-  }
-}
-
@@ -6,21 +6,21 @@
 #define AUDIORANKERWRAPPER_H
 
 #include <AudioRanker.h>
+#include <NodeEventRegistry.h>
 #include <nan.h>
 
 
 /*
  * Wrapper class of owt_base::AudioRanker
+ *
+ * Emits "rankchange" with the whole ranking, so only the latest one is delivered.
  */
-class AudioRanker : public Nan::ObjectWrap,
+class AudioRanker : public NodeEventedObjectWrap,
                     public owt_base::AudioRanker::Visitor {
 public:
     static NAN_MODULE_INIT(Init);
     owt_base::AudioRanker* me;
 
-    boost::mutex mutex;
-    std::queue<std::string> jsonChanges;
-
     void onRankChange(
         std::vector<std::pair<std::string, std::string>> updates) override;
 
@@ -28,10 +28,6 @@ private:
     AudioRanker();
     ~AudioRanker();
 
-    Nan::Callback *callback_;
-    uv_async_t async_;
-    Nan::AsyncResource *asyncResource_;
-
     static Nan::Persistent<v8::Function> constructor;
 
     static NAN_METHOD(New);
@@ -43,9 +39,6 @@ private:
     static NAN_METHOD(addInput);
 
     static NAN_METHOD(removeInput);
-
-    static NAUV_WORK_CB(Callback);
-
 };
 
 #endif
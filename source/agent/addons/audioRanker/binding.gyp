@@ -4,6 +4,7 @@
     'sources': [
       'addon.cc',
       'AudioRankerWrapper.cc',
+      '../common/NodeEventRegistry.cc',
       '../../../core/owt_base/selector/AudioRanker.cpp',
       '../../../core/owt_base/MediaFramePipeline.cpp',
       '../../../core/common/IOService.cpp',
@@ -28,6 +28,7 @@ void AVStreamOutWrap::Init(Local<Object> exports)
     // Prototype
     NODE_SET_PROTOTYPE_METHOD(tpl, "close", close);
     NODE_SET_PROTOTYPE_METHOD(tpl, "addEventListener", addEventListener);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "getStats", getStats);
 
     constructor.Reset(isolate, Nan::GetFunction(tpl).ToLocalChecked());
     Nan::Set(exports, Nan::New("AVStreamOut").ToLocalChecked(),
@@ -44,6 +45,7 @@ void AVStreamOutWrap::Init(Local<Object> exports, Local<Object> module)
     // Prototype
     NODE_SET_PROTOTYPE_METHOD(tpl, "close", close);
     NODE_SET_PROTOTYPE_METHOD(tpl, "addEventListener", addEventListener);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "getStats", getStats);
 
     constructor.Reset(isolate, Nan::GetFunction(tpl).ToLocalChecked());
     Nan::Set(module, Nan::New("exports").ToLocalChecked(),
@@ -69,6 +71,10 @@ void AVStreamOutWrap::New(const v8::FunctionCallbackInfo<v8::Value>& args)
     //     video_resolution: (required when require_video === true, string),
     //     url: (required, string),
     //     interval: (required, only for 'file')
+    //     queue: (optional) {
+    //       size: (number of frames, 0 for unbounded)
+    //       dropPolicy: ('non-reference', 'until-keyframe', 'disconnect')
+    //     }
     //     connection: {
     //       protocol: ('rtmp', 'rtsp', 'hls', 'dash')
     //       url: (string)
@@ -149,6 +155,23 @@ void AVStreamOutWrap::New(const v8::FunctionCallbackInfo<v8::Value>& args)
     }
     obj->dest = obj->me;
 
+    Local<Value> queue = Nan::Get(options, Nan::New("queue").ToLocalChecked()).ToLocalChecked();
+    if (queue->IsObject()) {
+        Local<Object> queueOptions = Nan::To<v8::Object>(queue).ToLocalChecked();
+        uint32_t size = Nan::To<uint32_t>(
+            Nan::Get(queueOptions, Nan::New("size").ToLocalChecked()).ToLocalChecked()).FromMaybe(0);
+        std::string dropPolicy = getString(
+            Nan::Get(queueOptions, Nan::New("dropPolicy").ToLocalChecked()).ToLocalChecked());
+
+        owt_base::MediaFrameQueue::DropPolicy policy = owt_base::MediaFrameQueue::DROP_UNTIL_KEYFRAME;
+        if (dropPolicy.compare("non-reference") == 0) {
+            policy = owt_base::MediaFrameQueue::DROP_NON_REFERENCE;
+        } else if (dropPolicy.compare("disconnect") == 0) {
+            policy = owt_base::MediaFrameQueue::DROP_DISCONNECT;
+        }
+        obj->me->setQueueOptions(size, policy);
+    }
+
     if (args.Length() > 1 && args[1]->IsFunction()) {
         Nan::Set(Local<Object>::New(isolate, obj->m_store),
                  Nan::New("init").ToLocalChecked(), args[1]);
@@ -184,3 +207,25 @@ void AVStreamOutWrap::addEventListener(const FunctionCallbackInfo<Value>& args)
     Nan::Set(Local<Object>::New(isolate, obj->m_store),
              args[0], args[1]);
 }
+
+void AVStreamOutWrap::getStats(const FunctionCallbackInfo<Value>& args)
+{
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+    AVStreamOutWrap* obj = ObjectWrap::Unwrap<AVStreamOutWrap>(args.Holder());
+    if (!obj->me)
+        return;
+
+    owt_base::AVStreamOutStats stats;
+    obj->me->getStats(stats);
+
+    Local<Object> result = Nan::New<Object>();
+    Nan::Set(result, Nan::New("queueDepth").ToLocalChecked(), Nan::New(stats.queueDepth));
+    Nan::Set(result, Nan::New("avgLatencyMs").ToLocalChecked(), Nan::New(stats.avgLatencyMs));
+    Nan::Set(result, Nan::New("maxLatencyMs").ToLocalChecked(), Nan::New(stats.maxLatencyMs));
+    Nan::Set(result, Nan::New("writtenFrames").ToLocalChecked(),
+             Nan::New(static_cast<double>(stats.writtenFrames)));
+    Nan::Set(result, Nan::New("droppedFrames").ToLocalChecked(),
+             Nan::New(static_cast<double>(stats.droppedFrames)));
+    args.GetReturnValue().Set(result);
+}
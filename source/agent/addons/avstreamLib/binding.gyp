@@ -11,6 +11,7 @@
       '../../../core/owt_base/MediaFileOut.cpp',
       '../../../core/owt_base/LiveStreamOut.cpp',
       '../../../core/owt_base/LiveStreamIn.cpp',
+      '../../../core/owt_base/NalScanner.cpp',
     ],
     'include_dirs': [ "<!(node -e \"require('nan')\")",
                       '$(CORE_HOME)/common',
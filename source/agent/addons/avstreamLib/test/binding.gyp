@@ -0,0 +1,63 @@
+{
+  'targets': [{
+    'target_name': 'nalScannerTest',
+    'type': 'executable',
+    'sources': [
+      '../../../../core/owt_base/NalScannerTest.cpp',
+      '../../../../core/owt_base/NalScanner.cpp',
+    ],
+    'include_dirs': [
+        '../../../../core/owt_base/',
+    ],
+    'libraries': [
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions'],
+        'cflags_cc!' : ['-fno-rtti']
+      }],
+    ]
+  }, {
+    'target_name': 'bitstreamInspectorTest',
+    'type': 'executable',
+    'sources': [
+      '../../../../core/owt_base/BitstreamInspectorTest.cpp',
+      '../../../../core/owt_base/BitstreamInspector.cpp',
+      '../../../../core/owt_base/NalScanner.cpp',
+      '../../../../core/owt_base/MediaFramePipeline.cpp',
+    ],
+    'include_dirs': [
+        '../../../../core/owt_base/',
+        '../../../../core/common/',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions'],
+        'cflags_cc!' : ['-fno-rtti']
+      }],
+    ]
+  }]
+}
@@ -3,7 +3,6 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "NodeEventRegistry.h"
-#include <list>
 #include <nan.h>
 
 using namespace v8;
@@ -21,6 +20,8 @@ NodeEventRegistry* NodeEventRegistry::New(const Local<Function>& f)
 NodeEventRegistry::NodeEventRegistry()
     : m_store{ Isolate::GetCurrent(), Object::New(Isolate::GetCurrent()) }
     , m_uvHandle{ reinterpret_cast<uv_async_t*>(malloc(sizeof(uv_async_t))) }
+    , m_wakeupPending{ false }
+    , m_stats()
 {
     if (m_uvHandle) {
         m_uvHandle->data = this;
@@ -32,6 +33,8 @@ NodeEventRegistry::NodeEventRegistry()
 NodeEventRegistry::NodeEventRegistry(Isolate* isolate, const Local<Function>& f)
     : m_store{ Isolate::GetCurrent(), f }
     , m_uvHandle{ reinterpret_cast<uv_async_t*>(malloc(sizeof(uv_async_t))) }
+    , m_wakeupPending{ false }
+    , m_stats()
 {
     if (m_uvHandle) {
         m_uvHandle->data = this;
@@ -44,6 +47,7 @@ NodeEventRegistry::~NodeEventRegistry()
 {
     std::lock_guard<std::mutex> lock(m_lock);
     m_store.Reset();
+    m_batchListener.Reset();
     if (m_uvHandle && !uv_is_closing(reinterpret_cast<uv_handle_t*>(m_uvHandle)))
         uv_close(reinterpret_cast<uv_handle_t*>(m_uvHandle), closeCallback);
     if (m_uvHandle)
@@ -87,38 +91,87 @@ void NodeEventRegistry::process(const Data& data)
     }
 }
 
+void NodeEventRegistry::processBatch(const std::deque<Data>& datas)
+{
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+    auto listener = Local<Function>::New(isolate, m_batchListener);
+    if (listener.IsEmpty())
+        return;
+
+    Local<v8::Array> events = Nan::New<v8::Array>(static_cast<int>(datas.size()));
+    uint32_t index = 0;
+    for (const Data& data : datas) {
+        Local<v8::Array> event = Nan::New<v8::Array>(2);
+        Nan::Set(event, 0u, Nan::New(data.event.c_str()).ToLocalChecked());
+        Nan::Set(event, 1u, Nan::New(data.message.c_str()).ToLocalChecked());
+        Nan::Set(events, index++, event);
+    }
+
+    const unsigned argc = 1;
+    Local<Value> argv[argc] = { events };
+    TryCatch try_catch(isolate);
+    Nan::Call(listener, isolate->GetCurrentContext()->Global(), argc, argv);
+    if (try_catch.HasCaught()) {
+        node::FatalException(isolate, try_catch);
+    }
+}
+
 void NodeEventRegistry::process()
 {
-    std::list<Data> datas;
+    std::deque<Data> datas;
     {
         std::lock_guard<std::mutex> lock(m_lock);
-        while (true) {
-            Data data;
-            {
-                if (!m_buffer.empty()) {
-                    data = m_buffer.front();
-                    m_buffer.pop_front();
-                } else {
-                    break;
-                }
-            }
-            datas.push_back(data);
+        datas.swap(m_buffer);
+        m_coalesced.clear();
+        m_wakeupPending = false;
+        m_stats.queuedEvents = 0;
+        m_stats.wakeups++;
+        m_stats.deliveredEvents += datas.size();
+        Clock::time_point now = Clock::now();
+        for (const Data& data : datas) {
+            uint32_t latency = std::chrono::duration_cast<std::chrono::microseconds>(now - data.time).count();
+            m_stats.latencySumUs += latency;
+            if (latency > m_stats.latencyMaxUs)
+                m_stats.latencyMaxUs = latency;
         }
     }
-    for (std::list<Data>::iterator it = datas.begin(); it != datas.end(); ++it) {
+    if (datas.empty())
+        return;
+
+    // One call into JS per wakeup
+    if (!m_batchListener.IsEmpty()) {
+        processBatch(datas);
+        return;
+    }
+    for (std::deque<Data>::iterator it = datas.begin(); it != datas.end(); ++it) {
         process(*it);
     }
 }
 
+bool NodeEventRegistry::onQueued()
+{
+    m_stats.queuedEvents = m_buffer.size();
+    if (m_stats.queuedEvents > m_stats.maxQueuedEvents)
+        m_stats.maxQueuedEvents = m_stats.queuedEvents;
+    if (m_wakeupPending)
+        return false;
+    m_wakeupPending = true;
+    return true;
+}
+
 // other thread
 bool NodeEventRegistry::notifyAsyncEvent(const std::string& event, const std::string& data)
 {
     if (m_uvHandle && uv_is_active(reinterpret_cast<uv_handle_t*>(m_uvHandle))) {
+        bool wakeup;
         {
             std::lock_guard<std::mutex> lock(m_lock);
-            m_buffer.push_back(Data{ event, data });
+            m_buffer.push_back(Data{ event, data, Clock::now() });
+            wakeup = onQueued();
         }
-        uv_async_send(m_uvHandle);
+        if (wakeup)
+            uv_async_send(m_uvHandle);
         return true;
     }
     return false;
@@ -128,16 +181,73 @@ bool NodeEventRegistry::notifyAsyncEvent(const std::string& event, const std::st
 bool NodeEventRegistry::notifyAsyncEventInEmergency(const std::string& event, const std::string& data)
 {
     if (m_uvHandle && uv_is_active(reinterpret_cast<uv_handle_t*>(m_uvHandle))) {
+        bool wakeup;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_buffer.push_front(Data{ event, data, Clock::now() });
+            wakeup = onQueued();
+        }
+        if (wakeup)
+            uv_async_send(m_uvHandle);
+        return true;
+    }
+    return false;
+}
+
+// other thread
+bool NodeEventRegistry::notifyCoalescedAsyncEvent(const std::string& event, const std::string& key, const std::string& data)
+{
+    if (m_uvHandle && uv_is_active(reinterpret_cast<uv_handle_t*>(m_uvHandle))) {
+        bool wakeup;
         {
             std::lock_guard<std::mutex> lock(m_lock);
-            m_buffer.push_front(Data{ event, data });
+            std::string id = event + '\0' + key;
+            auto it = m_coalesced.find(id);
+            if (it != m_coalesced.end()) {
+                // Keeps its place in the queue, the loop is already woken up for it
+                it->second->message = data;
+                m_stats.coalescedEvents++;
+                return true;
+            }
+            m_buffer.push_back(Data{ event, data, Clock::now() });
+            m_coalesced[id] = &m_buffer.back();
+            wakeup = onQueued();
         }
-        uv_async_send(m_uvHandle);
+        if (wakeup)
+            uv_async_send(m_uvHandle);
         return true;
     }
     return false;
 }
 
+void NodeEventRegistry::setBatchListener(Isolate* isolate, const Local<Function>& f)
+{
+    m_batchListener.Reset(isolate, f);
+}
+
+NodeEventRegistry::Stats NodeEventRegistry::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    Stats stats = m_stats;
+    m_stats.maxQueuedEvents = m_stats.queuedEvents;
+    m_stats.latencyMaxUs = 0;
+    return stats;
+}
+
+Local<Object> NodeEventRegistry::statsObject(const Stats& stats)
+{
+    Local<Object> result = Nan::New<Object>();
+    Nan::Set(result, Nan::New("queuedEvents").ToLocalChecked(), Nan::New<v8::Number>((double)stats.queuedEvents));
+    Nan::Set(result, Nan::New("maxQueuedEvents").ToLocalChecked(), Nan::New<v8::Number>((double)stats.maxQueuedEvents));
+    Nan::Set(result, Nan::New("deliveredEvents").ToLocalChecked(), Nan::New<v8::Number>((double)stats.deliveredEvents));
+    Nan::Set(result, Nan::New("coalescedEvents").ToLocalChecked(), Nan::New<v8::Number>((double)stats.coalescedEvents));
+    Nan::Set(result, Nan::New("wakeups").ToLocalChecked(), Nan::New<v8::Number>((double)stats.wakeups));
+    Nan::Set(result, Nan::New("avgLatencyUs").ToLocalChecked(),
+        Nan::New<v8::Number>(stats.deliveredEvents ? (double)stats.latencySumUs / stats.deliveredEvents : 0));
+    Nan::Set(result, Nan::New("maxLatencyUs").ToLocalChecked(), Nan::New<v8::Number>((double)stats.latencyMaxUs));
+    return result;
+}
+
 void NodeEventRegistry::closeCallback(uv_handle_t* handle)
 {
     free(handle);
@@ -174,3 +284,24 @@ void NodeEventedObjectWrap::addEventListener(const FunctionCallbackInfo<Value>&
     NodeEventedObjectWrap* n = ObjectWrap::Unwrap<NodeEventedObjectWrap>(args.Holder());
     Nan::Set(Local<Object>::New(isolate, n->m_store), args[0], args[1]);
 }
+
+void NodeEventedObjectWrap::setBatchListener(const FunctionCallbackInfo<Value>& args)
+{
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+    if (args.Length() < 1 || !args[0]->IsFunction()) {
+        isolate->ThrowException(Exception::TypeError(
+            Nan::New("Wrong arguments").ToLocalChecked()));
+        return;
+    }
+    NodeEventedObjectWrap* n = ObjectWrap::Unwrap<NodeEventedObjectWrap>(args.Holder());
+    n->NodeEventRegistry::setBatchListener(isolate, Local<Function>::Cast(args[0]));
+}
+
+void NodeEventedObjectWrap::getEventStats(const FunctionCallbackInfo<Value>& args)
+{
+    Isolate* isolate = Isolate::GetCurrent();
+    HandleScope scope(isolate);
+    NodeEventedObjectWrap* n = ObjectWrap::Unwrap<NodeEventedObjectWrap>(args.Holder());
+    args.GetReturnValue().Set(statsObject(n->getStats()));
+}
@@ -6,12 +6,14 @@
 #define NODEEVENTREGISTRY_H
 
 #include <EventRegistry.h>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <node.h>
 #include <node_object_wrap.h>
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <uv.h>
 
 // Implement ::EventRegistry interface
@@ -23,22 +25,51 @@ public:
     virtual ~NodeEventRegistry();
     bool notifyAsyncEvent(const std::string& event, const std::string& data);
     bool notifyAsyncEventInEmergency(const std::string& event, const std::string& data);
+    bool notifyCoalescedAsyncEvent(const std::string& event, const std::string& key, const std::string& data) override;
+
+    // Delivers all events of a wakeup in one call, as an array of [event, data], instead of one call per event.
+    void setBatchListener(v8::Isolate*, const v8::Local<v8::Function>&);
+
+    struct Stats {
+        uint32_t queuedEvents;
+        uint32_t maxQueuedEvents;   // Since the last getStats
+        uint64_t deliveredEvents;
+        uint64_t coalescedEvents;   // Replaced by a later one before delivery
+        uint64_t wakeups;
+        uint64_t latencySumUs;      // From notification to delivery
+        uint32_t latencyMaxUs;      // Since the last getStats
+    };
+    Stats getStats();
+    // Converts the stats for wrappers exposing them to JS
+    static v8::Local<v8::Object> statsObject(const Stats&);
 
 protected:
     explicit NodeEventRegistry();
     explicit NodeEventRegistry(v8::Isolate*, const v8::Local<v8::Function>&);
 
+    typedef std::chrono::steady_clock Clock;
+
     struct Data {
         std::string event, message;
+        Clock::time_point time;
     };
     v8::Persistent<v8::Object> m_store;
+    v8::Persistent<v8::Function> m_batchListener;
 
 private:
     uv_async_t* m_uvHandle;
     std::mutex m_lock;
     std::deque<Data> m_buffer;
+    // Queued coalesced events by event and key. Pushing at either end of a deque keeps references valid.
+    std::unordered_map<std::string, Data*> m_coalesced;
+    // An uv_async_send is in flight, later notifications ride on it
+    bool m_wakeupPending;
+    Stats m_stats;
+    // Called with m_lock held after queuing, returns whether to wake the loop up
+    bool onQueued();
     void process();
     void process(const Data& data);
+    void processBatch(const std::deque<Data>& datas);
     static void closeCallback(uv_handle_t*);
     static void callback(uv_async_t*);
 };
@@ -48,12 +79,16 @@ public:
     inline static void SETUP_EVENTED_PROTOTYPE_METHODS(v8::Local<v8::FunctionTemplate> tmpl)
     {
         NODE_SET_PROTOTYPE_METHOD(tmpl, "addEventListener", addEventListener);
+        NODE_SET_PROTOTYPE_METHOD(tmpl, "setBatchListener", setBatchListener);
+        NODE_SET_PROTOTYPE_METHOD(tmpl, "getEventStats", getEventStats);
     }
 
 protected:
     explicit NodeEventedObjectWrap();
     virtual ~NodeEventedObjectWrap();
     static void addEventListener(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void setBatchListener(const v8::FunctionCallbackInfo<v8::Value>& args);
+    static void getEventStats(const v8::FunctionCallbackInfo<v8::Value>& args);
 };
 
 #endif
@@ -6,6 +6,8 @@
 
 #include "QuicTransportStream.h"
 #include "../common/MediaFramePipelineWrapper.h"
+#include "BitstreamInspector.h"
+#include <chrono>
 
 using v8::Function;
 using v8::FunctionTemplate;
@@ -19,7 +21,12 @@ DEFINE_LOGGER(QuicTransportStream, "QuicTransportStream");
 Nan::Persistent<v8::Function> QuicTransportStream::s_constructor;
 
 const int uuidSizeInBytes = 16;
+// | size(4) | [capture timestamp(4)] | body |, both big endian. The highest bit of size indicates the capture timestamp
+// follows, in RTP clock rate of the track (90kHz for video, 48kHz for audio). Senders without capture timestamps must
+// keep that bit zero, as the reserved bits of the size header always were, see doc/design/quic-agent.md.
 const int frameHeaderSize = 4;
+const int frameHeaderMaxSize = 8;
+const uint32_t frameHeaderTimeStampFlag = 0x80000000;
 
 QuicTransportStream::QuicTransportStream()
     : QuicTransportStream(nullptr)
@@ -40,10 +47,14 @@ QuicTransportStream::QuicTransportStream(owt::quic::WebTransportStreamInterface*
     , m_frameFormat(owt_base::FRAME_FORMAT_UNKNOWN)
     , m_readingFrameSize(false)
     , m_frameSizeOffset(0)
-    , m_frameSizeArray(new uint8_t[frameHeaderSize])
+    , m_frameSizeArray(new uint8_t[frameHeaderMaxSize])
     , m_currentFrameSize(0)
     , m_receivedFrameOffset(0)
+    , m_hasCaptureTimeStamp(false)
+    , m_captureTimeStamp(0)
     , m_audioTimeStamp(0)
+    , m_videoWidth(0)
+    , m_videoHeight(0)
 {
 }
 
@@ -126,6 +137,7 @@ NAN_MODULE_INIT(QuicTransportStream::init)
     Nan::SetPrototypeMethod(tpl, "readTrackId", readTrackId);
     Nan::SetPrototypeMethod(tpl, "addDestination", addDestination);
     Nan::SetAccessor(instanceTpl, Nan::New("trackKind").ToLocalChecked(), trackKindGetter, trackKindSetter);
+    Nan::SetAccessor(instanceTpl, Nan::New("codec").ToLocalChecked(), codecGetter, codecSetter);
     Nan::SetAccessor(instanceTpl, Nan::New("ondata").ToLocalChecked(), onDataGetter, onDataSetter);
 
     s_constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
@@ -228,6 +240,19 @@ NAN_SETTER(QuicTransportStream::trackKindSetter)
     obj->m_trackKind = std::string(*trackKind);
 }
 
+NAN_GETTER(QuicTransportStream::codecGetter)
+{
+    QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    info.GetReturnValue().Set(Nan::New(owt_base::getFormatStr(obj->m_frameFormat)).ToLocalChecked());
+}
+
+NAN_SETTER(QuicTransportStream::codecSetter)
+{
+    QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    Nan::Utf8String codec(Nan::To<v8::String>(value).ToLocalChecked());
+    obj->m_frameFormat = owt_base::getFormat(std::string(*codec));
+}
+
 NAN_GETTER(QuicTransportStream::onDataGetter)
 {
     QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
@@ -381,19 +406,32 @@ void QuicTransportStream::SignalOnData()
             // A new frame.
             if (m_currentFrameSize == 0 && m_receivedFrameOffset == 0 && !m_readingFrameSize) {
                 m_readingFrameSize = true;
-                memset(m_frameSizeArray, 0, frameHeaderSize * sizeof(uint8_t));
+                memset(m_frameSizeArray, 0, frameHeaderMaxSize * sizeof(uint8_t));
                 m_frameSizeOffset = 0;
             }
             // Read frame header.
             if (m_readingFrameSize) {
-                size_t readSize = std::min(frameHeaderSize - m_frameSizeOffset, m_stream->ReadableBytes());
+                size_t headerSize = frameHeaderSize;
+                if (m_frameSizeOffset >= frameHeaderSize && (m_frameSizeArray[0] & 0x80)) {
+                    headerSize = frameHeaderMaxSize;
+                }
+                size_t readSize = std::min(headerSize - m_frameSizeOffset, m_stream->ReadableBytes());
                 m_stream->Read(m_frameSizeArray + m_frameSizeOffset, readSize);
                 m_frameSizeOffset += readSize;
-                if (m_frameSizeOffset == frameHeaderSize) {
-                    // Usually only the last 2 bytes are used. The first two bits could be used for indicating frame size.
+                if (m_frameSizeOffset == frameHeaderSize && (m_frameSizeArray[0] & 0x80)) {
+                    // Capture timestamp follows.
+                    continue;
+                }
+                if (m_frameSizeOffset == headerSize) {
+                    uint32_t size = 0;
                     for (int i = 0; i < frameHeaderSize; i++) {
-                        m_currentFrameSize <<= 8;
-                        m_currentFrameSize += m_frameSizeArray[i];
+                        size = (size << 8) | m_frameSizeArray[i];
+                    }
+                    m_hasCaptureTimeStamp = size & frameHeaderTimeStampFlag;
+                    m_currentFrameSize = size & ~frameHeaderTimeStampFlag;
+                    m_captureTimeStamp = 0;
+                    for (int i = frameHeaderSize; i < frameHeaderMaxSize && m_hasCaptureTimeStamp; i++) {
+                        m_captureTimeStamp = (m_captureTimeStamp << 8) | m_frameSizeArray[i];
                     }
                     if (m_currentFrameSize > m_bufferSize) {
                         ReallocateBuffer(m_currentFrameSize);
@@ -412,25 +450,18 @@ void QuicTransportStream::SignalOnData()
             // Complete frame.
             if (m_receivedFrameOffset == m_currentFrameSize) {
                 owt_base::Frame frame;
+                memset(&frame, 0, sizeof(frame));
+                frame.length = m_currentFrameSize;
+                frame.payload = m_buffer;
                 if (m_trackKind == "audio") {
-                    frame.format = owt_base::FRAME_FORMAT_OPUS;
-                    frame.timeStamp = m_audioTimeStamp;
-                    // TODO: Fill a correct timestamp and check overflow.
-                    m_audioTimeStamp += 10 * 1000;
-                    // TODO: Get format from signaling message.
-                    frame.additionalInfo.audio.isRtpPacket = false;
-                    frame.additionalInfo.audio.sampleRate = 48000;
-                    frame.additionalInfo.audio.channels = 2;
+                    FillAudioFrame(frame);
+                    deliverFrame(frame);
                 } else if (m_trackKind == "video") {
-                    frame.format = owt_base::FRAME_FORMAT_H264;
-                    // Transport layer doesn't know a frame's type. Video agent is able to parse the type of a frame from bistream. However, video agent doesn't feed the frame to decoder when a key frame is requested.
-                    frame.additionalInfo.video.isKeyFrame = "key";
+                    FillVideoFrame(frame);
+                    deliverFrame(frame);
                 } else {
                     ELOG_ERROR("Unexpected track kind: %s.", m_trackKind.c_str());
                 }
-                frame.length = m_currentFrameSize;
-                frame.payload = m_buffer;
-                deliverFrame(frame);
                 m_currentFrameSize = 0;
                 m_receivedFrameOffset = 0;
             }
@@ -448,6 +479,57 @@ void QuicTransportStream::SignalOnData()
     }
 }
 
+void QuicTransportStream::FillAudioFrame(owt_base::Frame& frame)
+{
+    // TODO: Get format from signaling message.
+    frame.format = owt_base::FRAME_FORMAT_OPUS;
+    frame.additionalInfo.audio.isRtpPacket = false;
+    frame.additionalInfo.audio.sampleRate = 48000;
+    frame.additionalInfo.audio.channels = 2;
+
+    uint32_t samples = owt_base::BitstreamInspector::opusSamples(frame.payload, frame.length);
+    if (samples == 0) {
+        // Keep the timeline moving on a broken packet, assume 20ms.
+        samples = 960;
+    }
+    if (m_hasCaptureTimeStamp) {
+        m_audioTimeStamp = m_captureTimeStamp;
+    }
+    frame.timeStamp = m_audioTimeStamp;
+    frame.additionalInfo.audio.nbSamples = samples;
+    m_audioTimeStamp += samples;
+}
+
+void QuicTransportStream::FillVideoFrame(owt_base::Frame& frame)
+{
+    frame.format = m_frameFormat == owt_base::FRAME_FORMAT_UNKNOWN ? owt_base::FRAME_FORMAT_H264 : m_frameFormat;
+    if (m_hasCaptureTimeStamp) {
+        frame.timeStamp = m_captureTimeStamp;
+    } else {
+        // Receiving time in 90kHz.
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        frame.timeStamp = std::chrono::duration_cast<std::chrono::microseconds>(now).count() * 90 / 1000;
+    }
+
+    // Downstream nodes skip delta frames after a key frame request and recorders start files at key frames, so only
+    // real random access points are marked. Frames the inspector doesn't understand stay marked as key frames.
+    owt_base::BitstreamInfo info;
+    if (!owt_base::BitstreamInspector::inspectVideo(frame.format, frame.payload, frame.length, info)) {
+        ELOG_DEBUG("Failed to inspect a %s frame of %u bytes.", owt_base::getFormatStr(frame.format), frame.length);
+        info.isKeyFrame = true;
+        info.width = 0;
+        info.height = 0;
+    }
+    if (info.width && info.height && (info.width != m_videoWidth || info.height != m_videoHeight)) {
+        ELOG_DEBUG("Video resolution %ux%u.", info.width, info.height);
+        m_videoWidth = info.width;
+        m_videoHeight = info.height;
+    }
+    frame.additionalInfo.video.isKeyFrame = info.isKeyFrame;
+    frame.additionalInfo.video.width = m_videoWidth;
+    frame.additionalInfo.video.height = m_videoHeight;
+}
+
 void QuicTransportStream::ReallocateBuffer(size_t size)
 {
     if (size > m_bufferSize) {
@@ -42,6 +42,9 @@ public:
 
     static NAN_GETTER(trackKindGetter);
     static NAN_SETTER(trackKindSetter);
+    // Codec of a media track, e.g. 'h264', 'vp9', 'opus'. Video defaults to H.264.
+    static NAN_GETTER(codecGetter);
+    static NAN_SETTER(codecSetter);
     static NAN_GETTER(onDataGetter);
     static NAN_SETTER(onDataSetter);
 
@@ -79,6 +82,9 @@ private:
     void ReadContentSessionId();
     void ReadTrackId();
     void SignalOnData();
+    // Fills format, timestamp and media info of a complete frame in m_buffer.
+    void FillAudioFrame(owt_base::Frame& frame);
+    void FillVideoFrame(owt_base::Frame& frame);
     void ReallocateBuffer(size_t size);
     // Check whether there is readable data. If so, fire ondata event.
     void CheckReadableData();
@@ -108,8 +114,14 @@ private:
     uint8_t* m_frameSizeArray;
     size_t m_currentFrameSize;
     size_t m_receivedFrameOffset;
-    // TODO: Using wall clock timestamps seems not working. Using an increasing sequence instead. Fix it later.
+    // Capture timestamp of the current frame, if its header carries one.
+    bool m_hasCaptureTimeStamp;
+    uint32_t m_captureTimeStamp;
+    // Audio timestamps in 48kHz samples, advanced by the Opus packet duration when the sender doesn't provide them.
     uint32_t m_audioTimeStamp;
+    // Last resolution seen in the video bitstream, delta frames don't carry it.
+    uint16_t m_videoWidth;
+    uint16_t m_videoHeight;
 
     uv_async_t m_asyncOnContentSessionId;
     uv_async_t m_asyncOnTrackId;
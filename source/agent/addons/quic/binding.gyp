@@ -17,6 +17,8 @@
       '../../../core/owt_base/MediaFramePipeline.cpp',
       '../../../core/owt_base/MediaFrameMulticaster.cpp',
       '../../../core/owt_base/Utils.cc',
+      '../../../core/owt_base/NalScanner.cpp',
+      '../../../core/owt_base/BitstreamInspector.cpp',
     ],
     'defines':[
       'OWT_ENABLE_QUIC=1',
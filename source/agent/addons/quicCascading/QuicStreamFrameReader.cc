@@ -0,0 +1,120 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "QuicStreamFrameReader.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+
+// Larger than any encoded frame, a length beyond it means a broken stream
+static const uint32_t kMaxMessageLength = 64 * 1024 * 1024;
+
+DEFINE_LOGGER(QuicStreamFrameReader, "QuicStreamFrameReader");
+
+static inline uint32_t readLength(const char* buf)
+{
+    uint32_t length;
+    memcpy(&length, buf, sizeof(length));
+    return ntohl(length);
+}
+
+QuicStreamFrameReader::QuicStreamFrameReader(QuicStreamFrameListener* listener, size_t initialBufferSize)
+    : m_listener(listener)
+    , m_buffer(new char[initialBufferSize])
+    , m_capacity(initialBufferSize)
+    , m_pending(0)
+    , m_failed(false)
+{
+}
+
+bool QuicStreamFrameReader::checkLength(uint32_t length)
+{
+    if (length == 0 || length > kMaxMessageLength) {
+        ELOG_ERROR("Invalid message length %u, drop the rest of the stream", length);
+        m_failed = true;
+        m_pending = 0;
+        return false;
+    }
+    return true;
+}
+
+void QuicStreamFrameReader::reserve(size_t size)
+{
+    if (size <= m_capacity)
+        return;
+
+    size_t capacity = m_capacity * 2 > size ? m_capacity * 2 : size;
+    std::unique_ptr<char[]> buffer(new char[capacity]);
+    memcpy(buffer.get(), m_buffer.get(), m_pending);
+    m_buffer.swap(buffer);
+    m_capacity = capacity;
+    ELOG_DEBUG("Reassembly buffer grows to %zu", m_capacity);
+}
+
+size_t QuicStreamFrameReader::missingBytes() const
+{
+    if (m_pending < 4)
+        return 4 - m_pending;
+    return 4 + readLength(m_buffer.get()) - m_pending;
+}
+
+bool QuicStreamFrameReader::feed(const char* buf, size_t len)
+{
+    if (m_failed)
+        return false;
+
+    while (len > 0) {
+        if (m_pending) {
+            // Complete the message split by the previous chunk
+            bool hadLength = m_pending >= 4;
+            size_t take = missingBytes();
+            if (take > len)
+                take = len;
+            memcpy(m_buffer.get() + m_pending, buf, take);
+            m_pending += take;
+            buf += take;
+            len -= take;
+
+            if (m_pending < 4)
+                break;
+
+            uint32_t length = readLength(m_buffer.get());
+            if (!hadLength) {
+                if (!checkLength(length))
+                    return false;
+                reserve(4 + length);
+                continue;
+            }
+
+            if (m_pending == 4 + length) {
+                m_pending = 0;
+                m_listener->onStreamMessage(m_buffer[4], m_buffer.get() + 5, length - 1);
+            }
+            continue;
+        }
+
+        // Hand out the messages complete in this chunk without copying
+        while (len >= 4) {
+            uint32_t length = readLength(buf);
+            if (!checkLength(length))
+                return false;
+            if (4 + (size_t)length > len)
+                break;
+
+            m_listener->onStreamMessage(buf[4], buf + 5, length - 1);
+            buf += 4 + length;
+            len -= 4 + length;
+        }
+
+        if (len > 0) {
+            if (len >= 4)
+                reserve(4 + readLength(buf));
+            memcpy(m_buffer.get(), buf, len);
+            m_pending = len;
+            len = 0;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,51 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef QUIC_STREAM_FRAME_READER_H_
+#define QUIC_STREAM_FRAME_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <logger.h>
+
+class QuicStreamFrameListener {
+public:
+    virtual ~QuicStreamFrameListener() { }
+    // data points at the message body right after the type byte and is only
+    // valid during the call.
+    virtual void onStreamMessage(char type, const char* data, uint32_t length) = 0;
+};
+
+/*
+ * Incremental parser of the length prefixed messages on a cascading stream,
+ * | length(4, network order) | type(1) | body(length - 1) |
+ *
+ * Messages complete in a received chunk are handed out in place. Only a
+ * message split across chunks is copied, into a reassembly buffer that
+ * grows to the largest such message and is reused afterwards.
+ */
+class QuicStreamFrameReader {
+    DECLARE_LOGGER();
+public:
+    explicit QuicStreamFrameReader(QuicStreamFrameListener* listener, size_t initialBufferSize = 80000);
+
+    // Returns false once the stream carries a message it can not parse,
+    // all later data is dropped.
+    bool feed(const char* buf, size_t len);
+
+private:
+    // Bytes of the pending message still missing.
+    size_t missingBytes() const;
+    void reserve(size_t size);
+    bool checkLength(uint32_t length);
+
+    QuicStreamFrameListener* m_listener;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_capacity;
+    size_t m_pending;
+    bool m_failed;
+};
+
+#endif // QUIC_STREAM_FRAME_READER_H_
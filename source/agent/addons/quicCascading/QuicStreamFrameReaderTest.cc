@@ -0,0 +1,124 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE QuicStreamFrameReader
+#include <boost/test/unit_test.hpp>
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "QuicStreamFrameReader.h"
+
+class MessageRecorder : public QuicStreamFrameListener {
+public:
+    void onStreamMessage(char type, const char* data, uint32_t length) override
+    {
+        types.push_back(type);
+        bodies.push_back(std::string(data, length));
+    }
+
+    std::vector<char> types;
+    std::vector<std::string> bodies;
+};
+
+static std::string message(char type, const std::string& body)
+{
+    uint32_t length = htonl(body.size() + 1);
+    std::string msg(reinterpret_cast<const char*>(&length), sizeof(length));
+    msg.push_back(type);
+    return msg + body;
+}
+
+static std::string payload(size_t size)
+{
+    std::string body(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        body[i] = static_cast<char>(i * 7);
+    }
+    return body;
+}
+
+struct ReaderFixture {
+    MessageRecorder recorder;
+    QuicStreamFrameReader reader;
+
+    ReaderFixture() : reader(&recorder, 16) {}
+
+    bool feed(const std::string& data) { return reader.feed(data.data(), data.size()); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(Reader, ReaderFixture)
+
+BOOST_AUTO_TEST_CASE(WholeMessages)
+{
+    BOOST_CHECK(feed(message(1, "first") + message(2, "") + message(3, "third")));
+    BOOST_REQUIRE_EQUAL(recorder.bodies.size(), 3u);
+    BOOST_CHECK_EQUAL(recorder.types[0], 1);
+    BOOST_CHECK_EQUAL(recorder.bodies[0], "first");
+    BOOST_CHECK_EQUAL(recorder.types[1], 2);
+    BOOST_CHECK_EQUAL(recorder.bodies[1], "");
+    BOOST_CHECK_EQUAL(recorder.bodies[2], "third");
+}
+
+BOOST_AUTO_TEST_CASE(SplitAtEveryOffset)
+{
+    std::string stream = message(1, "abc") + message(2, payload(100)) + message(3, "xyz");
+    for (size_t split = 1; split < stream.size(); split++) {
+        MessageRecorder recorder;
+        QuicStreamFrameReader reader(&recorder, 16);
+        BOOST_CHECK(reader.feed(stream.data(), split));
+        BOOST_CHECK(reader.feed(stream.data() + split, stream.size() - split));
+        BOOST_REQUIRE_EQUAL(recorder.bodies.size(), 3u);
+        BOOST_CHECK_EQUAL(recorder.bodies[0], "abc");
+        BOOST_CHECK(recorder.bodies[1] == payload(100));
+        BOOST_CHECK_EQUAL(recorder.bodies[2], "xyz");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ByteByByte)
+{
+    std::string stream = message(4, payload(300)) + message(5, "tail");
+    for (size_t i = 0; i < stream.size(); i++) {
+        BOOST_CHECK(reader.feed(stream.data() + i, 1));
+    }
+    BOOST_REQUIRE_EQUAL(recorder.bodies.size(), 2u);
+    BOOST_CHECK_EQUAL(recorder.types[0], 4);
+    BOOST_CHECK(recorder.bodies[0] == payload(300));
+    BOOST_CHECK_EQUAL(recorder.bodies[1], "tail");
+}
+
+BOOST_AUTO_TEST_CASE(GrowsPastInitialBuffer)
+{
+    // Split messages larger than the reassembly buffer, twice
+    std::string stream = message(6, payload(5000)) + message(7, payload(70000));
+    size_t half = stream.size() / 2;
+    BOOST_CHECK(feed(stream.substr(0, 10)));
+    BOOST_CHECK(feed(stream.substr(10, half - 10)));
+    BOOST_CHECK(feed(stream.substr(half)));
+    BOOST_REQUIRE_EQUAL(recorder.bodies.size(), 2u);
+    BOOST_CHECK(recorder.bodies[0] == payload(5000));
+    BOOST_CHECK(recorder.bodies[1] == payload(70000));
+}
+
+BOOST_AUTO_TEST_CASE(ZeroLengthFails)
+{
+    std::string broken(4, '\0');
+    BOOST_CHECK(feed(message(1, "ok")));
+    BOOST_CHECK(!feed(broken + message(2, "lost")));
+    // The rest of the stream is dropped
+    BOOST_CHECK(!feed(message(3, "after")));
+    BOOST_REQUIRE_EQUAL(recorder.bodies.size(), 1u);
+    BOOST_CHECK_EQUAL(recorder.bodies[0], "ok");
+}
+
+BOOST_AUTO_TEST_CASE(OversizedLengthFails)
+{
+    uint32_t length = htonl(0x7fffffff);
+    std::string broken(reinterpret_cast<const char*>(&length), sizeof(length));
+    // Split inside the length prefix, checked once it is complete
+    BOOST_CHECK(feed(broken.substr(0, 2)));
+    BOOST_CHECK(!feed(broken.substr(2) + "x"));
+    BOOST_CHECK(recorder.bodies.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,423 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "QuicTrackMux.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <cstring>
+
+// Set on the wire when the sender of the message created the track
+static const uint32_t kCreatorBit = 0x80000000;
+// Above the ids of QUIC streams so JS can keep both in one map
+static const uint32_t kFirstTrackId = 0x100000;
+// Track id and type before the body of a track message
+static const uint32_t kTrackHeaderSize = 5;
+// Track bytes received between two acknowledgements
+static const uint64_t kAckBytes = 64 * 1024;
+static const size_t kMaxPendingMessages = 256;
+static const size_t kMaxPooledMessages = 64;
+static const size_t kMaxPooledMessageSize = 256 * 1024;
+// Deficit round robin quantum per class
+static const int64_t kQuantum[QUIC_TRACK_PRIORITY_NUM] = {
+    8 * 16 * 1024,  // audio
+    4 * 16 * 1024,  // key frame
+    2 * 16 * 1024,  // delta frame
+    1 * 16 * 1024,  // metadata
+};
+
+DEFINE_LOGGER(QuicTrackMux, "QuicTrackMux");
+
+QuicTrackMux::QuicTrackMux(QuicTrackCarrier* carrier, size_t windowBytes, size_t discardBytes)
+    : m_carrier(carrier)
+    , m_nextTrackId(kFirstTrackId)
+    , m_maxPeerTrackId(0)
+    , m_current(0)
+    , m_queuedBytes(0)
+    , m_sentBytes(0)
+    , m_ackedBytes(0)
+    , m_windowBytes(windowBytes)
+    , m_discardBytes(discardBytes)
+    , m_running(true)
+    , m_receivedBytes(0)
+    , m_lastAckBytes(0)
+{
+    memset(m_deficits, 0, sizeof(m_deficits));
+    memset(m_stats, 0, sizeof(m_stats));
+    m_writer = boost::thread(&QuicTrackMux::writeLoop, this);
+}
+
+QuicTrackMux::~QuicTrackMux()
+{
+    stop();
+}
+
+void QuicTrackMux::stop()
+{
+    {
+        boost::mutex::scoped_lock lock(m_queueMutex);
+        if (!m_running)
+            return;
+        m_running = false;
+        m_queueCond.notify_all();
+    }
+    if (m_writer.joinable() && m_writer.get_id() != boost::this_thread::get_id())
+        m_writer.join();
+
+    boost::mutex::scoped_lock lock(m_carrierMutex);
+    m_carrier = nullptr;
+}
+
+uint32_t QuicTrackMux::createTrack(QuicTrackListener* track)
+{
+    boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+    uint32_t trackId = m_nextTrackId++;
+    m_tracks[trackId].stream = track;
+    ELOG_DEBUG("Create track %u", trackId);
+    return trackId;
+}
+
+void QuicTrackMux::attachTrack(uint32_t trackId, QuicTrackListener* track)
+{
+    boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+    auto it = m_tracks.find(trackId);
+    if (it == m_tracks.end()) {
+        ELOG_WARN("Attach to closed track %u", trackId);
+        return;
+    }
+    it->second.stream = track;
+    for (auto& msg : it->second.pending) {
+        track->onStreamMessage(msg.first, msg.second.data(), msg.second.size());
+    }
+    it->second.pending.clear();
+    it->second.pending.shrink_to_fit();
+}
+
+void QuicTrackMux::closeTrack(uint32_t trackId)
+{
+    {
+        boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+        if (!m_tracks.erase(trackId))
+            return;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(m_queueMutex);
+        for (int i = 0; i < QUIC_TRACK_PRIORITY_NUM; i++) {
+            auto& queue = m_queues[i];
+            for (auto it = queue.begin(); it != queue.end();) {
+                if ((*it)->trackId == trackId) {
+                    m_stats[i].queuedMessages--;
+                    m_stats[i].queuedBytes -= (*it)->data.size();
+                    m_queuedBytes -= (*it)->data.size();
+                    it = queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        m_queuedKeyFrames.erase(trackId);
+        m_waitKeyFrame.erase(trackId);
+    }
+
+    uint32_t wireId = htonl(trackId ^ kCreatorBit);
+    boost::mutex::scoped_lock lock(m_carrierMutex);
+    if (m_carrier) {
+        m_carrier->sendMessage(TDT_MUX_CLOSE, reinterpret_cast<const char*>(&wireId), sizeof(wireId), nullptr, 0);
+    }
+}
+
+std::unique_ptr<QuicTrackMux::Message> QuicTrackMux::allocMessage()
+{
+    if (m_pool.empty())
+        return std::unique_ptr<Message>(new Message());
+
+    std::unique_ptr<Message> msg = std::move(m_pool.back());
+    m_pool.pop_back();
+    return msg;
+}
+
+void QuicTrackMux::recycle(std::unique_ptr<Message> msg)
+{
+    if (m_pool.size() < kMaxPooledMessages && msg->data.capacity() <= kMaxPooledMessageSize) {
+        msg->data.clear();
+        m_pool.push_back(std::move(msg));
+    }
+}
+
+void QuicTrackMux::send(uint32_t trackId, QuicTrackPriority priority, char type,
+    const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength)
+{
+    std::vector<uint32_t> keyFrameTracks;
+    {
+        boost::mutex::scoped_lock lock(m_queueMutex);
+        if (!m_running)
+            return;
+
+        if (priority == QUIC_TRACK_PRIORITY_KEY_FRAME) {
+            // Queued delta frames of the track are superseded
+            auto& deltas = m_queues[QUIC_TRACK_PRIORITY_DELTA_FRAME];
+            auto& stats = m_stats[QUIC_TRACK_PRIORITY_DELTA_FRAME];
+            for (auto it = deltas.begin(); it != deltas.end();) {
+                if ((*it)->trackId == trackId) {
+                    stats.queuedMessages--;
+                    stats.queuedBytes -= (*it)->data.size();
+                    stats.droppedMessages++;
+                    m_queuedBytes -= (*it)->data.size();
+                    it = deltas.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            m_waitKeyFrame.erase(trackId);
+            m_queuedKeyFrames[trackId]++;
+        } else if (priority == QUIC_TRACK_PRIORITY_DELTA_FRAME) {
+            if (m_waitKeyFrame.count(trackId)) {
+                m_stats[priority].droppedMessages++;
+                return;
+            }
+            if (m_queuedBytes > m_discardBytes) {
+                // This frame goes stale with the queued ones
+                keyFrameTracks = discardDeltaFrames();
+                m_stats[priority].droppedMessages++;
+                if (m_waitKeyFrame.insert(trackId).second)
+                    keyFrameTracks.push_back(trackId);
+            }
+        }
+
+        if (!m_waitKeyFrame.count(trackId) || priority != QUIC_TRACK_PRIORITY_DELTA_FRAME) {
+            std::unique_ptr<Message> msg = allocMessage();
+            uint32_t wireId = htonl(trackId ^ kCreatorBit);
+
+            msg->trackId = trackId;
+            msg->priority = priority;
+            msg->data.reserve(kTrackHeaderSize + headerLength + payloadLength);
+            msg->data.insert(msg->data.end(), reinterpret_cast<char*>(&wireId), reinterpret_cast<char*>(&wireId) + 4);
+            msg->data.push_back(type);
+            if (headerLength)
+                msg->data.insert(msg->data.end(), header, header + headerLength);
+            if (payloadLength)
+                msg->data.insert(msg->data.end(), payload, payload + payloadLength);
+            msg->enqueueTime = Clock::now();
+
+            m_stats[priority].queuedMessages++;
+            m_stats[priority].queuedBytes += msg->data.size();
+            m_queuedBytes += msg->data.size();
+            m_queues[priority].push_back(std::move(msg));
+            m_queueCond.notify_one();
+        }
+    }
+
+    if (!keyFrameTracks.empty()) {
+        ELOG_DEBUG("Queue over %zu bytes, drop delta frames of %zu tracks", m_discardBytes, keyFrameTracks.size());
+        requestKeyFrames(keyFrameTracks);
+    }
+}
+
+std::vector<uint32_t> QuicTrackMux::discardDeltaFrames()
+{
+    std::vector<uint32_t> trackIds;
+    auto& deltas = m_queues[QUIC_TRACK_PRIORITY_DELTA_FRAME];
+    auto& stats = m_stats[QUIC_TRACK_PRIORITY_DELTA_FRAME];
+
+    for (auto& msg : deltas) {
+        if (m_waitKeyFrame.insert(msg->trackId).second)
+            trackIds.push_back(msg->trackId);
+        stats.droppedMessages++;
+        m_queuedBytes -= msg->data.size();
+        recycle(std::move(msg));
+    }
+    deltas.clear();
+    stats.queuedMessages = 0;
+    stats.queuedBytes = 0;
+    m_deficits[QUIC_TRACK_PRIORITY_DELTA_FRAME] = 0;
+    return trackIds;
+}
+
+void QuicTrackMux::requestKeyFrames(const std::vector<uint32_t>& trackIds)
+{
+    boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+    for (auto trackId : trackIds) {
+        auto it = m_tracks.find(trackId);
+        if (it != m_tracks.end() && it->second.stream) {
+            it->second.stream->requestKeyFrame();
+        }
+    }
+}
+
+bool QuicTrackMux::canWrite() const
+{
+    return m_sentBytes - m_ackedBytes < m_windowBytes;
+}
+
+std::unique_ptr<QuicTrackMux::Message> QuicTrackMux::nextMessage()
+{
+    // At least one queue is not empty, and each turn around adds a quantum
+    for (;;) {
+        auto& queue = m_queues[m_current];
+        if (!queue.empty()) {
+            Message* head = queue.front().get();
+            bool blocked = m_current == QUIC_TRACK_PRIORITY_DELTA_FRAME
+                && m_queuedKeyFrames.count(head->trackId);
+            if (!blocked && (int64_t)head->data.size() <= m_deficits[m_current]) {
+                std::unique_ptr<Message> msg = std::move(queue.front());
+                queue.pop_front();
+                m_deficits[m_current] -= msg->data.size();
+                if (queue.empty())
+                    m_deficits[m_current] = 0;
+                return msg;
+            }
+        } else {
+            m_deficits[m_current] = 0;
+        }
+
+        m_current = (m_current + 1) % QUIC_TRACK_PRIORITY_NUM;
+        if (!m_queues[m_current].empty())
+            m_deficits[m_current] += kQuantum[m_current];
+    }
+}
+
+void QuicTrackMux::writeLoop()
+{
+    boost::mutex::scoped_lock lock(m_queueMutex);
+
+    while (m_running) {
+        if (!m_queuedBytes || !canWrite()) {
+            m_queueCond.wait(lock);
+            continue;
+        }
+
+        std::unique_ptr<Message> msg = nextMessage();
+        QuicTrackPriorityStats& stats = m_stats[msg->priority];
+        uint32_t delayUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - msg->enqueueTime).count();
+
+        stats.queuedMessages--;
+        stats.queuedBytes -= msg->data.size();
+        stats.sentMessages++;
+        stats.sentBytes += msg->data.size();
+        stats.delaySumUs += delayUs;
+        if (delayUs > stats.delayMaxUs)
+            stats.delayMaxUs = delayUs;
+        m_queuedBytes -= msg->data.size();
+        m_sentBytes += msg->data.size();
+        if (msg->priority == QUIC_TRACK_PRIORITY_KEY_FRAME) {
+            auto it = m_queuedKeyFrames.find(msg->trackId);
+            if (it != m_queuedKeyFrames.end() && --it->second == 0)
+                m_queuedKeyFrames.erase(it);
+        }
+
+        lock.unlock();
+        {
+            boost::mutex::scoped_lock carrierLock(m_carrierMutex);
+            if (m_carrier) {
+                m_carrier->sendMessage(TDT_MUX_TRACK, msg->data.data(), msg->data.size(), nullptr, 0);
+            }
+        }
+        lock.lock();
+        recycle(std::move(msg));
+    }
+}
+
+void QuicTrackMux::sendAck()
+{
+    uint64_t received = htobe64(m_receivedBytes);
+
+    m_lastAckBytes = m_receivedBytes;
+    boost::mutex::scoped_lock lock(m_carrierMutex);
+    if (m_carrier) {
+        m_carrier->sendMessage(TDT_MUX_ACK, reinterpret_cast<const char*>(&received), sizeof(received), nullptr, 0);
+    }
+}
+
+void QuicTrackMux::onTrackMessage(const char* data, uint32_t length)
+{
+    uint32_t trackId;
+    memcpy(&trackId, data, sizeof(trackId));
+    trackId = ntohl(trackId);
+    char type = data[4];
+    const char* body = data + kTrackHeaderSize;
+    uint32_t bodyLength = length - kTrackHeaderSize;
+
+    boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+    auto it = m_tracks.find(trackId);
+    if (it == m_tracks.end()) {
+        // Ids of peer tracks only grow, a known one is closed here
+        if (!(trackId & kCreatorBit) || trackId <= m_maxPeerTrackId) {
+            return;
+        }
+        m_maxPeerTrackId = trackId;
+        it = m_tracks.insert(std::make_pair(trackId, Track())).first;
+        it->second.stream = nullptr;
+        ELOG_DEBUG("New track %u from peer", trackId);
+
+        boost::mutex::scoped_lock carrierLock(m_carrierMutex);
+        if (m_carrier) {
+            m_carrier->notifyNewTrack(trackId);
+        }
+    }
+
+    Track& track = it->second;
+    if (track.stream) {
+        track.stream->onStreamMessage(type, body, bodyLength);
+    } else if (track.pending.size() < kMaxPendingMessages) {
+        track.pending.push_back(std::make_pair(type, std::vector<char>(body, body + bodyLength)));
+    } else {
+        ELOG_WARN("Track %u not attached, drop message", trackId);
+    }
+}
+
+void QuicTrackMux::onCarrierMessage(char type, const char* data, uint32_t length)
+{
+    switch (type) {
+        case TDT_MUX_TRACK:
+            if (length < kTrackHeaderSize) {
+                ELOG_WARN("Short track message %u", length);
+                break;
+            }
+            onTrackMessage(data, length);
+            m_receivedBytes += length;
+            if (m_receivedBytes - m_lastAckBytes >= kAckBytes) {
+                sendAck();
+            }
+            break;
+        case TDT_MUX_ACK: {
+            uint64_t acked;
+            if (length < sizeof(acked))
+                break;
+            memcpy(&acked, data, sizeof(acked));
+            boost::mutex::scoped_lock lock(m_queueMutex);
+            m_ackedBytes = be64toh(acked);
+            m_queueCond.notify_one();
+            break;
+        }
+        case TDT_MUX_CLOSE: {
+            uint32_t trackId;
+            if (length < sizeof(trackId))
+                break;
+            memcpy(&trackId, data, sizeof(trackId));
+            trackId = ntohl(trackId);
+            boost::recursive_mutex::scoped_lock lock(m_tracksMutex);
+            auto it = m_tracks.find(trackId);
+            if (it != m_tracks.end() && !it->second.stream) {
+                // Never attached, nothing refers to it
+                m_tracks.erase(it);
+            } else if (it != m_tracks.end()) {
+                ELOG_DEBUG("Track %u closed by peer", trackId);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void QuicTrackMux::getStats(QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM])
+{
+    boost::mutex::scoped_lock lock(m_queueMutex);
+    memcpy(stats, m_stats, sizeof(m_stats));
+    for (int i = 0; i < QUIC_TRACK_PRIORITY_NUM; i++) {
+        m_stats[i].delayMaxUs = 0;
+    }
+}
@@ -0,0 +1,160 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef QUIC_TRACK_MUX_H_
+#define QUIC_TRACK_MUX_H_
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <logger.h>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "QuicStreamFrameReader.h"
+
+const char TDT_MUX_TRACK = 0x6C;
+const char TDT_MUX_ACK = 0x6D;
+const char TDT_MUX_CLOSE = 0x6E;
+
+// Scheduling classes, in the order they are served under congestion
+enum QuicTrackPriority {
+    QUIC_TRACK_PRIORITY_AUDIO = 0,  // audio frames and feedback
+    QUIC_TRACK_PRIORITY_KEY_FRAME,
+    QUIC_TRACK_PRIORITY_DELTA_FRAME,
+    QUIC_TRACK_PRIORITY_METADATA,
+    QUIC_TRACK_PRIORITY_NUM
+};
+
+struct QuicTrackPriorityStats {
+    uint32_t queuedMessages;
+    uint64_t queuedBytes;
+    uint64_t sentMessages;
+    uint64_t sentBytes;
+    uint64_t droppedMessages;
+    uint64_t delaySumUs;
+    uint32_t delayMaxUs;    // since the last getStats
+};
+
+// Stream the mux messages are written to and read from
+class QuicTrackCarrier {
+public:
+    virtual ~QuicTrackCarrier() { }
+    virtual void sendMessage(char type, const char* header, uint32_t headerLength,
+                             const char* payload, uint32_t payloadLength) = 0;
+    // A track created by the peer showed up
+    virtual void notifyNewTrack(uint32_t trackId) = 0;
+};
+
+// Local end of one track
+class QuicTrackListener : public QuicStreamFrameListener {
+public:
+    virtual void requestKeyFrame() = 0;
+};
+
+/*
+ * Carries many tracks on one cascading stream.
+ *
+ * A track message is | TDT_MUX_TRACK | track id(4) | type(1) | body |, sent
+ * as one length prefixed message of the carrier. The top bit of the track id
+ * on the wire is set when the sender of the message created the track, so
+ * both ends allocate ids without clashing.
+ *
+ * Outgoing messages are queued by priority class and written by one thread
+ * with deficit round robin, weighted towards audio and key frames. The peer
+ * acknowledges received track bytes, and at most a window of unacknowledged
+ * bytes is handed to the QUIC stream, so under congestion messages wait here
+ * where they can still be ordered and dropped. When the queue passes the
+ * discard threshold, queued delta frames are dropped, their tracks skip
+ * delta frames until the next key frame and a key frame is requested.
+ */
+class QuicTrackMux {
+    DECLARE_LOGGER();
+public:
+    QuicTrackMux(QuicTrackCarrier* carrier, size_t windowBytes, size_t discardBytes);
+    ~QuicTrackMux();
+
+    // Detaches the carrier, later messages are dropped.
+    void stop();
+
+    // Returns the local id of a new track created by this end.
+    uint32_t createTrack(QuicTrackListener* track);
+    // Binds a track announced by the peer and replays what arrived before.
+    void attachTrack(uint32_t trackId, QuicTrackListener* track);
+    // The track is gone locally, the peer is told to drop it too.
+    void closeTrack(uint32_t trackId);
+
+    void send(uint32_t trackId, QuicTrackPriority priority, char type,
+              const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength);
+
+    // Called by the carrier for mux messages received on it.
+    void onCarrierMessage(char type, const char* data, uint32_t length);
+
+    void getStats(QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM]);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Message {
+        uint32_t trackId;
+        QuicTrackPriority priority;
+        std::vector<char> data;
+        Clock::time_point enqueueTime;
+    };
+
+    struct Track {
+        QuicTrackListener* stream;
+        // Messages of a peer track received before it is attached
+        std::vector<std::pair<char, std::vector<char>>> pending;
+    };
+
+    void writeLoop();
+    bool canWrite() const;
+    std::unique_ptr<Message> nextMessage();
+    std::unique_ptr<Message> allocMessage();
+    void recycle(std::unique_ptr<Message> msg);
+    // Drops queued delta frames, returns the tracks that lost any.
+    std::vector<uint32_t> discardDeltaFrames();
+    void requestKeyFrames(const std::vector<uint32_t>& trackIds);
+    void onTrackMessage(const char* data, uint32_t length);
+    void sendAck();
+
+    boost::mutex m_carrierMutex;
+    QuicTrackCarrier* m_carrier;
+
+    // Recursive, a track may send while it handles a received message
+    boost::recursive_mutex m_tracksMutex;
+    std::unordered_map<uint32_t, Track> m_tracks;
+    uint32_t m_nextTrackId;
+    uint32_t m_maxPeerTrackId;
+
+    boost::mutex m_queueMutex;
+    boost::condition_variable m_queueCond;
+    std::deque<std::unique_ptr<Message>> m_queues[QUIC_TRACK_PRIORITY_NUM];
+    int64_t m_deficits[QUIC_TRACK_PRIORITY_NUM];
+    uint32_t m_current;
+    QuicTrackPriorityStats m_stats[QUIC_TRACK_PRIORITY_NUM];
+    std::vector<std::unique_ptr<Message>> m_pool;
+    // Key frames queued per track, its delta frames wait behind them
+    std::unordered_map<uint32_t, uint32_t> m_queuedKeyFrames;
+    // Tracks skipping delta frames until their next key frame
+    std::unordered_set<uint32_t> m_waitKeyFrame;
+    size_t m_queuedBytes;
+    uint64_t m_sentBytes;
+    uint64_t m_ackedBytes;
+    size_t m_windowBytes;
+    size_t m_discardBytes;
+    bool m_running;
+
+    // Receive side, only touched on the carrier's receiving thread
+    uint64_t m_receivedBytes;
+    uint64_t m_lastAckBytes;
+
+    boost::thread m_writer;
+};
+
+#endif // QUIC_TRACK_MUX_H_
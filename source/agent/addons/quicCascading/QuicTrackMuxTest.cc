@@ -0,0 +1,277 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE QuicTrackMux
+#include <boost/test/unit_test.hpp>
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "QuicTrackMux.h"
+
+// Records what the mux writes, the test hands it to the peer
+class TestCarrier : public QuicTrackCarrier {
+public:
+    void sendMessage(char type, const char* header, uint32_t headerLength,
+                     const char* payload, uint32_t payloadLength) override
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        std::string data(header, headerLength);
+        if (payloadLength)
+            data.append(payload, payloadLength);
+        m_messages.push_back(std::make_pair(type, data));
+        if (type == TDT_MUX_TRACK)
+            m_trackBytes += data.size();
+        m_cond.notify_all();
+    }
+
+    void notifyNewTrack(uint32_t trackId) override
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_newTracks.push_back(trackId);
+    }
+
+    // Waits until count messages were written
+    bool waitMessages(size_t count)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_cond.wait_for(lock, boost::chrono::seconds(2),
+            [&]() { return m_messages.size() >= count; });
+    }
+
+    std::vector<std::pair<char, std::string>> messages()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_messages;
+    }
+
+    std::vector<uint32_t> newTracks()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_newTracks;
+    }
+
+    uint64_t trackBytes()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        return m_trackBytes;
+    }
+
+    // Hands the written messages from index on to another mux
+    void deliver(QuicTrackMux& peer, size_t index = 0)
+    {
+        auto msgs = messages();
+        for (size_t i = index; i < msgs.size(); i++) {
+            peer.onCarrierMessage(msgs[i].first, msgs[i].second.data(), msgs[i].second.size());
+        }
+    }
+
+private:
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    std::vector<std::pair<char, std::string>> m_messages;
+    std::vector<uint32_t> m_newTracks;
+    uint64_t m_trackBytes = 0;
+};
+
+class TestTrack : public QuicTrackListener {
+public:
+    void onStreamMessage(char type, const char* data, uint32_t length) override
+    {
+        types.push_back(type);
+        bodies.push_back(std::string(data, length));
+    }
+
+    void requestKeyFrame() override { keyFrameRequests++; }
+
+    std::vector<char> types;
+    std::vector<std::string> bodies;
+    int keyFrameRequests = 0;
+};
+
+static void ack(QuicTrackMux& mux, uint64_t bytes)
+{
+    uint64_t wire = htobe64(bytes);
+    mux.onCarrierMessage(TDT_MUX_ACK, reinterpret_cast<const char*>(&wire), sizeof(wire));
+}
+
+// Track id and type of a written track message
+static uint32_t wireTrackId(const std::string& data)
+{
+    uint32_t trackId;
+    memcpy(&trackId, data.data(), sizeof(trackId));
+    return ntohl(trackId);
+}
+
+BOOST_AUTO_TEST_SUITE(TrackMux)
+
+BOOST_AUTO_TEST_CASE(NewTrackReachesPeer)
+{
+    TestCarrier carrierA, carrierB;
+    QuicTrackMux muxA(&carrierA, 1024 * 1024, 1024 * 1024);
+    QuicTrackMux muxB(&carrierB, 1024 * 1024, 1024 * 1024);
+    TestTrack trackA, trackB;
+
+    uint32_t trackId = muxA.createTrack(&trackA);
+    BOOST_CHECK(muxA.createTrack(&trackA) != trackId);
+
+    muxA.send(trackId, QUIC_TRACK_PRIORITY_AUDIO, 1, "hd", 2, "first", 5);
+    muxA.send(trackId, QUIC_TRACK_PRIORITY_AUDIO, 2, nullptr, 0, "second", 6);
+    BOOST_REQUIRE(carrierA.waitMessages(2));
+    carrierA.deliver(muxB);
+
+    // The peer sees the id with the creator bit set and buffers until attached
+    BOOST_REQUIRE_EQUAL(carrierB.newTracks().size(), 1u);
+    uint32_t peerId = carrierB.newTracks()[0];
+    BOOST_CHECK_EQUAL(peerId, trackId | 0x80000000);
+    BOOST_CHECK(trackB.bodies.empty());
+
+    muxB.attachTrack(peerId, &trackB);
+    BOOST_REQUIRE_EQUAL(trackB.bodies.size(), 2u);
+    BOOST_CHECK_EQUAL(trackB.types[0], 1);
+    BOOST_CHECK_EQUAL(trackB.bodies[0], "hdfirst");
+    BOOST_CHECK_EQUAL(trackB.types[1], 2);
+    BOOST_CHECK_EQUAL(trackB.bodies[1], "second");
+
+    // Attached tracks get messages directly
+    muxA.send(trackId, QUIC_TRACK_PRIORITY_METADATA, 3, nullptr, 0, "third", 5);
+    BOOST_REQUIRE(carrierA.waitMessages(3));
+    carrierA.deliver(muxB, 2);
+    BOOST_REQUIRE_EQUAL(trackB.bodies.size(), 3u);
+    BOOST_CHECK_EQUAL(trackB.bodies[2], "third");
+    BOOST_CHECK_EQUAL(carrierB.newTracks().size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(PriorityOrderUnderWindow)
+{
+    TestCarrier carrier;
+    // Only one message in flight until acknowledged
+    QuicTrackMux mux(&carrier, 1, 1024 * 1024);
+    TestTrack audio, video, data;
+    uint32_t audioId = mux.createTrack(&audio);
+    uint32_t videoId = mux.createTrack(&video);
+    uint32_t dataId = mux.createTrack(&data);
+
+    mux.send(dataId, QUIC_TRACK_PRIORITY_METADATA, 0, nullptr, 0, "m0", 2);
+    BOOST_REQUIRE(carrier.waitMessages(1));
+
+    mux.send(dataId, QUIC_TRACK_PRIORITY_METADATA, 0, nullptr, 0, "m1", 2);
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, "d1", 2);
+    mux.send(videoId, QUIC_TRACK_PRIORITY_KEY_FRAME, 0, nullptr, 0, "k1", 2);
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, "d2", 2);
+    mux.send(audioId, QUIC_TRACK_PRIORITY_AUDIO, 0, nullptr, 0, "a1", 2);
+
+    for (size_t sent = 1; sent < 5; sent++) {
+        ack(mux, carrier.trackBytes());
+        BOOST_REQUIRE(carrier.waitMessages(sent + 1));
+    }
+    ack(mux, carrier.trackBytes());
+
+    // Audio first, the key frame superseded the delta queued before it
+    auto msgs = carrier.messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 5u);
+    BOOST_CHECK(msgs[1].second.substr(5) == "a1");
+    BOOST_CHECK(msgs[2].second.substr(5) == "k1");
+    BOOST_CHECK(msgs[3].second.substr(5) == "d2");
+    BOOST_CHECK(msgs[4].second.substr(5) == "m1");
+    BOOST_CHECK_EQUAL(wireTrackId(msgs[1].second), audioId | 0x80000000);
+
+    QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM];
+    mux.getStats(stats);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_DELTA_FRAME].droppedMessages, 1u);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_DELTA_FRAME].sentMessages, 1u);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_METADATA].sentMessages, 2u);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_METADATA].queuedMessages, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(DiscardDeltaFramesOverThreshold)
+{
+    TestCarrier carrier;
+    QuicTrackMux mux(&carrier, 1, 100);
+    TestTrack video;
+    uint32_t videoId = mux.createTrack(&video);
+    std::string frame(60, 'd');
+
+    mux.send(videoId, QUIC_TRACK_PRIORITY_KEY_FRAME, 0, nullptr, 0, "key", 3);
+    BOOST_REQUIRE(carrier.waitMessages(1));
+
+    // The third delta finds the queue over the threshold, all are dropped
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, frame.data(), frame.size());
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, frame.data(), frame.size());
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, frame.data(), frame.size());
+    BOOST_CHECK_EQUAL(video.keyFrameRequests, 1);
+
+    // Deltas wait for the next key frame
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, "late", 4);
+    mux.send(videoId, QUIC_TRACK_PRIORITY_KEY_FRAME, 0, nullptr, 0, "key2", 4);
+    mux.send(videoId, QUIC_TRACK_PRIORITY_DELTA_FRAME, 0, nullptr, 0, "next", 4);
+
+    ack(mux, carrier.trackBytes());
+    BOOST_REQUIRE(carrier.waitMessages(2));
+    ack(mux, carrier.trackBytes());
+    BOOST_REQUIRE(carrier.waitMessages(3));
+
+    auto msgs = carrier.messages();
+    BOOST_CHECK(msgs[1].second.substr(5) == "key2");
+    BOOST_CHECK(msgs[2].second.substr(5) == "next");
+
+    QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM];
+    mux.getStats(stats);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_DELTA_FRAME].droppedMessages, 4u);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_DELTA_FRAME].queuedMessages, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(CloseTrack)
+{
+    TestCarrier carrierA, carrierB;
+    QuicTrackMux muxA(&carrierA, 1, 1024 * 1024);
+    QuicTrackMux muxB(&carrierB, 1024 * 1024, 1024 * 1024);
+    TestTrack track;
+    uint32_t trackId = muxA.createTrack(&track);
+
+    muxA.send(trackId, QUIC_TRACK_PRIORITY_AUDIO, 0, nullptr, 0, "a0", 2);
+    BOOST_REQUIRE(carrierA.waitMessages(1));
+    muxA.send(trackId, QUIC_TRACK_PRIORITY_AUDIO, 0, nullptr, 0, "a1", 2);
+
+    // Queued messages of the track go away and the peer is told
+    muxA.closeTrack(trackId);
+    auto msgs = carrierA.messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 2u);
+    BOOST_CHECK_EQUAL(msgs[1].first, TDT_MUX_CLOSE);
+    QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM];
+    muxA.getStats(stats);
+    BOOST_CHECK_EQUAL(stats[QUIC_TRACK_PRIORITY_AUDIO].queuedMessages, 0u);
+
+    // The peer drops the unattached track and ignores later messages for it
+    carrierA.deliver(muxB);
+    BOOST_CHECK_EQUAL(carrierB.newTracks().size(), 1u);
+    carrierA.deliver(muxB, 0);
+    BOOST_CHECK_EQUAL(carrierB.newTracks().size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(ReceiverAcknowledges)
+{
+    TestCarrier carrierA, carrierB;
+    QuicTrackMux muxA(&carrierA, 1024 * 1024, 1024 * 1024);
+    QuicTrackMux muxB(&carrierB, 1024 * 1024, 1024 * 1024);
+    TestTrack track;
+    uint32_t trackId = muxA.createTrack(&track);
+    std::string frame(16 * 1024, 'x');
+
+    for (int i = 0; i < 5; i++) {
+        muxA.send(trackId, QUIC_TRACK_PRIORITY_KEY_FRAME, 0, nullptr, 0, frame.data(), frame.size());
+    }
+    BOOST_REQUIRE(carrierA.waitMessages(5));
+    carrierA.deliver(muxB);
+
+    // One acknowledgement after 64KB of track bytes
+    auto msgs = carrierB.messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1u);
+    BOOST_CHECK_EQUAL(msgs[0].first, TDT_MUX_ACK);
+    uint64_t acked;
+    memcpy(&acked, msgs[0].second.data(), sizeof(acked));
+    BOOST_CHECK(be64toh(acked) >= 64 * 1024);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,10 @@ const char TDT_FEEDBACK_MSG = 0x5A;
 const char TDT_MEDIA_FRAME = 0x8F;
 const char TDT_MEDIA_METADATA = 0x3A;
 const size_t INIT_BUFF_SIZE = 80000;
+// Unacknowledged track bytes handed to QUIC, and queued bytes at which
+// delta frames are dropped
+const size_t TRACK_MUX_WINDOW_SIZE = 2 * 1024 * 1024;
+const size_t TRACK_MUX_DISCARD_SIZE = 1024 * 1024;
 
 DEFINE_LOGGER(QuicTransportStream, "QuicTransportStream");
 
@@ -45,12 +49,16 @@ QuicTransportStream::QuicTransportStream()
 }
 
 QuicTransportStream::QuicTransportStream(owt::quic::QuicTransportStreamInterface* stream)
-        : m_stream(stream)
-        , m_bufferSize(INIT_BUFF_SIZE)
-        , m_receivedBytes(0)
+        : has_data_callback_(false)
+        , data_callback_(nullptr)
+        , asyncResource_(nullptr)
+        , m_reader(this, INIT_BUFF_SIZE)
+        , m_stream(stream)
         , m_needKeyFrame(true)
-        , m_trackKind("unknown") {
-    m_receiveData.buffer.reset(new char[m_bufferSize]);
+        , m_trackKind("unknown")
+        , m_isTrack(false)
+        , track_callback_(nullptr)
+        , asyncResourceTrack_(nullptr) {
 }
 
 QuicTransportStream::~QuicTransportStream() {
@@ -58,12 +66,23 @@ QuicTransportStream::~QuicTransportStream() {
     if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(&m_asyncOnData))) {
         uv_close(reinterpret_cast<uv_handle_t*>(&m_asyncOnData), NULL);
     }
-    m_stream->SetVisitor(nullptr);
+    if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(&m_asyncOnNewTrack))) {
+        uv_close(reinterpret_cast<uv_handle_t*>(&m_asyncOnNewTrack), NULL);
+    }
+    if (m_isTrack) {
+        m_trackMux->closeTrack(id);
+    } else if (m_trackMux) {
+        m_trackMux->stop();
+    }
+    if (m_stream) {
+        m_stream->SetVisitor(nullptr);
+    }
     delete asyncResource_;
+    delete asyncResourceTrack_;
+    delete track_callback_;
     delete m_stream;
     m_stream = nullptr;
-    /*delete[] m_receiveData.buffer;
-    data_callback_.Reset();*/
+    /*data_callback_.Reset();*/
 }
 
 NAN_MODULE_INIT(QuicTransportStream::init)
@@ -79,6 +98,9 @@ NAN_MODULE_INIT(QuicTransportStream::init)
     Nan::SetPrototypeMethod(tpl, "close", close);
     Nan::SetPrototypeMethod(tpl, "onStreamData", onStreamData);
     Nan::SetPrototypeMethod(tpl, "getId", getId);
+    Nan::SetPrototypeMethod(tpl, "createTrack", createTrack);
+    Nan::SetPrototypeMethod(tpl, "onNewTrack", onNewTrack);
+    Nan::SetPrototypeMethod(tpl, "getTrackMuxStats", getTrackMuxStats);
     Nan::SetAccessor(instanceTpl, Nan::New("trackKind").ToLocalChecked(), trackKindGetter, trackKindSetter);
 
     s_constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
@@ -94,7 +116,10 @@ NAN_METHOD(QuicTransportStream::newInstance)
     QuicTransportStream* obj = new QuicTransportStream();
     obj->Wrap(info.This());
     uv_async_init(uv_default_loop(), &obj->m_asyncOnData, &QuicTransportStream::onStreamDataCallback);
+    uv_async_init(uv_default_loop(), &obj->m_asyncOnNewTrack, &QuicTransportStream::onNewTrackCallback);
+    obj->m_asyncOnNewTrack.data = obj;
     obj->asyncResource_ = new Nan::AsyncResource("streamDataCallback");
+    obj->asyncResourceTrack_ = new Nan::AsyncResource("newTrackCallback");
     info.GetReturnValue().Set(info.This());
 }
 
@@ -190,10 +215,123 @@ NAN_SETTER(QuicTransportStream::trackKindSetter) {
 NAN_METHOD(QuicTransportStream::close)
 {
     QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    if (obj->m_isTrack) {
+        obj->m_trackMux->closeTrack(obj->id);
+        return;
+    }
     obj->m_stream->Close();
     obj->m_stream->SetVisitor(nullptr);
 }
 
+std::shared_ptr<QuicTrackMux> QuicTransportStream::trackMux()
+{
+    boost::mutex::scoped_lock lock(m_trackMuxMutex);
+    if (!m_trackMux) {
+        ELOG_DEBUG("Carry tracks on stream:%d", id);
+        m_trackMux.reset(new QuicTrackMux(this, TRACK_MUX_WINDOW_SIZE, TRACK_MUX_DISCARD_SIZE));
+    }
+    return m_trackMux;
+}
+
+// createTrack() returns a QuicTransportStream multiplexed on this one
+NAN_METHOD(QuicTransportStream::createTrack)
+{
+    QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    if (obj->m_isTrack) {
+        Nan::ThrowError("Tracks can not carry tracks.");
+        return;
+    }
+    Local<Object> trackObject = Nan::NewInstance(Nan::New(QuicTransportStream::s_constructor)).ToLocalChecked();
+    QuicTransportStream* track = Nan::ObjectWrap::Unwrap<QuicTransportStream>(trackObject);
+    track->m_isTrack = true;
+    track->m_trackMux = obj->trackMux();
+    track->id = track->m_trackMux->createTrack(track);
+    info.GetReturnValue().Set(trackObject);
+}
+
+NAN_METHOD(QuicTransportStream::onNewTrack)
+{
+    QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    delete obj->track_callback_;
+    obj->track_callback_ = new Nan::Callback(info[0].As<Function>());
+}
+
+NAN_METHOD(QuicTransportStream::getTrackMuxStats)
+{
+    static const char* kClassNames[QUIC_TRACK_PRIORITY_NUM] = {"audio", "keyFrame", "deltaFrame", "metadata"};
+    QuicTransportStream* obj = Nan::ObjectWrap::Unwrap<QuicTransportStream>(info.Holder());
+    std::shared_ptr<QuicTrackMux> mux;
+    {
+        boost::mutex::scoped_lock lock(obj->m_trackMuxMutex);
+        mux = obj->m_trackMux;
+    }
+    if (!mux) {
+        return;
+    }
+
+    QuicTrackPriorityStats stats[QUIC_TRACK_PRIORITY_NUM];
+    mux->getStats(stats);
+
+    Local<Object> result = Nan::New<Object>();
+    for (int i = 0; i < QUIC_TRACK_PRIORITY_NUM; i++) {
+        Local<Object> item = Nan::New<Object>();
+        Nan::Set(item, Nan::New("queued").ToLocalChecked(), Nan::New(stats[i].queuedMessages));
+        Nan::Set(item, Nan::New("queuedBytes").ToLocalChecked(), Nan::New((double)stats[i].queuedBytes));
+        Nan::Set(item, Nan::New("sent").ToLocalChecked(), Nan::New((double)stats[i].sentMessages));
+        Nan::Set(item, Nan::New("sentBytes").ToLocalChecked(), Nan::New((double)stats[i].sentBytes));
+        Nan::Set(item, Nan::New("dropped").ToLocalChecked(), Nan::New((double)stats[i].droppedMessages));
+        Nan::Set(item, Nan::New("delayAvgMs").ToLocalChecked(),
+            Nan::New(stats[i].sentMessages ? stats[i].delaySumUs / 1000.0 / stats[i].sentMessages : 0.0));
+        Nan::Set(item, Nan::New("delayMaxMs").ToLocalChecked(), Nan::New(stats[i].delayMaxUs / 1000.0));
+        Nan::Set(result, Nan::New(kClassNames[i]).ToLocalChecked(), item);
+    }
+    info.GetReturnValue().Set(result);
+}
+
+NAUV_WORK_CB(QuicTransportStream::onNewTrackCallback)
+{
+    Nan::HandleScope scope;
+    QuicTransportStream* obj = reinterpret_cast<QuicTransportStream*>(async->data);
+    if (!obj || !obj->track_callback_) {
+        return;
+    }
+
+    std::queue<uint32_t> trackIds;
+    {
+        boost::mutex::scoped_lock lock(obj->mutex);
+        trackIds.swap(obj->m_newTracks);
+    }
+    std::shared_ptr<QuicTrackMux> mux = obj->trackMux();
+    while (!trackIds.empty()) {
+        Local<Object> trackObject = Nan::NewInstance(Nan::New(QuicTransportStream::s_constructor)).ToLocalChecked();
+        QuicTransportStream* track = Nan::ObjectWrap::Unwrap<QuicTransportStream>(trackObject);
+        track->m_isTrack = true;
+        track->m_trackMux = mux;
+        track->id = trackIds.front();
+        trackIds.pop();
+
+        Local<Value> args[] = { trackObject };
+        obj->asyncResourceTrack_->runInAsyncScope(Nan::GetCurrentContext()->Global(), obj->track_callback_->GetFunction(), 1, args);
+        // Messages that came before go out once JS has set up the track
+        mux->attachTrack(track->id, track);
+    }
+}
+
+void QuicTransportStream::notifyNewTrack(uint32_t trackId)
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        m_newTracks.push(trackId);
+    }
+    uv_async_send(&m_asyncOnNewTrack);
+}
+
+void QuicTransportStream::requestKeyFrame()
+{
+    owt_base::FeedbackMsg msg {.type = owt_base::VIDEO_FEEDBACK, .cmd = owt_base::REQUEST_KEY_FRAME};
+    deliverFeedbackMsg(msg);
+}
+
 NAUV_WORK_CB(QuicTransportStream::onStreamDataCallback){
     ELOG_DEBUG("********QuicTransportStream::onStreamDataCallback");
     Nan::HandleScope scope;
@@ -220,15 +358,7 @@ NAUV_WORK_CB(QuicTransportStream::onStreamDataCallback){
 
 void QuicTransportStream::onFeedback(const FeedbackMsg& msg) {
     ELOG_DEBUG("QuicTransportStream::onFeedback in stream:%d", id);
-    TransportData sendData;
-    uint32_t payloadLength = sizeof(FeedbackMsg);
-    sendData.buffer.reset(new char[payloadLength + 5]);
-    *(reinterpret_cast<uint32_t*>(sendData.buffer.get())) = htonl(payloadLength + 1);
-    sendData.buffer[4] = TDT_FEEDBACK_MSG;
-    memcpy(sendData.buffer.get() + 5, reinterpret_cast<char*>(const_cast<FeedbackMsg*>(&msg)), payloadLength);
-    sendData.length = payloadLength + 5;
-
-    m_stream->SendData(sendData.buffer.get(), sendData.length);
+    sendFeedback(msg);
 }
 
 void QuicTransportStream::onVideoSourceChanged()
@@ -241,123 +371,122 @@ void QuicTransportStream::onFrame(const owt_base::Frame& frame)
 {
     //ELOG_DEBUG("QuicTransportStream::onFrame");
     //dump(this, frame.payload, frame.length);
-    TransportData sendData;
-    sendData.buffer.reset(new char[sizeof(Frame) + frame.length + 5]);
-    *(reinterpret_cast<uint32_t*>(sendData.buffer.get())) = htonl(sizeof(Frame) + frame.length + 1);
-    sendData.buffer[4] = TDT_MEDIA_FRAME;
-    memcpy(sendData.buffer.get() + 5, reinterpret_cast<uint8_t*>(const_cast<Frame*>(&frame)),
-           sizeof(Frame));
-    memcpy(sendData.buffer.get() + 5 + sizeof(Frame), frame.payload, frame.length);
-    sendData.length = sizeof(Frame) + frame.length + 5;
-
-    m_stream->SendData(sendData.buffer.get(), sendData.length);
+    QuicTrackPriority priority = QUIC_TRACK_PRIORITY_METADATA;
+    if (isAudioFrame(frame)) {
+        priority = QUIC_TRACK_PRIORITY_AUDIO;
+    } else if (isVideoFrame(frame)) {
+        priority = frame.additionalInfo.video.isKeyFrame ? QUIC_TRACK_PRIORITY_KEY_FRAME : QUIC_TRACK_PRIORITY_DELTA_FRAME;
+    }
+    sendMediaMessage(priority, TDT_MEDIA_FRAME, reinterpret_cast<const char*>(&frame), sizeof(Frame),
+                     reinterpret_cast<const char*>(frame.payload), frame.length);
 }
 
 
 void QuicTransportStream::sendData(const std::string& data) {
     ELOG_DEBUG("QuicTransportStream::sendData:%s in stream:%d\n", data.c_str(), id);
-    TransportData sendData;
-    uint32_t payloadLength = data.length();
-    sendData.buffer.reset(new char[payloadLength + 5]);
-    *(reinterpret_cast<uint32_t*>(sendData.buffer.get())) = htonl(payloadLength + 1);
-    sendData.buffer[4] = TDT_MEDIA_METADATA;
-    memcpy(sendData.buffer.get() + 5, data.c_str(), payloadLength);
-    sendData.length = payloadLength + 5;
-
-    m_stream->SendData(sendData.buffer.get(), sendData.length);
+    sendMediaMessage(QUIC_TRACK_PRIORITY_METADATA, TDT_MEDIA_METADATA, data.data(), data.length(), nullptr, 0);
 }
 
 void QuicTransportStream::sendFeedback(const FeedbackMsg& msg) {
-    TransportData sendData;
-    uint32_t payloadLength = sizeof(FeedbackMsg);
-    sendData.buffer.reset(new char[payloadLength + 5]);
-    *(reinterpret_cast<uint32_t*>(sendData.buffer.get())) = htonl(payloadLength + 1);
-    sendData.buffer[4] = TDT_FEEDBACK_MSG;
-    memcpy(sendData.buffer.get() + 5, reinterpret_cast<uint8_t*>(const_cast<FeedbackMsg*>(&msg)),
-           sizeof(FeedbackMsg));
-    sendData.length = payloadLength + 5;
-    ELOG_DEBUG("QuicTransportStream::sendFeedback:%s\n", sendData.buffer.get());
+    sendMediaMessage(QUIC_TRACK_PRIORITY_AUDIO, TDT_FEEDBACK_MSG, reinterpret_cast<const char*>(&msg), sizeof(FeedbackMsg), nullptr, 0);
+}
+
+void QuicTransportStream::sendMediaMessage(QuicTrackPriority priority, char type, const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength)
+{
+    if (m_isTrack) {
+        m_trackMux->send(id, priority, type, header, headerLength, payload, payloadLength);
+    } else {
+        sendMessage(type, header, headerLength, payload, payloadLength);
+    }
+}
+
+void QuicTransportStream::sendMessage(char type, const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength)
+{
+    // Frame and feedback headers fit here, longer ones go as a second write
+    char prefix[5 + 128];
+    uint32_t prefixLength = 5;
+
+    *(reinterpret_cast<uint32_t*>(prefix)) = htonl(headerLength + payloadLength + 1);
+    prefix[4] = type;
+    if (headerLength <= sizeof(prefix) - 5) {
+        memcpy(prefix + 5, header, headerLength);
+        prefixLength += headerLength;
+        headerLength = 0;
+    }
 
-    m_stream->SendData(sendData.buffer.get(), sendData.length);
+    boost::mutex::scoped_lock lock(m_sendMutex);
+    m_stream->SendData(prefix, prefixLength);
+    if (headerLength > 0) {
+        m_stream->SendData(const_cast<char*>(header), headerLength);
+    }
+    if (payloadLength > 0) {
+        m_stream->SendData(const_cast<char*>(payload), payloadLength);
+    }
 }
 
 void QuicTransportStream::OnData(owt::quic::QuicTransportStreamInterface* stream, char* buf, size_t len) {
-    if (m_receivedBytes + len >= m_bufferSize) {
-        m_bufferSize += (m_receivedBytes + len);
-        std::cout << "new_bufferSize: " << m_bufferSize << " for stream id:" << id << std::endl;
-        boost::shared_array<char> new_buffer;
-        new_buffer.reset(new char[m_bufferSize]);
-        if (new_buffer.get()) {
-            memcpy(new_buffer.get(), m_receiveData.buffer.get(), m_receivedBytes);
-            m_receiveData.buffer.reset();
-            m_receiveData.buffer = new_buffer;
-        } else {
-            return;
-        }
+    if (!m_reader.feed(buf, len)) {
+        ELOG_WARN("Drop %zu bytes on broken stream:%d", len, id);
     }
-    memcpy(m_receiveData.buffer.get() + m_receivedBytes, buf, len);
-    m_receivedBytes += len;
-    while (m_receivedBytes >= 4) {
-        uint32_t payloadlen = 0;
-
-        payloadlen = ntohl(*(reinterpret_cast<uint32_t*>(m_receiveData.buffer.get())));
-        uint32_t expectedLen = payloadlen + 4;
-        if (expectedLen > m_receivedBytes) {
-            // continue
-            break;
-        } else {
-            m_receivedBytes -= expectedLen;
-            char* dpos = m_receiveData.buffer.get() + 4;
-            Frame* frame = nullptr;
-            std::string s_data(dpos + 1, payloadlen - 1);
-            owt_base::FeedbackMsg msg {.type = owt_base::VIDEO_FEEDBACK, .cmd = owt_base::REQUEST_KEY_FRAME};
+}
 
-            switch (dpos[0]) {
-                case TDT_MEDIA_FRAME:
-                    //ELOG_DEBUG("QuicTransportStream deliver frame with trackKind: %s", m_trackKind.c_str());
-                    frame = reinterpret_cast<Frame*>(dpos + 1);
-                    frame->payload = reinterpret_cast<uint8_t*>(dpos + 1 + sizeof(Frame));
-                    if (m_trackKind == "video") {
-                      if (m_needKeyFrame) {
-                        if (frame->additionalInfo.video.isKeyFrame) {
-                            m_needKeyFrame = false;
-                        } else {
-                            ELOG_DEBUG("Request key frame\n");
-                            sendFeedback(msg);
-                            return;
-                        }
-                      }
-                    }
-                    //dump(this, frame->payload, frame->length);
-                    deliverFrame(*frame);
-                    break;
-                case TDT_MEDIA_METADATA: {
-                    ELOG_DEBUG("QuicTransportStream::onData with type TDT_MEDIA_METADATA%s", s_data.c_str(), " in stream:%d", id);
-                    //boost::mutex::scoped_lock lock(mutex);
-                    this->data_messages.push(s_data);
-                    m_asyncOnData.data = this;
-                    //uv_async_send(&m_asyncOnData);
-                    if (uv_async_send(&m_asyncOnData) == 0) {
-                        ELOG_INFO("OnData uv_async_send succeed and handle pending is:%d", m_asyncOnData.pending); 
-                    } else {
-                        ELOG_INFO("OnData uv_async_send failed");
-                    };
-                    //lock.unlock();
-                    ELOG_DEBUG("QuicTransportStream::onData with type TDT_MEDIA_METADATA end in stream:%d in thread:%d", id, std::this_thread::get_id());
+void QuicTransportStream::onStreamMessage(char type, const char* data, uint32_t length)
+{
+    switch (type) {
+        case TDT_MEDIA_FRAME: {
+            if (length < sizeof(Frame)) {
+                ELOG_WARN("Short media frame message %u in stream:%d", length, id);
+                break;
+            }
+            // The header may be unaligned in the receive buffer, copy it out
+            // and point the payload at the data in place.
+            Frame frame;
+            memcpy(&frame, data, sizeof(Frame));
+            frame.payload = reinterpret_cast<uint8_t*>(const_cast<char*>(data + sizeof(Frame)));
+            if (frame.length > length - sizeof(Frame)) {
+                ELOG_WARN("Truncated media frame %u/%zu in stream:%d", frame.length, length - sizeof(Frame), id);
+                break;
+            }
+            if (m_trackKind == "video" && m_needKeyFrame) {
+                if (frame.additionalInfo.video.isKeyFrame) {
+                    m_needKeyFrame = false;
+                } else {
+                    ELOG_DEBUG("Request key frame\n");
+                    owt_base::FeedbackMsg msg {.type = owt_base::VIDEO_FEEDBACK, .cmd = owt_base::REQUEST_KEY_FRAME};
+                    sendFeedback(msg);
                     break;
                 }
-                case TDT_FEEDBACK_MSG:
-                    ELOG_DEBUG("QuicTransportStream deliver feedback msg");
-                    deliverFeedbackMsg(msg);
-                    break;
-                default:
-                    break;
             }
-
-            if (m_receivedBytes > 0) {
-                std::cout << "not zero m_receiveBytes" << std::endl;
-                memcpy(m_receiveData.buffer.get(), m_receiveData.buffer.get() + expectedLen, m_receivedBytes);
+            //dump(this, frame.payload, frame.length);
+            deliverFrame(frame);
+            break;
+        }
+        case TDT_MEDIA_METADATA: {
+            ELOG_DEBUG("QuicTransportStream::onData with type TDT_MEDIA_METADATA in stream:%d", id);
+            {
+                boost::mutex::scoped_lock lock(mutex);
+                this->data_messages.push(std::string(data, length));
+            }
+            m_asyncOnData.data = this;
+            if (uv_async_send(&m_asyncOnData) != 0) {
+                ELOG_INFO("OnData uv_async_send failed");
             }
+            break;
+        }
+        case TDT_FEEDBACK_MSG: {
+            ELOG_DEBUG("QuicTransportStream deliver feedback msg");
+            owt_base::FeedbackMsg msg {.type = owt_base::VIDEO_FEEDBACK, .cmd = owt_base::REQUEST_KEY_FRAME};
+            deliverFeedbackMsg(msg);
+            break;
         }
+        case TDT_MUX_TRACK:
+        case TDT_MUX_ACK:
+        case TDT_MUX_CLOSE:
+            if (!m_isTrack) {
+                trackMux()->onCarrierMessage(type, data, length);
+            }
+            break;
+        default:
+            break;
     }
 }
@@ -18,13 +18,15 @@
 #include "../../core/owt_base/MediaFramePipeline.h"
 #include "../common/MediaFramePipelineWrapper.h"
 #include "owt/quic/quic_transport_stream_interface.h"
+#include "QuicStreamFrameReader.h"
+#include "QuicTrackMux.h"
 
 /*
  * Wrapper class of TQuicServer
  *
  * Receives media from one
  */
-class QuicTransportStream : public owt_base::FrameSource, public owt_base::FrameDestination, public owt::quic::QuicTransportStreamInterface::Visitor, public NanFrameNode {
+class QuicTransportStream : public owt_base::FrameSource, public owt_base::FrameDestination, public owt::quic::QuicTransportStreamInterface::Visitor, public NanFrameNode, public QuicTrackCarrier, public QuicTrackListener {
     DECLARE_LOGGER();
 public:
     explicit QuicTransportStream();
@@ -43,10 +45,14 @@ public:
     static NAN_METHOD(send);
     static NAN_METHOD(onStreamData);
     static NAN_METHOD(getId);
+    static NAN_METHOD(createTrack);
+    static NAN_METHOD(onNewTrack);
+    static NAN_METHOD(getTrackMuxStats);
     static NAN_GETTER(trackKindGetter);
     static NAN_SETTER(trackKindSetter);
 
     static NAUV_WORK_CB(onStreamDataCallback);
+    static NAUV_WORK_CB(onNewTrackCallback);
 
 
     // Overrides owt_base::FrameSource.
@@ -62,20 +68,30 @@ public:
 
     void OnData(owt::quic::QuicTransportStreamInterface* stream, char* buf, size_t len) override;
 
+    // Overrides QuicStreamFrameListener.
+    void onStreamMessage(char type, const char* data, uint32_t length) override;
+
     void sendData(const std::string& data);
 
+    // Overrides QuicTrackCarrier, writes the length prefix, type and header,
+    // then the payload as is.
+    void sendMessage(char type, const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength) override;
+    void notifyNewTrack(uint32_t trackId) override;
+
+    // Overrides QuicTrackListener, asks the video source of a track for a key frame.
+    void requestKeyFrame() override;
+
     uint32_t id;
 private:
     void sendFeedback(const owt_base::FeedbackMsg& msg);
-    typedef struct {
-        boost::shared_array<char> buffer;
-        int length;
-    } TransportData;
+    // Tracks go through the mux of their carrier, streams write directly.
+    void sendMediaMessage(QuicTrackPriority priority, char type, const char* header, uint32_t headerLength, const char* payload, uint32_t payloadLength);
+    std::shared_ptr<QuicTrackMux> trackMux();
 
     std::unordered_map<std::string, bool> hasStream_;
-    size_t m_bufferSize;
-    TransportData m_receiveData;
-    uint32_t m_receivedBytes;
+    QuicStreamFrameReader m_reader;
+    // Keeps the pieces of one message together on the stream
+    boost::mutex m_sendMutex;
     uv_async_t m_asyncOnData;
     bool has_data_callback_;
     std::queue<std::string> data_messages;
@@ -86,6 +102,15 @@ private:
     static Nan::Persistent<v8::Function> s_constructor;
     bool m_needKeyFrame;
     std::string m_trackKind;
+
+    // Set on a carrier once tracks are used on it, and on each track
+    boost::mutex m_trackMuxMutex;
+    std::shared_ptr<QuicTrackMux> m_trackMux;
+    bool m_isTrack;
+    uv_async_t m_asyncOnNewTrack;
+    std::queue<uint32_t> m_newTracks;
+    Nan::Callback* track_callback_;
+    Nan::AsyncResource* asyncResourceTrack_;
 };
 
 #endif  // QUIC_TRANSPORT_SERVER_H_
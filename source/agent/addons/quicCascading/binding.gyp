@@ -4,6 +4,8 @@
     'sources': [
       'addon.cc',
       'QuicTransportStream.cc',
+      'QuicStreamFrameReader.cc',
+      'QuicTrackMux.cc',
       'QuicTransportSession.cc',
       'QuicTransportServer.cc',
       'QuicTransportClient.cc',
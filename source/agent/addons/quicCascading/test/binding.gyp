@@ -0,0 +1,60 @@
+{
+  'targets': [{
+    'target_name': 'quicStreamFrameReaderTest',
+    'type': 'executable',
+    'sources': [
+      '../QuicStreamFrameReaderTest.cc',
+      '../QuicStreamFrameReader.cc',
+    ],
+    'include_dirs': [
+        '../../../../core/common/',
+    ],
+    'libraries': [
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  },
+  {
+    'target_name': 'quicTrackMuxTest',
+    'type': 'executable',
+    'sources': [
+      '../QuicTrackMuxTest.cc',
+      '../QuicTrackMux.cc',
+    ],
+    'include_dirs': [
+        '../../../../core/common/',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  }]
+}
@@ -0,0 +1,103 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef BUILDING_NODE_EXTENSION
+#define BUILDING_NODE_EXTENSION
+#endif
+
+#include "TemporalLayerForwarderWrapper.h"
+
+using namespace v8;
+
+Nan::Persistent<Function> TemporalLayerForwarder::constructor;
+
+TemporalLayerForwarder::TemporalLayerForwarder() : parent(nullptr) {}
+TemporalLayerForwarder::~TemporalLayerForwarder() {}
+
+NAN_MODULE_INIT(TemporalLayerForwarder::Init) {
+  // Constructor template
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("TemporalLayerForwarder").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  Nan::SetPrototypeMethod(tpl, "close", close);
+  Nan::SetPrototypeMethod(tpl, "setTargetTemporalId", setTargetTemporalId);
+  Nan::SetPrototypeMethod(tpl, "addDestination", addDestination);
+  Nan::SetPrototypeMethod(tpl, "removeDestination", removeDestination);
+
+  constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
+  Nan::Set(target, Nan::New("TemporalLayerForwarder").ToLocalChecked(),
+           Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+// new TemporalLayerForwarder(source, temporalId)
+NAN_METHOD(TemporalLayerForwarder::New) {
+  if (info.IsConstructCall()) {
+    FrameSource* param = node::ObjectWrap::Unwrap<FrameSource>(
+      info[0]->ToObject(Nan::GetCurrentContext()).ToLocalChecked());
+    int temporalId = Nan::To<int32_t>(info[1]).FromJust();
+
+    TemporalLayerForwarder* obj = new TemporalLayerForwarder();
+    obj->me.reset(new owt_base::TemporalLayerForwarder(temporalId));
+    obj->src = obj->me.get();
+    obj->parent = param->src;
+    if (obj->parent) {
+      obj->parent->addVideoDestination(obj->me.get());
+    }
+
+    obj->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+}
+
+NAN_METHOD(TemporalLayerForwarder::close) {
+  TemporalLayerForwarder* obj = ObjectWrap::Unwrap<TemporalLayerForwarder>(info.Holder());
+  if (obj->parent && obj->me) {
+    obj->parent->removeVideoDestination(obj->me.get());
+  }
+  obj->parent = nullptr;
+  obj->src = nullptr;
+  obj->me.reset();
+}
+
+NAN_METHOD(TemporalLayerForwarder::setTargetTemporalId) {
+  TemporalLayerForwarder* obj = ObjectWrap::Unwrap<TemporalLayerForwarder>(info.Holder());
+  int temporalId = Nan::To<int32_t>(info[0]).FromJust();
+  if (obj->me) {
+    obj->me->setTargetTemporalId(temporalId);
+  }
+}
+
+NAN_METHOD(TemporalLayerForwarder::addDestination) {
+  TemporalLayerForwarder* obj = ObjectWrap::Unwrap<TemporalLayerForwarder>(info.Holder());
+
+  Nan::Utf8String param0(Nan::To<v8::String>(info[0]).ToLocalChecked());
+  std::string track = std::string(*param0);
+
+  FrameDestination* param =
+    ObjectWrap::Unwrap<FrameDestination>(
+      info[1]->ToObject(Nan::GetCurrentContext()).ToLocalChecked());
+  owt_base::FrameDestination* dest = param->dest;
+
+  if (obj->me && track == "video") {
+    obj->me->addVideoDestination(dest);
+  }
+}
+
+NAN_METHOD(TemporalLayerForwarder::removeDestination) {
+  TemporalLayerForwarder* obj = ObjectWrap::Unwrap<TemporalLayerForwarder>(info.Holder());
+
+  Nan::Utf8String param0(Nan::To<v8::String>(info[0]).ToLocalChecked());
+  std::string track = std::string(*param0);
+
+  FrameDestination* param =
+    ObjectWrap::Unwrap<FrameDestination>(
+      info[1]->ToObject(Nan::GetCurrentContext()).ToLocalChecked());
+  owt_base::FrameDestination* dest = param->dest;
+
+  if (obj->me && track == "video") {
+    obj->me->removeVideoDestination(dest);
+  }
+}
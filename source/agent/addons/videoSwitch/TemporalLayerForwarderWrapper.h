@@ -0,0 +1,37 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TEMPORALLAYERFORWARDERWRAPPER_H
+#define TEMPORALLAYERFORWARDERWRAPPER_H
+
+#include "../../addons/common/MediaFramePipelineWrapper.h"
+#include <TemporalLayerForwarder.h>
+#include <nan.h>
+
+#include <memory>
+
+/*
+ * Wrapper class of owt_base::TemporalLayerForwarder
+ */
+class TemporalLayerForwarder : public FrameSource {
+public:
+    static NAN_MODULE_INIT(Init);
+    std::shared_ptr<owt_base::TemporalLayerForwarder> me;
+    owt_base::FrameSource* parent;
+
+private:
+    TemporalLayerForwarder();
+    ~TemporalLayerForwarder();
+
+    static Nan::Persistent<v8::Function> constructor;
+
+    static NAN_METHOD(New);
+    static NAN_METHOD(close);
+    static NAN_METHOD(setTargetTemporalId);
+
+    static NAN_METHOD(addDestination);
+    static NAN_METHOD(removeDestination);
+};
+
+#endif
@@ -24,6 +24,7 @@ NAN_MODULE_INIT(VideoSwitch::Init) {
   // Prototype
   Nan::SetPrototypeMethod(tpl, "close", close);
   Nan::SetPrototypeMethod(tpl, "setTargetBitrate", setTargetBitrate);
+  Nan::SetPrototypeMethod(tpl, "getStats", getStats);
   Nan::SetPrototypeMethod(tpl, "addDestination", addDestination);
   Nan::SetPrototypeMethod(tpl, "removeDestination", removeDestination);
 
@@ -66,6 +67,29 @@ NAN_METHOD(VideoSwitch::setTargetBitrate) {
   obj->me->setTargetBitrate(bitrate);
 }
 
+NAN_METHOD(VideoSwitch::getStats) {
+  VideoSwitch* obj = ObjectWrap::Unwrap<VideoSwitch>(info.Holder());
+  if (!obj->me) {
+    return;
+  }
+
+  owt_base::VideoQualitySwitchStats stats;
+  obj->me->getStats(stats);
+
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("currentLayer").ToLocalChecked(), Nan::New(stats.currentLayer));
+  Nan::Set(result, Nan::New("estimatedBps").ToLocalChecked(), Nan::New(stats.estimatedBps));
+  Nan::Set(result, Nan::New("switchCount").ToLocalChecked(), Nan::New(stats.switchCount));
+  Nan::Set(result, Nan::New("failedSwitchCount").ToLocalChecked(), Nan::New(stats.failedSwitchCount));
+  Nan::Set(result, Nan::New("lastSwitchLatencyMs").ToLocalChecked(), Nan::New(stats.lastSwitchLatencyMs));
+  Nan::Set(result, Nan::New("maxSwitchLatencyMs").ToLocalChecked(), Nan::New(stats.maxSwitchLatencyMs));
+  Nan::Set(result, Nan::New("avgSwitchLatencyMs").ToLocalChecked(), Nan::New(stats.avgSwitchLatencyMs));
+  Nan::Set(result, Nan::New("freezeCount").ToLocalChecked(), Nan::New(stats.freezeCount));
+  Nan::Set(result, Nan::New("totalFreezeMs").ToLocalChecked(),
+           Nan::New(static_cast<double>(stats.totalFreezeMs)));
+  info.GetReturnValue().Set(result);
+}
+
 NAN_METHOD(VideoSwitch::addDestination) {
   VideoSwitch* obj = ObjectWrap::Unwrap<VideoSwitch>(info.Holder());
 
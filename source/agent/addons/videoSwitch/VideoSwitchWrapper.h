@@ -28,6 +28,7 @@ private:
     static NAN_METHOD(New);
     static NAN_METHOD(close);
     static NAN_METHOD(setTargetBitrate);
+    static NAN_METHOD(getStats);
 
     static NAN_METHOD(addDestination);
     static NAN_METHOD(removeDestination);
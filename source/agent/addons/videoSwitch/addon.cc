@@ -2,6 +2,7 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "TemporalLayerForwarderWrapper.h"
 #include "VideoSwitchWrapper.h"
 
 #include <node.h>
@@ -10,6 +11,7 @@ using namespace v8;
 
 void InitAll(Local<Object> exports) {
   VideoSwitch::Init(exports);
+  TemporalLayerForwarder::Init(exports);
 }
 
 NODE_MODULE(addon, InitAll)
@@ -4,8 +4,11 @@
     'sources': [
       'addon.cc',
       'VideoSwitchWrapper.cc',
+      'TemporalLayerForwarderWrapper.cc',
       '../../../core/owt_base/MediaFramePipeline.cpp',
+      '../../../core/owt_base/NalScanner.cpp',
       '../../../core/owt_base/selector/VideoQualitySwitch.cpp',
+      '../../../core/owt_base/selector/TemporalLayerForwarder.cpp',
     ],
     'include_dirs': [
       "<!(node -e \"require('nan')\")",
@@ -0,0 +1,69 @@
+{
+  'targets': [{
+    'target_name': 'videoQualitySwitchTest',
+    'type': 'executable',
+    'sources': [
+      '../../../../core/owt_base/selector/VideoQualitySwitchTest.cpp',
+      '../../../../core/owt_base/selector/VideoQualitySwitch.cpp',
+      '../../../../core/owt_base/MediaFramePipeline.cpp',
+    ],
+    'include_dirs': [
+        '../../../../core/common/',
+        '../../../../core/owt_base/',
+        '../../../../core/owt_base/selector/',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  },
+  {
+    'target_name': 'temporalLayerForwarderTest',
+    'type': 'executable',
+    'sources': [
+      '../../../../core/owt_base/selector/TemporalLayerForwarderTest.cpp',
+      '../../../../core/owt_base/selector/TemporalLayerForwarder.cpp',
+      '../../../../core/owt_base/NalScanner.cpp',
+      '../../../../core/owt_base/MediaFramePipeline.cpp',
+    ],
+    'include_dirs': [
+        '../../../../core/common/',
+        '../../../../core/owt_base/',
+        '../../../../core/owt_base/selector/',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  }]
+}
@@ -107,6 +107,8 @@ void AcmDecoder::onFrame(const Frame& frame)
         return;
     }
 
+    updateVoiceActivity(frame);
+
     memset(&rtp_header, 0, sizeof(WebRtcRTPHeader));
     rtp_header.frameType = kAudioFrameSpeech;
 
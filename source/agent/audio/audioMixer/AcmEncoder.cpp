@@ -20,6 +20,7 @@ AcmEncoder::AcmEncoder(const FrameFormat format)
     , m_valid(false)
     , m_running(false)
     , m_incomingFrameCount(0)
+    , m_timestamp(0)
 {
     AudioCodingModule::Config config;
     m_audioCodingModule.reset(AudioCodingModule::Create(config));
@@ -104,6 +105,9 @@ bool AcmEncoder::addAudioFrame(const AudioFrame* audioFrame)
         boost::mutex::scoped_lock lock(m_mutex);
 
         m_frame->CopyFrom(*audioFrame);
+        m_frame->timestamp_ = m_timestamp;
+        m_timestamp += audioFrame->samples_per_channel_;
+        m_dtx.onVoice();
 
         if (m_incomingFrameCount > 1)
             ELOG_DEBUG_T("Too many pending frames(%d)", m_incomingFrameCount);
@@ -118,6 +122,56 @@ bool AcmEncoder::addAudioFrame(const AudioFrame* audioFrame)
     return true;
 }
 
+bool AcmEncoder::addSilentFrame()
+{
+    if (!m_valid)
+        return false;
+
+    uint8_t dtx;
+    uint32_t timestamp;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (m_frame->samples_per_channel_ == 0)
+            return false;
+
+        if (m_format != FRAME_FORMAT_OPUS) {
+            // No dtx for other codecs, encode silence as comfort noise
+            memset(m_frame->data_, 0, m_frame->samples_per_channel_ * m_frame->num_channels_ * sizeof(int16_t));
+            m_frame->timestamp_ = m_timestamp;
+            m_timestamp += m_frame->samples_per_channel_;
+
+            m_incomingFrameCount++;
+            m_cond.notify_one();
+            return true;
+        }
+
+        // Keep input timestamp running, so acm carries the gap into rtp timestamp on resume
+        m_timestamp += m_frame->samples_per_channel_;
+
+        if (!m_dtx.onSilence(m_rtpSampleRate, dtx, timestamp))
+            return false;
+    }
+
+    // Delivered without the lock, SendData takes it too
+    owt_base::Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.format = m_format;
+    frame.additionalInfo.audio.sampleRate = getAudioSampleRate(frame.format);
+    frame.additionalInfo.audio.channels = getAudioChannels(frame.format);
+    frame.payload = &dtx;
+    frame.length = 1;
+    frame.timeStamp = timestamp;
+
+    ELOG_TRACE_T("deliverFrame(%s), dtx, timeStamp(%d)",
+            getFormatStr(frame.format),
+            frame.timeStamp * 1000 / m_rtpSampleRate
+            );
+
+    deliverFrame(frame);
+    return false;
+}
+
 void AcmEncoder::encodeLoop()
 {
     while (true) {
@@ -166,6 +220,13 @@ int32_t AcmEncoder::SendData(FrameType frame_type,
         return -1;
     }
 
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (m_format == FRAME_FORMAT_OPUS)
+            m_dtx.onPacket(payload_data[0], timestamp);
+    }
+
     owt_base::Frame frame;
     memset(&frame, 0, sizeof(frame));
     frame.format = m_format;
@@ -15,6 +15,7 @@
 
 #include "MediaFramePipeline.h"
 #include "AudioEncoder.h"
+#include "OpusDtx.h"
 
 namespace mcu {
 using namespace owt_base;
@@ -30,6 +31,7 @@ public:
 
     bool init() override;
     bool addAudioFrame(const AudioFrame *audioFrame) override;
+    bool addSilentFrame() override;
 
     // Implements AudioPacketizationCallback
     int32_t SendData(FrameType frame_type,
@@ -56,6 +58,9 @@ private:
 
     uint32_t m_incomingFrameCount;
     boost::shared_ptr<AudioFrame> m_frame;
+
+    uint32_t m_timestamp;
+    OpusDtx m_dtx;
 };
 
 } /* namespace mcu */
@@ -120,4 +120,17 @@ void AcmmBroadcastGroup::NewMixedAudio(const webrtc::AudioFrame *audioFrame)
     }
 }
 
+uint32_t AcmmBroadcastGroup::NewSilentAudio()
+{
+    uint32_t skipped = 0;
+
+    for (auto& it : m_outputMap) {
+        boost::shared_ptr<AcmmOutput> output = it.second;
+        if (output->newSilentFrame())
+            skipped++;
+    }
+
+    return skipped;
+}
+
 } /* namespace mcu */
@@ -33,6 +33,7 @@ public:
 
     int32_t NeededFrequency();
     void NewMixedAudio(const AudioFrame* audioFrame);
+    uint32_t NewSilentAudio();
 
 protected:
     bool getFreeOutputId(uint16_t *id);
@@ -4,6 +4,8 @@
 
 #include "AcmmFrameMixer.h"
 
+#include "AudioTime.h"
+
 namespace mcu {
 
 static inline AudioConferenceMixer::Frequency convert2Frequency(int32_t freq)
@@ -32,6 +34,9 @@ AcmmFrameMixer::AcmmFrameMixer()
     : m_asyncHandle(NULL)
     , m_vadEnabled(false)
     , m_frequency(0)
+    , m_idle(false)
+    , m_skippedMixCount(0)
+    , m_skippedEncodeCount(0)
 {
     m_mixerModule.reset(AudioConferenceMixer::Create(0));
     m_mixerModule->RegisterMixedStreamCallback(this);
@@ -45,12 +50,13 @@ AcmmFrameMixer::AcmmFrameMixer()
     m_groupIds[0] = false;
     m_broadcastGroup.reset(new AcmmBroadcastGroup());
 
-    m_jobTimer.reset(new JobTimer(MIXER_FREQUENCY, this));
+    m_scheduler = AudioMixScheduler::GetSharedScheduler(MIXER_FREQUENCY);
+    m_scheduler->addMixer(this);
 }
 
 AcmmFrameMixer::~AcmmFrameMixer()
 {
-    m_jobTimer->stop();
+    m_scheduler->removeMixer(this);
 
     boost::unique_lock<boost::shared_mutex> lock(m_mutex);
 
@@ -117,6 +123,30 @@ void AcmmFrameMixer::setEventRegistry(EventRegistry* handle)
     m_asyncHandle = handle;
 }
 
+void AcmmFrameMixer::getStats(AudioFrameMixerStats& stats)
+{
+    MixCostStats cost;
+    MixSchedulerStats schedulerStats;
+
+    // Query scheduler before locking, its worker holds own lock while mixing
+    if (!m_scheduler->getMixCost(this, cost)) {
+        cost.avgUs = 0;
+        cost.maxUs = 0;
+    }
+    m_scheduler->getStats(schedulerStats);
+
+    stats.avgMixCostUs = cost.avgUs;
+    stats.maxMixCostUs = cost.maxUs;
+    stats.tickCount = schedulerStats.tickCount;
+    stats.tickOverrunCount = schedulerStats.overrunCount;
+
+    boost::upgrade_lock<boost::shared_mutex> lock(m_mutex);
+
+    stats.idle = m_idle;
+    stats.skippedMixCount = m_skippedMixCount;
+    stats.skippedEncodeCount = m_skippedEncodeCount;
+}
+
 void AcmmFrameMixer::enableVAD(uint32_t period)
 {
     boost::unique_lock<boost::shared_mutex> lock(m_mutex);
@@ -492,9 +522,54 @@ void AcmmFrameMixer::onTimeout()
 void AcmmFrameMixer::performMix()
 {
     boost::upgrade_lock<boost::shared_mutex> lock(m_mutex);
+
+    if (allInputsSilent()) {
+        if (!m_idle) {
+            ELOG_DEBUG("Enter idle, skipped mix(%lu), skipped encode(%lu)", m_skippedMixCount, m_skippedEncodeCount);
+            m_idle = true;
+        }
+
+        performIdle();
+        return;
+    }
+
+    if (m_idle) {
+        ELOG_DEBUG("Leave idle, skipped mix(%lu), skipped encode(%lu)", m_skippedMixCount, m_skippedEncodeCount);
+        m_idle = false;
+    }
+
     m_mixerModule->Process();
 }
 
+void AcmmFrameMixer::performIdle()
+{
+    for (auto& p : m_groups) {
+        boost::shared_ptr<AcmmGroup> acmmGroup = p.second;
+
+        // Keep decoders' jitter buffers from piling up while not mixing
+        acmmGroup->drainInputs(&m_drainFrame);
+
+        if (acmmGroup->numOfOutputs()) {
+            m_skippedEncodeCount += acmmGroup->NewSilentAudio();
+        }
+    }
+
+    m_skippedEncodeCount += m_broadcastGroup->NewSilentAudio();
+    m_skippedMixCount++;
+}
+
+bool AcmmFrameMixer::allInputsSilent()
+{
+    int64_t since = AudioTime::currentTime() - SILENCE_HANGOVER_MS;
+
+    for (auto& p : m_groups) {
+        if (!p.second->allInputsSilent(since))
+            return false;
+    }
+
+    return true;
+}
+
 void AcmmFrameMixer::NewMixedAudio(int32_t id,
         const AudioFrame& generalAudioFrame,
         const AudioFrame** uniqueAudioFrames,
@@ -579,7 +654,7 @@ void AcmmFrameMixer::VadParticipants(const ParticipantVadStatistics *statistics,
                 , activeAcmmInput->name().c_str());
 
         m_mostActiveInput = activeAcmmInput;
-        m_asyncHandle->notifyAsyncEvent("vad", m_mostActiveInput->name().c_str());
+        m_asyncHandle->notifyCoalescedAsyncEvent("vad", "", m_mostActiveInput->name());
     }
 }
 
@@ -20,6 +20,7 @@
 #include "AcmmBroadcastGroup.h"
 #include "AcmmGroup.h"
 #include "AcmmInput.h"
+#include "AudioMixScheduler.h"
 
 namespace mcu {
 
@@ -32,6 +33,8 @@ class AcmmFrameMixer : public AudioFrameMixer,
 
     static const int32_t MAX_GROUPS = 10240;
     static const int32_t MIXER_FREQUENCY = 100;
+    // Keep mixing a while after the last voice, also covers jitter buffer delay
+    static const int32_t SILENCE_HANGOVER_MS = 500;
 
     struct OutputInfo {
         owt_base::FrameFormat format;
@@ -57,6 +60,8 @@ public:
 
     void setEventRegistry(EventRegistry* handle) override;
 
+    void getStats(AudioFrameMixerStats& stats) override;
+
     // Implements JobTimerListener
     void onTimeout() override;
 
@@ -74,6 +79,9 @@ public:
 
 protected:
     void performMix();
+    void performIdle();
+
+    bool allInputsSilent();
 
     bool getFreeGroupId(uint16_t *id);
 
@@ -89,7 +97,7 @@ protected:
 
 private:
     EventRegistry *m_asyncHandle;
-    boost::scoped_ptr<JobTimer> m_jobTimer;
+    boost::shared_ptr<AudioMixScheduler> m_scheduler;
     boost::shared_ptr<AudioConferenceMixer> m_mixerModule;
 
     std::map<AcmmOutput*, OutputInfo> m_outputInfoMap;
@@ -103,6 +111,11 @@ private:
     bool m_vadEnabled;
     boost::shared_ptr<AcmmInput> m_mostActiveInput;
     int32_t m_frequency;
+
+    bool m_idle;
+    uint64_t m_skippedMixCount;
+    uint64_t m_skippedEncodeCount;
+    AudioFrame m_drainFrame;
 };
 
 } /* namespace mcu */
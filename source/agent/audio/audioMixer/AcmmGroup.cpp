@@ -192,6 +192,23 @@ bool AcmmGroup::anyOutputsConnected()
     return false;
 }
 
+bool AcmmGroup::allInputsSilent(int64_t since)
+{
+    for (auto& it : m_inputs) {
+        if (!it.second->isSilent(since))
+            return false;
+    }
+
+    return true;
+}
+
+void AcmmGroup::drainInputs(AudioFrame* audioFrame)
+{
+    for (auto& it : m_inputs) {
+        it.second->drainAudioFrame(audioFrame);
+    }
+}
+
 int32_t AcmmGroup::NeededFrequency()
 {
     int32_t neededFreq = 0;
@@ -223,4 +240,17 @@ void AcmmGroup::NewMixedAudio(const AudioFrame* audioFrame)
     }
 }
 
+uint32_t AcmmGroup::NewSilentAudio()
+{
+    uint32_t skipped = 0;
+
+    for (auto& it : m_outputs) {
+        boost::shared_ptr<AcmmOutput> output = it.second;
+        if (output->newSilentFrame())
+            skipped++;
+    }
+
+    return skipped;
+}
+
 } /* namespace mcu */
@@ -51,9 +51,13 @@ public:
 
     bool allInputsMuted();
     bool anyOutputsConnected();
+    bool allInputsSilent(int64_t since);
+
+    void drainInputs(AudioFrame* audioFrame);
 
     int32_t NeededFrequency();
     void NewMixedAudio(const AudioFrame* audioFrame);
+    uint32_t NewSilentAudio();
 
 protected:
     bool getFreeInputId(uint16_t *id);
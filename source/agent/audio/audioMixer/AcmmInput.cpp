@@ -85,6 +85,24 @@ void AcmmInput::setActive(bool active)
     m_active = active;
 }
 
+bool AcmmInput::isSilent(int64_t since)
+{
+    if (!m_active || !m_decoder)
+        return true;
+
+    return m_decoder->lastVoiceTime() < since;
+}
+
+void AcmmInput::drainAudioFrame(AudioFrame* audioFrame)
+{
+    if (!m_active || !m_decoder)
+        return;
+
+    // Pull at decoder's native rate, the frame is dropped anyway
+    audioFrame->sample_rate_hz_ = -1;
+    m_decoder->getAudioFrame(audioFrame);
+}
+
 int32_t AcmmInput::GetAudioFrame(int32_t id, AudioFrame* audio_frame)
 {
     if (!m_active)
@@ -38,6 +38,9 @@ public:
 
     void setActive(bool active);
 
+    bool isSilent(int64_t since);
+    void drainAudioFrame(AudioFrame* audioFrame);
+
     // Implements MixerParticipant
     int32_t GetAudioFrame(int32_t id, AudioFrame* audioFrame) override;
     int32_t NeededFrequency(int32_t id) const override;
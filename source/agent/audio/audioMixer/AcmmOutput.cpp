@@ -123,4 +123,13 @@ bool AcmmOutput::newAudioFrame(const webrtc::AudioFrame *audioFrame)
     return true;
 }
 
+// Returns true if encoding is skipped
+bool AcmmOutput::newSilentFrame()
+{
+    if (!m_destinations.size() || !m_encoder)
+        return false;
+
+    return !m_encoder->addSilentFrame();
+}
+
 } /* namespace mcu */
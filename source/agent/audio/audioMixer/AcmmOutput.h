@@ -37,6 +37,7 @@ public:
 
     int32_t NeededFrequency();
     bool newAudioFrame(const webrtc::AudioFrame *audioFrame);
+    bool newSilentFrame();
 
 private:
     int32_t m_id;
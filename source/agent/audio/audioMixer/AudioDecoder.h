@@ -5,13 +5,18 @@
 #ifndef AudioDecoder_h
 #define AudioDecoder_h
 
+#include <atomic>
+
 #include <webrtc/modules/include/module_common_types.h>
 #include "MediaFramePipeline.h"
 
+#include "AudioTime.h"
+
 namespace mcu {
 
 class AudioDecoder : public owt_base::FrameDestination {
 public:
+    AudioDecoder() : m_lastVoiceTime(0) { }
     virtual ~AudioDecoder() { }
 
     virtual bool init() = 0;
@@ -19,6 +24,24 @@ public:
 
     // Implements owt_base::FrameDestination
     virtual void onFrame(const owt_base::Frame& frame) = 0;
+
+    // Time(ms) of the last received frame with voice activity, 0 if none
+    int64_t lastVoiceTime() {return m_lastVoiceTime;}
+
+protected:
+    // RFC 6464 level in -dBov, 127 means digital silence
+    static const uint8_t SILENT_AUDIO_LEVEL = 90;
+
+    // Frames without audio level extension have level 0 and are always taken as voice
+    void updateVoiceActivity(const owt_base::Frame& frame)
+    {
+        if (frame.additionalInfo.audio.voice
+                || frame.additionalInfo.audio.audioLevel < SILENT_AUDIO_LEVEL)
+            m_lastVoiceTime = AudioTime::currentTime();
+    }
+
+private:
+    std::atomic<int64_t> m_lastVoiceTime;
 };
 
 } /* namespace mcu */
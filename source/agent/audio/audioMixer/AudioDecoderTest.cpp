@@ -0,0 +1,79 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE AudioDecoder
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+
+#include "AudioDecoder.h"
+
+class TestDecoder : public mcu::AudioDecoder {
+public:
+    bool init() override { return true; }
+    bool getAudioFrame(webrtc::AudioFrame*) override { return false; }
+    void onFrame(const owt_base::Frame& frame) override { updateVoiceActivity(frame); }
+};
+
+struct VoiceFrame
+{
+    TestDecoder decoder;
+    owt_base::Frame frame;
+
+    VoiceFrame()
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.format = owt_base::FRAME_FORMAT_OPUS;
+    }
+
+    bool voiceAfter(uint8_t voice, uint8_t audioLevel)
+    {
+        int64_t before = mcu::AudioTime::currentTime();
+        frame.additionalInfo.audio.voice = voice;
+        frame.additionalInfo.audio.audioLevel = audioLevel;
+        decoder.onFrame(frame);
+        return decoder.lastVoiceTime() >= before;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(VoiceActivity, VoiceFrame)
+
+BOOST_AUTO_TEST_CASE(NoVoiceInitially)
+{
+    BOOST_CHECK(decoder.lastVoiceTime() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(SilentLevelWithoutVFlag)
+{
+    // Digital silence and levels at or below the threshold are not voice
+    BOOST_CHECK(!voiceAfter(0, 127));
+    BOOST_CHECK(!voiceAfter(0, 90));
+    BOOST_CHECK(decoder.lastVoiceTime() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(LoudLevelWithoutVFlag)
+{
+    BOOST_CHECK(voiceAfter(0, 89));
+    BOOST_CHECK(voiceAfter(0, 30));
+}
+
+BOOST_AUTO_TEST_CASE(VFlagOverridesLevel)
+{
+    // The sender's VAD decision wins even for a quiet level
+    BOOST_CHECK(voiceAfter(1, 127));
+}
+
+BOOST_AUTO_TEST_CASE(NoLevelExtension)
+{
+    // Without the extension the level stays 0, always taken as voice
+    BOOST_CHECK(voiceAfter(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(SilenceKeepsLastVoiceTime)
+{
+    BOOST_CHECK(voiceAfter(1, 127));
+    int64_t last = decoder.lastVoiceTime();
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+    BOOST_CHECK(!voiceAfter(0, 127));
+    BOOST_CHECK(decoder.lastVoiceTime() == last);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
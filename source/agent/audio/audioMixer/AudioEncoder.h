@@ -16,6 +16,8 @@ public:
 
     virtual bool init() = 0;
     virtual bool addAudioFrame(const webrtc::AudioFrame *audioFrame) = 0;
+    // Called instead of addAudioFrame for every 10ms the mixer idles, returns false if nothing is encoded
+    virtual bool addSilentFrame() = 0;
 };
 
 } /* namespace mcu */
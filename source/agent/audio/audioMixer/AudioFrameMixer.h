@@ -11,6 +11,17 @@
 
 namespace mcu {
 
+struct AudioFrameMixerStats {
+    bool idle;
+    uint64_t skippedMixCount;
+    uint64_t skippedEncodeCount;
+    uint32_t avgMixCostUs;
+    uint32_t maxMixCostUs;
+    // Shared by all mixers in the agent
+    uint64_t tickCount;
+    uint64_t tickOverrunCount;
+};
+
 class AudioFrameMixer {
 public:
     virtual ~AudioFrameMixer() {}
@@ -28,6 +39,8 @@ public:
     virtual void removeOutput(const std::string& group, const std::string& outStream) = 0;
 
     virtual void setEventRegistry(EventRegistry* handle) = 0;
+
+    virtual void getStats(AudioFrameMixerStats& stats) = 0;
 };
 
 } /* namespace mcu */
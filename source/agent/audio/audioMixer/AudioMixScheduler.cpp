@@ -0,0 +1,182 @@
+// Copyright (C) <2019> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <chrono>
+
+#include "AudioMixScheduler.h"
+
+namespace mcu {
+
+DEFINE_LOGGER(AudioMixScheduler, "mcu.media.AudioMixScheduler");
+
+AudioMixScheduler::AudioMixScheduler(uint32_t frequency, uint32_t workers)
+    : m_tickCount(0)
+    , m_overrunCount(0)
+{
+    ELOG_INFO("AudioMixScheduler, frequency(%u), workers(%u)", frequency, workers);
+
+    for (uint32_t i = 0; i < workers; i++) {
+        boost::shared_ptr<Worker> worker(new Worker());
+        worker->service = std::make_shared<owt_base::IOService>();
+        m_workers.push_back(worker);
+    }
+
+    m_jobTimer.reset(new JobTimer(frequency, this));
+}
+
+AudioMixScheduler::~AudioMixScheduler()
+{
+    m_jobTimer->stop();
+    m_workers.clear();
+}
+
+boost::shared_ptr<AudioMixScheduler> AudioMixScheduler::GetSharedScheduler(uint32_t frequency)
+{
+    static boost::mutex schedulersMutex;
+    static std::map<uint32_t, boost::shared_ptr<AudioMixScheduler>> sharedSchedulers;
+
+    boost::mutex::scoped_lock lock(schedulersMutex);
+    if (sharedSchedulers.find(frequency) == sharedSchedulers.end()) {
+        uint32_t workers = boost::thread::hardware_concurrency() / 2;
+        if (workers < 1)
+            workers = 1;
+        if (workers > MAX_WORKERS)
+            workers = MAX_WORKERS;
+
+        sharedSchedulers[frequency].reset(new AudioMixScheduler(frequency, workers));
+    }
+
+    return sharedSchedulers[frequency];
+}
+
+void AudioMixScheduler::addMixer(JobTimerListener* mixer)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (m_entries.find(mixer) != m_entries.end()) {
+        ELOG_WARN("Mixer(%p) already added", mixer);
+        return;
+    }
+
+    // Place on the worker with the fewest mixers
+    uint32_t index = 0;
+    for (uint32_t i = 1; i < m_workers.size(); i++) {
+        if (m_workers[i]->mixers.size() < m_workers[index]->mixers.size())
+            index = i;
+    }
+
+    boost::shared_ptr<MixerEntry> entry(new MixerEntry());
+    entry->mixer = mixer;
+    entry->worker = index;
+    entry->avgUs = 0;
+    entry->maxUs = 0;
+    m_entries[mixer] = entry;
+
+    {
+        boost::mutex::scoped_lock workerLock(m_workers[index]->mutex);
+        m_workers[index]->mixers.push_back(entry);
+    }
+
+    ELOG_DEBUG("addMixer(%p), worker(%u), mixers(%ld)", mixer, index, m_entries.size());
+}
+
+void AudioMixScheduler::removeMixer(JobTimerListener* mixer)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    auto it = m_entries.find(mixer);
+    if (it == m_entries.end()) {
+        ELOG_WARN("Mixer(%p) not found", mixer);
+        return;
+    }
+
+    boost::shared_ptr<MixerEntry> entry = it->second;
+    m_entries.erase(it);
+
+    {
+        boost::shared_ptr<Worker> worker = m_workers[entry->worker];
+        boost::mutex::scoped_lock workerLock(worker->mutex);
+        for (auto i = worker->mixers.begin(); i != worker->mixers.end(); ++i) {
+            if (*i == entry) {
+                worker->mixers.erase(i);
+                break;
+            }
+        }
+    }
+
+    ELOG_DEBUG("removeMixer(%p), worker(%u), mixers(%ld)", mixer, entry->worker, m_entries.size());
+}
+
+bool AudioMixScheduler::getMixCost(JobTimerListener* mixer, MixCostStats& stats)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    auto it = m_entries.find(mixer);
+    if (it == m_entries.end())
+        return false;
+
+    boost::shared_ptr<MixerEntry> entry = it->second;
+    boost::mutex::scoped_lock workerLock(m_workers[entry->worker]->mutex);
+    stats.avgUs = entry->avgUs;
+    stats.maxUs = entry->maxUs;
+    entry->maxUs = 0;
+
+    return true;
+}
+
+void AudioMixScheduler::getStats(MixSchedulerStats& stats)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    stats.workers = m_workers.size();
+    stats.mixers = m_entries.size();
+    stats.tickCount = m_tickCount;
+    stats.overrunCount = m_overrunCount;
+}
+
+void AudioMixScheduler::onTimeout()
+{
+    bool overrun = false;
+
+    m_tickCount++;
+    for (uint32_t i = 0; i < m_workers.size(); i++) {
+        // Skip the worker still busy with last tick instead of queuing up
+        if (m_workers[i]->busy.exchange(true)) {
+            overrun = true;
+            continue;
+        }
+
+        m_workers[i]->service->post(boost::bind(&AudioMixScheduler::runWorker, this, i));
+    }
+
+    if (overrun) {
+        uint64_t count = ++m_overrunCount;
+        if (count == 1 || count % 1000 == 0)
+            ELOG_WARN("Mix tick overrun(%lu) in %lu ticks, agent is saturated", count, (uint64_t)m_tickCount);
+    }
+}
+
+void AudioMixScheduler::runWorker(uint32_t index)
+{
+    Worker* worker = m_workers[index].get();
+
+    {
+        boost::mutex::scoped_lock lock(worker->mutex);
+
+        for (auto& entry : worker->mixers) {
+            auto start = std::chrono::steady_clock::now();
+            entry->mixer->onTimeout();
+            uint32_t cost = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+
+            entry->avgUs = entry->avgUs ? (entry->avgUs * 7 + cost) / 8 : cost;
+            if (cost > entry->maxUs)
+                entry->maxUs = cost;
+        }
+    }
+
+    worker->busy = false;
+}
+
+} /* namespace mcu */
@@ -0,0 +1,90 @@
+// Copyright (C) <2019> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef AudioMixScheduler_h
+#define AudioMixScheduler_h
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <logger.h>
+#include <JobTimer.h>
+#include <IOService.h>
+
+namespace mcu {
+
+struct MixCostStats {
+    uint32_t avgUs;
+    uint32_t maxUs; // since last query
+};
+
+struct MixSchedulerStats {
+    uint32_t workers;
+    uint32_t mixers;
+    uint64_t tickCount;
+    uint64_t overrunCount;
+};
+
+// Drives all mixers in the agent from one aligned tick,
+// mixers are partitioned across a fixed set of workers
+class AudioMixScheduler : public JobTimerListener {
+    DECLARE_LOGGER();
+
+    static const uint32_t MAX_WORKERS = 8;
+
+    struct MixerEntry {
+        JobTimerListener* mixer;
+        uint32_t worker;
+        uint32_t avgUs;
+        uint32_t maxUs;
+    };
+
+    struct Worker {
+        Worker() : busy(false) {}
+
+        // Held during a batch, so a removed mixer is never called afterwards
+        boost::mutex mutex;
+        std::vector<boost::shared_ptr<MixerEntry>> mixers;
+        std::atomic<bool> busy;
+        // Last member, its thread is joined before others are destroyed
+        std::shared_ptr<owt_base::IOService> service;
+    };
+
+public:
+    AudioMixScheduler(uint32_t frequency, uint32_t workers);
+    ~AudioMixScheduler();
+
+    static boost::shared_ptr<AudioMixScheduler> GetSharedScheduler(uint32_t frequency);
+
+    void addMixer(JobTimerListener* mixer);
+    void removeMixer(JobTimerListener* mixer);
+
+    bool getMixCost(JobTimerListener* mixer, MixCostStats& stats);
+    void getStats(MixSchedulerStats& stats);
+
+    // Implements JobTimerListener
+    void onTimeout() override;
+
+protected:
+    void runWorker(uint32_t index);
+
+private:
+    boost::mutex m_mutex;
+    std::map<JobTimerListener*, boost::shared_ptr<MixerEntry>> m_entries;
+    std::vector<boost::shared_ptr<Worker>> m_workers;
+
+    std::atomic<uint64_t> m_tickCount;
+    std::atomic<uint64_t> m_overrunCount;
+
+    boost::scoped_ptr<JobTimer> m_jobTimer;
+};
+
+} /* namespace mcu */
+
+#endif /* AudioMixScheduler_h */
@@ -54,6 +54,11 @@ void AudioMixer::setEventRegistry(EventRegistry *handle)
     m_mixer->setEventRegistry(handle);
 }
 
+void AudioMixer::getStats(AudioFrameMixerStats& stats)
+{
+    m_mixer->getStats(stats);
+}
+
 void AudioMixer::enableVAD(uint32_t period)
 {
     m_mixer->enableVAD(period);
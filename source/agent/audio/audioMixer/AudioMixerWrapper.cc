@@ -30,6 +30,7 @@ void AudioMixer::Init(Local<Object> exports, Local<Object> module) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "setInputActive", setInputActive);
   NODE_SET_PROTOTYPE_METHOD(tpl, "addOutput", addOutput);
   NODE_SET_PROTOTYPE_METHOD(tpl, "removeOutput", removeOutput);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "getStats", getStats);
 
 
   constructor.Reset(isolate, Nan::GetFunction(tpl).ToLocalChecked());
@@ -182,3 +183,31 @@ void AudioMixer::removeOutput(const v8::FunctionCallbackInfo<v8::Value>& args) {
 
   me->removeOutput(endpointID, streamID);
 }
+
+void AudioMixer::getStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  Isolate* isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  AudioMixer* obj = ObjectWrap::Unwrap<AudioMixer>(args.Holder());
+  mcu::AudioMixer* me = obj->me;
+  if (me == nullptr)
+    return;
+
+  mcu::AudioFrameMixerStats stats;
+  me->getStats(stats);
+
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("idle").ToLocalChecked(), Nan::New(stats.idle));
+  Nan::Set(result, Nan::New("skippedMix").ToLocalChecked(),
+           Nan::New(static_cast<double>(stats.skippedMixCount)));
+  Nan::Set(result, Nan::New("skippedEncode").ToLocalChecked(),
+           Nan::New(static_cast<double>(stats.skippedEncodeCount)));
+  Nan::Set(result, Nan::New("avgMixCostUs").ToLocalChecked(), Nan::New(stats.avgMixCostUs));
+  Nan::Set(result, Nan::New("maxMixCostUs").ToLocalChecked(), Nan::New(stats.maxMixCostUs));
+  Nan::Set(result, Nan::New("ticks").ToLocalChecked(),
+           Nan::New(static_cast<double>(stats.tickCount)));
+  Nan::Set(result, Nan::New("tickOverruns").ToLocalChecked(),
+           Nan::New(static_cast<double>(stats.tickOverrunCount)));
+
+  args.GetReturnValue().Set(result);
+}
@@ -355,6 +355,8 @@ void FfDecoder::onFrame(const Frame& frame)
         return;
     }
 
+    updateVoiceActivity(frame);
+
     if (!m_decCtx) {
         if (!initDecoder(frame.format, frame.additionalInfo.audio.sampleRate, frame.additionalInfo.audio.channels)) {
             m_valid = false;
@@ -286,6 +286,23 @@ bool FfEncoder::addAudioFrame(const AudioFrame* audioFrame)
     return true;
 }
 
+bool FfEncoder::addSilentFrame()
+{
+    if (!m_valid)
+        return false;
+
+    // Muxers expect continuous aac stream, so silence is still encoded
+    if (!m_silentFrame) {
+        m_silentFrame.reset(new AudioFrame());
+        m_silentFrame->sample_rate_hz_ = m_sampleRate;
+        m_silentFrame->num_channels_ = m_channels;
+        m_silentFrame->samples_per_channel_ = m_sampleRate / 100;
+        memset(m_silentFrame->data_, 0, sizeof(m_silentFrame->data_));
+    }
+
+    return addAudioFrame(m_silentFrame.get());
+}
+
 
 char *FfEncoder::ff_err2str(int errRet)
 {
@@ -38,6 +38,7 @@ public:
 
     bool init() override;
     bool addAudioFrame(const AudioFrame *audioFrame) override;
+    bool addSilentFrame() override;
 
 protected:
     bool initEncoder(const FrameFormat format);
@@ -59,6 +60,8 @@ private:
     AVAudioFifo* m_audioFifo;
     AVFrame* m_audioFrame;
 
+    boost::scoped_ptr<AudioFrame> m_silentFrame;
+
     char m_errbuff[500];
 };
 
@@ -0,0 +1,60 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OpusDtx_h
+#define OpusDtx_h
+
+#include <stdint.h>
+
+namespace mcu {
+
+// Tracks what the encoder sent last and produces the opus dtx frames
+// to send while the input stays silent. Not thread safe.
+class OpusDtx {
+public:
+    // Interval of opus dtx frames in 10ms, same as libopus
+    static const uint32_t INTERVAL = 40;
+
+    OpusDtx()
+        : m_hasToc(false)
+        , m_toc(0)
+        , m_timestamp(0)
+        , m_silentCount(0)
+    {
+    }
+
+    // An encoded packet was sent
+    void onPacket(uint8_t toc, uint32_t timestamp)
+    {
+        m_hasToc = true;
+        m_toc = toc;
+        m_timestamp = timestamp;
+    }
+
+    // Input is voiced again
+    void onVoice() { m_silentCount = 0; }
+
+    // Called for each silent 10ms of input. Returns whether a dtx frame
+    // is due, its single TOC byte and its rtp timestamp.
+    bool onSilence(uint32_t rtpSampleRate, uint8_t& toc, uint32_t& timestamp)
+    {
+        if (!m_hasToc || (m_silentCount++ % INTERVAL) != 0) {
+            return false;
+        }
+        // TOC-only packet, the same as libopus emits in dtx
+        toc = m_toc & 0xfc;
+        timestamp = m_timestamp + (m_silentCount + 1) * rtpSampleRate / 100;
+        return true;
+    }
+
+private:
+    bool m_hasToc;
+    uint8_t m_toc;
+    uint32_t m_timestamp;
+    uint32_t m_silentCount;
+};
+
+} /* namespace mcu */
+
+#endif /* OpusDtx_h */
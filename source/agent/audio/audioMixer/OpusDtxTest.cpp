@@ -0,0 +1,80 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE OpusDtx
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "OpusDtx.h"
+
+using mcu::OpusDtx;
+
+static const uint32_t kRate = 48000;
+
+struct Emitted {
+    uint32_t tick;
+    uint8_t toc;
+    uint32_t timestamp;
+};
+
+static std::vector<Emitted> silence(OpusDtx& dtx, uint32_t ticks)
+{
+    std::vector<Emitted> emitted;
+    for (uint32_t i = 0; i < ticks; i++) {
+        uint8_t toc = 0;
+        uint32_t timestamp = 0;
+        if (dtx.onSilence(kRate, toc, timestamp)) {
+            emitted.push_back(Emitted{ i, toc, timestamp });
+        }
+    }
+    return emitted;
+}
+
+BOOST_AUTO_TEST_CASE(NothingBeforeFirstPacket)
+{
+    OpusDtx dtx;
+    BOOST_CHECK(silence(dtx, 100).empty());
+}
+
+BOOST_AUTO_TEST_CASE(TocOnlyFrameEveryInterval)
+{
+    OpusDtx dtx;
+    // config 31, stereo, code 3
+    dtx.onPacket(0xff, 96000);
+
+    std::vector<Emitted> emitted = silence(dtx, 3 * OpusDtx::INTERVAL + 1);
+    BOOST_REQUIRE_EQUAL(emitted.size(), 4u);
+    for (size_t i = 0; i < emitted.size(); i++) {
+        BOOST_CHECK_EQUAL(emitted[i].tick, i * OpusDtx::INTERVAL);
+        // Same config and stereo flag, a single frame
+        BOOST_CHECK_EQUAL(emitted[i].toc, 0xfc);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TimestampAdvances)
+{
+    OpusDtx dtx;
+    dtx.onPacket(0x78, 96000);
+
+    std::vector<Emitted> emitted = silence(dtx, 2 * OpusDtx::INTERVAL + 1);
+    BOOST_REQUIRE_EQUAL(emitted.size(), 3u);
+    BOOST_CHECK_GT(emitted[0].timestamp, 96000u);
+    for (size_t i = 1; i < emitted.size(); i++) {
+        // INTERVAL 10ms ticks apart in rtp clock
+        BOOST_CHECK_EQUAL(emitted[i].timestamp - emitted[i - 1].timestamp, OpusDtx::INTERVAL * kRate / 100);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(VoiceRestartsInterval)
+{
+    OpusDtx dtx;
+    dtx.onPacket(0x78, 0);
+    BOOST_CHECK_EQUAL(silence(dtx, 5).size(), 1u);
+
+    dtx.onVoice();
+    dtx.onPacket(0x7b, 4800);
+    std::vector<Emitted> emitted = silence(dtx, 5);
+    BOOST_REQUIRE_EQUAL(emitted.size(), 1u);
+    BOOST_CHECK_EQUAL(emitted[0].tick, 0u);
+    BOOST_CHECK_EQUAL(emitted[0].toc, 0x78);
+    BOOST_CHECK_GT(emitted[0].timestamp, 4800u);
+}
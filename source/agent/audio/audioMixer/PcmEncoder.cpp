@@ -95,4 +95,10 @@ bool PcmEncoder::addAudioFrame(const AudioFrame* audioFrame)
     return true;
 }
 
+bool PcmEncoder::addSilentFrame()
+{
+    // Nothing to send, timestamps are taken from wall clock
+    return false;
+}
+
 } /* namespace mcu */
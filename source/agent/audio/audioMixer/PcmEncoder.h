@@ -28,6 +28,7 @@ public:
 
     bool init() override;
     bool addAudioFrame(const AudioFrame *audioFrame) override;
+    bool addSilentFrame() override;
 
 private:
     FrameFormat m_format;
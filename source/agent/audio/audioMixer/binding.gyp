@@ -16,10 +16,12 @@
       'AcmmInput.cpp',
       'AcmmOutput.cpp',
       'AudioTime.cpp',
+      'AudioMixScheduler.cpp',
       '../../addons/common/NodeEventRegistry.cc',
       '../../../core/owt_base/MediaFramePipeline.cpp',
       '../../../core/owt_base/AudioUtilities.cpp',
       '../../../core/common/JobTimer.cpp',
+      '../../../core/common/IOService.cpp',
     ],
     'cflags_cc': [
         '-Wall',
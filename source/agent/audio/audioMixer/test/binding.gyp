@@ -0,0 +1,38 @@
+{
+  'targets': [{
+    'target_name': 'audioDecoderTest',
+    'type': 'executable',
+    'sources': [
+      '../AudioDecoderTest.cpp',
+      '../AudioTime.cpp',
+      '../../../../core/owt_base/MediaFramePipeline.cpp',
+    ],
+    'include_dirs': [
+      '..',
+      '../../../../core/common',
+      '../../../../core/owt_base',
+      '../../../../../third_party/webrtc/src',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-lboost_unit_test_framework'
+    ],
+    'cflags_cc': ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11', '-DWEBRTC_POSIX'],
+    'cflags_cc!': ['-fno-exceptions'],
+  }, {
+    'target_name': 'opusDtxTest',
+    'type': 'executable',
+    'sources': [
+      '../OpusDtxTest.cpp',
+    ],
+    'include_dirs': [
+      '..',
+    ],
+    'libraries': [
+      '-lboost_unit_test_framework'
+    ],
+    'cflags_cc': ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+    'cflags_cc!': ['-fno-exceptions'],
+  }]
+}
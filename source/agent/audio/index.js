@@ -367,6 +367,14 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
         engine.resetVAD();
     };
 
+    that.getEventStats = function (callback) {
+        if (engine && engine.getEventStats) {
+            callback('callback', engine.getEventStats());
+        } else {
+            callback('callback', {});
+        }
+    };
+
     that.init = function (service, config, belongToRoom, controller, mixView, callback) {
         var audioConfig = global.config.audio || {};
         log.debug('init, audioConfig:', audioConfig);
@@ -22,8 +22,14 @@ class SelectiveMixer {
         // streamId : { owner, codec, conn }
         this.inputs = new Map();
         this.mixer = new AudioMixer(config);
-        this.ranker = new AudioRanker(
-            this._onRankChange.bind(this), DETECT_MUTE, CHANGE_INTERVAL);
+        this.ranker = new AudioRanker(DETECT_MUTE, CHANGE_INTERVAL);
+        this.ranker.setBatchListener((events) => {
+            // Rank changes are coalesced, each carries the whole ranking
+            const changes = events.filter(([event]) => event === 'rankchange');
+            if (changes.length > 0) {
+                this._onRankChange(changes[changes.length - 1][1]);
+            }
+        });
         this.topK = [];
         for (let i = 0; i < k; i++) {
             let multicaster = new MediaFrameMulticaster();
@@ -123,6 +129,10 @@ class SelectiveMixer {
         }
     }
 
+    getEventStats() {
+        return {ranker: this.ranker.getEventStats()};
+    }
+
     close() {
         this.mixer.close();
     }
@@ -130,6 +130,15 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
       return streamPipeline;
     };
 
+    // Media of a cascaded cluster goes on tracks multiplexed on its
+    // signaling stream when the peer supports it, else on QUIC streams.
+    const createMediaStream = function(dest) {
+      if (clusters[dest].trackMux && clusters[dest].signalStream) {
+        return clusters[dest].signalStream.createTrack();
+      }
+      return clusters[dest].quicsession.createBidirectionalStream();
+    };
+
     var onSuccess = function(callback) {
       return function(result) {
         callback('callback', result);
@@ -187,7 +196,7 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                         return;
                     }
 
-                    var quicStream = clusters[dest].quicsession.createBidirectionalStream();
+                    var quicStream = createMediaStream(dest);
                     var streamID = quicStream.getId();
                     quicStream.trackKind = pubArg.type;
 
@@ -251,7 +260,7 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                     return;
                 }
 
-                var quicStream = clusters[dest].quicsession.createBidirectionalStream();
+                var quicStream = createMediaStream(dest);
                 var streamID = quicStream.getId();
 
                 if (!connections[pubId]) {
@@ -419,6 +428,7 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                 var quicStream = clusters[dest].quicsession.createBidirectionalStream();
                 var streamID = quicStream.getId();
                 clusters[dest].signalStream = quicStream;
+                quicStream.onNewTrack(onIncomingStream);
 
                 log.info("Create quic stream with controller:", controller, " and data:",data, " streamID:", streamID);
                 //Client create initialized stream to exchange cluster info for this session
@@ -435,15 +445,18 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                       type: 'cluster',
                       room: data.room,
                       token: data.token,
-                      cluster: data.selfCluster
+                      cluster: data.selfCluster,
+                      trackMux: true
                     }
                     quicStream.send(JSON.stringify(info));
+                  } else if (event.type === 'cluster-ack') {
+                    clusters[dest].trackMux = !!event.trackMux;
                   }
                 })
                 callback('callback', 'ok');
               });
 
-              client.onNewStream((incomingStream) => {
+              const onIncomingStream = (incomingStream) => {
                 var streamId = incomingStream.getId();
                 log.info("client get new stream id:", streamId);
                 if (!clusters[dest].streams) {
@@ -497,7 +510,8 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                   type: 'ready'
                 }
                 incomingStream.send(JSON.stringify(data));
-              })
+              };
+              client.onNewStream(onIncomingStream);
 
               client.onConnectionFailed(() => {
                 log.info("Quic client failed to connect with:", dest);
@@ -569,7 +583,7 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
           clusters[sessionId].id = sessionId;
 
           log.info("Server get new session:", sessionId);
-          session.onNewStream((quicStream) => {
+          const onNewStream = (quicStream) => {
             var streamId = quicStream.getId();
             log.info("Server get new stream id:", streamId);
             if (clusters[dest]) {
@@ -606,6 +620,11 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
                     } else {
                         clusters[dest].quicsession = session;
                         clusters[dest].signalStream = quicStream;
+                        if (info.trackMux) {
+                            clusters[dest].trackMux = true;
+                            quicStream.onNewTrack(onNewStream);
+                            quicStream.send(JSON.stringify({type: 'cluster-ack', trackMux: true}));
+                        }
                     }
                 });
               } else if (info.type === 'track') {
@@ -652,7 +671,8 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
               type: 'ready'
             }
             quicStream.send(JSON.stringify(data));
-          })
+          };
+          session.onNewStream(onNewStream);
 
           session.onClosedStream((closedStreamId) => {
             log.info("server stream:", closedStreamId, " is closed");
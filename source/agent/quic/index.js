@@ -251,6 +251,12 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
           log.warn('Unexpected track ID: ' + stream.trackId);
           return;
         }
+        const options = publicationOptions.get(stream.contentSessionId);
+        const track = options && options.tracks &&
+            options.tracks.find((t) => t.type === stream.trackKind);
+        if (track && track.format && track.format.codec) {
+          stream.codec = track.format.codec;
+        }
         if (frameSourceMap.has(stream.contentSessionId)) {
           frameSourceMap.get(stream.contentSessionId).addStreamInput(stream);
         }
@@ -44,6 +44,9 @@ module.exports.load = () => {
       config.internal.ip_address = addr.ip;
     }
 
+    config.sip = config.sip || {};
+    config.sip.media_workers = config.sip.media_workers || 0;
+
     return config;
   } catch (e) {
     console.error('Parsing config error on line ' + e.line + ', column ' + e.column + ': ' + e.message);
@@ -4,6 +4,11 @@
 
 'use strict';
 var InternalIO = require('../internalIO/build/Release/internalIO');
+var sip_config = (global.config || {}).sip || {};
+if (sip_config.media_workers && !process.env.OWT_SIP_MEDIA_WORKERS) {
+  // Read by the sipIn addon when it initializes
+  process.env.OWT_SIP_MEDIA_WORKERS = String(sip_config.media_workers);
+}
 var SipGateway = require('../sipIn/build/Release/sipIn');
 var SipCallConnection = require('./sipCallConnection').SipCallConnection;
 var InternalIn = InternalIO.In;
@@ -131,7 +131,7 @@ void VideoFrameConstructor::requestKeyFrame(const FunctionCallbackInfo<Value>& a
 }
 
 void VideoFrameConstructor::onVideoInfo(const std::string& message) {
-    notifyAsyncEvent("mediaInfo", message);
+    notifyCoalescedAsyncEvent("mediaInfo", "", message);
 }
 
 void VideoFrameConstructor::addEventListener(const FunctionCallbackInfo<Value>& args)
@@ -95,8 +95,10 @@ SipCallConnection::SipCallConnection(SipGateway* gateway, const std::string& pee
 
 SipCallConnection::~SipCallConnection()
 {
-    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+    // Returns once no media worker delivers to this object, the rx
+    // handlers take m_mutex so it must not be held here
     m_gateway->resetCallOwner(m_sipCall);
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
     running = false;
     video_sink_ = NULL;
     audio_sink_ = NULL;
@@ -299,8 +301,10 @@ void SipCallConnection::refreshVideoStream() {
 }
 
 void SipCallConnection::close() {
-    boost::unique_lock<boost::shared_mutex> lock(m_mutex);
-    running = false;
+    {
+        boost::unique_lock<boost::shared_mutex> lock(m_mutex);
+        running = false;
+    }
     m_gateway->resetCallOwner(m_sipCall);
 }
 
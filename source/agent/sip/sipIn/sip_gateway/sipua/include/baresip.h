@@ -98,6 +98,8 @@ bool          call_is_outgoing(const struct call *call);
 
 void *call_get_owner(const struct call *call);
 void call_set_owner(struct call *call, void *owner);
+void *call_owner_acquire(struct call *call);
+void call_owner_release(struct call *call);
 const char *call_audio_dir(const struct call *call);
 const char *call_video_dir(const struct call *call);
 void call_subscribe_audio(struct call *call, void *subscriber);
@@ -27,6 +27,8 @@ void sipua_mod_close(void);
 int sipua_new(struct sipua_entity **sipua, void *endpoint, const char *sip_server, const char * user_name,
 	          const char *password, const char *disp_name);
 void sipua_delete(struct sipua_entity *sipua);
+/* Local SIP/UDP address of the ua as "ip:port", for direct calls without a registrar */
+int sipua_laddr(struct sipua_entity *sipua, char *buf, size_t size);
 
 
 /*****************/
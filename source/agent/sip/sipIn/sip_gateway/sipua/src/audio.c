@@ -442,8 +442,7 @@ static void stream_recv_handler(const struct rtp_header *hdr,
 {
 	struct audio *a = arg;
 	struct aurx *rx = &a->rx;
-    void *owner = (a->call ? call_get_owner(a->call) : NULL);
-
+    void *owner;
 
 	/* Telephone event? */
     if (hdr->pt != rx->pt) {
@@ -476,10 +475,16 @@ static void stream_recv_handler(const struct rtp_header *hdr,
     /***  Do NOT decode the stream data here, but send to transcoder ***/
     // (void)aurx_stream_decode(&a->rx, mb);
     mb->pos = 0;
-    if (mbuf_get_left(mb) && owner) {
+    if (!mbuf_get_left(mb))
+        return;
+
+    /* Runs on a media worker, keep the owner from being reset meanwhile */
+    owner = call_owner_acquire(a->call);
+    if (owner) {
         ++a->rx.rx_counter;
         call_connection_rx_audio(owner, mbuf_buf(mb), mbuf_get_left(mb));
     }
+    call_owner_release(a->call);
 
     return;
 }
@@ -827,10 +832,19 @@ void audio_send(struct audio *a, uint8_t *data, size_t len)
 	}
 
 	tx = &a->tx;
-    tx->mb->pos = tx->mb->end = STREAM_PRESZ;
-    pl_pos = hdr.ext ? RTP_HEADER_SIZE + 4 * hdr.cc + 4 + hdr.x.len : RTP_HEADER_SIZE + 4 * hdr.cc;
+    pl_pos = hdr.ext ? RTP_HEADER_SIZE + 4 * hdr.cc + 4 + 4 * hdr.x.len : RTP_HEADER_SIZE + 4 * hdr.cc;
     pl_len = len - pl_pos;
 
+	/* Packets come from our own packetizer, rewrite the header in place */
+	err = stream_relay(a->strm, hdr.m, hdr.ts, data, pl_pos, len);
+	if (err != ENOTSUP) {
+		if (err)
+			warning("audio_send: stream_relay failed.\n");
+		goto out;
+	}
+
+    tx->mb->pos = tx->mb->end = STREAM_PRESZ;
+
     err = mbuf_write_mem(tx->mb, data + pl_pos , pl_len);
 	if (err) {
 		warning("audio_send: mbuf_write_mem failed.\n");
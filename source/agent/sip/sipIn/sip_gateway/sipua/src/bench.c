@@ -0,0 +1,834 @@
+/**
+ * @file bench.c  SIP gateway media load generator
+ *
+ * Runs two sipua instances in one process, a caller side standing in for
+ * the gateway and a callee side standing in for the SIP devices. The caller
+ * sets up a number of calls directly to the callee, no registrar needed.
+ * Once they are established both sides push synthetic RTP audio and video
+ * through the same entry points SipCallConnection uses. Every payload
+ * carries its send time, so the receiving side measures one-way latency
+ * and loss per call leg.
+ *
+ * Build with "make bench", run "./sipua_bench -h" for the options.
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+#include <re/re.h>
+#include <sipua.h>
+#include <baresip.h>
+
+
+enum {
+	BENCH_MAGIC      = 0x53425031, /* "SBP1" */
+	RTP_HDR_SIZE     = 12,
+	PKT_MAX          = 1400,
+	AUDIO_PTIME_MS   = 20,
+	AUDIO_PAYLOAD    = 160,
+	AUDIO_CLOCK      = 8000,
+	VIDEO_CLOCK      = 90000,
+	VIDEO_PAYLOAD    = 1200,
+	HIST_BUCKETS     = 184,
+};
+
+enum bench_side {
+	SIDE_CALLER = 0,
+	SIDE_CALLEE,
+};
+
+/* Head of every synthetic payload */
+struct bench_payload {
+	uint32_t magic;
+	uint16_t side;
+	uint16_t leg;
+	uint32_t seq;
+	uint32_t pad;
+	uint64_t send_ns;
+};
+
+/* Latency histogram, 8 buckets per power of two in microseconds */
+struct bench_hist {
+	uint32_t n[HIST_BUCKETS];
+	uint64_t count;
+	uint64_t sum_us;
+	uint64_t max_us;
+};
+
+struct bench_media_stat {
+	uint64_t sent;
+	uint64_t recv;
+	uint64_t bytes;
+	struct bench_hist lat;
+};
+
+/* One direction of a call, owned by the sending side */
+struct bench_leg {
+	struct bench_ua *ua;
+	void *call;
+	unsigned index;
+	uint16_t a_seq;
+	uint16_t v_seq;
+	uint32_t a_ts;
+	uint32_t v_ts;
+	uint32_t a_cnt;
+	uint32_t v_cnt;
+	uint32_t ssrc;
+	pthread_mutex_t mutex;
+	struct bench_media_stat audio;
+	struct bench_media_stat video;
+};
+
+struct bench_ua {
+	enum bench_side side;
+	struct sipua_entity *sipua;
+	struct bench_leg *legs;
+	unsigned established;
+	unsigned closed;
+};
+
+struct bench_cfg {
+	unsigned calls;
+	unsigned duration;
+	unsigned setup_timeout;
+	unsigned video_kbps;
+	unsigned video_fps;
+	bool audio;
+	bool video;
+	bool verbose;
+};
+
+static struct bench_cfg cfg = {
+	.calls = 10,
+	.duration = 30,
+	.setup_timeout = 20,
+	.video_kbps = 1000,
+	.video_fps = 30,
+	.audio = true,
+	.video = true,
+	.verbose = false,
+};
+
+static struct bench_ua caller = {.side = SIDE_CALLER};
+static struct bench_ua callee = {.side = SIDE_CALLEE};
+
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static uint64_t thread_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static uint64_t process_cpu_ns(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return ((uint64_t)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec)
+		* 1000000000ULL
+		+ ((uint64_t)ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000;
+}
+
+
+static unsigned hist_index(uint64_t us)
+{
+	unsigned msb, idx;
+
+	if (us < 8)
+		return (unsigned)us;
+
+	msb = 63 - __builtin_clzll(us);
+	idx = (msb - 2) * 8 + ((us >> (msb - 3)) & 7);
+
+	return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+
+static uint64_t hist_value(unsigned idx)
+{
+	unsigned msb;
+
+	if (idx < 8)
+		return idx;
+
+	msb = idx / 8 + 2;
+	return (uint64_t)(8 + idx % 8) << (msb - 3);
+}
+
+
+static void hist_add(struct bench_hist *h, uint64_t us)
+{
+	h->n[hist_index(us)]++;
+	h->count++;
+	h->sum_us += us;
+	if (us > h->max_us)
+		h->max_us = us;
+}
+
+
+static void hist_merge(struct bench_hist *dst, const struct bench_hist *src)
+{
+	unsigned i;
+
+	for (i = 0; i < HIST_BUCKETS; i++)
+		dst->n[i] += src->n[i];
+	dst->count += src->count;
+	dst->sum_us += src->sum_us;
+	if (src->max_us > dst->max_us)
+		dst->max_us = src->max_us;
+}
+
+
+static double hist_percentile(const struct bench_hist *h, double p)
+{
+	uint64_t target, acc = 0;
+	unsigned i;
+
+	if (!h->count)
+		return 0;
+
+	target = (uint64_t)(p * h->count / 100.0);
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		acc += h->n[i];
+		if (acc > target)
+			return hist_value(i) / 1000.0;
+	}
+
+	return h->max_us / 1000.0;
+}
+
+
+static void media_merge(struct bench_media_stat *dst,
+			const struct bench_media_stat *src)
+{
+	dst->sent += src->sent;
+	dst->recv += src->recv;
+	dst->bytes += src->bytes;
+	hist_merge(&dst->lat, &src->lat);
+}
+
+
+static struct bench_ua *side_ua(unsigned side)
+{
+	return side == SIDE_CALLER ? &caller : &callee;
+}
+
+
+/*
+ * Receive path, runs on the sipua thread or a media worker
+ */
+static void bench_rx(uint8_t *data, size_t len, bool video)
+{
+	const uint64_t now = now_ns();
+	struct bench_payload pl;
+	struct bench_ua *ua;
+	struct bench_leg *leg;
+	struct bench_media_stat *st;
+	size_t pos;
+
+	if (len < RTP_HDR_SIZE)
+		return;
+
+	pos = RTP_HDR_SIZE + 4 * (data[0] & 0x0f);
+	if ((data[0] & 0x10) && len >= pos + 4)
+		pos += 4 + 4 * ntohs(*(uint16_t *)&data[pos + 2]);
+
+	if (len < pos + sizeof(pl))
+		return;
+
+	memcpy(&pl, data + pos, sizeof(pl));
+	if (pl.magic != BENCH_MAGIC || pl.side > SIDE_CALLEE)
+		return;
+
+	ua = side_ua(pl.side);
+	if (pl.leg >= cfg.calls)
+		return;
+
+	leg = &ua->legs[pl.leg];
+	st = video ? &leg->video : &leg->audio;
+
+	pthread_mutex_lock(&leg->mutex);
+	st->recv++;
+	st->bytes += len;
+	if (now > pl.send_ns)
+		hist_add(&st->lat, (now - pl.send_ns) / 1000);
+	else
+		hist_add(&st->lat, 0);
+	pthread_mutex_unlock(&leg->mutex);
+}
+
+
+/*
+ * sipua -> endpoint callbacks, normally implemented by SipEP and
+ * SipCallConnection
+ */
+void ep_register_result(void *endpoint, sipua_bool successful)
+{
+	(void)endpoint;
+	(void)successful;
+}
+
+
+int ep_incoming_call(void *endpoint, sipua_bool audio, sipua_bool video,
+		     const char *callerURI)
+{
+	struct bench_ua *ua = endpoint;
+	(void)audio;
+	(void)video;
+
+	sipua_accept(ua->sipua, callerURI);
+	return 0;
+}
+
+
+void ep_peer_ringing(void *endpoint, const char *peer)
+{
+	(void)endpoint;
+	(void)peer;
+}
+
+
+void ep_call_established(void *endpoint, const char *peer, void *call,
+			 const char *audio_dir, const char *video_dir)
+{
+	struct bench_ua *ua = endpoint;
+	struct bench_leg *leg;
+	unsigned index;
+
+	index = __atomic_load_n(&ua->established, __ATOMIC_ACQUIRE);
+	if (index >= cfg.calls)
+		return;
+
+	leg = &ua->legs[index];
+	leg->call = call;
+
+	sipua_set_call_owner(ua->sipua, call, leg);
+
+	if (cfg.verbose)
+		printf("%s leg %u established with %s, audio %s, video %s\n",
+		       ua->side == SIDE_CALLER ? "caller" : "callee", index,
+		       peer, audio_dir, video_dir);
+
+	/* Published last, the sender only walks established legs */
+	__atomic_store_n(&ua->established, index + 1, __ATOMIC_RELEASE);
+}
+
+
+void ep_call_updated(void *endpoint, const char *peer,
+		     const char *audio_dir, const char *video_dir)
+{
+	(void)endpoint;
+	(void)peer;
+	(void)audio_dir;
+	(void)video_dir;
+}
+
+
+void ep_call_closed(void *endpoint, const char *peer, const char *reason)
+{
+	struct bench_ua *ua = endpoint;
+
+	__atomic_add_fetch(&ua->closed, 1, __ATOMIC_RELAXED);
+
+	if (cfg.verbose)
+		printf("%s call with %s closed: %s\n",
+		       ua->side == SIDE_CALLER ? "caller" : "callee",
+		       peer, reason);
+}
+
+
+void ep_call_loss(void *endpoint, const char *peer, const char *reason,
+		  void *call)
+{
+	(void)call;
+	ep_call_closed(endpoint, peer, reason);
+}
+
+
+int ep_update_audio_params(void *endpoint, const char *peer,
+			   const char *cdcname, int srate, int ch,
+			   const char *fmtp)
+{
+	(void)endpoint;
+	(void)peer;
+	(void)cdcname;
+	(void)srate;
+	(void)ch;
+	(void)fmtp;
+	return 0;
+}
+
+
+void ep_update_video_params(void *endpoint, const char *peer,
+			    const char *cdcname, int bitrate, int packetsize,
+			    int fps, const char *fmtp)
+{
+	(void)endpoint;
+	(void)peer;
+	(void)cdcname;
+	(void)bitrate;
+	(void)packetsize;
+	(void)fps;
+	(void)fmtp;
+}
+
+
+void call_connection_rx_audio(void *owner, uint8_t *data, size_t len)
+{
+	(void)owner;
+	bench_rx(data, len, false);
+}
+
+
+void call_connection_rx_video(void *owner, uint8_t *data, size_t len)
+{
+	(void)owner;
+	bench_rx(data, len, true);
+}
+
+
+void call_connection_rx_fir(void *owner)
+{
+	(void)owner;
+}
+
+
+void call_connection_rx_gnack(void *owner, uint32_t ssrcPacket,
+			      uint32_t ssrcMedia, uint32_t n,
+			      uint32_t *pid_blp)
+{
+	(void)owner;
+	(void)ssrcPacket;
+	(void)ssrcMedia;
+	(void)n;
+	(void)pid_blp;
+}
+
+
+void call_connection_closed(void *owner)
+{
+	(void)owner;
+}
+
+
+/*
+ * Send path, the same calls SipCallConnection makes for packetized media
+ */
+static size_t build_packet(uint8_t *buf, struct bench_leg *leg, bool video,
+			   bool marker, size_t payload)
+{
+	struct bench_payload pl;
+	uint16_t seq;
+	uint32_t ts;
+
+	if (payload < sizeof(pl))
+		payload = sizeof(pl);
+	if (payload > PKT_MAX - RTP_HDR_SIZE)
+		payload = PKT_MAX - RTP_HDR_SIZE;
+
+	seq = video ? leg->v_seq++ : leg->a_seq++;
+	ts  = video ? leg->v_ts : leg->a_ts;
+
+	buf[0] = 0x80;
+	buf[1] = (marker ? 0x80 : 0) | (video ? 96 : 0);
+	*(uint16_t *)&buf[2] = htons(seq);
+	*(uint32_t *)&buf[4] = htonl(ts);
+	*(uint32_t *)&buf[8] = htonl(leg->ssrc + (video ? 1 : 0));
+
+	pl.magic = BENCH_MAGIC;
+	pl.side = leg->ua->side;
+	pl.leg = leg->index;
+	pl.seq = video ? leg->v_cnt++ : leg->a_cnt++;
+	pl.pad = 0;
+	pl.send_ns = now_ns();
+
+	memset(buf + RTP_HDR_SIZE, 0, payload);
+	memcpy(buf + RTP_HDR_SIZE, &pl, sizeof(pl));
+
+	return RTP_HDR_SIZE + payload;
+}
+
+
+static void send_audio(struct bench_leg *leg)
+{
+	uint8_t buf[PKT_MAX];
+	size_t len;
+
+	len = build_packet(buf, leg, false, false, AUDIO_PAYLOAD);
+	call_connection_tx_audio(leg->call, buf, len);
+	leg->a_ts += AUDIO_CLOCK * AUDIO_PTIME_MS / 1000;
+
+	pthread_mutex_lock(&leg->mutex);
+	leg->audio.sent++;
+	pthread_mutex_unlock(&leg->mutex);
+}
+
+
+static void send_video_frame(struct bench_leg *leg)
+{
+	uint8_t buf[PKT_MAX];
+	size_t frame, chunk, len;
+	unsigned packets = 0;
+
+	frame = (size_t)cfg.video_kbps * 1000 / 8 / cfg.video_fps;
+
+	while (frame > 0) {
+		chunk = frame > VIDEO_PAYLOAD ? VIDEO_PAYLOAD : frame;
+		frame -= chunk;
+
+		len = build_packet(buf, leg, true, frame == 0, chunk);
+		call_connection_tx_video(leg->call, buf, len);
+		packets++;
+	}
+	leg->v_ts += VIDEO_CLOCK / cfg.video_fps;
+
+	pthread_mutex_lock(&leg->mutex);
+	leg->video.sent += packets;
+	pthread_mutex_unlock(&leg->mutex);
+}
+
+
+static void sleep_until(uint64_t deadline)
+{
+	struct timespec ts;
+
+	ts.tv_sec = deadline / 1000000000ULL;
+	ts.tv_nsec = deadline % 1000000000ULL;
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+
+/* Paces media on all established legs, returns its own CPU time */
+static uint64_t run_media(uint64_t duration_ns)
+{
+	const uint64_t audio_period = AUDIO_PTIME_MS * 1000000ULL;
+	const uint64_t video_period = 1000000000ULL / cfg.video_fps;
+	const uint64_t start = now_ns();
+	const uint64_t cpu_start = thread_cpu_ns();
+	uint64_t next_audio = start, next_video = start, now;
+	unsigned i, n;
+
+	while ((now = now_ns()) < start + duration_ns) {
+
+		if (cfg.audio && now >= next_audio) {
+			n = __atomic_load_n(&caller.established,
+					    __ATOMIC_ACQUIRE);
+			for (i = 0; i < n; i++)
+				send_audio(&caller.legs[i]);
+			n = __atomic_load_n(&callee.established,
+					    __ATOMIC_ACQUIRE);
+			for (i = 0; i < n; i++)
+				send_audio(&callee.legs[i]);
+			next_audio += audio_period;
+		}
+
+		if (cfg.video && now >= next_video) {
+			n = __atomic_load_n(&caller.established,
+					    __ATOMIC_ACQUIRE);
+			for (i = 0; i < n; i++)
+				send_video_frame(&caller.legs[i]);
+			n = __atomic_load_n(&callee.established,
+					    __ATOMIC_ACQUIRE);
+			for (i = 0; i < n; i++)
+				send_video_frame(&callee.legs[i]);
+			next_video += video_period;
+		}
+
+		if (!cfg.audio)
+			sleep_until(next_video);
+		else if (!cfg.video)
+			sleep_until(next_audio);
+		else
+			sleep_until(next_audio < next_video ?
+				    next_audio : next_video);
+	}
+
+	return thread_cpu_ns() - cpu_start;
+}
+
+
+static void print_media(const char *name, const struct bench_media_stat *st,
+			double secs)
+{
+	double loss = 0;
+
+	if (st->sent)
+		loss = 100.0 * (double)(st->sent - (st->recv < st->sent ?
+						    st->recv : st->sent))
+			/ st->sent;
+
+	printf("  %-5s sent %9llu  recv %9llu  %9.1f pps  %8.1f kbps"
+	       "  loss %6.2f%%  latency ms p50 %7.2f p90 %7.2f"
+	       " p99 %7.2f max %7.2f\n",
+	       name,
+	       (unsigned long long)st->sent, (unsigned long long)st->recv,
+	       secs > 0 ? st->recv / secs : 0,
+	       secs > 0 ? st->bytes * 8 / secs / 1000 : 0,
+	       loss,
+	       hist_percentile(&st->lat, 50),
+	       hist_percentile(&st->lat, 90),
+	       hist_percentile(&st->lat, 99),
+	       st->lat.max_us / 1000.0);
+}
+
+
+static void print_report(double secs, uint64_t cpu_ns, uint64_t sender_ns)
+{
+	struct bench_media_stat audio, video;
+	const struct bench_ua *uas[2] = {&caller, &callee};
+	unsigned i, j;
+
+	memset(&audio, 0, sizeof(audio));
+	memset(&video, 0, sizeof(video));
+
+	printf("\nPer leg:\n");
+	for (j = 0; j < 2; j++) {
+		for (i = 0; i < uas[j]->established; i++) {
+			const struct bench_leg *leg = &uas[j]->legs[i];
+
+			printf(" %s leg %u\n",
+			       j == SIDE_CALLER ? "caller->callee"
+			       : "callee->caller", i);
+			if (cfg.audio)
+				print_media("audio", &leg->audio, secs);
+			if (cfg.video)
+				print_media("video", &leg->video, secs);
+
+			media_merge(&audio, &leg->audio);
+			media_merge(&video, &leg->video);
+		}
+	}
+
+	printf("\nAggregate: %u/%u calls established, %.1f s\n",
+	       caller.established, cfg.calls, secs);
+	if (cfg.audio)
+		print_media("audio", &audio, secs);
+	if (cfg.video)
+		print_media("video", &video, secs);
+
+	printf("  cpu   sipua %.1f%%, load generator %.1f%% (of one core)\n",
+	       secs > 0 ? (cpu_ns - sender_ns) / 1e7 / secs : 0,
+	       secs > 0 ? sender_ns / 1e7 / secs : 0);
+}
+
+
+static int alloc_legs(struct bench_ua *ua)
+{
+	unsigned i;
+
+	ua->legs = calloc(cfg.calls, sizeof(*ua->legs));
+	if (!ua->legs)
+		return ENOMEM;
+
+	for (i = 0; i < cfg.calls; i++) {
+		ua->legs[i].ua = ua;
+		ua->legs[i].index = i;
+		ua->legs[i].ssrc = rand_u32() & ~1u;
+		ua->legs[i].a_seq = rand_u16();
+		ua->legs[i].v_seq = rand_u16();
+		ua->legs[i].a_ts = rand_u32();
+		ua->legs[i].v_ts = rand_u32();
+		pthread_mutex_init(&ua->legs[i].mutex, NULL);
+	}
+
+	return 0;
+}
+
+
+static void free_legs(struct bench_ua *ua)
+{
+	unsigned i;
+
+	if (!ua->legs)
+		return;
+
+	for (i = 0; i < cfg.calls; i++)
+		pthread_mutex_destroy(&ua->legs[i].mutex);
+
+	free(ua->legs);
+	ua->legs = NULL;
+}
+
+
+static void usage(void)
+{
+	(void)fprintf(stderr,
+		"Usage: sipua_bench [options]\n"
+		"options:\n"
+		"\t-n <calls>      Concurrent calls (default %u)\n"
+		"\t-d <seconds>    Media duration (default %u)\n"
+		"\t-t <seconds>    Call setup timeout (default %u)\n"
+		"\t-b <kbps>       Video bitrate per leg (default %u)\n"
+		"\t-f <fps>        Video frame rate (default %u)\n"
+		"\t-w <workers>    Media workers, sets OWT_SIP_MEDIA_WORKERS\n"
+		"\t-A              Audio only\n"
+		"\t-V              Video only\n"
+		"\t-v              Verbose call events\n"
+		"\t-h              Help\n",
+		cfg.calls, cfg.duration, cfg.setup_timeout,
+		cfg.video_kbps, cfg.video_fps);
+}
+
+
+int main(int argc, char *argv[])
+{
+	char laddr[64], uri[128];
+	uint64_t start, cpu_start, sender_ns;
+	double secs;
+	unsigned i;
+	int c, err;
+
+	while ((c = getopt(argc, argv, "n:d:t:b:f:w:AVvh")) != -1) {
+		switch (c) {
+
+		case 'n':
+			cfg.calls = atoi(optarg);
+			break;
+
+		case 'd':
+			cfg.duration = atoi(optarg);
+			break;
+
+		case 't':
+			cfg.setup_timeout = atoi(optarg);
+			break;
+
+		case 'b':
+			cfg.video_kbps = atoi(optarg);
+			break;
+
+		case 'f':
+			cfg.video_fps = atoi(optarg);
+			break;
+
+		case 'w':
+			(void)setenv("OWT_SIP_MEDIA_WORKERS", optarg, 1);
+			break;
+
+		case 'A':
+			cfg.video = false;
+			break;
+
+		case 'V':
+			cfg.audio = false;
+			break;
+
+		case 'v':
+			cfg.verbose = true;
+			break;
+
+		case 'h':
+		default:
+			usage();
+			return -2;
+		}
+	}
+
+	if (!cfg.calls || !cfg.video_fps || (!cfg.audio && !cfg.video)) {
+		usage();
+		return -2;
+	}
+
+	err = sipua_mod_init();
+	if (err) {
+		fprintf(stderr, "sipua module init failed (%d)\n", err);
+		return err;
+	}
+	log_enable_debug(cfg.verbose);
+
+	err = alloc_legs(&caller);
+	err |= alloc_legs(&callee);
+	if (err)
+		goto out;
+
+	/* The registrar is unreachable on purpose, calls go direct */
+	err = sipua_new(&callee.sipua, &callee, "127.0.0.1",
+			"bench_callee", "bench", "Bench Callee");
+	err |= sipua_new(&caller.sipua, &caller, "127.0.0.1",
+			 "bench_caller", "bench", "Bench Caller");
+	if (err) {
+		fprintf(stderr, "sipua_new failed\n");
+		goto out;
+	}
+
+	err = sipua_laddr(callee.sipua, laddr, sizeof(laddr));
+	if (err) {
+		fprintf(stderr, "no local address for callee (%d)\n", err);
+		goto out;
+	}
+	(void)snprintf(uri, sizeof(uri), "sip:bench_callee@%s", laddr);
+
+	/*
+	 * One call at a time, the callee answers its latest incoming call
+	 * the same way the gateway does
+	 */
+	printf("Setting up %u calls to %s\n", cfg.calls, uri);
+	start = now_ns();
+	for (i = 0; i < cfg.calls; i++) {
+		sipua_call(caller.sipua, cfg.audio, cfg.video, uri);
+
+		while (__atomic_load_n(&caller.established, __ATOMIC_ACQUIRE)
+		       <= i ||
+		       __atomic_load_n(&callee.established, __ATOMIC_ACQUIRE)
+		       <= i) {
+			if (now_ns() - start >
+			    cfg.setup_timeout * 1000000000ULL)
+				break;
+			usleep(1000);
+		}
+	}
+	printf("%u calls established in %.2f s\n",
+	       __atomic_load_n(&caller.established, __ATOMIC_ACQUIRE),
+	       (now_ns() - start) / 1e9);
+
+	start = now_ns();
+	cpu_start = process_cpu_ns();
+	sender_ns = run_media(cfg.duration * 1000000000ULL);
+
+	/* Let packets in flight arrive before counting loss */
+	usleep(500000);
+	secs = (now_ns() - start) / 1e9;
+
+	print_report(secs, process_cpu_ns() - cpu_start, sender_ns);
+
+	for (i = 0; i < caller.established; i++)
+		sipua_hangup(caller.sipua, caller.legs[i].call);
+
+	start = now_ns();
+	while (__atomic_load_n(&caller.closed, __ATOMIC_RELAXED)
+	       < caller.established &&
+	       now_ns() - start < 5000000000ULL)
+		usleep(10000);
+
+ out:
+	if (caller.sipua)
+		sipua_delete(caller.sipua);
+	if (callee.sipua)
+		sipua_delete(callee.sipua);
+
+	sipua_mod_close();
+
+	free_legs(&caller);
+	free_legs(&callee);
+
+	return err;
+}
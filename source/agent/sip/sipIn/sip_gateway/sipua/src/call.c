@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <time.h>
 #include <re/re.h>
 #include <baresip.h>
@@ -46,6 +47,7 @@ struct call {
 	struct sipnot *not;       /**< REFER/NOTIFY client                  */
 	struct list streaml;      /**< List of mediastreams (struct stream) */
 	void *owner;              /**< The owner SipCallConnection          */
+	pthread_rwlock_t owner_lock;/**< Held by media workers using owner  */
 	struct audio *audio;      /**< Audio stream                         */
 #ifdef USE_VIDEO
 	struct video *video;      /**< Video stream                         */
@@ -392,6 +394,8 @@ static void call_destructor(void *arg)
 	mem_deref(call->sub);
 	mem_deref(call->not);
 	mem_deref(call->acc);
+
+	pthread_rwlock_destroy(&call->owner_lock);
 }
 
 
@@ -479,6 +483,7 @@ int call_alloc(struct call **callp, const struct config *cfg, struct list *lst,
 	if (!call)
 		return ENOMEM;
 
+	pthread_rwlock_init(&call->owner_lock, NULL);
 
 	call->config_avt = cfg->avt;
 
@@ -1017,7 +1022,38 @@ void* call_get_owner(const struct call *call)
 
 void call_set_owner(struct call *call, void *owner)
 {
-    if (call) call->owner = owner;
+	if (!call)
+		return;
+
+	/* Waits for media workers still delivering to the old owner */
+	pthread_rwlock_wrlock(&call->owner_lock);
+	call->owner = owner;
+	pthread_rwlock_unlock(&call->owner_lock);
+}
+
+
+/**
+ * Get the call owner for delivering media, the owner can not be reset
+ * until call_owner_release() is called
+ *
+ * @param call Call object
+ *
+ * @return Owner of the call, NULL if none
+ */
+void *call_owner_acquire(struct call *call)
+{
+	if (!call)
+		return NULL;
+
+	pthread_rwlock_rdlock(&call->owner_lock);
+	return call->owner;
+}
+
+
+void call_owner_release(struct call *call)
+{
+	if (call)
+		pthread_rwlock_unlock(&call->owner_lock);
 }
 
 static int auth_handler(char **username, char **password,
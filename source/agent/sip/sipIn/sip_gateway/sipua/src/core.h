@@ -287,6 +287,7 @@ struct stream {
 	stream_rtp_h *rtph;      /**< Stream RTP handler                    */
 	stream_rtcp_h *rtcph;    /**< Stream RTCP handler                   */
 	void *arg;               /**< Handler argument                      */
+	struct media_shard *shard;/**< Media worker polling the sockets     */
 };
 
 int  stream_alloc(struct stream **sp, const struct config_avt *cfg,
@@ -299,6 +300,8 @@ int  stream_alloc(struct stream **sp, const struct config_avt *cfg,
 struct sdp_media *stream_sdpmedia(const struct stream *s);
 int  stream_send(struct stream *s, bool marker, int pt, uint32_t ts,
 		 struct mbuf *mb);
+int  stream_relay(struct stream *s, bool marker, uint32_t ts,
+		  uint8_t *data, size_t pl_pos, size_t len);
 void stream_update(struct stream *s);
 void stream_update_encoder(struct stream *s, int pt_enc);
 int  stream_jbuf_stat(struct re_printf *pf, const struct stream *s);
@@ -312,6 +315,18 @@ int  stream_debug(struct re_printf *pf, const struct stream *s);
 int  stream_print(struct re_printf *pf, const struct stream *s);
 
 
+/*
+ * Media shards
+ */
+
+struct media_shard;
+
+int  media_shards_init(unsigned num);
+void media_shards_close(void);
+void stream_shard_attach(struct stream *s);
+void stream_shard_detach(struct stream *s);
+
+
 /*
  * User-Agent
  */
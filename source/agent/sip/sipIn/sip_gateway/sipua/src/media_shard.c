@@ -0,0 +1,371 @@
+/**
+ * @file media_shard.c  Media worker threads for RTP/RTCP receive
+ *
+ * Each shard runs its own libre main loop, so the RTP sockets of a call
+ * are polled and handled off the SIP user-agent thread. Signaling, RTCP
+ * timers and sending stay where they are.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <re/re.h>
+#include <baresip.h>
+#include "core.h"
+
+
+#define DEBUG_MODULE "media_shard"
+#define DEBUG_LEVEL 5
+#include <re/re_dbg.h>
+
+
+enum {
+	MEDIA_SHARD_MAX = 64,
+	DETACH_RETRY_MAX = 100,
+	DETACH_RETRY_US = 10000,
+};
+
+enum shard_cmd {
+	SHARD_ATTACH = 0,
+	SHARD_DETACH,
+	SHARD_TERMINATE,
+};
+
+struct media_shard {
+	pthread_t thid;
+	struct mqueue *mq;
+	unsigned streams;        /**< Streams currently attached            */
+	unsigned index;
+	bool failed;             /**< Unreachable, takes no new streams     */
+};
+
+/* Request handed to a shard, the caller waits until it is done */
+struct shard_req {
+	struct stream *s;
+	int err;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool done;
+};
+
+static struct media_shard shards[MEDIA_SHARD_MAX];
+static unsigned shard_num;
+static pthread_mutex_t shard_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Polls the receive sockets on the calling thread, all or none */
+static int sock_attach(struct stream *s)
+{
+	int err;
+
+	err = udp_thread_attach(rtp_sock(s->rtp));
+	if (err)
+		return err;
+
+	if (rtcp_sock(s->rtp)) {
+		err = udp_thread_attach(rtcp_sock(s->rtp));
+		if (err)
+			udp_thread_detach(rtp_sock(s->rtp));
+	}
+
+	return err;
+}
+
+
+static void sock_detach(struct stream *s)
+{
+	udp_thread_detach(rtp_sock(s->rtp));
+	if (rtcp_sock(s->rtp))
+		udp_thread_detach(rtcp_sock(s->rtp));
+}
+
+
+static void shard_req_done(struct shard_req *req)
+{
+	pthread_mutex_lock(&req->mutex);
+	req->done = true;
+	pthread_cond_signal(&req->cond);
+	pthread_mutex_unlock(&req->mutex);
+}
+
+
+static void shard_cmd_handler(int id, void *data, void *arg)
+{
+	struct shard_req *req = data;
+	(void)arg;
+
+	switch (id) {
+
+	case SHARD_ATTACH:
+		req->err = sock_attach(req->s);
+		shard_req_done(req);
+		break;
+
+	case SHARD_DETACH:
+		sock_detach(req->s);
+		shard_req_done(req);
+		break;
+
+	case SHARD_TERMINATE:
+		re_cancel();
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+/* Run cmd on the shard thread and wait for it */
+static int shard_call(struct media_shard *shard, int cmd, struct stream *s)
+{
+	struct shard_req req;
+	int err;
+
+	req.s = s;
+	req.err = 0;
+	req.done = false;
+	pthread_mutex_init(&req.mutex, NULL);
+	pthread_cond_init(&req.cond, NULL);
+
+	err = mqueue_push(shard->mq, cmd, &req);
+	if (!err) {
+		pthread_mutex_lock(&req.mutex);
+		while (!req.done)
+			pthread_cond_wait(&req.cond, &req.mutex);
+		pthread_mutex_unlock(&req.mutex);
+	}
+
+	pthread_cond_destroy(&req.cond);
+	pthread_mutex_destroy(&req.mutex);
+
+	return err ? err : req.err;
+}
+
+
+/* Receive sockets go back to the UA thread if the worker can't take them */
+static void sock_attach_main(struct stream *s)
+{
+	int err = sock_attach(s);
+
+	if (err)
+		warning("media_shard: attach to main thread failed (%m),"
+			" no media received\n", err);
+}
+
+
+struct shard_run_params {
+	struct media_shard *shard;
+	int pfd[2];
+};
+
+static void *shard_run(void *arg)
+{
+	struct shard_run_params *params = arg;
+	struct media_shard *shard = params->shard;
+	int err;
+
+	re_thread_init();
+	fd_setsize(8192);
+
+	err = mqueue_alloc(&shard->mq, shard_cmd_handler, shard);
+	if (err)
+		warning("media_shard: mqueue_alloc failed (%m)\n", err);
+
+	if (write(params->pfd[1], &err, sizeof(err)) < 0)
+		warning("media_shard: pipe write failed.\n");
+
+	if (!err)
+		re_main(NULL);
+
+	shard->mq = mem_deref(shard->mq);
+	re_thread_close();
+	return NULL;
+}
+
+
+static int shard_start(struct media_shard *shard)
+{
+	struct shard_run_params params;
+	int err = 0;
+
+	params.shard = shard;
+	if (pipe(params.pfd) < 0)
+		return errno;
+
+	if (pthread_create(&shard->thid, NULL, shard_run, &params))
+		err = ENOMEM;
+	else if (read(params.pfd[0], &err, sizeof(err)) < 0)
+		err = errno;
+
+	(void)close(params.pfd[0]);
+	(void)close(params.pfd[1]);
+
+	return err;
+}
+
+
+/**
+ * Start the media workers, with num 0 media stays on the UA threads
+ *
+ * @param num Number of worker threads
+ *
+ * @return 0 if success, otherwise errorcode
+ */
+int media_shards_init(unsigned num)
+{
+	unsigned i;
+	int err = 0;
+
+	if (num > MEDIA_SHARD_MAX)
+		num = MEDIA_SHARD_MAX;
+
+	for (i = 0; i < num; i++) {
+		shards[i].index = i;
+		shards[i].streams = 0;
+		shards[i].failed = false;
+
+		err = shard_start(&shards[i]);
+		if (err) {
+			warning("media_shard: start worker %u failed (%m)\n",
+				i, err);
+			break;
+		}
+		shard_num++;
+	}
+
+	if (shard_num)
+		info("media_shard: %u media workers\n", shard_num);
+
+	return err;
+}
+
+
+void media_shards_close(void)
+{
+	unsigned i;
+
+	for (i = 0; i < shard_num; i++) {
+		if (shards[i].mq)
+			mqueue_push(shards[i].mq, SHARD_TERMINATE, NULL);
+		pthread_join(shards[i].thid, NULL);
+	}
+
+	shard_num = 0;
+}
+
+
+/*
+ * Streams of one call share a shard so audio and video are handled in
+ * order with each other, new calls go to the least loaded shard.
+ */
+static struct media_shard *shard_select(const struct stream *s)
+{
+	struct media_shard *shard = NULL;
+	struct le *le;
+	unsigned i;
+
+	for (le = list_head(call_streaml(s->call)); le; le = le->next) {
+		const struct stream *strm = le->data;
+
+		if (strm != s && strm->shard && !strm->shard->failed)
+			return strm->shard;
+	}
+
+	for (i = 0; i < shard_num; i++) {
+		if (shards[i].failed)
+			continue;
+		if (!shard || shards[i].streams < shard->streams)
+			shard = &shards[i];
+	}
+
+	return shard;
+}
+
+
+/**
+ * Move the receive sockets of a stream to a media worker, must be called
+ * from the thread owning the stream
+ *
+ * @param s Media stream
+ */
+void stream_shard_attach(struct stream *s)
+{
+	struct media_shard *shard;
+	int err;
+
+	if (!s || s->shard || !shard_num)
+		return;
+
+	/* Encryption and NAT traversal state is driven by the UA thread */
+	if (s->menc || s->mns)
+		return;
+
+	pthread_mutex_lock(&shard_lock);
+	shard = shard_select(s);
+	if (shard)
+		shard->streams++;
+	pthread_mutex_unlock(&shard_lock);
+
+	if (!shard)
+		return;
+
+	sock_detach(s);
+
+	err = shard_call(shard, SHARD_ATTACH, s);
+	if (err) {
+		warning("media_shard: attach to worker %u failed (%m),"
+			" media stays on main thread\n", shard->index, err);
+		sock_attach_main(s);
+		pthread_mutex_lock(&shard_lock);
+		shard->streams--;
+		pthread_mutex_unlock(&shard_lock);
+		return;
+	}
+
+	s->shard = shard;
+}
+
+
+/**
+ * Bring the receive sockets of a stream back to the calling thread, after
+ * return no handler of the stream runs on the media worker, unless the
+ * worker could not be reached, which is logged
+ *
+ * @param s Media stream
+ */
+void stream_shard_detach(struct stream *s)
+{
+	struct media_shard *shard;
+	unsigned tries = 0;
+	int err;
+
+	if (!s || !s->shard)
+		return;
+
+	shard = s->shard;
+
+	while ((err = shard_call(shard, SHARD_DETACH, s))) {
+		if (++tries >= DETACH_RETRY_MAX)
+			break;
+		(void)usleep(DETACH_RETRY_US);
+	}
+
+	/*
+	 * An unreachable worker may still poll the sockets until they are
+	 * closed with the stream, it takes no new streams from now on
+	 */
+	if (err) {
+		warning("media_shard: detach from worker %u failed (%m),"
+			" media moves to main thread\n", shard->index, err);
+	}
+
+	sock_attach_main(s);
+
+	pthread_mutex_lock(&shard_lock);
+	if (err)
+		shard->failed = true;
+	shard->streams--;
+	pthread_mutex_unlock(&shard_lock);
+
+	s->shard = NULL;
+}
@@ -1,4 +1,5 @@
 #include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <re/re.h>
@@ -210,9 +211,25 @@ void sipua_delete(struct sipua_entity *sipua)
 	pthread_join(thread, NULL);
 }
 
+int sipua_laddr(struct sipua_entity *sipua, char *buf, size_t size)
+{
+	struct sa laddr;
+	int err;
+
+	if (!sipua || !sipua->uag || !buf || !size)
+		return EINVAL;
+
+	err = sip_transp_laddr(sipua->uag->sip, &laddr, SIP_TRANSP_UDP, NULL);
+	if (err)
+		return err;
+
+	return re_snprintf(buf, size, "%J", &laddr) < 0 ? ENOMEM : 0;
+}
+
 int sipua_mod_init(void/*const char *dlpath*/)
 {
     int err = 0;
+	const char *workers;
 
 	(void)sys_coredump_set(true);
 
@@ -240,6 +257,13 @@ int sipua_mod_init(void/*const char *dlpath*/)
 		goto out;
 	}
 
+	/* Media workers are optional, without them media stays on UA threads */
+	workers = getenv("OWT_SIP_MEDIA_WORKERS");
+	if (workers && atoi(workers) > 0) {
+		if (media_shards_init(atoi(workers)))
+			warning("sipua: media workers not fully started\n");
+	}
+
 	log_enable_debug(true);
 
 	info("sipua is ready.\n");
@@ -252,6 +276,7 @@ int usleep(unsigned long usec);
 void sipua_mod_close(void){
 	list_flush(&sipual);
 	unload_modules();
+	media_shards_close();
 
     dnsc_delete();
     net_close();
@@ -305,23 +330,52 @@ void sipua_accept(struct sipua_entity *sipua, const char* peer)
 	return;
 }
 
+/* The owner may be freed once a reset returns, so a reset waits for the UA thread */
+static void reset_call_owner(struct sipua_entity *sipua, void *call)
+{
+	struct sipua_call_disconnect req;
+
+	if (pthread_equal(pthread_self(), sipua->thid)) {
+		call_set_owner((struct call*)call, NULL);
+		return;
+	}
+
+	req.call = call;
+	req.done = false;
+	pthread_mutex_init(&req.mutex, NULL);
+	pthread_cond_init(&req.cond, NULL);
+
+	if (!mqueue_push(sipua->mq, SIPUA_CALL_DISCONNECT, &req)) {
+		pthread_mutex_lock(&req.mutex);
+		while (!req.done)
+			pthread_cond_wait(&req.cond, &req.mutex);
+		pthread_mutex_unlock(&req.mutex);
+	} else {
+		warning("sipua: reset call owner on UA thread failed!\n");
+		call_set_owner((struct call*)call, NULL);
+	}
+
+	pthread_cond_destroy(&req.cond);
+	pthread_mutex_destroy(&req.mutex);
+}
+
 void sipua_set_call_owner(struct sipua_entity *sipua, void *call, void *callowner)
 {
        struct sipua_call_connect * data = NULL;
-       //FIX ME, lock
 	if (!sipua || !sipua->mq) {
 		warning("sipua entity NULL!\n");
 		return;
 	}
+
+        if (!callowner) {
+	    reset_call_owner(sipua, call);
+	    return;
+        }
+
 	data = mem_zalloc(sizeof(struct sipua_call_connect), NULL);
 	data->call = call;
 	data->owner = callowner;
-
-        if (callowner) {
-	    mqueue_push(sipua->mq, SIPUA_CALL_CONNECT, data);
-        } else {
-	    mqueue_push(sipua->mq, SIPUA_CALL_DISCONNECT, data);
-        }
+	mqueue_push(sipua->mq, SIPUA_CALL_CONNECT, data);
 	return;
 }
 
@@ -49,10 +49,16 @@ static void sipua_do_call_connect(void *data, void *arg)
 
 static void sipua_do_call_disconnect(void *data, void *arg)
 {
-	struct sipua_call_connect *connect = (struct sipua_call_connect *)data;
-        (void)arg;
-        call_set_owner((struct call*)(connect->call), NULL);
-	mem_deref(connect);
+	struct sipua_call_disconnect *disconnect = (struct sipua_call_disconnect *)data;
+	(void)arg;
+
+	/* Returns only after media workers stopped using the owner */
+	call_set_owner((struct call*)(disconnect->call), NULL);
+
+	pthread_mutex_lock(&disconnect->mutex);
+	disconnect->done = true;
+	pthread_cond_signal(&disconnect->cond);
+	pthread_mutex_unlock(&disconnect->mutex);
 	return;
 }
 
@@ -1,6 +1,7 @@
 #ifndef SIPUA_ACTIONS_H_
 #define SIPUA_ACTIONS_H_
 
+#include <pthread.h>
 
 enum sipua_cmd_code {
 	SIPUA_TERMINATE = 1,
@@ -29,6 +30,14 @@ struct sipua_call_connect {
        void *owner;
 };
 
+/* Owner reset, the caller waits on it until the UA thread is done */
+struct sipua_call_disconnect {
+	void *call;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool done;
+};
+
 void sipua_cmd_handler(int id, void *data, void *arg);
 
 #endif
@@ -10,6 +10,7 @@ SRCS	+= audio.c
 SRCS	+= call.c
 SRCS	+= conf.c
 SRCS	+= log.c
+SRCS	+= media_shard.c
 SRCS	+= metric.c
 SRCS	+= mnat.c
 SRCS    += menc.c
@@ -77,6 +77,9 @@ static void stream_destructor(void *arg)
 {
 	struct stream *s = arg;
 
+	/* No receive handler may run once the stream is gone */
+	stream_shard_detach(s);
+
 	if (s->cfg.rtp_stats)
 		print_rtp_stats(s);
 
@@ -329,6 +332,8 @@ int stream_alloc(struct stream **sp, const struct config_avt *cfg,
 
 	list_append(call_streaml(call), &s->le, s);
 
+	stream_shard_attach(s);
+
  out:
 	if (err)
 		mem_deref(s);
@@ -402,6 +407,40 @@ int stream_send(struct stream *s, bool marker, int pt, uint32_t ts,
 }
 
 
+/**
+ * Send an RTP packet relayed from the conference without copying, the new
+ * RTP header is written in place in front of the payload
+ *
+ * @param s      Media stream
+ * @param marker RTP marker bit
+ * @param ts     RTP timestamp
+ * @param data   Packet including the original RTP header
+ * @param pl_pos Payload offset in the packet
+ * @param len    Packet length
+ *
+ * @return 0 if success, ENOTSUP if the packet must be copied
+ */
+int stream_relay(struct stream *s, bool marker, uint32_t ts,
+		 uint8_t *data, size_t pl_pos, size_t len)
+{
+	struct mbuf mb;
+
+	if (!s || !data || pl_pos < RTP_HEADER_SIZE || pl_pos > len)
+		return EINVAL;
+
+	/* Encryption and NAT helpers may grow the packet */
+	if (s->menc || s->mns)
+		return ENOTSUP;
+
+	mb.buf  = data;
+	mb.size = len;
+	mb.pos  = pl_pos;
+	mb.end  = len;
+
+	return stream_send(s, marker, -1, ts, &mb);
+}
+
+
 static void stream_remote_set(struct stream *s)
 {
 	struct sa rtcp;
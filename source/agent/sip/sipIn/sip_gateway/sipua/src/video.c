@@ -434,7 +434,7 @@ static void stream_recv_handler(const struct rtp_header *hdr,
 {
 	struct video *v = arg;
 	int err;
-        void* call_owner = (v->call ? call_get_owner(v->call) : NULL);
+        void* call_owner;
 
 	if (!mb)
 		return;
@@ -447,10 +447,16 @@ static void stream_recv_handler(const struct rtp_header *hdr,
 	}
 
 	mb->pos = 0;
-    if (mbuf_get_left(mb) && v->call && call_owner) {
+    if (!mbuf_get_left(mb))
+        return;
+
+    /* Runs on a media worker, keep the owner from being reset meanwhile */
+    call_owner = call_owner_acquire(v->call);
+    if (call_owner) {
         ++v->vrx.rx_counter;
         call_connection_rx_video(call_owner, mbuf_buf(mb), mbuf_get_left(mb));
     }
+    call_owner_release(v->call);
 }
 
 
@@ -459,9 +465,9 @@ static void rtcp_handler(struct rtcp_msg *msg, void *arg)
 	struct video *v = arg;
   uint32_t fci[32] = {0};
   size_t i = 0;
-	void *owner = (v->call ? call_get_owner(v->call) : NULL);
+	void *owner = call_owner_acquire(v->call);
 	if (!owner)
-		return;
+		goto out;
 
 	switch (msg->hdr.pt) {
 
@@ -499,6 +505,9 @@ static void rtcp_handler(struct rtcp_msg *msg, void *arg)
 	default:
 		break;
 	}
+
+ out:
+	call_owner_release(v->call);
 }
 
 
@@ -886,9 +895,18 @@ void video_send(struct video *v, uint8_t *data, size_t len)
     	}
     
     	vtx = &v->vtx;
-        vtx->mb->pos = vtx->mb->end = STREAM_PRESZ;
-        pl_pos = hdr.ext ? RTP_HEADER_SIZE + 4 * hdr.cc + 4 + hdr.x.len : RTP_HEADER_SIZE + 4 * hdr.cc;
+        pl_pos = hdr.ext ? RTP_HEADER_SIZE + 4 * hdr.cc + 4 + 4 * hdr.x.len : RTP_HEADER_SIZE + 4 * hdr.cc;
         pl_len = len - pl_pos;
+
+        /* Packets come from our own packetizer, rewrite the header in place */
+        err = stream_relay(v->strm, hdr.m, hdr.ts, data, pl_pos, len);
+        if (err != ENOTSUP) {
+        	if (err)
+        		warning("video_send: stream_relay failed.\n");
+        	goto out;
+        }
+
+        vtx->mb->pos = vtx->mb->end = STREAM_PRESZ;
     
         err = mbuf_write_mem(vtx->mb, data + pl_pos , pl_len);
     	if (err) {
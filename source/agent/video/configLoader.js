@@ -46,6 +46,11 @@ module.exports.load = () => {
     config.video.hardwareAccelerated = !!config.video.hardwareAccelerated;
     config.video.enableBetterHEVCQuality = !!config.video.enableBetterHEVCQuality;
     config.video.MFE_timeout = config.video.MFE_timeout || 0;
+    config.video.decodeThreading = {
+      type: config.video.decodeThreadType || 'auto',
+      threads: (typeof config.video.decodeThreads === 'number') ? config.video.decodeThreads : 1,
+      limit: config.video.decodeThreadsLimit || 0
+    };
     let videoCap = require('./videoCapability').detected(config.video.hardwareAccelerated);
     config.video.hardwareAccelerated = videoCap.hw;
     config.video.codecs = videoCap.codecs;
@@ -0,0 +1,264 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "AvatarCache.h"
+
+#include "libyuv/scale.h"
+
+#include <fstream>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace mcu {
+
+// Scaled variants kept per image, least recently used are dropped
+static const size_t kMaxScaledVariants = 8;
+
+static std::atomic<uint32_t> g_images(0);
+static std::atomic<uint32_t> g_scaledImages(0);
+static std::atomic<uint64_t> g_bytes(0);
+static std::atomic<uint64_t> g_hits(0);
+static std::atomic<uint64_t> g_misses(0);
+static std::atomic<uint64_t> g_scaleHits(0);
+static std::atomic<uint64_t> g_scaleMisses(0);
+
+static uint64_t bufferBytes(const rtc::scoped_refptr<webrtc::I420Buffer> &buffer)
+{
+    return (uint64_t)buffer->StrideY() * buffer->height()
+        + (uint64_t)(buffer->StrideU() + buffer->StrideV()) * ((buffer->height() + 1) / 2);
+}
+
+DEFINE_LOGGER(AvatarImage, "mcu.media.AvatarImage");
+
+AvatarImage::AvatarImage(const std::string &url, time_t mtime, rtc::scoped_refptr<webrtc::I420Buffer> buffer)
+    : m_url(url)
+    , m_mtime(mtime)
+    , m_frame(new webrtc::VideoFrame(buffer, webrtc::kVideoRotation_0, 0))
+    , m_bytes(bufferBytes(buffer))
+    , m_useCounter(0)
+{
+    g_images++;
+    g_bytes += m_bytes;
+}
+
+AvatarImage::~AvatarImage()
+{
+    ELOG_DEBUG("Release avatar(%s)", m_url.c_str());
+
+    g_bytes -= m_bytes;
+    g_images--;
+
+    for (auto &it : m_scaled) {
+        g_bytes -= bufferBytes(it.second.buffer);
+        g_scaledImages--;
+    }
+}
+
+bool AvatarImage::ScaleKey::operator<(const ScaleKey &other) const
+{
+    if (srcX != other.srcX)
+        return srcX < other.srcX;
+    if (srcY != other.srcY)
+        return srcY < other.srcY;
+    if (srcWidth != other.srcWidth)
+        return srcWidth < other.srcWidth;
+    if (srcHeight != other.srcHeight)
+        return srcHeight < other.srcHeight;
+    if (dstWidth != other.dstWidth)
+        return dstWidth < other.dstWidth;
+    return dstHeight < other.dstHeight;
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface> AvatarImage::getScaled(
+        uint32_t srcX, uint32_t srcY, uint32_t srcWidth, uint32_t srcHeight,
+        uint32_t dstWidth, uint32_t dstHeight)
+{
+    if (dstWidth == 0 || dstHeight == 0)
+        return NULL;
+
+    ScaleKey key{srcX, srcY, srcWidth, srcHeight, dstWidth, dstHeight};
+
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+
+    auto it = m_scaled.find(key);
+    if (it != m_scaled.end()) {
+        it->second.lastUse = ++m_useCounter;
+        g_scaleHits++;
+        return it->second.buffer;
+    }
+    g_scaleMisses++;
+
+    if (m_scaled.size() >= kMaxScaledVariants) {
+        auto oldest = m_scaled.begin();
+        for (auto it2 = m_scaled.begin(); it2 != m_scaled.end(); ++it2) {
+            if (it2->second.lastUse < oldest->second.lastUse)
+                oldest = it2;
+        }
+        g_bytes -= bufferBytes(oldest->second.buffer);
+        g_scaledImages--;
+        m_scaled.erase(oldest);
+    }
+
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> src = m_frame->video_frame_buffer();
+    rtc::scoped_refptr<webrtc::I420Buffer> dst = webrtc::I420Buffer::Create(dstWidth, dstHeight);
+
+    int ret = libyuv::I420Scale(
+            src->DataY() + srcY * src->StrideY() + srcX, src->StrideY(),
+            src->DataU() + (srcY * src->StrideU() + srcX) / 2, src->StrideU(),
+            src->DataV() + (srcY * src->StrideV() + srcX) / 2, src->StrideV(),
+            srcWidth, srcHeight,
+            dst->MutableDataY(), dst->StrideY(),
+            dst->MutableDataU(), dst->StrideU(),
+            dst->MutableDataV(), dst->StrideV(),
+            dstWidth, dstHeight,
+            libyuv::kFilterBox);
+    if (ret != 0) {
+        ELOG_ERROR("I420Scale failed, ret %d", ret);
+        return NULL;
+    }
+
+    ELOG_DEBUG("Scale avatar(%s) to %dx%d", m_url.c_str(), dstWidth, dstHeight);
+
+    Scaled scaled{dst, ++m_useCounter};
+    m_scaled[key] = scaled;
+    g_bytes += bufferBytes(dst);
+    g_scaledImages++;
+    return dst;
+}
+
+DEFINE_LOGGER(AvatarCache, "mcu.media.AvatarCache");
+
+AvatarCache *AvatarCache::get()
+{
+    static AvatarCache cache;
+    return &cache;
+}
+
+bool AvatarCache::getImageSize(const std::string &url, uint32_t *pWidth, uint32_t *pHeight)
+{
+    uint32_t width, height;
+    size_t begin, end;
+    char *str_end = NULL;
+
+    begin = url.find('.');
+    if (begin == std::string::npos) {
+        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
+        return false;
+    }
+
+    end = url.find('x', begin);
+    if (end == std::string::npos) {
+        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
+        return false;
+    }
+
+    width = strtol(url.data() + begin + 1, &str_end, 10);
+    if (url.data() + end != str_end) {
+        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
+        return false;
+    }
+
+    begin = end;
+    end = url.find('.', begin);
+    if (end == std::string::npos) {
+        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
+        return false;
+    }
+
+    height = strtol(url.data() + begin + 1, &str_end, 10);
+    if (url.data() + end != str_end) {
+        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
+        return false;
+    }
+
+    *pWidth = width;
+    *pHeight = height;
+
+    ELOG_TRACE("Image size in url(%s), %dx%d", url.c_str(), *pWidth, *pHeight);
+    return true;
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> AvatarCache::loadImage(const std::string &url)
+{
+    uint32_t width, height;
+
+    if (!getImageSize(url, &width, &height))
+        return NULL;
+
+    std::ifstream in(url, std::ios::in | std::ios::binary);
+
+    in.seekg (0, in.end);
+    uint32_t size = in.tellg();
+    in.seekg (0, in.beg);
+
+    if (size <= 0 || ((width * height * 3 + 1) / 2) != size) {
+        ELOG_WARN("Open avatar image(%s) error, invalid size %d, expected size %d"
+                , url.c_str(), size, (width * height * 3 + 1) / 2);
+        return NULL;
+    }
+
+    std::vector<char> image(size);
+    in.read (image.data(), size);
+    in.close();
+
+    return webrtc::I420Buffer::Copy(
+            width, height,
+            reinterpret_cast<const uint8_t *>(image.data()), width,
+            reinterpret_cast<const uint8_t *>(image.data() + width * height), width / 2,
+            reinterpret_cast<const uint8_t *>(image.data() + width * height * 5 / 4), width / 2
+            );
+}
+
+boost::shared_ptr<AvatarImage> AvatarCache::acquire(const std::string &url)
+{
+    struct stat st;
+    if (stat(url.c_str(), &st) != 0) {
+        ELOG_WARN("Avatar image(%s) not found", url.c_str());
+        return NULL;
+    }
+
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+
+    auto it = m_images.find(url);
+    if (it != m_images.end()) {
+        boost::shared_ptr<AvatarImage> image = it->second.lock();
+        if (image && image->mtime() == st.st_mtime) {
+            g_hits++;
+            return image;
+        }
+    }
+    g_misses++;
+
+    // Drop entries released by all compositors
+    for (auto it2 = m_images.begin(); it2 != m_images.end();) {
+        if (it2->second.expired())
+            it2 = m_images.erase(it2);
+        else
+            ++it2;
+    }
+
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = loadImage(url);
+    if (!buffer)
+        return NULL;
+
+    ELOG_DEBUG("Load avatar(%s), %dx%d", url.c_str(), buffer->width(), buffer->height());
+
+    boost::shared_ptr<AvatarImage> image(new AvatarImage(url, st.st_mtime, buffer));
+    m_images[url] = image;
+    return image;
+}
+
+void AvatarCache::getStats(AvatarCacheStats &stats)
+{
+    stats.images = g_images;
+    stats.scaledImages = g_scaledImages;
+    stats.bytes = g_bytes;
+    stats.hits = g_hits;
+    stats.misses = g_misses;
+    stats.scaleHits = g_scaleHits;
+    stats.scaleMisses = g_scaleMisses;
+}
+
+}
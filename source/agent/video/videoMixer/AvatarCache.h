@@ -0,0 +1,102 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef AvatarCache_h
+#define AvatarCache_h
+
+#include <atomic>
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <webrtc/api/video/video_frame.h>
+#include <webrtc/api/video/i420_buffer.h>
+
+#include "logger.h"
+
+namespace mcu {
+
+struct AvatarCacheStats {
+    uint32_t images;
+    uint32_t scaledImages;
+    uint64_t bytes;         // decoded and scaled buffers
+    uint64_t hits;          // served without loading file
+    uint64_t misses;
+    uint64_t scaleHits;     // served without scaling
+    uint64_t scaleMisses;
+};
+
+/**
+ * Decoded avatar image shared by all compositors, keeps scaled variants
+ * per source crop and output size so each region is scaled only once.
+ */
+class AvatarImage {
+    DECLARE_LOGGER();
+
+public:
+    AvatarImage(const std::string &url, time_t mtime, rtc::scoped_refptr<webrtc::I420Buffer> buffer);
+    ~AvatarImage();
+
+    const std::string &url() const {return m_url;}
+    time_t mtime() const {return m_mtime;}
+    boost::shared_ptr<webrtc::VideoFrame> frame() {return m_frame;}
+
+    rtc::scoped_refptr<webrtc::I420BufferInterface> getScaled(
+            uint32_t srcX, uint32_t srcY, uint32_t srcWidth, uint32_t srcHeight,
+            uint32_t dstWidth, uint32_t dstHeight);
+
+private:
+    struct ScaleKey {
+        uint32_t srcX, srcY, srcWidth, srcHeight;
+        uint32_t dstWidth, dstHeight;
+
+        bool operator<(const ScaleKey &other) const;
+    };
+
+    struct Scaled {
+        rtc::scoped_refptr<webrtc::I420Buffer> buffer;
+        uint64_t lastUse;
+    };
+
+    std::string m_url;
+    time_t m_mtime;
+    boost::shared_ptr<webrtc::VideoFrame> m_frame;
+    uint64_t m_bytes;
+
+    boost::mutex m_mutex;
+    std::map<ScaleKey, Scaled> m_scaled;
+    uint64_t m_useCounter;
+};
+
+/**
+ * Process wide avatar cache keyed by path and modification time,
+ * an image lives as long as any compositor holds it.
+ */
+class AvatarCache {
+    DECLARE_LOGGER();
+
+public:
+    static AvatarCache *get();
+
+    // Returns the shared image, NULL if the file is invalid
+    boost::shared_ptr<AvatarImage> acquire(const std::string &url);
+
+    void getStats(AvatarCacheStats &stats);
+
+protected:
+    AvatarCache() {}
+
+    static bool getImageSize(const std::string &url, uint32_t *pWidth, uint32_t *pHeight);
+    static rtc::scoped_refptr<webrtc::I420Buffer> loadImage(const std::string &url);
+
+private:
+    boost::mutex m_mutex;
+    std::map<std::string, boost::weak_ptr<AvatarImage>> m_images;
+};
+
+}
+#endif /* AvatarCache_h */
@@ -19,8 +19,12 @@ namespace mcu {
 
 DEFINE_LOGGER(AvatarManager, "mcu.media.SoftVideoCompositor.AvatarManager");
 
+// Period to check avatar file for modification(ms)
+static const int64_t kAvatarCheckPeriod = 5000;
+
 AvatarManager::AvatarManager(uint8_t size)
     : m_size(size)
+    , m_clock(Clock::GetRealTimeClock())
 {
 }
 
@@ -28,87 +32,6 @@ AvatarManager::~AvatarManager()
 {
 }
 
-bool AvatarManager::getImageSize(const std::string &url, uint32_t *pWidth, uint32_t *pHeight)
-{
-    uint32_t width, height;
-    size_t begin, end;
-    char *str_end = NULL;
-
-    begin = url.find('.');
-    if (begin == std::string::npos) {
-        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
-        return false;
-    }
-
-    end = url.find('x', begin);
-    if (end == std::string::npos) {
-        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
-        return false;
-    }
-
-    width = strtol(url.data() + begin + 1, &str_end, 10);
-    if (url.data() + end != str_end) {
-        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
-        return false;
-    }
-
-    begin = end;
-    end = url.find('.', begin);
-    if (end == std::string::npos) {
-        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
-        return false;
-    }
-
-    height = strtol(url.data() + begin + 1, &str_end, 10);
-    if (url.data() + end != str_end) {
-        ELOG_WARN("Invalid image size in url(%s)", url.c_str());
-        return false;
-    }
-
-    *pWidth = width;
-    *pHeight = height;
-
-    ELOG_TRACE("Image size in url(%s), %dx%d", url.c_str(), *pWidth, *pHeight);
-    return true;
-}
-
-boost::shared_ptr<webrtc::VideoFrame> AvatarManager::loadImage(const std::string &url)
-{
-    uint32_t width, height;
-
-    if (!getImageSize(url, &width, &height))
-        return NULL;
-
-    std::ifstream in(url, std::ios::in | std::ios::binary);
-
-    in.seekg (0, in.end);
-    uint32_t size = in.tellg();
-    in.seekg (0, in.beg);
-
-    if (size <= 0 || ((width * height * 3 + 1) / 2) != size) {
-        ELOG_WARN("Open avatar image(%s) error, invalid size %d, expected size %d"
-                , url.c_str(), size, (width * height * 3 + 1) / 2);
-        return NULL;
-    }
-
-    char *image = new char [size];;
-    in.read (image, size);
-    in.close();
-
-    rtc::scoped_refptr<I420Buffer> i420Buffer = I420Buffer::Copy(
-            width, height,
-            reinterpret_cast<const uint8_t *>(image), width,
-            reinterpret_cast<const uint8_t *>(image + width * height), width / 2,
-            reinterpret_cast<const uint8_t *>(image + width * height * 5 / 4), width / 2
-            );
-
-    boost::shared_ptr<webrtc::VideoFrame> frame(new webrtc::VideoFrame(i420Buffer, webrtc::kVideoRotation_0, 0));
-
-    delete [] image;
-
-    return frame;
-}
-
 bool AvatarManager::setAvatar(uint8_t index, const std::string &url)
 {
     boost::unique_lock<boost::shared_mutex> lock(m_mutex);
@@ -131,7 +54,7 @@ bool AvatarManager::setAvatar(uint8_t index, const std::string &url)
         if (old_url == it2.second)
             return true;
     }
-    m_frames.erase(old_url);
+    m_avatars.erase(old_url);
     return true;
 }
 
@@ -152,11 +75,11 @@ bool AvatarManager::unsetAvatar(uint8_t index)
         if (url == it2.second)
             return true;
     }
-    m_frames.erase(url);
+    m_avatars.erase(url);
     return true;
 }
 
-boost::shared_ptr<webrtc::VideoFrame> AvatarManager::getAvatarFrame(uint8_t index)
+boost::shared_ptr<AvatarImage> AvatarManager::getAvatar(uint8_t index)
 {
     boost::unique_lock<boost::shared_mutex> lock(m_mutex);
 
@@ -165,14 +88,17 @@ boost::shared_ptr<webrtc::VideoFrame> AvatarManager::getAvatarFrame(uint8_t inde
         ELOG_WARN("Not valid index(%d)", index);
         return NULL;
     }
-    auto it2 = m_frames.find(it->second);
-    if (it2 != m_frames.end()) {
-        return it2->second;
+
+    int64_t now = m_clock->TimeInMilliseconds();
+    auto it2 = m_avatars.find(it->second);
+    if (it2 != m_avatars.end() && now - it2->second.checkTime < kAvatarCheckPeriod) {
+        return it2->second.image;
     }
 
-    boost::shared_ptr<webrtc::VideoFrame> frame = loadImage(it->second);
-    m_frames[it->second] = frame;
-    return frame;
+    // Shared with other compositors, reloaded only if the file changed
+    Avatar avatar{AvatarCache::get()->acquire(it->second), now};
+    m_avatars[it->second] = avatar;
+    return avatar.image;
 }
 
 DEFINE_LOGGER(SoftInput, "mcu.media.SoftVideoCompositor.SoftInput");
@@ -399,8 +325,10 @@ void SoftFrameGenerator::onTimeout()
     }
 
     if (hasValidOutput) {
-        rtc::scoped_refptr<webrtc::VideoFrameBuffer> compositeBuffer = generateFrame();
+        rtc::scoped_refptr<webrtc::I420Buffer> compositeBuffer = generateFrame();
         if (compositeBuffer) {
+            // Composited fresh each tick, nothing else holds it yet
+            m_textDrawer->drawInPlace(compositeBuffer.get());
             webrtc::VideoFrame compositeFrame(
                     compositeBuffer,
                     webrtc::kVideoRotation_0,
@@ -417,8 +345,6 @@ void SoftFrameGenerator::onTimeout()
             frame.additionalInfo.video.width = compositeFrame.width();
             frame.additionalInfo.video.height = compositeFrame.height();
 
-            m_textDrawer->drawFrame(frame);
-
             {
                 boost::unique_lock<boost::shared_mutex> lock(m_outputMutex);
                 for (uint32_t i = 0; i <  m_outputs.size(); i++) {
@@ -439,7 +365,7 @@ void SoftFrameGenerator::onTimeout()
     m_counter = (m_counter + 1) % m_counterMax;
 }
 
-rtc::scoped_refptr<webrtc::VideoFrameBuffer> SoftFrameGenerator::generateFrame()
+rtc::scoped_refptr<webrtc::I420Buffer> SoftFrameGenerator::generateFrame()
 {
     reconfigureIfNeeded();
     return layout();
@@ -451,7 +377,11 @@ void SoftFrameGenerator::layout_regions(SoftFrameGenerator *t, rtc::scoped_refpt
     uint32_t composite_height = compositeBuffer->height();
 
     for (LayoutSolution::const_iterator it = regions.begin(); it != regions.end(); ++it) {
-        boost::shared_ptr<webrtc::VideoFrame> inputFrame = t->m_owner->getInputFrame(it->input);
+        boost::shared_ptr<AvatarImage> avatar;
+        boost::shared_ptr<webrtc::VideoFrame> inputFrame = t->m_owner->getInputFrame(it->input, avatar);
+        if (inputFrame == NULL && avatar) {
+            inputFrame = avatar->frame();
+        }
         if (inputFrame == NULL) {
             continue;
         }
@@ -506,6 +436,26 @@ void SoftFrameGenerator::layout_regions(SoftFrameGenerator *t, rtc::scoped_refpt
         cropped_dst_width   &= ~1;
         cropped_dst_height  &= ~1;
 
+        if (avatar) {
+            // Scaled once per region size and shared by all compositors
+            rtc::scoped_refptr<webrtc::I420BufferInterface> scaled = avatar->getScaled(
+                    src_x, src_y, src_width, src_height, cropped_dst_width, cropped_dst_height);
+            if (!scaled)
+                continue;
+
+            int ret = libyuv::I420Copy(
+                    scaled->DataY(), scaled->StrideY(),
+                    scaled->DataU(), scaled->StrideU(),
+                    scaled->DataV(), scaled->StrideV(),
+                    compositeBuffer->MutableDataY() + dst_y * compositeBuffer->StrideY() + dst_x, compositeBuffer->StrideY(),
+                    compositeBuffer->MutableDataU() + (dst_y * compositeBuffer->StrideU() + dst_x) / 2, compositeBuffer->StrideU(),
+                    compositeBuffer->MutableDataV() + (dst_y * compositeBuffer->StrideV() + dst_x) / 2, compositeBuffer->StrideV(),
+                    cropped_dst_width, cropped_dst_height);
+            if (ret != 0)
+                ELOG_ERROR("I420Copy failed, ret %d", ret);
+            continue;
+        }
+
         int ret = libyuv::I420Scale(
                 inputBuffer->DataY() + src_y * inputBuffer->StrideY() + src_x, inputBuffer->StrideY(),
                 inputBuffer->DataU() + (src_y * inputBuffer->StrideU() + src_x) / 2, inputBuffer->StrideU(),
@@ -521,7 +471,7 @@ void SoftFrameGenerator::layout_regions(SoftFrameGenerator *t, rtc::scoped_refpt
     }
 }
 
-rtc::scoped_refptr<webrtc::VideoFrameBuffer> SoftFrameGenerator::layout()
+rtc::scoped_refptr<webrtc::I420Buffer> SoftFrameGenerator::layout()
 {
     rtc::scoped_refptr<webrtc::I420Buffer> compositeBuffer = m_bufferManager->getFreeBuffer(m_size.width, m_size.height);
     if (!compositeBuffer) {
@@ -700,7 +650,7 @@ bool SoftVideoCompositor::removeOutput(owt_base::FrameDestination *dst)
     return false;
 }
 
-boost::shared_ptr<webrtc::VideoFrame> SoftVideoCompositor::getInputFrame(int index)
+boost::shared_ptr<webrtc::VideoFrame> SoftVideoCompositor::getInputFrame(int index, boost::shared_ptr<AvatarImage> &avatar)
 {
     boost::shared_ptr<webrtc::VideoFrame> src;
 
@@ -708,7 +658,7 @@ boost::shared_ptr<webrtc::VideoFrame> SoftVideoCompositor::getInputFrame(int ind
     if (input->isActive()) {
         src = input->popInput();
     } else {
-        src = m_avatarManager->getAvatarFrame(index);
+        avatar = m_avatarManager->getAvatar(index);
     }
 
     return src;
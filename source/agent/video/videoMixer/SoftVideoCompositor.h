@@ -24,6 +24,7 @@
 #include "VideoLayout.h"
 #include "I420BufferManager.h"
 #include "FFmpegDrawText.h"
+#include "AvatarCache.h"
 
 namespace mcu {
 class SoftVideoCompositor;
@@ -38,17 +39,19 @@ public:
     bool setAvatar(uint8_t index, const std::string &url);
     bool unsetAvatar(uint8_t index);
 
-    boost::shared_ptr<webrtc::VideoFrame> getAvatarFrame(uint8_t index);
-
-protected:
-    bool getImageSize(const std::string &url, uint32_t *pWidth, uint32_t *pHeight);
-    boost::shared_ptr<webrtc::VideoFrame> loadImage(const std::string &url);
+    boost::shared_ptr<AvatarImage> getAvatar(uint8_t index);
 
 private:
+    struct Avatar {
+        boost::shared_ptr<AvatarImage> image;
+        int64_t checkTime;
+    };
+
     uint8_t m_size;
+    const webrtc::Clock *m_clock;
 
     std::map<uint8_t, std::string> m_inputs;
-    std::map<std::string, boost::shared_ptr<webrtc::VideoFrame>> m_frames;
+    std::map<std::string, Avatar> m_avatars;
 
     boost::shared_mutex m_mutex;
 };
@@ -113,8 +116,8 @@ public:
     void onTimeout() override;
 
 protected:
-    rtc::scoped_refptr<webrtc::VideoFrameBuffer> generateFrame();
-    rtc::scoped_refptr<webrtc::VideoFrameBuffer> layout();
+    rtc::scoped_refptr<webrtc::I420Buffer> generateFrame();
+    rtc::scoped_refptr<webrtc::I420Buffer> layout();
     static void layout_regions(SoftFrameGenerator *t, rtc::scoped_refptr<webrtc::I420Buffer> compositeBuffer, const LayoutSolution &regions);
 
     void reconfigureIfNeeded();
@@ -186,7 +189,8 @@ public:
     void clearText();
 
 protected:
-    boost::shared_ptr<webrtc::VideoFrame> getInputFrame(int index);
+    // Returns the input frame, or sets avatar for an inactive input
+    boost::shared_ptr<webrtc::VideoFrame> getInputFrame(int index, boost::shared_ptr<AvatarImage> &avatar);
 
 private:
     uint32_t m_maxInput;
@@ -29,6 +29,10 @@ struct VideoMixerConfig {
     } bgColor;
     bool useGacc;
     uint32_t MFE_timeout;
+    // Software decoding threading, see FFmpegFrameDecoder
+    std::string decodeThreadType;
+    uint32_t decodeThreads;
+    uint32_t decodeThreadsLimit;
 };
 
 class VideoMixer {
@@ -55,6 +55,7 @@ void VideoMixer::Init(Local<Object> exports, Local<Object> module) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "forceKeyFrame", forceKeyFrame);
   NODE_SET_PROTOTYPE_METHOD(tpl, "drawText", drawText);
   NODE_SET_PROTOTYPE_METHOD(tpl, "clearText", clearText);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "getAvatarCacheStats", getAvatarCacheStats);
 
   constructor.Reset(isolate, Nan::GetFunction(tpl).ToLocalChecked());
   Nan::Set(module, Nan::New("exports").ToLocalChecked(),
@@ -85,6 +86,12 @@ void VideoMixer::New(const v8::FunctionCallbackInfo<v8::Value>& args) {
   }
   config.useGacc = Nan::To<bool>(nanGetChecked(options, "gaccplugin")).FromJust();
   config.MFE_timeout = Nan::To<int32_t>(nanGetChecked(options, "MFE_timeout")).FromJust();
+  Local<Value> decodeThreadType = nanGetChecked(options, "decodeThreadType");
+  config.decodeThreadType = decodeThreadType->IsString() ? getString(decodeThreadType) : "auto";
+  Local<Value> decodeThreads = nanGetChecked(options, "decodeThreads");
+  config.decodeThreads = decodeThreads->IsNumber() ? Nan::To<int32_t>(decodeThreads).FromJust() : 1;
+  Local<Value> decodeThreadsLimit = nanGetChecked(options, "decodeThreadsLimit");
+  config.decodeThreadsLimit = decodeThreadsLimit->IsNumber() ? Nan::To<int32_t>(decodeThreadsLimit).FromJust() : 0;
 
   VideoMixer* obj = new VideoMixer();
   obj->me = new mcu::VideoMixer(config);
@@ -285,3 +292,21 @@ void VideoMixer::clearText(const v8::FunctionCallbackInfo<v8::Value>& args) {
   me->clearText();
 }
 
+void VideoMixer::getAvatarCacheStats(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  Isolate* isolate = Isolate::GetCurrent();
+  HandleScope scope(isolate);
+
+  // Cache is process wide, shared by all mixers
+  mcu::AvatarCacheStats stats;
+  mcu::AvatarCache::get()->getStats(stats);
+
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("images").ToLocalChecked(), Nan::New(stats.images));
+  Nan::Set(result, Nan::New("scaledImages").ToLocalChecked(), Nan::New(stats.scaledImages));
+  Nan::Set(result, Nan::New("bytes").ToLocalChecked(), Nan::New((double)stats.bytes));
+  Nan::Set(result, Nan::New("hits").ToLocalChecked(), Nan::New((double)stats.hits));
+  Nan::Set(result, Nan::New("misses").ToLocalChecked(), Nan::New((double)stats.misses));
+  Nan::Set(result, Nan::New("scaleHits").ToLocalChecked(), Nan::New((double)stats.scaleHits));
+  Nan::Set(result, Nan::New("scaleMisses").ToLocalChecked(), Nan::New((double)stats.scaleMisses));
+  args.GetReturnValue().Set(result);
+}
@@ -6,6 +6,7 @@
 #define VIDEOMIXERWRAPPER_H
 
 #include "../../addons/common/MediaFramePipelineWrapper.h"
+#include "AvatarCache.h"
 #include "VideoMixer.h"
 #include <node.h>
 #include <node_object_wrap.h>
@@ -39,6 +40,8 @@ class VideoMixer : public node::ObjectWrap {
 
   static void drawText(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void clearText(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  static void getAvatarCacheStats(const v8::FunctionCallbackInfo<v8::Value>& args);
 };
 
 #endif
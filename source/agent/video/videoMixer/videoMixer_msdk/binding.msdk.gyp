@@ -5,6 +5,7 @@
       '../addon.cc',
       '../VideoMixerWrapper.cc',
       '../MsdkVideoCompositor.cpp',
+      '../AvatarCache.cpp',
       '../VideoMixer.cpp',
       '../../../../core/owt_base/I420BufferManager.cpp',
       '../../../../core/owt_base/MediaFramePipeline.cpp',
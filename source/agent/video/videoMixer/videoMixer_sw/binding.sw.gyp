@@ -5,6 +5,7 @@
       '../addon.cc',
       '../VideoMixerWrapper.cc',
       '../SoftVideoCompositor.cpp',
+      '../AvatarCache.cpp',
       '../VideoMixer.cpp',
       '../../../../core/owt_base/I420BufferManager.cpp',
       '../../../../core/owt_base/MediaFramePipeline.cpp',
@@ -13,6 +14,7 @@
       '../../../../core/owt_base/VCMFrameEncoder.cpp',
       '../../../../core/owt_base/FFmpegFrameDecoder.cpp',
       '../../../../core/owt_base/FFmpegDrawText.cpp',
+      '../../../../core/owt_base/TextAtlas.cpp',
       '../../../../core/owt_base/SVTHEVCEncoder.cpp',
       '../../../../core/common/JobTimer.cpp',
     ],
@@ -21,6 +23,7 @@
         '-O$(OPTIMIZATION_LEVEL)',
         '-g',
         '-std=c++11',
+        '<!@(pkg-config --cflags freetype2)',
         '-DWEBRTC_POSIX',
         '-DENABLE_SVT_HEVC_ENCODER',
     ],
@@ -45,6 +48,7 @@
       '<!@(pkg-config --libs libavcodec)',
       '<!@(pkg-config --libs libavformat)',
       '<!@(pkg-config --libs libavfilter)',
+      '<!@(pkg-config --libs freetype2)',
       '-L$(DEFAULT_DEPENDENCY_PATH)/lib',
       '-lSvtHevcEnc',
     ],
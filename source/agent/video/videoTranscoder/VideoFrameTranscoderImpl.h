@@ -7,10 +7,14 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <algorithm>
 #include <map>
+#include <sstream>
 #include <MediaUtilities.h>
 #include <MediaFramePipeline.h>
+#include <MediaFrameMulticaster.h>
 #include <VideoFrameTranscoder.h>
 
 #include <VCMFrameDecoder.h>
@@ -74,24 +78,136 @@ public:
     void onFrame(const owt_base::Frame& frame) {deliverFrame(frame);}
 
 private:
+    // Fans one encoded stream out to all outputs of the same rendition, the
+    // encoder follows the lowest bitrate requested by any of the outputs
+    class StreamFanout : public owt_base::MediaFrameMulticaster {
+    public:
+        // Per-output hop, tags bitrate feedback with the output it came from
+        class Branch : public owt_base::FrameSource, public owt_base::FrameDestination {
+        public:
+            Branch(StreamFanout* fanout) : m_fanout(fanout) {}
+
+            void onFrame(const owt_base::Frame& frame) {deliverFrame(frame);}
+            void onMetaData(const owt_base::MetaData& metadata) {deliverMetaData(metadata);}
+
+            void onFeedback(const owt_base::FeedbackMsg& msg)
+            {
+                if (msg.type == owt_base::VIDEO_FEEDBACK && msg.cmd == owt_base::SET_BITRATE) {
+                    m_fanout->setBranchBitrate(this, msg.data.kbps);
+                    return;
+                }
+                deliverFeedbackMsg(msg);
+            }
+
+        private:
+            StreamFanout* m_fanout;
+        };
+
+        StreamFanout(unsigned short bitrateKbps)
+            : m_targetKbps(bitrateKbps)
+            , m_currentKbps(bitrateKbps)
+        {
+        }
+
+        boost::shared_ptr<Branch> addBranch(owt_base::FrameDestination* dest)
+        {
+            boost::shared_ptr<Branch> branch(new Branch(this));
+            branch->addVideoDestination(dest);
+            addVideoDestination(branch.get());
+            return branch;
+        }
+
+        void removeBranch(const boost::shared_ptr<Branch>& branch, owt_base::FrameDestination* dest)
+        {
+            removeVideoDestination(branch.get());
+            branch->removeVideoDestination(dest);
+            boost::unique_lock<boost::mutex> lock(m_bitrateMutex);
+            m_branchKbps.erase(branch.get());
+            updateBitrate(lock);
+        }
+
+        // False once feedback has moved the encoder off the configured bitrate
+        bool atTargetBitrate()
+        {
+            boost::unique_lock<boost::mutex> lock(m_bitrateMutex);
+            return m_currentKbps == m_targetKbps;
+        }
+
+    private:
+        void setBranchBitrate(const Branch* branch, unsigned short kbps)
+        {
+            boost::unique_lock<boost::mutex> lock(m_bitrateMutex);
+            m_branchKbps[branch] = kbps;
+            updateBitrate(lock);
+        }
+
+        void updateBitrate(boost::unique_lock<boost::mutex>& lock)
+        {
+            // Outputs that never reported leave the configured bitrate in place
+            unsigned short kbps = m_targetKbps;
+            if (!m_branchKbps.empty()) {
+                kbps = m_branchKbps.begin()->second;
+                for (auto it = m_branchKbps.begin(); it != m_branchKbps.end(); ++it)
+                    kbps = std::min(kbps, it->second);
+            }
+            if (kbps == m_currentKbps)
+                return;
+
+            m_currentKbps = kbps;
+            lock.unlock();
+            owt_base::FeedbackMsg msg(owt_base::VIDEO_FEEDBACK, owt_base::SET_BITRATE);
+            msg.data.kbps = kbps;
+            deliverFeedbackMsg(msg);
+        }
+
+        const unsigned short m_targetKbps;
+        unsigned short m_currentKbps;
+        std::map<const Branch*, unsigned short> m_branchKbps;
+        boost::mutex m_bitrateMutex;
+    };
+
     struct Input {
         owt_base::FrameSource* source;
         boost::shared_ptr<owt_base::VideoFrameDecoder> decoder;
     };
 
-    struct Output {
+    // Scaled frames of one size and frame rate, shared by renditions
+    struct Processer {
+        boost::shared_ptr<owt_base::VideoFrameProcesser> processer;
+        uint32_t refs;
+    };
+
+    // One encoder stream, shared by outputs of identical encoding parameters
+    struct Rendition {
+        std::string processerKey;
         boost::shared_ptr<owt_base::VideoFrameProcesser> processer;
 #ifdef BUILD_FOR_ANALYTICS
         boost::shared_ptr<owt_base::VideoFrameAnalyzer> analyzer;
 #endif
         boost::shared_ptr<owt_base::VideoFrameEncoder> encoder;
         int streamId;
+        boost::shared_ptr<StreamFanout> fanout;
+        uint32_t refs;
+    };
+
+    struct Output {
+        std::string renditionKey;
+        owt_base::FrameDestination* dest;
+        boost::shared_ptr<StreamFanout::Branch> branch;
     };
 
+    boost::shared_ptr<owt_base::VideoFrameProcesser> acquireProcesser(const std::string& key,
+            owt_base::FrameFormat format, const owt_base::VideoSize& size, const unsigned int framerateFPS);
+    void releaseProcesser(const std::string& key);
+    void destroyRendition(Rendition& rendition);
+    void rekeyRendition(std::map<std::string, Rendition>::iterator rit);
+
     std::map<int, Input> m_inputs;
     boost::shared_mutex m_inputMutex;
 
     std::map<int, Output> m_outputs;
+    std::map<std::string, Rendition> m_renditions;
+    std::map<std::string, Processer> m_processers;
     boost::shared_mutex m_outputMutex;
 };
 
@@ -104,16 +220,19 @@ VideoFrameTranscoderImpl::~VideoFrameTranscoderImpl()
     {
         boost::unique_lock<boost::shared_mutex> lock(m_outputMutex);
         for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
-            this->removeVideoDestination(it->second.processer.get());
-#ifdef BUILD_FOR_ANALYTICS
-            it->second.processer->removeVideoDestination(it->second.analyzer.get());
-            it->second.analyzer->removeVideoDestination(it->second.encoder.get());
-#else
-            it->second.processer->removeVideoDestination(it->second.encoder.get());
-#endif
-            it->second.encoder->degenerateStream(it->second.streamId);
+            auto rit = m_renditions.find(it->second.renditionKey);
+            if (rit != m_renditions.end())
+                rit->second.fanout->removeBranch(it->second.branch, it->second.dest);
         }
         m_outputs.clear();
+
+        for (auto it = m_renditions.begin(); it != m_renditions.end(); ++it)
+            destroyRendition(it->second);
+        m_renditions.clear();
+
+        for (auto it = m_processers.begin(); it != m_processers.end(); ++it)
+            this->removeVideoDestination(it->second.processer.get());
+        m_processers.clear();
     }
 
     {
@@ -202,9 +321,33 @@ inline bool VideoFrameTranscoderImpl::addOutput(int output,
 #ifdef BUILD_FOR_ANALYTICS
     boost::shared_ptr<owt_base::VideoFrameAnalyzer> analyzer;
 #endif
-    boost::upgrade_lock<boost::shared_mutex> lock(m_outputMutex);
+    boost::unique_lock<boost::shared_mutex> lock(m_outputMutex);
     int32_t streamId = -1;
 
+    if (m_outputs.find(output) != m_outputs.end())
+        return false;
+
+    std::ostringstream renditionKey;
+    renditionKey << format << "-" << profile << "-" << rootSize.width << "x" << rootSize.height
+        << "-" << framerateFPS << "-" << bitrateKbps << "-" << keyFrameIntervalSeconds;
+#ifdef BUILD_FOR_ANALYTICS
+    renditionKey << "-" << algorithm << "-" << pluginName;
+#endif
+
+    // Same encoding parameters, attach to the existing encoder stream
+    auto rit = m_renditions.find(renditionKey.str());
+    if (rit != m_renditions.end()) {
+        if (rit->second.fanout->atTargetBitrate()) {
+            rit->second.refs++;
+            m_outputs[output] = Output{.renditionKey = renditionKey.str(), .dest = dest,
+                .branch = rit->second.fanout->addBranch(dest)};
+            return true;
+        }
+        // Its bitrate is held down by the current outputs, move it aside so
+        // the new output gets a stream at the bitrate it asked for
+        rekeyRendition(rit);
+    }
+
 #ifdef ENABLE_MSDK
     if (!encoder && owt_base::MsdkFrameEncoder::supportFormat(format)) {
         encoder.reset(new owt_base::MsdkFrameEncoder(format, profile, false));
@@ -222,80 +365,142 @@ inline bool VideoFrameTranscoderImpl::addOutput(int output,
     if (!encoder)
         return false;
 
-    streamId = encoder->generateStream(rootSize.width, rootSize.height, framerateFPS, bitrateKbps, keyFrameIntervalSeconds, dest);
+    boost::shared_ptr<StreamFanout> fanout(new StreamFanout(bitrateKbps));
+    streamId = encoder->generateStream(rootSize.width, rootSize.height, framerateFPS, bitrateKbps, keyFrameIntervalSeconds, fanout.get());
     if (streamId < 0)
         return false;
 
+    // Renditions differing only in codec, bitrate or key frame interval share the scaled frames
+    std::ostringstream processerKey;
+    processerKey << encoder->getInputFormat() << "-" << rootSize.width << "x" << rootSize.height << "-" << framerateFPS;
+    processer = acquireProcesser(processerKey.str(), encoder->getInputFormat(), rootSize, framerateFPS);
     if (!processer) {
-        processer.reset(new owt_base::FrameProcesser());
-    }
-
-    if (!processer->init(encoder->getInputFormat(), rootSize.width, rootSize.height, framerateFPS))
+        encoder->degenerateStream(streamId);
         return false;
+    }
 
-    this->addVideoDestination(processer.get());
 #ifdef BUILD_FOR_ANALYTICS
     if (!analyzer) {
         analyzer.reset(new owt_base::FrameAnalyzer());
     }
-    if (!analyzer->init(encoder->getInputFormat(), rootSize.width, rootSize.height, framerateFPS, pluginName))
+    if (!analyzer->init(encoder->getInputFormat(), rootSize.width, rootSize.height, framerateFPS, pluginName)) {
+        encoder->degenerateStream(streamId);
+        releaseProcesser(processerKey.str());
         return false;
+    }
     processer->addVideoDestination(analyzer.get());
     analyzer->addVideoDestination(encoder.get());
 #else
     processer->addVideoDestination(encoder.get());
 #endif
-
-    boost::upgrade_to_unique_lock<boost::shared_mutex> uniqueLock(lock);
 #ifdef BUILD_FOR_ANALYTICS
-    Output out{.processer = processer, .analyzer = analyzer, .encoder = encoder, .streamId = streamId};
+    Rendition rendition{.processerKey = processerKey.str(), .processer = processer, .analyzer = analyzer,
+        .encoder = encoder, .streamId = streamId, .fanout = fanout, .refs = 1};
 #else
-    Output out{.processer = processer, .encoder = encoder, .streamId = streamId};
+    Rendition rendition{.processerKey = processerKey.str(), .processer = processer,
+        .encoder = encoder, .streamId = streamId, .fanout = fanout, .refs = 1};
 #endif
-    m_outputs[output] = out;
+    m_renditions[renditionKey.str()] = rendition;
+    m_outputs[output] = Output{.renditionKey = renditionKey.str(), .dest = dest, .branch = fanout->addBranch(dest)};
     return true;
 }
 
 inline void VideoFrameTranscoderImpl::removeOutput(int32_t output)
 {
-    boost::upgrade_lock<boost::shared_mutex> lock(m_outputMutex);
+    boost::unique_lock<boost::shared_mutex> lock(m_outputMutex);
     auto it = m_outputs.find(output);
-    if (it != m_outputs.end()) {
-        it->second.encoder->degenerateStream(it->second.streamId);
-        if (it->second.encoder->isIdle()) {
-            this->removeVideoDestination(it->second.processer.get());
+    if (it == m_outputs.end())
+        return;
+
+    auto rit = m_renditions.find(it->second.renditionKey);
+    Output out = it->second;
+    m_outputs.erase(it);
+    if (rit == m_renditions.end())
+        return;
+
+    Rendition& rendition = rit->second;
+    rendition.fanout->removeBranch(out.branch, out.dest);
+    if (--rendition.refs > 0)
+        return;
+
+    destroyRendition(rendition);
+    releaseProcesser(rendition.processerKey);
+    m_renditions.erase(rit);
+}
+
+inline boost::shared_ptr<owt_base::VideoFrameProcesser> VideoFrameTranscoderImpl::acquireProcesser(const std::string& key,
+        owt_base::FrameFormat format, const owt_base::VideoSize& size, const unsigned int framerateFPS)
+{
+    auto it = m_processers.find(key);
+    if (it != m_processers.end()) {
+        it->second.refs++;
+        return it->second.processer;
+    }
+
+    boost::shared_ptr<owt_base::VideoFrameProcesser> processer(new owt_base::FrameProcesser());
+    if (!processer->init(format, size.width, size.height, framerateFPS))
+        return nullptr;
+
+    this->addVideoDestination(processer.get());
+    m_processers[key] = Processer{.processer = processer, .refs = 1};
+    return processer;
+}
+
+inline void VideoFrameTranscoderImpl::releaseProcesser(const std::string& key)
+{
+    auto it = m_processers.find(key);
+    if (it != m_processers.end() && --it->second.refs == 0) {
+        this->removeVideoDestination(it->second.processer.get());
+        m_processers.erase(it);
+    }
+}
+
+inline void VideoFrameTranscoderImpl::destroyRendition(Rendition& rendition)
+{
+    rendition.encoder->degenerateStream(rendition.streamId);
 #ifdef BUILD_FOR_ANALYTICS
-            it->second.processer->removeVideoDestination(it->second.analyzer.get());
-            it->second.analyzer->removeVideoDestination(it->second.encoder.get());
+    rendition.processer->removeVideoDestination(rendition.analyzer.get());
+    rendition.analyzer->removeVideoDestination(rendition.encoder.get());
 #else
-            it->second.processer->removeVideoDestination(it->second.encoder.get());
+    rendition.processer->removeVideoDestination(rendition.encoder.get());
 #endif
-        }
-        boost::upgrade_to_unique_lock<boost::shared_mutex> ulock(lock);
-        m_outputs.erase(output);
+}
+
+inline void VideoFrameTranscoderImpl::rekeyRendition(std::map<std::string, Rendition>::iterator rit)
+{
+    std::ostringstream key;
+    key << rit->first << "#" << rit->second.encoder.get() << "-" << rit->second.streamId;
+    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
+        if (it->second.renditionKey == rit->first)
+            it->second.renditionKey = key.str();
     }
+    m_renditions[key.str()] = rit->second;
+    m_renditions.erase(rit);
 }
 
 inline void VideoFrameTranscoderImpl::requestKeyFrame(int output)
 {
     boost::shared_lock<boost::shared_mutex> lock(m_outputMutex);
     auto it = m_outputs.find(output);
-    if (it != m_outputs.end())
-        it->second.encoder->requestKeyFrame(it->second.streamId);
+    if (it != m_outputs.end()) {
+        auto rit = m_renditions.find(it->second.renditionKey);
+        if (rit != m_renditions.end())
+            rit->second.encoder->requestKeyFrame(rit->second.streamId);
+    }
 }
 
 #ifndef BUILD_FOR_ANALYTICS
 inline void VideoFrameTranscoderImpl::drawText(const std::string& textSpec)
 {
     boost::shared_lock<boost::shared_mutex> lock(m_outputMutex);
-    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it)
+    for (auto it = m_processers.begin(); it != m_processers.end(); ++it)
         it->second.processer->drawText(textSpec);
 }
 
 inline void VideoFrameTranscoderImpl::clearText()
 {
     boost::shared_lock<boost::shared_mutex> lock(m_outputMutex);
-    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it)
+    for (auto it = m_processers.begin(); it != m_processers.end(); ++it)
         it->second.processer->clearText();
 }
 #endif
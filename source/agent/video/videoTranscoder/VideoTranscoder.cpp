@@ -53,6 +53,8 @@ VideoTranscoder::VideoTranscoder(const VideoTranscoderConfig& config)
     }
 #endif
 
+    FFmpegFrameDecoder::setThreadingConfig(config.decodeThreadType, config.decodeThreads, config.decodeThreadsLimit);
+
     ELOG_INFO("Init");
 
     m_frameTranscoder.reset(new VideoFrameTranscoderImpl());
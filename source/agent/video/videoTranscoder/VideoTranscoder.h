@@ -18,6 +18,10 @@ namespace mcu {
 struct VideoTranscoderConfig {
     bool useGacc;
     uint32_t MFE_timeout;
+    // Software decoding threading, see FFmpegFrameDecoder
+    std::string decodeThreadType;
+    uint32_t decodeThreads;
+    uint32_t decodeThreadsLimit;
 };
 
 class VideoTranscoder {
@@ -52,6 +52,15 @@ void VideoTranscoder::New(const v8::FunctionCallbackInfo<v8::Value>& args) {
     Nan::Get(options, Nan::New("gaccplugin").ToLocalChecked()).ToLocalChecked()).FromJust();
   config.MFE_timeout = Nan::To<int32_t>(
     Nan::Get(options, Nan::New("MFE_timeout").ToLocalChecked()).ToLocalChecked()).FromJust();
+  Local<Value> decodeThreadType =
+    Nan::Get(options, Nan::New("decodeThreadType").ToLocalChecked()).ToLocalChecked();
+  config.decodeThreadType = decodeThreadType->IsString() ? getString(decodeThreadType) : "auto";
+  Local<Value> decodeThreads =
+    Nan::Get(options, Nan::New("decodeThreads").ToLocalChecked()).ToLocalChecked();
+  config.decodeThreads = decodeThreads->IsNumber() ? Nan::To<int32_t>(decodeThreads).FromJust() : 1;
+  Local<Value> decodeThreadsLimit =
+    Nan::Get(options, Nan::New("decodeThreadsLimit").ToLocalChecked()).ToLocalChecked();
+  config.decodeThreadsLimit = decodeThreadsLimit->IsNumber() ? Nan::To<int32_t>(decodeThreadsLimit).FromJust() : 0;
 
   VideoTranscoder* obj = new VideoTranscoder();
   obj->me = new mcu::VideoTranscoder(config);
@@ -6,6 +6,7 @@
       '../VideoTranscoderWrapper.cc',
       '../VideoTranscoder.cpp',
       '../../../../core/owt_base/MediaFramePipeline.cpp',
+      '../../../../core/owt_base/MediaFrameMulticaster.cpp',
       '../../../../core/owt_base/FrameConverter.cpp',
       '../../../../core/owt_base/FrameAnalyzer.cpp',
       '../../../../core/owt_base/I420BufferManager.cpp',
@@ -14,6 +15,7 @@
       '../../../../core/owt_base/FFmpegFrameDecoder.cpp',
       '../../../../core/owt_base/FrameProcesser.cpp',
       '../../../../core/owt_base/FFmpegDrawText.cpp',
+      '../../../../core/owt_base/TextAtlas.cpp',
       '../../../../core/owt_base/SVTHEVCEncoder.cpp',
       '../../../../core/common/JobTimer.cpp',
     ],
@@ -22,6 +24,7 @@
         '-O$(OPTIMIZATION_LEVEL)',
         '-g',
         '-std=c++11',
+        '<!@(pkg-config --cflags freetype2)',
         '-DWEBRTC_POSIX',
         '-DBUILD_FOR_ANALYTICS',
         '-DENABLE_SVT_HEVC_ENCODER',
@@ -47,6 +50,7 @@
       '<!@(pkg-config --libs libavcodec)',
       '<!@(pkg-config --libs libavformat)',
       '<!@(pkg-config --libs libavfilter)',
+      '<!@(pkg-config --libs freetype2)',
       '-L$(DEFAULT_DEPENDENCY_PATH)/lib',
       '-lSvtHevcEnc',
     ],
@@ -7,11 +7,13 @@
       '../VideoTranscoder.cpp',
       '../../../../core/owt_base/I420BufferManager.cpp',
       '../../../../core/owt_base/MediaFramePipeline.cpp',
+      '../../../../core/owt_base/MediaFrameMulticaster.cpp',
       '../../../../core/owt_base/FrameConverter.cpp',
       '../../../../core/owt_base/VCMFrameDecoder.cpp',
       '../../../../core/owt_base/VCMFrameEncoder.cpp',
       '../../../../core/owt_base/FFmpegFrameDecoder.cpp',
       '../../../../core/owt_base/FFmpegDrawText.cpp',
+      '../../../../core/owt_base/TextAtlas.cpp',
       '../../../../core/owt_base/FrameProcesser.cpp',
       '../../../../core/owt_base/MsdkFrameDecoder.cpp',
       '../../../../core/owt_base/MsdkFrameEncoder.cpp',
@@ -28,6 +30,7 @@
         '-O$(OPTIMIZATION_LEVEL)',
         '-g',
         '-std=c++11',
+        '<!@(pkg-config --cflags freetype2)',
         '-DWEBRTC_POSIX',
         '-DENABLE_MSDK',
         '-msse4',
@@ -56,6 +59,7 @@
       '<!@(pkg-config --libs libavcodec)',
       '<!@(pkg-config --libs libavformat)',
       '<!@(pkg-config --libs libavfilter)',
+      '<!@(pkg-config --libs freetype2)',
     ],
   }]
 }
@@ -27,6 +27,7 @@ const isUnspecified = (value) => (value === undefined || value === 'unspecified'
 const useHardware = global.config.video.hardwareAccelerated;
 const gaccPluginEnabled = global.config.video.enableBetterHEVCQuality || false;
 const MFE_timeout = global.config.video.MFE_timeout || 0;
+const decodeThreading = global.config.video.decodeThreading;
 const supported_codecs = global.config.video.codecs;
 
 /*
@@ -395,7 +396,10 @@ function VMixer(rpcClient, clusterIP, VideoMixer, router, streamingEmitter) {
             'layout': videoConfig.layout.templates,
             'crop': (videoConfig.layout.fitPolicy === 'crop' ? true : false),
             'gaccplugin': gaccPluginEnabled,
-            'MFE_timeout': MFE_timeout
+            'MFE_timeout': MFE_timeout,
+            'decodeThreadType': decodeThreading.type,
+            'decodeThreads': decodeThreading.threads,
+            'decodeThreadsLimit': decodeThreading.limit
         };
 
         inputManager = new InputManager(videoConfig.maxInput);
@@ -19,6 +19,7 @@ const isUnspecified = (value) => (value === undefined || value === 'unspecified'
 const useHardware = global.config.video.hardwareAccelerated;
 const gaccPluginEnabled = global.config.video.enableBetterHEVCQuality || false;
 const MFE_timeout = global.config.video.MFE_timeout || 0;
+const decodeThreading = global.config.video.decodeThreading;
 const supported_codecs = global.config.video.codecs;
 
 function VTranscoder(rpcClient, clusterIP, VideoTranscoder, router) {
@@ -162,7 +163,10 @@ function VTranscoder(rpcClient, clusterIP, VideoTranscoder, router) {
             'simulcast': false,
             'crop': false,
             'gaccplugin': gaccPluginEnabled,
-            'MFE_timeout': MFE_timeout
+            'MFE_timeout': MFE_timeout,
+            'decodeThreadType': decodeThreading.type,
+            'decodeThreads': decodeThreading.threads,
+            'decodeThreadsLimit': decodeThreading.limit
         };
 
         controller = ctrlr;
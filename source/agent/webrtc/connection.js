@@ -112,9 +112,13 @@ class Connection extends EventEmitter {
       // mediaStream.metadata = options.metadata;
       // mediaStream.setMetadata(JSON.stringify(options.metadata));
     }
-    mediaStream.onMediaStreamEvent((type, message) => {
-      this._onMediaStreamEvent(type, message, mediaStream.id);
+    // All events of a wakeup arrive in one call
+    mediaStream.setBatchListener((events) => {
+      for (const [type, message] of events) {
+        this._onMediaStreamEvent(type, message, mediaStream.id);
+      }
     });
+    mediaStream.onMediaStreamEvent();
     return mediaStream;
   }
 
@@ -272,6 +276,14 @@ class Connection extends EventEmitter {
     return this.mediaStreams.size;
   }
 
+  getEventStats() {
+    const stats = {};
+    this.mediaStreams.forEach((mediaStream, id) => {
+      stats[id] = mediaStream.getEventStats();
+    });
+    return stats;
+  }
+
   close() {
     log.info(`message: Closing connection ${this.id}`);
     log.info(`message: WebRtcConnection status update, id: ${this.id}, status: ${CONN_FINISHED}, ` +
@@ -10,6 +10,7 @@ var WrtcConnection = require('./wrtcConnection');
 var Connections = require('./connections');
 var logger = require('../logger').logger;
 var {InternalConnectionRouter} = require('./internalConnectionRouter');
+var { getCallShardStats, getThreadPoolStats } = require('./streamStats');
 
 // Logger
 var log = logger.getLogger('WebrtcNode');
@@ -494,6 +495,33 @@ module.exports = function (rpcClient, selfRpcId, parentRpcId, clusterWorkerIP) {
         callback('callback', {id: switchId});
     };
 
+    // Stats are read from the binary stats channel, JSON only here
+    that.getTrackStats = function (trackId, callback) {
+        const track = mediaTracks.get(trackId);
+        if (!track) {
+            callback('callback', 'error', 'Track does NOT exist:', trackId);
+            return;
+        }
+        callback('callback', {trackId, video: track.getStats()});
+    };
+
+    that.getCallShardStats = function (callback) {
+        callback('callback', getCallShardStats());
+    };
+
+    that.getThreadPoolStats = function (callback) {
+        callback('callback', getThreadPoolStats());
+    };
+
+    // Event delivery of the media streams by transport
+    that.getEventStats = function (callback) {
+        const stats = {};
+        peerConnections.forEach((connection, transportId) => {
+            stats[transportId] = connection.getEventStats();
+        });
+        callback('callback', stats);
+    };
+
     that.setVideoBitrate = function (connectionId, bitrate, callback) {
         log.debug('setVideoBitrate no longer supported');
     };
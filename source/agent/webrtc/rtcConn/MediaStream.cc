@@ -77,17 +77,10 @@ void StatCallWorker::HandleOKCallback() {
   callback->Call(1, argv, async_resource);
 }
 
-void destroyAsyncHandle(uv_handle_t *handle) {
-  delete handle;
-}
-
 Nan::Persistent<Function> MediaStream::constructor;
 
-MediaStream::MediaStream() : closed_{false}, id_{"undefined"} {
-  async_stats_ = new uv_async_t;
-  async_event_ = new uv_async_t;
-  uv_async_init(uv_default_loop(), async_stats_, &MediaStream::statsCallback);
-  uv_async_init(uv_default_loop(), async_event_, &MediaStream::eventCallback);
+MediaStream::MediaStream()
+    : has_event_callback_{false}, has_stats_callback_{false}, closed_{false}, id_{"undefined"} {
 }
 
 MediaStream::~MediaStream() {
@@ -110,16 +103,9 @@ void MediaStream::close() {
   }
   has_stats_callback_ = false;
   has_event_callback_ = false;
-  if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(async_stats_))) {
-    ELOG_DEBUG("%s, message: Closing Stats handle", toLog());
-    uv_close(reinterpret_cast<uv_handle_t*>(async_stats_), destroyAsyncHandle);
-  }
-  async_stats_ = nullptr;
-  if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(async_event_))) {
-    ELOG_DEBUG("%s, message: Closing MediaStreamEvent handle", toLog());
-    uv_close(reinterpret_cast<uv_handle_t*>(async_event_), destroyAsyncHandle);
-  }
-  async_event_ = nullptr;
+  // Nothing still queued is delivered after closing
+  m_store.Reset();
+  m_batchListener.Reset();
   closed_ = true;
   ELOG_DEBUG("%s, message: Closed", toLog());
 }
@@ -150,6 +136,8 @@ NAN_MODULE_INIT(MediaStream::Init) {
   Nan::SetPrototypeMethod(tpl, "setQualityLayer", setQualityLayer);
   Nan::SetPrototypeMethod(tpl, "enableSlideShowBelowSpatialLayer", enableSlideShowBelowSpatialLayer);
   Nan::SetPrototypeMethod(tpl, "onMediaStreamEvent", onMediaStreamEvent);
+  Nan::SetPrototypeMethod(tpl, "setBatchListener", setBatchListener);
+  Nan::SetPrototypeMethod(tpl, "getEventStats", getEventStats);
   Nan::SetPrototypeMethod(tpl, "setVideoConstraints", setVideoConstraints);
   Nan::SetPrototypeMethod(tpl, "setMetadata", setMetadata);
   Nan::SetPrototypeMethod(tpl, "enableHandler", enableHandler);
@@ -189,7 +177,6 @@ NAN_METHOD(MediaStream::New) {
     ELOG_DEBUG("%s, message: Created", obj->toLog());
     obj->Wrap(info.This());
     info.GetReturnValue().Set(info.This());
-    obj->asyncResource_ = new Nan::AsyncResource("MediaStreamCallback");
   } else {
     // TODO(pedro) Check what happens here
   }
@@ -198,7 +185,6 @@ NAN_METHOD(MediaStream::New) {
 NAN_METHOD(MediaStream::close) {
   MediaStream* obj = Nan::ObjectWrap::Unwrap<MediaStream>(info.Holder());
   if (obj) {
-    delete obj->asyncResource_;
     obj->close();
   }
 }
@@ -404,9 +390,9 @@ NAN_METHOD(MediaStream::getPeriodicStats) {
   if (obj->me == nullptr || info.Length() != 1) {
     return;
   }
-  obj->me->setMediaStreamStatsListener(obj);
+  Nan::Set(Nan::New(obj->m_store), Nan::New("stats").ToLocalChecked(), info[0]);
   obj->has_stats_callback_ = true;
-  obj->stats_callback_ = new Nan::Callback(info[0].As<Function>());
+  obj->me->setMediaStreamStatsListener(obj);
 }
 
 NAN_METHOD(MediaStream::setFeedbackReports) {
@@ -427,68 +413,35 @@ NAN_METHOD(MediaStream::onMediaStreamEvent) {
   if (!me) {
     return;
   }
-  me ->setMediaStreamEventListener(obj);
   obj->has_event_callback_ = true;
-  obj->event_callback_ = new Nan::Callback(info[0].As<Function>());
+  me->setMediaStreamEventListener(obj);
 }
 
-void MediaStream::notifyStats(const std::string& message) {
-  if (!this->has_stats_callback_) {
-    return;
-  }
-  if (!async_stats_) {
+NAN_METHOD(MediaStream::setBatchListener) {
+  MediaStream* obj = Nan::ObjectWrap::Unwrap<MediaStream>(info.Holder());
+  if (info.Length() < 1 || !info[0]->IsFunction()) {
+    Nan::ThrowTypeError("Wrong arguments");
     return;
   }
-  boost::mutex::scoped_lock lock(mutex);
-  this->stats_messages.push(message);
-  async_stats_->data = this;
-  uv_async_send(async_stats_);
+  obj->NodeEventRegistry::setBatchListener(info.GetIsolate(), info[0].As<Function>());
 }
 
-void MediaStream::notifyMediaStreamEvent(const std::string& type, const std::string& message) {
-  if (!this->has_event_callback_) {
-    return;
-  }
-  if (!async_event_) {
-    return;
-  }
-  boost::mutex::scoped_lock lock(mutex);
-  this->event_messages.push(std::make_pair(type, message));
-  async_event_->data = this;
-  uv_async_send(async_event_);
+NAN_METHOD(MediaStream::getEventStats) {
+  MediaStream* obj = Nan::ObjectWrap::Unwrap<MediaStream>(info.Holder());
+  info.GetReturnValue().Set(statsObject(obj->NodeEventRegistry::getStats()));
 }
 
-NAUV_WORK_CB(MediaStream::statsCallback) {
-  Nan::HandleScope scope;
-  MediaStream* obj = reinterpret_cast<MediaStream*>(async->data);
-  if (!obj || !obj->me) {
+void MediaStream::notifyStats(const std::string& message) {
+  if (!this->has_stats_callback_) {
     return;
   }
-  boost::mutex::scoped_lock lock(obj->mutex);
-  if (obj->has_stats_callback_) {
-    while (!obj->stats_messages.empty()) {
-      Local<Value> args[] = {Nan::New(obj->stats_messages.front().c_str()).ToLocalChecked()};
-      obj->asyncResource_->runInAsyncScope(Nan::GetCurrentContext()->Global(), obj->stats_callback_->GetFunction(), 1, args);
-      obj->stats_messages.pop();
-    }
-  }
+  // Stats are snapshots, only the latest one is delivered
+  notifyCoalescedAsyncEvent("stats", "", message);
 }
 
-NAUV_WORK_CB(MediaStream::eventCallback) {
-  Nan::HandleScope scope;
-  MediaStream* obj = reinterpret_cast<MediaStream*>(async->data);
-  if (!obj || !obj->me) {
+void MediaStream::notifyMediaStreamEvent(const std::string& type, const std::string& message) {
+  if (!this->has_event_callback_) {
     return;
   }
-  boost::mutex::scoped_lock lock(obj->mutex);
-  ELOG_DEBUG("%s, message: eventsCallback", obj->toLog());
-  if (obj->has_event_callback_) {
-      while (!obj->event_messages.empty()) {
-          Local<Value> args[] = {Nan::New(obj->event_messages.front().first.c_str()).ToLocalChecked(),
-              Nan::New(obj->event_messages.front().second.c_str()).ToLocalChecked()};
-          obj->asyncResource_->runInAsyncScope(Nan::GetCurrentContext()->Global(), obj->event_callback_->GetFunction(), 2, args);
-          obj->event_messages.pop();
-      }
-  }
-  ELOG_DEBUG("%s, message: eventsCallback finished", obj->toLog());
+  notifyAsyncEvent(type, message);
 }
@@ -32,11 +32,11 @@
 #include <nan.h>
 #include <MediaStream.h>
 #include <logger.h>
-#include <queue>
 #include <string>
 #include <future>  // NOLINT
 
 #include "MediaWrapper.h"
+#include "NodeEventRegistry.h"
 
 class StatCallWorker : public Nan::AsyncWorker {
  public:
@@ -56,17 +56,15 @@ class StatCallWorker : public Nan::AsyncWorker {
  *
  * A WebRTC Connection. This class represents a MediaStream that can be established with other peers via a SDP negotiation
  * it comprises all the necessary ICE and SRTP components.
+ * Media stream events and the periodic stats, coalesced as "stats", go through NodeEventRegistry.
  */
-class MediaStream : public MediaFilter, public erizo::MediaStreamStatsListener, public erizo::MediaStreamEventListener {
+class MediaStream : public MediaFilter, public NodeEventRegistry,
+                    public erizo::MediaStreamStatsListener, public erizo::MediaStreamEventListener {
  public:
     DECLARE_LOGGER();
     static NAN_MODULE_INIT(Init);
 
     std::shared_ptr<erizo::MediaStream> me;
-    std::queue<std::string> stats_messages;
-    std::queue<std::pair<std::string, std::string>> event_messages;
-
-    boost::mutex mutex;
 
  private:
     MediaStream();
@@ -75,17 +73,11 @@ class MediaStream : public MediaFilter, public erizo::MediaStreamStatsListener,
     void close();
     std::string toLog();
 
-    Nan::Callback *event_callback_;
-    uv_async_t *async_event_;
     bool has_event_callback_;
-
-    Nan::Callback *stats_callback_;
-    uv_async_t *async_stats_;
     bool has_stats_callback_;
     bool closed_;
     std::string id_;
     std::string label_;
-    Nan::AsyncResource *asyncResource_;
     /*
      * Constructor.
      * Constructs an empty MediaStream without any configuration.
@@ -182,14 +174,25 @@ class MediaStream : public MediaFilter, public erizo::MediaStreamStatsListener,
     static NAN_METHOD(setQualityLayer);
     static NAN_METHOD(enableSlideShowBelowSpatialLayer);
 
+    /*
+     * Starts delivering media stream events to the batch listener
+     */
     static NAN_METHOD(onMediaStreamEvent);
+    /*
+     * Delivers all events of a wakeup in one call as [type, message] pairs,
+     * stats included, instead of through the callbacks
+     * Param: Callback taking the array of events
+     */
+    static NAN_METHOD(setBatchListener);
+    /*
+     * Gets the event delivery stats
+     * Returns: Queued, delivered and coalesced events, wakeups and latency
+     */
+    static NAN_METHOD(getEventStats);
 
     static Nan::Persistent<v8::Function> constructor;
 
-    static NAUV_WORK_CB(statsCallback);
     virtual void notifyStats(const std::string& message);
-
-    static NAUV_WORK_CB(eventCallback);
     virtual void notifyMediaStreamEvent(const std::string& type = "",
         const std::string& message = "");
 };
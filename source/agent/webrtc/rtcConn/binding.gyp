@@ -11,6 +11,7 @@
       'ThreadPool.cc',
       'IOThreadPool.cc',
       "MediaStream.cc",
+      '<(source_rel_dir)/agent/addons/common/NodeEventRegistry.cc',
       'conn_handler/WoogeenHandler.cpp',
       'erizo/src/erizo/DtlsTransport.cpp',
       'erizo/src/erizo/IceConnection.cpp',
@@ -49,6 +50,7 @@
       'erizo/src/erizo/stats',
       '<(source_rel_dir)/core/common',
       '<(source_rel_dir)/core/owt_base',
+      '<(source_rel_dir)/agent/addons/common',
       '$(DEFAULT_DEPENDENCY_PATH)/include',
       '$(CUSTOM_INCLUDE_PATH)',
       '<!@(pkg-config glib-2.0 --cflags-only-I | sed s/-I//g)',
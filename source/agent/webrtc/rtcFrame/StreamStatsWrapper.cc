@@ -0,0 +1,106 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef BUILDING_NODE_EXTENSION
+#define BUILDING_NODE_EXTENSION
+#endif
+
+#include "StreamStatsWrapper.h"
+
+#include <IOService.h>
+#include <RtcAdapter.h>
+#include <vector>
+
+using namespace v8;
+
+static const uint32_t kDefaultMaxRecords = 4096;
+
+NAN_MODULE_INIT(StreamStats::Init) {
+  Nan::SetMethod(target, "readStreamStats", read);
+  Nan::SetMethod(target, "subscribeStreamStats", subscribe);
+  Nan::SetMethod(target, "unsubscribeStreamStats", unsubscribe);
+  Nan::SetMethod(target, "getCallShardStats", getCallShardStats);
+  Nan::SetMethod(target, "getIOServiceStats", getIOServiceStats);
+  Nan::SetMethod(target, "getTaskRunnerUsers", getTaskRunnerUsers);
+  Nan::Set(target, Nan::New("STREAM_STATS_RECORD_SIZE").ToLocalChecked(),
+           Nan::New(static_cast<uint32_t>(sizeof(owt_base::StreamStatsRecord))));
+}
+
+NAN_METHOD(StreamStats::read) {
+  uint32_t maxRecords = kDefaultMaxRecords;
+  if (info.Length() > 0 && info[0]->IsNumber()) {
+    maxRecords = Nan::To<uint32_t>(info[0]).FromJust();
+  }
+
+  std::vector<owt_base::StreamStatsRecord> records(maxRecords);
+  size_t count = owt_base::StreamStatsRing::get()->read(records.data(), maxRecords);
+
+  // One copy into a Buffer, records are decoded in place on JS side
+  info.GetReturnValue().Set(Nan::CopyBuffer(
+      reinterpret_cast<const char*>(records.data()),
+      count * sizeof(owt_base::StreamStatsRecord)).ToLocalChecked());
+}
+
+NAN_METHOD(StreamStats::subscribe) {
+  if (info.Length() < 1 || !info[0]->IsNumber()) {
+    Nan::ThrowTypeError("Invalid statsId");
+    return;
+  }
+  owt_base::StreamStatsRing::get()->subscribe(Nan::To<uint32_t>(info[0]).FromJust());
+}
+
+NAN_METHOD(StreamStats::unsubscribe) {
+  if (info.Length() < 1 || !info[0]->IsNumber()) {
+    Nan::ThrowTypeError("Invalid statsId");
+    return;
+  }
+  owt_base::StreamStatsRing::get()->unsubscribe(Nan::To<uint32_t>(info[0]).FromJust());
+}
+
+NAN_METHOD(StreamStats::getCallShardStats) {
+  std::vector<rtc_adapter::CallShardStats> stats =
+      rtc_adapter::RtcAdapterFactory::GetCallShardStats();
+
+  Local<Array> result = Nan::New<Array>(stats.size());
+  for (uint32_t i = 0; i < stats.size(); i++) {
+    Local<Object> shard = Nan::New<Object>();
+    Nan::Set(shard, Nan::New("adapters").ToLocalChecked(),
+             Nan::New(stats[i].adapters));
+    Nan::Set(shard, Nan::New("queueDelayMs").ToLocalChecked(),
+             Nan::New(stats[i].queueDelayMs));
+    Nan::Set(shard, Nan::New("maxQueueDelayMs").ToLocalChecked(),
+             Nan::New(stats[i].maxQueueDelayMs));
+    Nan::Set(result, i, shard);
+  }
+  info.GetReturnValue().Set(result);
+}
+
+NAN_METHOD(StreamStats::getIOServiceStats) {
+  std::vector<owt_base::IOServiceStats> stats = owt_base::getIOServiceStats();
+
+  Local<Array> result = Nan::New<Array>(stats.size());
+  for (uint32_t i = 0; i < stats.size(); i++) {
+    Local<Object> service = Nan::New<Object>();
+    Nan::Set(service, Nan::New("cpu").ToLocalChecked(),
+             Nan::New(stats[i].cpu));
+    Nan::Set(service, Nan::New("utilization").ToLocalChecked(),
+             Nan::New(stats[i].utilization));
+    Nan::Set(service, Nan::New("queueDelayMs").ToLocalChecked(),
+             Nan::New(stats[i].queueDelayMs));
+    Nan::Set(service, Nan::New("owners").ToLocalChecked(),
+             Nan::New(static_cast<double>(stats[i].owners)));
+    Nan::Set(result, i, service);
+  }
+  info.GetReturnValue().Set(result);
+}
+
+NAN_METHOD(StreamStats::getTaskRunnerUsers) {
+  std::vector<long> users = rtc_adapter::RtcAdapterFactory::GetTaskRunnerUsers();
+
+  Local<Array> result = Nan::New<Array>(users.size());
+  for (uint32_t i = 0; i < users.size(); i++) {
+    Nan::Set(result, i, Nan::New(static_cast<double>(users[i])));
+  }
+  info.GetReturnValue().Set(result);
+}
@@ -0,0 +1,33 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef STREAMSTATSWRAPPER_H
+#define STREAMSTATSWRAPPER_H
+
+#include <StreamStatsRing.h>
+#include <nan.h>
+
+/*
+ * Batch reader of owt_base::StreamStatsRing, the call shard and the
+ * thread pool counters
+ */
+class StreamStats {
+ public:
+  static NAN_MODULE_INIT(Init);
+
+ private:
+  // readStreamStats(maxRecords) => Buffer of StreamStatsRecord
+  static NAN_METHOD(read);
+  // subscribeStreamStats(statsId) / unsubscribeStreamStats(statsId)
+  static NAN_METHOD(subscribe);
+  static NAN_METHOD(unsubscribe);
+  // getCallShardStats() => [{adapters, queueDelayMs, maxQueueDelayMs}]
+  static NAN_METHOD(getCallShardStats);
+  // getIOServiceStats() => [{cpu, utilization, queueDelayMs, owners}]
+  static NAN_METHOD(getIOServiceStats);
+  // getTaskRunnerUsers() => [users]
+  static NAN_METHOD(getTaskRunnerUsers);
+};
+
+#endif
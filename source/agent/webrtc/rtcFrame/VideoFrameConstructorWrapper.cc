@@ -38,6 +38,7 @@ NAN_MODULE_INIT(VideoFrameConstructor::Init) {
   Nan::SetPrototypeMethod(tpl, "setPreferredLayers", setPreferredLayers);
   Nan::SetPrototypeMethod(tpl, "requestKeyFrame", requestKeyFrame);
   Nan::SetPrototypeMethod(tpl, "source", source);
+  Nan::SetPrototypeMethod(tpl, "statsId", statsId);
 
   constructor.Reset(Nan::GetFunction(tpl).ToLocalChecked());
   Nan::Set(target,
@@ -202,6 +203,13 @@ NAUV_WORK_CB(VideoFrameConstructor::Callback) {
   }
 }
 
+NAN_METHOD(VideoFrameConstructor::statsId) {
+  VideoFrameConstructor* obj = Nan::ObjectWrap::Unwrap<VideoFrameConstructor>(info.Holder());
+  owt_base::VideoFrameConstructor* me = obj->me;
+
+  info.GetReturnValue().Set(Nan::New(me->statsId()));
+}
+
 NAN_METHOD(VideoFrameConstructor::source) {
   const int argc = 1;
   v8::Local<v8::Value> argv[argc] = {info.Holder()};
@@ -51,6 +51,7 @@ class VideoFrameConstructor : public MediaSink, public owt_base::VideoInfoListen
   static NAN_METHOD(requestKeyFrame);
 
   static NAN_METHOD(source);
+  static NAN_METHOD(statsId);
 
   static Nan::Persistent<v8::Function> constructor;
 
@@ -5,6 +5,7 @@
 #include "AudioFrameConstructorWrapper.h"
 #include "AudioFramePacketizerWrapper.h"
 #include "CallBaseWrapper.h"
+#include "StreamStatsWrapper.h"
 #include "VideoFrameConstructorWrapper.h"
 #include "VideoFramePacketizerWrapper.h"
 
@@ -18,6 +19,7 @@ void InitAll(Local<Object> exports) {
   VideoFrameConstructor::Init(exports);
   VideoFramePacketizer::Init(exports);
   CallBase::Init(exports);
+  StreamStats::Init(exports);
 }
 
 NODE_MODULE(addon, InitAll)
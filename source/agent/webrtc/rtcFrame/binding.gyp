@@ -11,12 +11,15 @@
       '<(source_rel_dir)/core/owt_base/VideoFrameConstructor.cpp',
       '<(source_rel_dir)/core/owt_base/VideoFramePacketizer.cpp',
       '<(source_rel_dir)/core/owt_base/MediaFramePipeline.cpp',
+      '<(source_rel_dir)/core/owt_base/StreamStatsRing.cpp',
       '<(source_rel_dir)/core/common/JobTimer.cpp',
+      '<(source_rel_dir)/core/common/IOService.cpp',
       'AudioFrameConstructorWrapper.cc',
       'AudioFramePacketizerWrapper.cc',
       'VideoFrameConstructorWrapper.cc',
       'VideoFramePacketizerWrapper.cc',
       'CallBaseWrapper.cc',
+      'StreamStatsWrapper.cc',
       'addon.cc',
     ],
     'dependencies': ['librtcadapter'],
@@ -70,11 +73,13 @@
         '<(source_rel_dir)/core/rtc_adapter/RtcAdapter.cc',
         '<(source_rel_dir)/core/rtc_adapter/VideoReceiveAdapter.cc',
         '<(source_rel_dir)/core/rtc_adapter/VideoSendAdapter.cc',
+        '<(source_rel_dir)/core/rtc_adapter/PacedSender.cc',
         '<(source_rel_dir)/core/rtc_adapter/AudioSendAdapter.cc',
         '<(source_rel_dir)/core/rtc_adapter/thread/StaticTaskQueueFactory.cc',
         '<(source_rel_dir)/core/owt_base/SsrcGenerator.cc',
         '<(source_rel_dir)/core/owt_base/AudioUtilitiesNew.cpp',
         '<(source_rel_dir)/core/owt_base/TaskRunnerPool.cpp',
+        '<(source_rel_dir)/core/owt_base/NalScanner.cpp',
     ],
     'cflags_cc': ['-DWEBRTC_POSIX', '-DWEBRTC_LINUX', '-DLINUX', '-DNOLINUXIF', '-DNO_REG_RPC=1', '-DHAVE_VFPRINTF=1', '-DRETSIGTYPE=void', '-DNEW_STDIO', '-DHAVE_STRDUP=1', '-DHAVE_STRLCPY=1', '-DHAVE_LIBM=1', '-DHAVE_SYS_TIME_H=1', '-DTIME_WITH_SYS_TIME_H=1', '-DOWT_ENABLE_H265', '-D_LIBCPP_ABI_UNSTABLE', '-DNDEBUG'],
     'include_dirs': [
@@ -0,0 +1,72 @@
+{
+  'targets': [{
+    'target_name': 'streamStatsRingTest',
+    'type': 'executable',
+    'sources': [
+      '../../../../core/owt_base/StreamStatsRingTest.cpp',
+      '../../../../core/owt_base/StreamStatsRing.cpp',
+    ],
+    'include_dirs': [
+        '../../../../core/common/',
+        '../../../../core/owt_base/',
+    ],
+    'libraries': [
+      '-lboost_thread',
+      '-lboost_system',
+      '-llog4cxx',
+      '-lboost_unit_test_framework'
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  ['-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=c++11'],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  },
+  {
+    'target_name': 'pacedSenderTest',
+    'type': 'executable',
+    'variables': {
+      'webrtc_abs_dir%': '<(module_root_dir)/../../../../../third_party/webrtc-m88' # absolute webrtc dir path
+    },
+    'sources': [
+      '../../../../core/rtc_adapter/PacedSenderTest.cc',
+      '../../../../core/rtc_adapter/PacedSender.cc',
+    ],
+    'cflags_cc': ['-DWEBRTC_POSIX', '-DWEBRTC_LINUX', '-DLINUX', '-D_LIBCPP_ABI_UNSTABLE', '-DNDEBUG'],
+    'include_dirs': [
+      '../../../../core/rtc_adapter',
+      '<(webrtc_abs_dir)/src', # webrtc include files
+      '<(webrtc_abs_dir)/src/third_party/abseil-cpp', # abseil-cpp include files used by webrtc
+    ],
+    'libraries': [
+      '-lpthread',
+      '-L<(webrtc_abs_dir)', '-lwebrtc',
+    ],
+    'conditions': [
+      [ 'OS=="mac"', {
+        'xcode_settings': {
+          'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',        # -fno-exceptions
+          'MACOSX_DEPLOYMENT_TARGET':  '10.7',       # from MAC OS 10.7
+          'OTHER_CFLAGS': ['-g -O$(OPTIMIZATION_LEVEL) -stdlib=libc++']
+        },
+      }, { # OS!="mac"
+        'cflags!':    ['-fno-exceptions'],
+        'cflags_cc':  [
+          '-Wall', '-O$(OPTIMIZATION_LEVEL)', '-g', '-std=gnu++14', '-fexceptions',
+          '-nostdinc++',
+          '-I<(webrtc_abs_dir)/src/buildtools/third_party/libc++/trunk/include',
+          '-I<(webrtc_abs_dir)/src/buildtools/third_party/libc++abi/trunk/include'
+        ],
+        'cflags_cc!': ['-fno-exceptions']
+      }],
+    ]
+  }]
+}
@@ -0,0 +1,159 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+'use strict';
+
+const {
+  readStreamStats,
+  subscribeStreamStats,
+  unsubscribeStreamStats,
+  getCallShardStats,
+  getIOServiceStats,
+  getTaskRunnerUsers,
+  STREAM_STATS_RECORD_SIZE,
+} = require('../rtcFrame/build/Release/rtcFrame.node');
+
+const logger = require('../logger').logger;
+// Logger
+const log = logger.getLogger('StreamStats');
+
+const READ_INTERVAL = 1000;
+const READ_BATCH = 4096;
+// Streams stop writing records when nobody asked for them this long
+const IDLE_TIMEOUT = 30000;
+
+// Layout of owt_base::StreamStatsRecord, little endian
+const FIELDS = [
+  ['bitrateKbps', 16],
+  ['frameRate', 20],
+  ['width', 24],
+  ['height', 28],
+  ['format', 32],
+  ['packetsReceived', 36],
+  ['packetsLost', 40],
+  ['fractionLost', 44],
+  ['jitterMs', 48],
+  ['rttMs', 52],
+  ['keyFrameRequests', 56],
+];
+
+/*
+ * Reads stats records of subscribed streams in batches and keeps the
+ * latest counters per stream. A stream is subscribed on the first get()
+ * and unsubscribed again once it is not asked for.
+ */
+class StreamStatsReader {
+  constructor() {
+    if (STREAM_STATS_RECORD_SIZE !== 64) {
+      log.error('Unexpected stats record size:', STREAM_STATS_RECORD_SIZE);
+    }
+    // statsId => {stats, subscribed, lastGet}
+    this.streams = new Map();
+    this.subscriptions = 0;
+    this.timer = null;
+  }
+
+  start() {
+    if (!this.timer) {
+      this.timer = setInterval(() => this.read(), READ_INTERVAL);
+      this.timer.unref();
+    }
+  }
+
+  stop() {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+
+  subscribe(statsId, stream) {
+    if (!stream.subscribed) {
+      subscribeStreamStats(statsId);
+      stream.subscribed = true;
+      this.subscriptions++;
+      this.start();
+    }
+  }
+
+  unsubscribe(statsId, stream) {
+    if (stream.subscribed) {
+      unsubscribeStreamStats(statsId);
+      stream.subscribed = false;
+      stream.stats = null;
+      if (--this.subscriptions === 0) {
+        this.stop();
+      }
+    }
+  }
+
+  read() {
+    let buffer;
+    do {
+      buffer = readStreamStats(READ_BATCH);
+      for (let offset = 0; offset + STREAM_STATS_RECORD_SIZE <= buffer.length;
+          offset += STREAM_STATS_RECORD_SIZE) {
+        const stream = this.streams.get(buffer.readUInt32LE(offset));
+        if (stream && stream.subscribed) {
+          stream.stats = parse(buffer, offset, stream.stats || {});
+        }
+      }
+    } while (buffer.length === READ_BATCH * STREAM_STATS_RECORD_SIZE);
+
+    const now = Date.now();
+    for (const [statsId, stream] of this.streams) {
+      if (stream.subscribed && now - stream.lastGet > IDLE_TIMEOUT) {
+        this.unsubscribe(statsId, stream);
+      }
+    }
+  }
+
+  watch(statsId) {
+    if (!this.streams.has(statsId)) {
+      this.streams.set(statsId, {stats: null, subscribed: false, lastGet: 0});
+    }
+  }
+
+  unwatch(statsId) {
+    const stream = this.streams.get(statsId);
+    if (stream) {
+      this.unsubscribe(statsId, stream);
+      this.streams.delete(statsId);
+    }
+  }
+
+  // Latest counters of stream, null if none reported yet
+  get(statsId) {
+    const stream = this.streams.get(statsId);
+    if (!stream) {
+      return null;
+    }
+    stream.lastGet = Date.now();
+    this.subscribe(statsId, stream);
+    return stream.stats ? Object.assign({}, stream.stats) : null;
+  }
+}
+
+function parse(buffer, offset, stats) {
+  stats.timestamp = buffer.readUInt32LE(offset + 8) +
+    buffer.readUInt32LE(offset + 12) * 0x100000000;
+  for (const [name, fieldOffset] of FIELDS) {
+    stats[name] = buffer.readUInt32LE(offset + fieldOffset);
+  }
+  return stats;
+}
+
+exports.streamStatsReader = new StreamStatsReader();
+
+// Per call shard: adapters, queueDelayMs and maxQueueDelayMs since last call
+exports.getCallShardStats = getCallShardStats;
+
+// Per pooled IOService: cpu, utilization, queueDelayMs and owners,
+// users per pooled TaskRunner
+exports.getThreadPoolStats = function () {
+  return {
+    ioServices: getIOServiceStats(),
+    taskRunners: getTaskRunnerUsers(),
+  };
+};
@@ -13,6 +13,8 @@ const {
   VideoFramePacketizer,
   CallBase,
 } = require('../rtcFrame/build/Release/rtcFrame.node');
+const { TemporalLayerForwarder } = require(
+  '../videoSwitch/build/Release/videoSwitch.node');
 
 const logger = require('../logger').logger;
 const cipher = require('../cipher');
@@ -22,6 +24,7 @@ const log = logger.getLogger('WrtcConnection');
 const { Connection } = require('./connection');
 
 const { SdpInfo } = require('./sdpInfo.js');
+const { streamStatsReader } = require('./streamStats.js');
 
 /*
  * This class represents a filtered stream
@@ -37,13 +40,24 @@ class LayerStream {
     const spatialId = (pos >= 0) ? parseInt(layerId[pos + 1]) : -1;
     pos = layerId.indexOf('t');
     const temporalId = (pos >= 0) ? parseInt(layerId[pos + 1]) : -1;
-    this.videoFrameConstructor = new VideoFrameConstructor(
-      parent.wrtc.callBase, parent.videoFrameConstructor,
-      layerId, spatialId, temporalId);
+    this.videoFrameConstructor = null;
+    this.forwarder = null;
+    if (spatialId < 0) {
+      // Temporal layers are thinned from parent frames, no extra receiver
+      this.forwarder = new TemporalLayerForwarder(
+        parent.videoFrameConstructor.source(), temporalId);
+    } else {
+      this.videoFrameConstructor = new VideoFrameConstructor(
+        parent.wrtc.callBase, parent.videoFrameConstructor,
+        layerId, spatialId, temporalId);
+    }
   }
 
   sender() {
     let sender = null;
+    if (this.forwarder) {
+      return this.forwarder;
+    }
     if (this.videoFrameConstructor) {
       sender = this.videoFrameConstructor.source();
       sender.parent = this.videoFrameConstructor;
@@ -63,7 +77,11 @@ class LayerStream {
 
   close() {
     this.closeCb(this);
-    this.videoFrameConstructor.close();
+    if (this.forwarder) {
+      this.forwarder.close();
+    } else {
+      this.videoFrameConstructor.close();
+    }
   }
 }
 
@@ -117,6 +135,8 @@ class WrtcStream extends EventEmitter {
         this.videoFrameConstructor = new VideoFrameConstructor(
           this._onMediaUpdate.bind(this), video.transportcc, wrtc.callBase);
         this.videoFrameConstructor.bindTransport(wrtc.getMediaStream(id));
+        this.statsId = this.videoFrameConstructor.statsId();
+        streamStatsReader.watch(this.statsId);
         wrtc.setVideoSsrcList(id, video.ssrcs);
       }
 
@@ -180,6 +200,9 @@ class WrtcStream extends EventEmitter {
       // TODO: seperate call and frame constructor in node wrapper
       this.videoFrameConstructor.close();
     }
+    if (this.statsId !== undefined) {
+      streamStatsReader.unwatch(this.statsId);
+    }
   }
 
   _onMediaUpdate(jsonUpdate) {
@@ -333,6 +356,18 @@ class WrtcStream extends EventEmitter {
     return onError('no video track');
   };
 
+  // Latest receiving stats of video, null if not available
+  getStats() {
+    if (this.statsId === undefined) {
+      return null;
+    }
+    const stats = streamStatsReader.get(this.statsId);
+    if (stats) {
+      stats.format = this.videoFormat;
+    }
+    return stats;
+  }
+
   //FIXME: Temporarily add this interface to workround the hardware mode's absence of feedback mechanism.
   requestKeyFrame() {
     if (this.videoFrameConstructor) {
@@ -692,6 +727,10 @@ module.exports = function (spec, on_status, on_track) {
     }
   };
 
+  that.getEventStats = function () {
+    return wrtc ? wrtc.getEventStats() : {};
+  };
+
   that.close = function () {
     if (wrtc) {
       if (wrtc.getNumMediaStreams() > 0) {
@@ -0,0 +1,769 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef AsyncLogger_h
+#define AsyncLogger_h
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <log4cxx/logger.h>
+
+// log4cxx 1.x takes the event time from a replaceable clock
+#if defined(LOG4CXX_VERSION_MAJOR) && LOG4CXX_VERSION_MAJOR >= 1
+#include <log4cxx/helpers/date.h>
+#define ELOG_EVENT_TIME
+#endif
+
+/*
+ * Asynchronous backend of the ELOG_* macros.
+ *
+ * A log call copies the format string pointer, its raw arguments and the
+ * current time into a lock-free ring owned by the calling thread. One
+ * background thread per process drains all rings, formats the records and
+ * hands them to log4cxx, so media threads never format, take the appender
+ * lock or wait for disk I/O. The drain sleeps on a condition variable while
+ * the rings are empty and the first record pushed wakes it.
+ *
+ * - The format must be a string literal, it's referenced, not copied.
+ * - %s arguments are copied at the call and must be NUL terminated, even
+ *   with a precision.
+ * - When a thread's ring is full the message is dropped and counted, a
+ *   summary is logged from time to time.
+ * - The event time is the time of the call. log4cxx before 1.0 can't be
+ *   given a time, so there the message notes how long it was queued when
+ *   that's ELOG_LATE_MS or more.
+ * - Call sites aren't rate limited. The ELOG_*_RATE macros pass at most the
+ *   given number of messages per second for hot paths, the number
+ *   suppressed is appended to the next message that passes.
+ * - OWT_LOG_SYNC=1 in the environment, or defining ELOG_SYNC at build time,
+ *   logs on the calling thread as before. Fatal messages always do.
+ */
+
+#define ELOG_MAX_RECORD_SIZE 2048
+#define ELOG_RING_SIZE (64 * 1024)
+#define ELOG_DEFAULT_SITE_RATE 0
+#define ELOG_LATE_MS 10
+
+namespace owt_base {
+namespace elog {
+
+enum Level {
+    LEVEL_TRACE = 0,
+    LEVEL_DEBUG,
+    LEVEL_INFO,
+    LEVEL_WARN,
+    LEVEL_ERROR,
+    LEVEL_FATAL,
+};
+
+// Never called, gives the ELOG_* macros printf format checking
+inline void checkFormat(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+inline void checkFormat(const char*, ...) { }
+
+inline void formatMessage(char* buffer, size_t size, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, size, fmt, args);
+    va_end(args);
+}
+
+// Microseconds since the epoch, what log4cxx stamps events with
+inline int64_t eventTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+#ifdef ELOG_EVENT_TIME
+// Time of the event being dispatched on this thread, 0 for now
+inline int64_t& pendingEventTime()
+{
+    static thread_local int64_t time = 0;
+    return time;
+}
+
+inline log4cxx_time_t currentEventTime()
+{
+    int64_t time = pendingEventTime();
+    return time ? time : eventTime();
+}
+#endif
+
+inline void dispatch(const log4cxx::LoggerPtr& logger, Level level, const char* msg)
+{
+    switch (level) {
+    case LEVEL_TRACE:
+#ifdef LOG4CXX_TRACE
+        LOG4CXX_TRACE(logger, msg);
+#else
+        LOG4CXX_DEBUG(logger, msg);
+#endif
+        break;
+    case LEVEL_DEBUG:
+        LOG4CXX_DEBUG(logger, msg);
+        break;
+    case LEVEL_INFO:
+        LOG4CXX_INFO(logger, msg);
+        break;
+    case LEVEL_WARN:
+        LOG4CXX_WARN(logger, msg);
+        break;
+    case LEVEL_ERROR:
+        LOG4CXX_ERROR(logger, msg);
+        break;
+    case LEVEL_FATAL:
+        LOG4CXX_FATAL(logger, msg);
+        break;
+    }
+}
+
+inline uint32_t envValue(const char* name, uint32_t defaultValue)
+{
+    const char* value = getenv(name);
+    return value ? (uint32_t)strtoul(value, nullptr, 10) : defaultValue;
+}
+
+// Rate limit of a call site, a constant initialized static in each expansion
+struct Site {
+    constexpr Site(uint32_t rate = ELOG_DEFAULT_SITE_RATE)
+        : limit(rate)
+        , windowStart(0)
+        , windowCount(0)
+        , suppressed(0)
+    {
+    }
+
+    const uint32_t limit;  // Messages per second, 0 for no limit
+    std::atomic<int64_t> windowStart;
+    std::atomic<uint32_t> windowCount;
+    std::atomic<uint32_t> suppressed;
+
+    bool admit()
+    {
+        if (limit == 0) {
+            return true;
+        }
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t start = windowStart.load(std::memory_order_relaxed);
+        if (start != now && windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            windowCount.store(0, std::memory_order_relaxed);
+        }
+        if (windowCount.fetch_add(1, std::memory_order_relaxed) < limit) {
+            return true;
+        }
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+};
+
+enum ArgType : uint8_t {
+    ARG_INT = 0,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+};
+
+enum RecordKind : uint32_t {
+    RECORD_MESSAGE = 0,
+    RECORD_PADDING,
+};
+
+struct RecordHeader {
+    uint32_t size;  // Whole record, multiple of 8
+    uint32_t kind;
+    const log4cxx::LoggerPtr* logger;
+    const char* fmt;
+    int64_t time;  // Microseconds since the epoch
+    uint32_t suppressed;
+    uint8_t level;
+    uint8_t argCount;
+};
+
+// Serializes arguments after a RecordHeader, dropping whatever doesn't fit
+class RecordWriter {
+public:
+    RecordWriter(char* buffer, size_t capacity)
+        : m_buffer(buffer)
+        , m_capacity(capacity)
+        , m_size(sizeof(RecordHeader))
+        , m_count(0)
+    {
+    }
+
+    size_t size() const { return m_size; }
+    uint8_t count() const { return m_count; }
+
+    template <typename T>
+    void put(ArgType type, T value)
+    {
+        if (m_size + 1 + sizeof(T) > m_capacity) {
+            return;
+        }
+        m_buffer[m_size] = type;
+        memcpy(m_buffer + m_size + 1, &value, sizeof(T));
+        m_size += 1 + sizeof(T);
+        m_count++;
+    }
+
+    void putString(const char* str)
+    {
+        if (m_size + 1 + sizeof(str) + sizeof(uint16_t) + 1 > m_capacity) {
+            return;
+        }
+        size_t room = m_capacity - m_size - 1 - sizeof(str) - sizeof(uint16_t) - 1;
+        uint16_t length = str ? (uint16_t)strnlen(str, room) : 0;
+        m_buffer[m_size] = ARG_STR;
+        memcpy(m_buffer + m_size + 1, &str, sizeof(str));
+        memcpy(m_buffer + m_size + 1 + sizeof(str), &length, sizeof(length));
+        char* dest = m_buffer + m_size + 1 + sizeof(str) + sizeof(length);
+        if (length) {
+            memcpy(dest, str, length);
+        }
+        dest[length] = '\0';
+        m_size += 1 + sizeof(str) + sizeof(length) + length + 1;
+        m_count++;
+    }
+
+    // Arguments take their printf promoted type, so formatting them later
+    // reads exactly what the direct call would have read.
+    void encode(bool v) { put(ARG_INT, (int)v); }
+    void encode(char v) { put(ARG_INT, (int)v); }
+    void encode(signed char v) { put(ARG_INT, (int)v); }
+    void encode(unsigned char v) { put(ARG_INT, (int)v); }
+    void encode(short v) { put(ARG_INT, (int)v); }
+    void encode(unsigned short v) { put(ARG_INT, (int)v); }
+    void encode(int v) { put(ARG_INT, v); }
+    void encode(unsigned int v) { put(ARG_UINT, v); }
+    void encode(long v) { put(ARG_LONG, v); }
+    void encode(unsigned long v) { put(ARG_ULONG, v); }
+    void encode(long long v) { put(ARG_LLONG, v); }
+    void encode(unsigned long long v) { put(ARG_ULLONG, v); }
+    void encode(float v) { put(ARG_DOUBLE, (double)v); }
+    void encode(double v) { put(ARG_DOUBLE, v); }
+    void encode(const char* v) { putString(v); }
+    void encode(char* v) { putString(v); }
+    void encode(const std::string& v) { putString(v.c_str()); }
+    void encode(std::nullptr_t) { put(ARG_PTR, (const void*)nullptr); }
+    template <typename T>
+    void encode(T* v) { put(ARG_PTR, (const void*)v); }
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type encode(T v)
+    {
+        encode(static_cast<typename std::underlying_type<T>::type>(v));
+    }
+    // Other objects were never printable through varargs
+    template <typename T>
+    typename std::enable_if<std::is_class<T>::value>::type encode(const T&) { putString("(object)"); }
+
+    void encodeAll() { }
+    template <typename T, typename... Args>
+    void encodeAll(T first, Args... rest)
+    {
+        encode(first);
+        encodeAll(rest...);
+    }
+
+private:
+    char* m_buffer;
+    size_t m_capacity;
+    size_t m_size;
+    uint8_t m_count;
+};
+
+// Single producer, single consumer byte ring of records
+class Ring {
+public:
+    explicit Ring(size_t capacity)
+        : m_buffer(new char[capacity])
+        , m_capacity(capacity)
+        , m_head(0)
+        , m_tail(0)
+        , m_retired(false)
+    {
+    }
+
+    bool push(const char* record, uint32_t size)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        uint64_t tail = m_tail.load(std::memory_order_acquire);
+        size_t offset = head % m_capacity;
+        size_t contiguous = m_capacity - offset;
+        size_t needed = size + (contiguous < size ? contiguous : 0);
+        if (m_capacity - (head - tail) < needed) {
+            return false;
+        }
+        if (contiguous < size) {
+            // Records never wrap, skip the end of the buffer
+            RecordHeader* padding = reinterpret_cast<RecordHeader*>(m_buffer.get() + offset);
+            padding->size = contiguous;
+            padding->kind = RECORD_PADDING;
+            head += contiguous;
+            offset = 0;
+        }
+        memcpy(m_buffer.get() + offset, record, size);
+        m_head.store(head + size, std::memory_order_release);
+        return true;
+    }
+
+    // Calls handle for each queued record, returns the number handled
+    template <typename Handler>
+    size_t drain(Handler handle)
+    {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (tail < head) {
+            const RecordHeader* record = reinterpret_cast<const RecordHeader*>(m_buffer.get() + tail % m_capacity);
+            if (record->kind == RECORD_MESSAGE) {
+                handle(record);
+                count++;
+            }
+            tail += record->size;
+            m_tail.store(tail, std::memory_order_release);
+        }
+        return count;
+    }
+
+    bool empty() const { return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire); }
+
+    void retire() { m_retired.store(true, std::memory_order_release); }
+    bool retired() const { return m_retired.load(std::memory_order_acquire); }
+
+private:
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_capacity;
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+    std::atomic<bool> m_retired;
+};
+
+// Addons are loaded with RTLD_LOCAL. The instance is a static of an inline
+// function with default visibility, which GCC emits as a unique symbol, so
+// all addons of a process share one logger and one drain thread.
+class __attribute__((visibility("default"))) AsyncLogger {
+public:
+    // nullptr when logging is synchronous or the process is exiting
+    static AsyncLogger* get()
+    {
+        static AsyncLogger* instance = create();
+        if (instance && instance->m_stopped.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return instance;
+    }
+
+    template <typename... Args>
+    void log(Site& site, const log4cxx::LoggerPtr& logger, Level level, const char* fmt, Args... args)
+    {
+        int64_t time = eventTime();
+        alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+        RecordWriter writer(record, sizeof(record));
+        writer.encodeAll(args...);
+
+        RecordHeader* header = reinterpret_cast<RecordHeader*>(record);
+        header->size = (writer.size() + 7) & ~(size_t)7;
+        header->kind = RECORD_MESSAGE;
+        header->logger = &logger;
+        header->fmt = fmt;
+        header->time = time;
+        header->suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        header->level = level;
+        header->argCount = writer.count();
+
+        if (!localRing()->push(record, header->size)) {
+            m_dropped.fetch_add(1 + header->suppressed, std::memory_order_relaxed);
+        }
+        wake();
+    }
+
+    // Formats a record's message, returns its length
+    static size_t format(const RecordHeader* record, char* out, size_t size)
+    {
+        const char* arg = reinterpret_cast<const char*>(record) + sizeof(RecordHeader);
+        uint32_t argsLeft = record->argCount;
+        char* begin = out;
+        size_t room = size;
+        const char* fmt = record->fmt;
+
+        // Format one conversion at a time with the captured argument
+        while (*fmt && room > 1) {
+            if (*fmt != '%') {
+                *out++ = *fmt++;
+                room--;
+                continue;
+            }
+            if (fmt[1] == '%') {
+                *out++ = '%';
+                room--;
+                fmt += 2;
+                continue;
+            }
+
+            char spec[32];
+            size_t specLength = 0;
+            int stars[2];
+            int starCount = 0;
+            const char* p = fmt;
+            do {
+                if (*p == '*' && starCount < 2) {
+                    stars[starCount++] = argsLeft ? takeInt(arg, argsLeft) : 0;
+                }
+                if (specLength < sizeof(spec) - 1) {
+                    spec[specLength++] = *p;
+                }
+                p++;
+            } while (*p && !strchr("diouxXeEfFgGaAcspn", *p));
+            if (!*p) {
+                break;
+            }
+            spec[specLength++] = *p;
+            spec[specLength] = '\0';
+            fmt = p + 1;
+
+            int written = 0;
+            if (*p != 'n' && argsLeft) {
+                written = formatArg(out, room, spec, *p, stars, starCount, arg);
+                argsLeft--;
+            }
+            if (written < 0) {
+                written = 0;
+            }
+            if ((size_t)written >= room) {
+                written = room - 1;
+            }
+            out += written;
+            room -= written;
+        }
+        *out = '\0';
+
+        if (record->suppressed && room > 1) {
+            int written = snprintf(out, room, " [%u suppressed]", record->suppressed);
+            out += written > 0 ? std::min((size_t)written, room - 1) : 0;
+        }
+        return out - begin;
+    }
+
+private:
+    struct RingHolder {
+        std::shared_ptr<Ring> ring;
+        ~RingHolder()
+        {
+            if (ring) {
+                ring->retire();
+            }
+        }
+    };
+
+    static AsyncLogger* create()
+    {
+        if (envValue("OWT_LOG_SYNC", 0)) {
+            return nullptr;
+        }
+        // Never deleted, threads may still log while statics are destroyed
+        AsyncLogger* logger = new AsyncLogger();
+        atexit([] {
+            AsyncLogger* instance = get();
+            if (instance) {
+                instance->stop();
+            }
+        });
+        return logger;
+    }
+
+    AsyncLogger()
+        : m_ringSize(envValue("OWT_LOG_RING_KB", ELOG_RING_SIZE / 1024) * 1024)
+        , m_dropped(0)
+        , m_stopped(false)
+        , m_waiting(false)
+        , m_wakeup(false)
+        , m_message(new char[ELOG_MAX_BUFFER_SIZE])
+        , m_self(log4cxx::Logger::getLogger("AsyncLogger"))
+    {
+        if (m_ringSize < 4 * ELOG_MAX_RECORD_SIZE) {
+            m_ringSize = 4 * ELOG_MAX_RECORD_SIZE;
+        }
+#ifdef ELOG_EVENT_TIME
+        log4cxx::helpers::Date::setGetCurrentTimeFunction(currentEventTime);
+#endif
+        m_thread = std::thread(&AsyncLogger::run, this);
+    }
+
+    Ring* localRing()
+    {
+        static thread_local RingHolder holder;
+        if (!holder.ring) {
+            holder.ring = std::make_shared<Ring>(m_ringSize);
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            m_rings.push_back(holder.ring);
+        }
+        return holder.ring.get();
+    }
+
+    void stop()
+    {
+        m_stopped.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakeCond.notify_one();
+        }
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        drainAll();
+    }
+
+    void wake()
+    {
+        // Pairs with the fence in waitForRecords(), either the drain sees
+        // the record or this thread sees the drain waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakeup = true;
+            m_wakeCond.notify_one();
+        }
+    }
+
+    void waitForRecords()
+    {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!pending()) {
+            m_wakeCond.wait(lock, [this] { return m_wakeup || m_stopped.load(std::memory_order_acquire); });
+        }
+        m_wakeup = false;
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+
+    bool pending()
+    {
+        if (m_dropped.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        for (auto& ring : m_rings) {
+            if (!ring->empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run()
+    {
+        while (!m_stopped.load(std::memory_order_acquire)) {
+            if (drainAll() == 0) {
+                waitForRecords();
+            }
+        }
+    }
+
+    size_t drainAll()
+    {
+        std::vector<std::shared_ptr<Ring>> rings;
+        {
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            rings = m_rings;
+        }
+
+        size_t count = 0;
+        for (auto& ring : rings) {
+            count += ring->drain([this](const RecordHeader* record) { write(record); });
+            if (ring->retired() && ring->empty()) {
+                std::lock_guard<std::mutex> lock(m_ringsMutex);
+                for (auto it = m_rings.begin(); it != m_rings.end(); ++it) {
+                    if (*it == ring) {
+                        m_rings.erase(it);
+                        break;
+                    }
+                }
+            }
+        }
+
+        uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            formatMessage(m_message.get(), ELOG_MAX_BUFFER_SIZE, "%llu log messages dropped, ring full", (unsigned long long)dropped);
+            dispatch(m_self, LEVEL_WARN, m_message.get());
+        }
+        return count;
+    }
+
+    void write(const RecordHeader* record)
+    {
+        size_t length = format(record, m_message.get(), ELOG_MAX_BUFFER_SIZE);
+#ifdef ELOG_EVENT_TIME
+        pendingEventTime() = record->time;
+        dispatch(*record->logger, (Level)record->level, m_message.get());
+        pendingEventTime() = 0;
+#else
+        int64_t queuedMs = (eventTime() - record->time) / 1000;
+        if (queuedMs >= ELOG_LATE_MS) {
+            formatMessage(m_message.get() + length, ELOG_MAX_BUFFER_SIZE - length, " [queued %lld ms]", (long long)queuedMs);
+        }
+        dispatch(*record->logger, (Level)record->level, m_message.get());
+#endif
+    }
+
+    static int takeInt(const char*& arg, uint32_t& argsLeft)
+    {
+        long long value = 0;
+        ArgType type = (ArgType)*arg;
+        if (type == ARG_STR) {
+            skipArg(arg);
+        } else {
+            readScalar(arg, type, value);
+        }
+        argsLeft--;
+        return (int)value;
+    }
+
+    static void readScalar(const char*& arg, ArgType type, long long& value)
+    {
+        arg++;
+        switch (type) {
+        case ARG_INT: { int v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_UINT: { unsigned v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_LONG: { long v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_ULONG: { unsigned long v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_LLONG: { long long v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_ULLONG: { unsigned long long v; memcpy(&v, arg, sizeof(v)); value = v; arg += sizeof(v); break; }
+        case ARG_DOUBLE: { double v; memcpy(&v, arg, sizeof(v)); value = (long long)v; arg += sizeof(v); break; }
+        case ARG_PTR: { const void* v; memcpy(&v, arg, sizeof(v)); value = (long long)(intptr_t)v; arg += sizeof(v); break; }
+        default: break;
+        }
+    }
+
+    static void skipArg(const char*& arg)
+    {
+        if ((ArgType)*arg == ARG_STR) {
+            uint16_t length;
+            memcpy(&length, arg + 1 + sizeof(const char*), sizeof(length));
+            arg += 1 + sizeof(const char*) + sizeof(length) + length + 1;
+        } else {
+            long long ignored;
+            readScalar(arg, (ArgType)*arg, ignored);
+        }
+    }
+
+    template <typename T>
+    static int print(char* out, size_t room, const char* spec, const int* stars, int starCount, T value)
+    {
+        // The spec comes from a checked literal, the value has its original type
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+        switch (starCount) {
+        case 0:
+            return snprintf(out, room, spec, value);
+        case 1:
+            return snprintf(out, room, spec, stars[0], value);
+        default:
+            return snprintf(out, room, spec, stars[0], stars[1], value);
+        }
+#pragma GCC diagnostic pop
+    }
+
+    static int formatArg(char* out, size_t room, const char* spec, char conversion, const int* stars, int starCount, const char*& arg)
+    {
+        ArgType type = (ArgType)*arg;
+        const char* value = arg + 1;
+        int written = 0;
+        switch (type) {
+        case ARG_INT: { int v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_UINT: { unsigned v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_LONG: { long v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_ULONG: { unsigned long v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_LLONG: { long long v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_ULLONG: { unsigned long long v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_DOUBLE: { double v; memcpy(&v, value, sizeof(v)); written = print(out, room, spec, stars, starCount, v); break; }
+        case ARG_PTR: {
+            // A non-char pointer given to %s can't be read here, print its address instead
+            const void* v;
+            memcpy(&v, value, sizeof(v));
+            written = print(out, room, conversion == 's' ? "%p" : spec, stars, conversion == 's' ? 0 : starCount, v);
+            break;
+        }
+        case ARG_STR: {
+            const char* original;
+            memcpy(&original, value, sizeof(original));
+            const char* copy = value + sizeof(original) + sizeof(uint16_t);
+            if (conversion == 's') {
+                written = print(out, room, spec, stars, starCount, original ? copy : "(null)");
+            } else {
+                written = print(out, room, spec, stars, starCount, (const void*)original);
+            }
+            break;
+        }
+        }
+        skipArg(arg);
+        return written;
+    }
+
+    size_t m_ringSize;
+    std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<bool> m_stopped;
+    std::atomic<bool> m_waiting;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCond;
+    bool m_wakeup;
+    std::unique_ptr<char[]> m_message;
+    log4cxx::LoggerPtr m_self;
+    std::thread m_thread;
+};
+
+// std::string arguments are accepted by the compiler through varargs, pass their content
+template <typename T>
+inline T passArg(T value) { return value; }
+inline const char* passArg(const std::string& value) { return value.c_str(); }
+
+template <typename... Args>
+inline void log(Site& site, const log4cxx::LoggerPtr& logger, Level level, const char* fmt, Args... args)
+{
+    if (!site.admit()) {
+        return;
+    }
+    AsyncLogger* async = level != LEVEL_FATAL ? AsyncLogger::get() : nullptr;
+    if (async) {
+        async->log(site, logger, level, fmt, args...);
+        return;
+    }
+    char buffer[ELOG_MAX_BUFFER_SIZE];
+    formatMessage(buffer, ELOG_MAX_BUFFER_SIZE, fmt, passArg(args)...);
+    uint32_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    if (suppressed) {
+        size_t length = strlen(buffer);
+        formatMessage(buffer + length, ELOG_MAX_BUFFER_SIZE - length, " [%u suppressed]", suppressed);
+    }
+    dispatch(logger, level, buffer);
+}
+
+} /* namespace elog */
+} /* namespace owt_base */
+
+#endif /* AsyncLogger_h */
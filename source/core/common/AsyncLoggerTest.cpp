@@ -0,0 +1,218 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE AsyncLogger
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+
+using namespace owt_base::elog;
+
+template <typename... Args>
+static uint32_t makeRecord(char* buffer, size_t capacity, const char* fmt, Args... args)
+{
+    RecordWriter writer(buffer, capacity);
+    writer.encodeAll(args...);
+
+    RecordHeader* header = reinterpret_cast<RecordHeader*>(buffer);
+    header->size = (writer.size() + 7) & ~(size_t)7;
+    header->kind = RECORD_MESSAGE;
+    header->logger = nullptr;
+    header->fmt = fmt;
+    header->time = 0;
+    header->suppressed = 0;
+    header->level = LEVEL_INFO;
+    header->argCount = writer.count();
+    return header->size;
+}
+
+template <typename... Args>
+static std::string formatted(const char* fmt, Args... args)
+{
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    makeRecord(record, sizeof(record), fmt, args...);
+    char out[256];
+    size_t length = AsyncLogger::format(reinterpret_cast<RecordHeader*>(record), out, sizeof(out));
+    BOOST_CHECK_EQUAL(length, strlen(out));
+    return out;
+}
+
+static std::vector<std::string> drainMessages(Ring& ring)
+{
+    std::vector<std::string> messages;
+    ring.drain([&messages](const RecordHeader* record) {
+        char out[256];
+        AsyncLogger::format(record, out, sizeof(out));
+        messages.push_back(out);
+    });
+    return messages;
+}
+
+BOOST_AUTO_TEST_SUITE(RingBuffer)
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    Ring ring(1024);
+    BOOST_CHECK(ring.empty());
+    BOOST_CHECK(drainMessages(ring).empty());
+}
+
+BOOST_AUTO_TEST_CASE(Order)
+{
+    Ring ring(4096);
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    for (int i = 0; i < 10; i++) {
+        uint32_t size = makeRecord(record, sizeof(record), "message %d", i);
+        BOOST_REQUIRE(ring.push(record, size));
+    }
+    BOOST_CHECK(!ring.empty());
+
+    std::vector<std::string> messages = drainMessages(ring);
+    BOOST_REQUIRE_EQUAL(messages.size(), 10u);
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK_EQUAL(messages[i], "message " + std::to_string(i));
+    }
+    BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_CASE(FullRejects)
+{
+    Ring ring(256);
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    uint32_t size = makeRecord(record, sizeof(record), "%s", "0123456789012345678901234567890123456789");
+
+    uint32_t pushed = 0;
+    while (ring.push(record, size)) {
+        pushed++;
+    }
+    BOOST_CHECK_EQUAL(pushed, 256 / size);
+    BOOST_CHECK_EQUAL(drainMessages(ring).size(), pushed);
+    BOOST_CHECK(ring.push(record, size));
+}
+
+BOOST_AUTO_TEST_CASE(WrapSkipsTail)
+{
+    // Records don't fit the end of the buffer evenly, so the writer pads and wraps
+    Ring ring(256);
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    uint32_t size = makeRecord(record, sizeof(record), "%s %d", "01234567890123456789", 0);
+    BOOST_REQUIRE_NE(256 % size, 0u);
+
+    for (int i = 0; i < 50; i++) {
+        makeRecord(record, sizeof(record), "%s %d", "01234567890123456789", i);
+        BOOST_REQUIRE(ring.push(record, size));
+        std::vector<std::string> messages = drainMessages(ring);
+        BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+        BOOST_CHECK_EQUAL(messages[0], "01234567890123456789 " + std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentProducer)
+{
+    const int count = 100000;
+    Ring ring(4096);
+    std::vector<std::string> messages;
+
+    std::thread producer([&ring] {
+        alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+        for (int i = 0; i < count; i++) {
+            uint32_t size = makeRecord(record, sizeof(record), "%d", i);
+            while (!ring.push(record, size)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    while ((int)messages.size() < count) {
+        std::vector<std::string> drained = drainMessages(ring);
+        messages.insert(messages.end(), drained.begin(), drained.end());
+    }
+    producer.join();
+
+    for (int i = 0; i < count; i++) {
+        BOOST_REQUIRE_EQUAL(messages[i], std::to_string(i));
+    }
+    BOOST_CHECK(ring.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Formatting)
+
+BOOST_AUTO_TEST_CASE(Conversions)
+{
+    BOOST_CHECK_EQUAL(formatted("plain"), "plain");
+    BOOST_CHECK_EQUAL(formatted("%d %u %ld %lu", -1, 2u, -3L, 4UL), "-1 2 -3 4");
+    BOOST_CHECK_EQUAL(formatted("%lld %llu", -5LL, 6ULL), "-5 6");
+    BOOST_CHECK_EQUAL(formatted("%.2f %x %c", 1.5, 255, 'a'), "1.50 ff a");
+    BOOST_CHECK_EQUAL(formatted("%5d|%-3s|", 42, "ab"), "   42|ab |");
+    BOOST_CHECK_EQUAL(formatted("%*d %.*s", 4, 7, 2, "abc"), "   7 ab");
+    BOOST_CHECK_EQUAL(formatted("100%% %s", "done"), "100% done");
+    BOOST_CHECK_EQUAL(formatted("%p", (void*)0x1234), "0x1234");
+    BOOST_CHECK_EQUAL(formatted("%s", (const char*)nullptr), "(null)");
+    BOOST_CHECK_EQUAL(formatted("%s", std::string("copied")), "copied");
+}
+
+BOOST_AUTO_TEST_CASE(StringsAreCopied)
+{
+    char text[] = "before";
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    makeRecord(record, sizeof(record), "%s", text);
+    strcpy(text, "after");
+
+    char out[64];
+    AsyncLogger::format(reinterpret_cast<RecordHeader*>(record), out, sizeof(out));
+    BOOST_CHECK_EQUAL(std::string(out), "before");
+}
+
+BOOST_AUTO_TEST_CASE(Suppressed)
+{
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    makeRecord(record, sizeof(record), "hot %d", 1);
+    reinterpret_cast<RecordHeader*>(record)->suppressed = 7;
+
+    char out[64];
+    AsyncLogger::format(reinterpret_cast<RecordHeader*>(record), out, sizeof(out));
+    BOOST_CHECK_EQUAL(std::string(out), "hot 1 [7 suppressed]");
+}
+
+BOOST_AUTO_TEST_CASE(Truncation)
+{
+    std::string longText(ELOG_MAX_RECORD_SIZE * 2, 'x');
+    alignas(8) char record[ELOG_MAX_RECORD_SIZE];
+    uint32_t size = makeRecord(record, sizeof(record), "%s", longText.c_str());
+    BOOST_CHECK_LE(size, (uint32_t)ELOG_MAX_RECORD_SIZE);
+
+    char out[16];
+    size_t length = AsyncLogger::format(reinterpret_cast<RecordHeader*>(record), out, sizeof(out));
+    BOOST_CHECK_EQUAL(length, sizeof(out) - 1);
+    BOOST_CHECK_EQUAL(std::string(out), std::string(sizeof(out) - 1, 'x'));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(RateLimit)
+
+BOOST_AUTO_TEST_CASE(UnlimitedByDefault)
+{
+    Site site;
+    for (int i = 0; i < 1000; i++) {
+        BOOST_REQUIRE(site.admit());
+    }
+    BOOST_CHECK_EQUAL(site.suppressed.load(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(LimitedSite)
+{
+    Site site(3);
+    uint32_t admitted = 0;
+    for (int i = 0; i < 10; i++) {
+        admitted += site.admit() ? 1 : 0;
+    }
+    // A second boundary may open a new window once
+    BOOST_CHECK(admitted == 3 || admitted == 6);
+    BOOST_CHECK_EQUAL(site.suppressed.load(), 10 - admitted);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
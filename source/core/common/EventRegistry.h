@@ -16,6 +16,12 @@ public:
     // which would be handled before other normal notifications (LIFO).
     // Do not abuse it.
     virtual bool notifyAsyncEventInEmergency(const std::string& event, const std::string& data) = 0;
+    // For events carrying a state rather than a change, e.g. stats or the active speaker. While one with the same
+    // `event' and `key' is still queued, only its data is replaced, so the handler sees the latest state once.
+    virtual bool notifyCoalescedAsyncEvent(const std::string& event, const std::string& key, const std::string& data)
+    {
+        return notifyAsyncEvent(event, data);
+    }
 };
 
 #endif // EventRegistry_h
@@ -4,19 +4,138 @@
 
 #include "IOService.h"
 
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 namespace owt_base {
 
-static constexpr uint32_t kServiceNum = 4;
+static log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger("owt.IOService");
+
+static constexpr uint32_t kMinServiceNum = 4;
+static constexpr uint32_t kMaxServiceNum = 16;
+static constexpr uint32_t kMaxServiceNumByEnv = 64;
+// Each service samples itself on a timer at this interval
+static constexpr int64_t kSampleIntervalNs = 100 * 1000 * 1000;
+static constexpr double kUtilizationAlpha = 0.3;
+// Weights of queue delay (per ms) and owners against the busy ratio,
+// 10ms of delay counts like a thread 20% busier
+static constexpr double kQueueDelayWeight = 0.02;
+static constexpr double kOwnerWeight = 0.02;
+// Minimum load gap before moving an existing user
+static constexpr double kRebalanceMargin = 0.2;
+
 static boost::mutex g_serviceMutex;
 static std::vector<std::shared_ptr<IOService>> g_services;
 
-IOService::IOService()
+static int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        uint32_t num = std::max(boost::thread::hardware_concurrency(), 1U);
+        for (uint32_t i = 0; i < num; i++) {
+            cpus.push_back(i);
+        }
+    }
+    return cpus;
+}
+
+static uint32_t serviceNum(uint32_t cores)
+{
+    const char* env = std::getenv("OWT_IO_SERVICES");
+    if (env && std::atoi(env) > 0) {
+        return std::min<uint32_t>(std::atoi(env), kMaxServiceNumByEnv);
+    }
+    return std::min(std::max(cores / 2, kMinServiceNum), kMaxServiceNum);
+}
+
+static bool affinityEnabled()
+{
+    const char* env = std::getenv("OWT_IO_AFFINITY");
+    return env && std::atoi(env) > 0;
+}
+
+static double loadOf(const std::shared_ptr<IOService>& service)
+{
+    // The pool holds one reference
+    long owners = service.use_count() - 1;
+    return service->utilization()
+        + kQueueDelayWeight * service->queueDelayMs()
+        + kOwnerWeight * owners;
+}
+
+static void initServices()
+{
+    if (!g_services.empty()) {
+        return;
+    }
+    std::vector<int> cpus = allowedCpus();
+    uint32_t num = serviceNum(cpus.size());
+    bool pin = affinityEnabled();
+    for (size_t i = 0; i < num; i++) {
+        g_services.push_back(std::make_shared<IOService>(pin ? cpus[i % cpus.size()] : -1));
+    }
+    ELOG_INFO("IOService pool size: %u, cores: %zu, pinned: %d", num, cpus.size(), pin);
+}
+
+// Must be called with g_serviceMutex held
+static size_t leastLoaded(double* load)
+{
+    size_t best = 0;
+    double bestLoad = loadOf(g_services[0]);
+    for (size_t i = 1; i < g_services.size(); i++) {
+        double l = loadOf(g_services[i]);
+        if (l < bestLoad) {
+            best = i;
+            bestLoad = l;
+        }
+    }
+    if (load) {
+        *load = bestLoad;
+    }
+    return best;
+}
+
+IOService::IOService(int cpu)
     : m_count(0)
     , m_service()
     , m_work(m_service)
     , m_thread(boost::bind(&boost::asio::io_service::run, &m_service))
+    , m_cpu(-1)
+    , m_sampleTimer(m_service)
+    , m_sampleDueNs(0)
+    , m_queueDelayNs(0)
+    , m_utilization(0)
+    , m_lastSampleNs(monotonicNs())
+    , m_lastBusyNs(-1)
 {
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(m_thread.native_handle(), sizeof(set), &set) == 0) {
+            m_cpu = cpu;
+        } else {
+            ELOG_WARN_T("Failed to pin IOService thread to cpu %d", cpu);
+        }
+    }
+    scheduleSample();
 }
 
 IOService::~IOService()
@@ -35,16 +154,82 @@ void IOService::post(std::function<void()> task)
     });
 }
 
+double IOService::queueDelayMs() const
+{
+    int64_t delay = m_queueDelayNs.load();
+    // A timer that is overdue shows a stall still going on
+    int64_t overdue = monotonicNs() - m_sampleDueNs.load();
+    return std::max(delay, overdue) / 1e6;
+}
+
+void IOService::scheduleSample()
+{
+    m_sampleDueNs.store(monotonicNs() + kSampleIntervalNs);
+    m_sampleTimer.expires_from_now(boost::posix_time::microseconds(kSampleIntervalNs / 1000));
+    m_sampleTimer.async_wait(boost::bind(&IOService::onSample, this, boost::asio::placeholders::error));
+}
+
+// Runs on the service thread
+void IOService::onSample(const boost::system::error_code& ec)
+{
+    if (ec) {
+        return;
+    }
+    int64_t now = monotonicNs();
+    m_queueDelayNs.store(std::max<int64_t>(0, now - m_sampleDueNs.load()));
+
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        int64_t busy = int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        if (m_lastBusyNs >= 0 && now > m_lastSampleNs) {
+            double ratio = std::min(1.0, double(busy - m_lastBusyNs) / (now - m_lastSampleNs));
+            m_utilization.store(kUtilizationAlpha * ratio + (1 - kUtilizationAlpha) * m_utilization.load());
+        }
+        m_lastBusyNs = busy;
+    }
+    m_lastSampleNs = now;
+    scheduleSample();
+}
+
 std::shared_ptr<IOService> getIOService()
 {
     boost::mutex::scoped_lock lock(g_serviceMutex);
-    if (g_services.empty()) {
-        for (size_t i = 0; i < kServiceNum; i++) {
-            g_services.push_back(std::make_shared<IOService>());
-        }
+    initServices();
+    return g_services[leastLoaded(nullptr)];
+}
+
+std::shared_ptr<IOService> rebalanceIOService(const std::shared_ptr<IOService>& current)
+{
+    boost::mutex::scoped_lock lock(g_serviceMutex);
+    initServices();
+    double bestLoad = 0;
+    size_t best = leastLoaded(&bestLoad);
+    if (!current || g_services[best] == current) {
+        return current ? current : g_services[best];
+    }
+    // Moving takes one owner from current to best
+    double currentLoad = loadOf(current) - kOwnerWeight;
+    if (currentLoad - (bestLoad + kOwnerWeight) < kRebalanceMargin) {
+        return current;
+    }
+    ELOG_DEBUG("Rebalance IOService user, load %.2f -> %.2f", currentLoad, bestLoad);
+    return g_services[best];
+}
+
+std::vector<IOServiceStats> getIOServiceStats()
+{
+    boost::mutex::scoped_lock lock(g_serviceMutex);
+    std::vector<IOServiceStats> stats;
+    for (auto& service : g_services) {
+        IOServiceStats s;
+        s.cpu = service->cpu();
+        s.utilization = service->utilization();
+        s.queueDelayMs = service->queueDelayMs();
+        // The pool holds one reference
+        s.owners = service.use_count() - 1;
+        stats.push_back(s);
     }
-    int i = std::rand()/((RAND_MAX + 1u)/kServiceNum);
-    return g_services[i];
+    return stats;
 }
 
 }
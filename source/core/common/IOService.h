@@ -10,13 +10,15 @@
 #include <boost/thread/mutex.hpp>
 #include <logger.h>
 #include <memory>
+#include <vector>
 
 namespace owt_base {
 
 // Wrapped io_service for transport usage
 class IOService {
 public:
-    IOService();
+    // Pin the thread to `cpu' if it's not negative
+    IOService(int cpu = -1);
     virtual ~IOService();
 
     // Get in-process counted tasks number
@@ -26,15 +28,54 @@ public:
     // Get raw io_service
     boost::asio::io_service& service() { return m_service; }
 
+    // Busy ratio EWMA of the thread in [0, 1]
+    double utilization() const { return m_utilization.load(); }
+    // How long work handed to the service waits before it runs, posted
+    // tasks, socket completions and strands alike. Measured as the
+    // lateness of a sampling timer on the service itself.
+    double queueDelayMs() const;
+    int cpu() const { return m_cpu; }
+
 private:
+    void scheduleSample();
+    void onSample(const boost::system::error_code& ec);
+
     std::atomic<int> m_count;
     boost::asio::io_service m_service;
     boost::asio::io_service::work m_work;
     boost::thread m_thread;
+
+    int m_cpu;
+    boost::asio::deadline_timer m_sampleTimer;
+    // Set before the timer is armed, read by other threads
+    std::atomic<int64_t> m_sampleDueNs;
+    std::atomic<int64_t> m_queueDelayNs;
+    std::atomic<double> m_utilization;
+    // Only touched on the service thread
+    int64_t m_lastSampleNs;
+    int64_t m_lastBusyNs;
+};
+
+struct IOServiceStats {
+    int cpu;
+    // Busy ratio EWMA of the thread
+    double utilization;
+    // See IOService::queueDelayMs
+    double queueDelayMs;
+    // Users holding the service
+    long owners;
 };
 
-// Get a IOService from service pool
+// Get the least loaded IOService from service pool. The load is the busy
+// ratio, the queue delay and the number of users holding the service.
 std::shared_ptr<IOService> getIOService();
+// For long-lived users that only post tasks: returns a clearly less loaded
+// IOService than `current', or `current' itself. The caller must make sure
+// no task of its own is pending on `current' before switching. Users with
+// sockets or timers on the service can't move, their handlers stay there.
+std::shared_ptr<IOService> rebalanceIOService(const std::shared_ptr<IOService>& current);
+// Per-service counters of the pool, empty before the pool is used
+std::vector<IOServiceStats> getIOServiceStats();
 
 } /* namespace owt_base */
 
@@ -0,0 +1,109 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE IOService
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <thread>
+
+#include "IOService.h"
+
+using namespace owt_base;
+
+// The pool is created on first use, size it before any test runs
+struct PoolSize {
+    PoolSize() { setenv("OWT_IO_SERVICES", "4", 1); }
+};
+BOOST_GLOBAL_FIXTURE(PoolSize);
+
+static void sleepMs(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static void spin(int ms)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SpreadsUsers)
+{
+    std::vector<std::shared_ptr<IOService>> held;
+    std::set<IOService*> distinct;
+    for (int i = 0; i < 8; i++) {
+        held.push_back(getIOService());
+        distinct.insert(held.back().get());
+    }
+    BOOST_CHECK_EQUAL(distinct.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(QueueDelayOfBlockedService)
+{
+    IOService service;
+    sleepMs(250);
+    BOOST_CHECK_LT(service.queueDelayMs(), 20);
+
+    // Work queued behind a long task waits, whatever posted it
+    service.service().post([] { spin(400); });
+    sleepMs(300);
+    BOOST_CHECK_GT(service.queueDelayMs(), 100);
+
+    sleepMs(400);
+    BOOST_CHECK_LT(service.queueDelayMs(), 20);
+    BOOST_CHECK_GT(service.utilization(), 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(FollowsLoad)
+{
+    std::shared_ptr<IOService> busy = getIOService();
+    // Posted straight to the io_service, like socket handlers and strands
+    busy->service().post([] { spin(600); });
+    sleepMs(300);
+
+    std::vector<std::shared_ptr<IOService>> held;
+    for (int i = 0; i < 3; i++) {
+        held.push_back(getIOService());
+        BOOST_CHECK(held.back() != busy);
+    }
+    BOOST_CHECK(rebalanceIOService(busy) != busy);
+    held.clear();
+
+    // Once idle again the user stays
+    sleepMs(1300);
+    BOOST_CHECK(rebalanceIOService(busy) == busy);
+}
+
+BOOST_AUTO_TEST_CASE(PoolStats)
+{
+    std::vector<std::shared_ptr<IOService>> held;
+    for (int i = 0; i < 4; i++) {
+        held.push_back(getIOService());
+    }
+    held.push_back(held[0]);
+    held[1]->service().post([] { spin(400); });
+    sleepMs(300);
+
+    std::vector<IOServiceStats> stats = getIOServiceStats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 4u);
+    long owners = 0;
+    for (size_t i = 0; i < stats.size(); i++) {
+        owners += stats[i].owners;
+        BOOST_CHECK_EQUAL(stats[i].cpu, -1);
+        BOOST_CHECK(stats[i].utilization >= 0 && stats[i].utilization <= 1);
+        BOOST_CHECK_GE(stats[i].queueDelayMs, 0);
+    }
+    BOOST_CHECK_EQUAL(owners, 5);
+
+    // Same order as the pool, the blocked service reports its delay
+    size_t blocked = stats.size();
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (stats[i].queueDelayMs > 100) {
+            blocked = i;
+        }
+    }
+    BOOST_REQUIRE(blocked < stats.size());
+    BOOST_CHECK_EQUAL(stats[blocked].owners, held[1].use_count() - 1);
+}
@@ -46,6 +46,74 @@
     char buffer[ELOG_MAX_BUFFER_SIZE]; \
     snprintf( buffer, ELOG_MAX_BUFFER_SIZE, fmt, ##args );
 
+#ifndef ELOG_SYNC
+
+#include "AsyncLogger.h"
+
+// Formatted off the calling thread, see AsyncLogger.h. "" fmt keeps the format a literal.
+#define ELOG_ASYNC_MSG(logger, level, rate, fmt, args...) \
+    static owt_base::elog::Site __elogSite( rate ); \
+    if (false) owt_base::elog::checkFormat( fmt, ##args ); \
+    owt_base::elog::log( __elogSite, logger, level, "" fmt, ##args );
+
+// older versions of log4cxx don't support tracing
+#ifdef LOG4CXX_TRACE
+#define ELOG_TRACE_RATE2(logger, rate, fmt, args...) \
+    if (logger->isTraceEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_TRACE, rate, fmt, ##args ); \
+    }
+#else
+#define ELOG_TRACE_RATE2(logger, rate, fmt, args...) \
+    if (logger->isDebugEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_DEBUG, rate, fmt, ##args ); \
+    }
+#endif
+
+#define ELOG_DEBUG_RATE2(logger, rate, fmt, args...) \
+    if (logger->isDebugEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_DEBUG, rate, fmt, ##args ); \
+    }
+
+#define ELOG_INFO_RATE2(logger, rate, fmt, args...) \
+    if (logger->isInfoEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_INFO, rate, fmt, ##args ); \
+    }
+
+#define ELOG_WARN_RATE2(logger, rate, fmt, args...) \
+    if (logger->isWarnEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_WARN, rate, fmt, ##args ); \
+    }
+
+#define ELOG_ERROR_RATE2(logger, rate, fmt, args...) \
+    if (logger->isErrorEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_ERROR, rate, fmt, ##args ); \
+    }
+
+#define ELOG_FATAL_RATE2(logger, rate, fmt, args...) \
+    if (logger->isFatalEnabled()) { \
+        ELOG_ASYNC_MSG( logger, owt_base::elog::LEVEL_FATAL, rate, fmt, ##args ); \
+    }
+
+#define ELOG_TRACE2(logger, fmt, args...) \
+    ELOG_TRACE_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#define ELOG_DEBUG2(logger, fmt, args...) \
+    ELOG_DEBUG_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#define ELOG_INFO2(logger, fmt, args...) \
+    ELOG_INFO_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#define ELOG_WARN2(logger, fmt, args...) \
+    ELOG_WARN_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#define ELOG_ERROR2(logger, fmt, args...) \
+    ELOG_ERROR_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#define ELOG_FATAL2(logger, fmt, args...) \
+    ELOG_FATAL_RATE2( logger, ELOG_DEFAULT_SITE_RATE, fmt, ##args )
+
+#else
+
 // older versions of log4cxx don't support tracing
 #ifdef LOG4CXX_TRACE
 #define ELOG_TRACE2(logger, fmt, args...) \
@@ -91,6 +159,25 @@
         LOG4CXX_FATAL( logger, __tmp ); \
     }
 
+#define ELOG_TRACE_RATE2(logger, rate, fmt, args...) \
+    ELOG_TRACE2( logger, fmt, ##args )
+
+#define ELOG_DEBUG_RATE2(logger, rate, fmt, args...) \
+    ELOG_DEBUG2( logger, fmt, ##args )
+
+#define ELOG_INFO_RATE2(logger, rate, fmt, args...) \
+    ELOG_INFO2( logger, fmt, ##args )
+
+#define ELOG_WARN_RATE2(logger, rate, fmt, args...) \
+    ELOG_WARN2( logger, fmt, ##args )
+
+#define ELOG_ERROR_RATE2(logger, rate, fmt, args...) \
+    ELOG_ERROR2( logger, fmt, ##args )
+
+#define ELOG_FATAL_RATE2(logger, rate, fmt, args...) \
+    ELOG_FATAL2( logger, fmt, ##args )
+
+#endif /* ELOG_SYNC */
 
 #define ELOG_TRACE(fmt, args...) \
     ELOG_TRACE2( logger, fmt, ##args );
@@ -110,6 +197,22 @@
 #define ELOG_FATAL(fmt, args...) \
     ELOG_FATAL2( logger, fmt, ##args );
 
+// At most rate messages per second from this call site, for hot paths
+#define ELOG_TRACE_RATE(rate, fmt, args...) \
+    ELOG_TRACE_RATE2( logger, rate, fmt, ##args );
+
+#define ELOG_DEBUG_RATE(rate, fmt, args...) \
+    ELOG_DEBUG_RATE2( logger, rate, fmt, ##args );
+
+#define ELOG_INFO_RATE(rate, fmt, args...) \
+    ELOG_INFO_RATE2( logger, rate, fmt, ##args );
+
+#define ELOG_WARN_RATE(rate, fmt, args...) \
+    ELOG_WARN_RATE2( logger, rate, fmt, ##args );
+
+#define ELOG_ERROR_RATE(rate, fmt, args...) \
+    ELOG_ERROR_RATE2( logger, rate, fmt, ##args );
+
 //this
 #define ELOG_TRACE_T(fmt, args...) \
     ELOG_TRACE2( logger, "(%p)" fmt, this, ##args );
@@ -2,9 +2,66 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 #include "AVStreamOut.h"
+#include "NalScanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Muxer threads shared by all outputs in the process,
+// each output is serialized on its own strand
+class MuxerWorkerPool {
+public:
+    MuxerWorkerPool(uint32_t workers)
+    : m_service{}
+    , m_work{m_service}
+    {
+        for (uint32_t i = 0; i < workers; i++)
+            m_threads.create_thread(boost::bind(&boost::asio::io_service::run, &m_service));
+    }
+
+    ~MuxerWorkerPool()
+    {
+        m_service.stop();
+        m_threads.join_all();
+    }
+
+    boost::asio::io_service& service()
+    {
+        return m_service;
+    }
+
+private:
+    boost::asio::io_service m_service;
+    boost::asio::io_service::work m_work;
+    boost::thread_group m_threads;
+};
+
+boost::scoped_ptr<MuxerWorkerPool> g_muxerPool;
+std::once_flag g_muxerPoolOnce;
+
+// Writes may block on network, keep some headroom over the cores
+const uint32_t kMinMuxerWorkers = 4;
+
+void startMuxerPool()
+{
+    g_muxerPool.reset(new MuxerWorkerPool(std::max(kMinMuxerWorkers, boost::thread::hardware_concurrency())));
+}
+
+}
 
 namespace owt_base {
 
+static const uint32_t kFormatWaitMs = 20;
+static const uint32_t kInputCheckMs = 500;
+static const uint32_t kNoInputTimeoutMs = 2000;
+// Frames written per turn before yielding the worker to other outputs
+static const uint32_t kMaxFramesPerDrain = 32;
+// Longest a network open, write or trailer may block a muxer worker
+static const uint32_t kIoTimeoutMs = 10000;
+
 inline AVCodecID frameFormat2AVCodecID(int frameFormat)
 {
     switch (frameFormat) {
@@ -30,6 +87,200 @@ inline AVCodecID frameFormat2AVCodecID(int frameFormat)
     }
 }
 
+DEFINE_LOGGER(MediaFrameQueue, "owt.MediaFrameQueue");
+
+MediaFrameQueue::MediaFrameQueue()
+    : m_valid(true)
+    , m_startTimeOffset(currentTimeMs())
+    , m_capacity(0)
+    , m_policy(DROP_UNTIL_KEYFRAME)
+    , m_waitKeyFrame(false)
+    , m_droppedCount(0)
+{
+}
+
+MediaFrameQueue::~MediaFrameQueue()
+{
+}
+
+void MediaFrameQueue::setCapacity(size_t capacity, DropPolicy policy)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_capacity = capacity;
+    m_policy = policy;
+}
+
+MediaFrameQueue::PushResult MediaFrameQueue::pushFrame(const owt_base::Frame& frame)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_valid)
+        return PUSH_DROPPED;
+
+    if (isVideoFrame(frame) && m_waitKeyFrame) {
+        if (!frame.additionalInfo.video.isKeyFrame) {
+            m_droppedCount++;
+            return PUSH_DROPPED;
+        }
+        m_waitKeyFrame = false;
+    }
+
+    if (m_capacity > 0 && m_queue.size() >= m_capacity) {
+        PushResult ret = dropOnOverflow(frame);
+        if (ret != PUSH_OK)
+            return ret;
+    }
+
+    boost::shared_ptr<MediaFrame> lastFrame;
+
+    boost::shared_ptr<MediaFrame> mediaFrame(new MediaFrame(frame, currentTimeMs() - m_startTimeOffset));
+    if (isAudioFrame(frame)) {
+        if (!m_lastAudioFrame) {
+            m_lastAudioFrame = mediaFrame;
+            return PUSH_OK;
+        }
+
+        m_lastAudioFrame->m_duration = mediaFrame->m_timeStamp - m_lastAudioFrame->m_timeStamp;
+        if (m_lastAudioFrame->m_duration <= 0) {
+            m_lastAudioFrame->m_duration = 1;
+            mediaFrame->m_timeStamp = m_lastAudioFrame->m_timeStamp + 1;
+        }
+
+        lastFrame = m_lastAudioFrame;
+        m_lastAudioFrame = mediaFrame;
+    } else {
+        if (!m_lastVideoFrame) {
+            m_lastVideoFrame = mediaFrame;
+            return PUSH_OK;
+        }
+
+        m_lastVideoFrame->m_duration = mediaFrame->m_timeStamp - m_lastVideoFrame->m_timeStamp;
+        if (m_lastVideoFrame->m_duration <= 0) {
+            m_lastVideoFrame->m_duration = 1;
+            mediaFrame->m_timeStamp = m_lastVideoFrame->m_timeStamp + 1;
+        }
+
+        lastFrame = m_lastVideoFrame;
+        m_lastVideoFrame = mediaFrame;
+    }
+
+    m_queue.push_back(lastFrame);
+    if (m_queue.size() == 1)
+        m_cond.notify_one();
+
+    return PUSH_OK;
+}
+
+boost::shared_ptr<MediaFrame> MediaFrameQueue::popFrame(int timeout)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    boost::shared_ptr<MediaFrame> mediaFrame;
+
+    if (!m_valid)
+        return NULL;
+
+    if (m_queue.size() == 0 && timeout > 0) {
+        m_cond.timed_wait(lock, boost::get_system_time() + boost::posix_time::milliseconds(timeout));
+    }
+
+    if (m_queue.size() > 0) {
+        mediaFrame = m_queue.front();
+        m_queue.pop_front();
+    }
+
+    return mediaFrame;
+}
+
+void MediaFrameQueue::cancel()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_valid = false;
+    m_cond.notify_all();
+}
+
+bool MediaFrameQueue::isValid()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_valid;
+}
+
+size_t MediaFrameQueue::size()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_queue.size();
+}
+
+MediaFrameQueue::PushResult MediaFrameQueue::dropOnOverflow(const owt_base::Frame& frame)
+{
+    switch (m_policy) {
+        case DROP_DISCONNECT:
+            ELOG_WARN("Queue overflow, capacity(%zu)", m_capacity);
+
+            m_valid = false;
+            m_cond.notify_all();
+            return PUSH_OVERFLOW;
+
+        case DROP_NON_REFERENCE:
+            if (isAudioFrame(frame) || isDisposableFrame(frame)) {
+                m_droppedCount++;
+                return PUSH_DROPPED;
+            }
+            // fall through
+
+        case DROP_UNTIL_KEYFRAME:
+        default:
+            if (isAudioFrame(frame)) {
+                m_droppedCount++;
+                return PUSH_DROPPED;
+            }
+
+            flushVideo();
+            if (!frame.additionalInfo.video.isKeyFrame) {
+                ELOG_DEBUG("Queue overflow, drop video until key frame");
+
+                m_waitKeyFrame = true;
+                m_droppedCount++;
+                return PUSH_NEED_KEY_FRAME;
+            }
+            return PUSH_OK;
+    }
+}
+
+void MediaFrameQueue::flushVideo()
+{
+    size_t size = m_queue.size();
+
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+            [](const boost::shared_ptr<MediaFrame>& mediaFrame) {return isVideoFrame(mediaFrame->m_frame);}),
+            m_queue.end());
+    m_droppedCount += size - m_queue.size();
+
+    if (m_lastVideoFrame) {
+        m_lastVideoFrame.reset();
+        m_droppedCount++;
+    }
+}
+
+// H.264 frame whose slices all have nal_ref_idc 0, no other frame refers to it
+bool MediaFrameQueue::isDisposableFrame(const owt_base::Frame& frame)
+{
+    if (frame.format != FRAME_FORMAT_H264 || frame.additionalInfo.video.isKeyFrame)
+        return false;
+
+    NalSpan nals[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(frame.payload, frame.length, false, nals, NalScanner::MAX_NALS);
+    bool hasSlice = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if (nals[i].type == 1 || nals[i].type == 5) {
+            if (frame.payload[nals[i].payloadOffset()] & 0x60)
+                return false;
+            hasSlice = true;
+        }
+    }
+
+    return hasSlice;
+}
+
 DEFINE_LOGGER(AVStreamOut, "owt.AVStreamOut");
 
 AVStreamOut::AVStreamOut(const std::string& url, bool hasAudio, bool hasVideo, EventRegistry *handle, int timeout)
@@ -50,6 +301,17 @@ AVStreamOut::AVStreamOut(const std::string& url, bool hasAudio, bool hasVideo, E
     , m_audioStream(NULL)
     , m_videoStream(NULL)
     , m_lastKeyFrameTimestamp(0)
+    , m_waitStartTime(0)
+    , m_lastPushTime(0)
+    , m_connectRetry(0)
+    , m_headerWritten(false)
+    , m_avgLatencyMs(0)
+    , m_maxLatencyMs(0)
+    , m_writtenFrames(0)
+    , m_drainScheduled(false)
+    , m_pendingHandlers(0)
+    , m_interrupted(false)
+    , m_ioDeadline(0)
 {
     ELOG_INFO("url %s, audio %d, video %d, timeOut %d", m_url.c_str(), m_hasAudio, m_hasVideo, m_timeOutMs);
 
@@ -71,13 +333,58 @@ AVStreamOut::AVStreamOut(const std::string& url, bool hasAudio, bool hasVideo, E
     m_status = Context_INITIALIZING;
     notifyAsyncEvent("init", "");
 
-    m_thread = boost::thread(&AVStreamOut::sendLoop, this);
+    // Start the shared muxer pool once
+    std::call_once(g_muxerPoolOnce, startMuxerPool);
+    m_strand.reset(new boost::asio::io_service::strand(g_muxerPool->service()));
+    m_timer.reset(new boost::asio::deadline_timer(g_muxerPool->service()));
+
+    m_waitStartTime = currentTimeMs();
+    scheduleTimer(kFormatWaitMs);
 }
 
 AVStreamOut::~AVStreamOut()
 {
 }
 
+void AVStreamOut::setQueueOptions(size_t capacity, MediaFrameQueue::DropPolicy policy)
+{
+    ELOG_DEBUG("Queue capacity(%zu), drop policy(%d)", capacity, policy);
+    m_frameQueue.setCapacity(capacity, policy);
+}
+
+void AVStreamOut::getStats(AVStreamOutStats& stats)
+{
+    stats.queueDepth = m_frameQueue.size();
+    stats.droppedFrames = m_frameQueue.droppedCount();
+
+    boost::mutex::scoped_lock lock(m_statsMutex);
+    stats.avgLatencyMs = m_avgLatencyMs;
+    stats.maxLatencyMs = m_maxLatencyMs;
+    stats.writtenFrames = m_writtenFrames;
+    m_maxLatencyMs = 0;
+}
+
+void AVStreamOut::queueFrame(const owt_base::Frame& frame)
+{
+    switch (m_frameQueue.pushFrame(frame)) {
+        case MediaFrameQueue::PUSH_NEED_KEY_FRAME:
+            ELOG_DEBUG("Request video key frame after queue overflow");
+            deliverFeedbackMsg(FeedbackMsg{.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME});
+            break;
+
+        case MediaFrameQueue::PUSH_OVERFLOW:
+            ELOG_ERROR("Output queue overflow, %s", m_url.c_str());
+            notifyAsyncEvent("fatal", "Output queue overflow");
+            break;
+
+        default:
+            break;
+    }
+
+    m_lastPushTime = currentTimeMs();
+    scheduleDrain();
+}
+
 void AVStreamOut::onFrame(const owt_base::Frame& frame)
 {
     if (isAudioFrame(frame)) {
@@ -123,7 +430,7 @@ void AVStreamOut::onFrame(const owt_base::Frame& frame)
             notifyAsyncEvent("fatal", "Invalid audio frame channels or sample rate");
             return;
         }
-        m_frameQueue.pushFrame(frame);
+        queueFrame(frame);
     } else if (isVideoFrame(frame)) {
         if (!m_hasVideo) {
             ELOG_ERROR("Video is not enabled");
@@ -197,93 +504,207 @@ void AVStreamOut::onFrame(const owt_base::Frame& frame)
             return;
 #endif
 
-        m_frameQueue.pushFrame(frame);
+        queueFrame(frame);
     } else {
         ELOG_WARN("Unsupported frame format: %s(%d)", getFormatStr(frame.format), frame.format);
         notifyAsyncEvent("fatal", "Unsupported frame format");
     }
 }
 
-void AVStreamOut::sendLoop()
+bool AVStreamOut::open()
 {
-    uint32_t connectRetry;
-
-    const uint32_t waitMs = 20;
-    uint32_t timeOut = 0;
-    while ((m_hasAudio && m_audioFormat == FRAME_FORMAT_UNKNOWN) || (m_hasVideo && m_videoFormat == FRAME_FORMAT_UNKNOWN)) {
-        if (m_status == AVStreamOut::Context_CLOSED)
-            goto exit;
-
-        if (timeOut >= m_timeOutMs) {
-            ELOG_ERROR("No a/v frames, hasAudio(%d) - ready(%d), hasVideo(%d) - ready(%d), timeOutMs %d"
-                    , m_hasAudio
-                    , (m_audioFormat != FRAME_FORMAT_UNKNOWN)
-                    , m_hasVideo
-                    , (m_videoFormat != FRAME_FORMAT_UNKNOWN)
-                    , m_timeOutMs);
-            notifyAsyncEvent("fatal", "No a/v frames");
-            goto exit;
-        }
-
-        timeOut += waitMs;
-        usleep(waitMs * 1000);
-
-        ELOG_DEBUG("Wait for av options available, hasAudio(%d) - ready(%d), hasVideo(%d) - ready(%d), waitMs %d"
-                , m_hasAudio, m_audioFormat != FRAME_FORMAT_UNKNOWN, m_hasVideo, m_videoFormat != FRAME_FORMAT_UNKNOWN, timeOut);
-    }
-
-     connectRetry = getReconnectCount();
-reconnect:
+    armIoDeadline();
     if(!connect()) {
         notifyAsyncEvent("init", "Cannot open connection");
-        goto exit;
+        return false;
     }
 
     if (m_hasAudio && !addAudioStream(m_audioFormat, m_sampleRate, m_channels)) {
         notifyAsyncEvent("fatal", "Cannot add audio stream");
-        goto exit;
+        return false;
     }
     if (m_hasVideo && !addVideoStream(m_videoFormat, m_width, m_height)) {
         notifyAsyncEvent("fatal", "Cannot add video stream");
-        goto exit;
+        return false;
     }
     if (!writeHeader()) {
         notifyAsyncEvent("fatal", "Cannot write header");
-        goto exit;
+        return false;
     }
+    m_headerWritten = true;
     av_dump_format(m_context, 0, m_context->url, 1);
 
-    m_status = AVStreamOut::Context_READY;
+    return true;
+}
+
+void AVStreamOut::teardown()
+{
+    if (m_headerWritten) {
+        armIoDeadline();
+        av_write_trailer(m_context);
+        m_headerWritten = false;
+    }
+
+    m_status = AVStreamOut::Context_CLOSED;
+    m_frameQueue.cancel();
+    ELOG_DEBUG("Stopped");
+}
+
+void AVStreamOut::onTimer(const boost::system::error_code& ec)
+{
+    if (ec || m_status == AVStreamOut::Context_CLOSED)
+        return;
 
-    ELOG_DEBUG("Start");
-    while (m_status == AVStreamOut::Context_READY) {
-        boost::shared_ptr<owt_base::MediaFrame> mediaFrame = m_frameQueue.popFrame(2000);
-        if (!mediaFrame) {
-            if (m_status == AVStreamOut::Context_READY) {
-                ELOG_WARN("No input frames available");
-                notifyAsyncEvent("fatal", "No input frames available");
+    if (!m_frameQueue.isValid()) {
+        teardown();
+        return;
+    }
+
+    if (m_status == AVStreamOut::Context_INITIALIZING) {
+        if ((m_hasAudio && m_audioFormat == FRAME_FORMAT_UNKNOWN) || (m_hasVideo && m_videoFormat == FRAME_FORMAT_UNKNOWN)) {
+            int64_t waitMs = currentTimeMs() - m_waitStartTime;
+
+            if (waitMs >= m_timeOutMs) {
+                ELOG_ERROR("No a/v frames, hasAudio(%d) - ready(%d), hasVideo(%d) - ready(%d), timeOutMs %d"
+                        , m_hasAudio
+                        , (m_audioFormat != FRAME_FORMAT_UNKNOWN)
+                        , m_hasVideo
+                        , (m_videoFormat != FRAME_FORMAT_UNKNOWN)
+                        , m_timeOutMs);
+                notifyAsyncEvent("fatal", "No a/v frames");
+                teardown();
+                return;
             }
-            break;
+
+            ELOG_DEBUG("Wait for av options available, hasAudio(%d) - ready(%d), hasVideo(%d) - ready(%d), waitMs %ld"
+                    , m_hasAudio, m_audioFormat != FRAME_FORMAT_UNKNOWN, m_hasVideo, m_videoFormat != FRAME_FORMAT_UNKNOWN, waitMs);
+
+            scheduleTimer(kFormatWaitMs);
+            return;
+        }
+
+        m_connectRetry = getReconnectCount();
+        if (!open()) {
+            teardown();
+            return;
         }
 
+        m_lastPushTime = currentTimeMs();
+        m_status = AVStreamOut::Context_READY;
+
+        ELOG_DEBUG("Start");
+        scheduleDrain();
+    } else if (m_status == AVStreamOut::Context_READY) {
+        if (currentTimeMs() - m_lastPushTime > kNoInputTimeoutMs) {
+            ELOG_WARN("No input frames available");
+            notifyAsyncEvent("fatal", "No input frames available");
+            teardown();
+            return;
+        }
+    }
+
+    scheduleTimer(kInputCheckMs);
+}
+
+void AVStreamOut::onDrain()
+{
+    m_drainScheduled = false;
+
+    if (m_status != AVStreamOut::Context_READY)
+        return;
+
+    if (!m_frameQueue.isValid()) {
+        teardown();
+        return;
+    }
+
+    for (uint32_t i = 0; i < kMaxFramesPerDrain; i++) {
+        boost::shared_ptr<owt_base::MediaFrame> mediaFrame = m_frameQueue.popFrame();
+        if (!mediaFrame)
+            return;
+
+        armIoDeadline();
         bool ret = writeFrame(isVideoFrame(mediaFrame->m_frame) ? m_videoStream : m_audioStream, mediaFrame);
         if (!ret) {
-            if (connectRetry-- > 0) {
+            // Interrupted by close()
+            if (m_interrupted)
+                return;
+
+            if (m_connectRetry > 0) {
+                m_connectRetry--;
+
                 ELOG_WARN("Try to reconnect");
+                armIoDeadline();
                 av_write_trailer(m_context);
+                m_headerWritten = false;
                 disconnect();
-                goto reconnect;
-            } else {
-                notifyAsyncEvent("fatal", "Cannot write frame");
-                break;
+                if (!open()) {
+                    teardown();
+                    return;
+                }
+                continue;
             }
+
+            notifyAsyncEvent("fatal", "Cannot write frame");
+            teardown();
+            return;
         }
+
+        uint32_t latency = currentTimeMs() - mediaFrame->m_pushTime;
+        boost::mutex::scoped_lock lock(m_statsMutex);
+        m_avgLatencyMs = m_avgLatencyMs ? (m_avgLatencyMs * 7 + latency) / 8 : latency;
+        if (latency > m_maxLatencyMs)
+            m_maxLatencyMs = latency;
+        m_writtenFrames++;
     }
-    av_write_trailer(m_context);
 
-exit:
-    m_status = AVStreamOut::Context_CLOSED;
-    ELOG_DEBUG("Thread exited!");
+    // Frames left, yield the worker to other outputs
+    scheduleDrain();
+}
+
+bool AVStreamOut::beginHandler()
+{
+    boost::mutex::scoped_lock lock(m_handlerMutex);
+    if (m_status == AVStreamOut::Context_CLOSED)
+        return false;
+
+    m_pendingHandlers++;
+    return true;
+}
+
+void AVStreamOut::endHandler()
+{
+    boost::mutex::scoped_lock lock(m_handlerMutex);
+    if (--m_pendingHandlers == 0)
+        m_handlerCond.notify_all();
+}
+
+void AVStreamOut::scheduleTimer(uint32_t waitMs)
+{
+    if (!beginHandler())
+        return;
+
+    m_timer->expires_from_now(boost::posix_time::milliseconds(waitMs));
+    m_timer->async_wait(m_strand->wrap([this](const boost::system::error_code& ec) {
+        onTimer(ec);
+        endHandler();
+    }));
+}
+
+void AVStreamOut::scheduleDrain()
+{
+    if (m_drainScheduled.exchange(true))
+        return;
+
+    if (!beginHandler()) {
+        m_drainScheduled = false;
+        return;
+    }
+
+    m_strand->post([this]() {
+        onDrain();
+        endHandler();
+    });
 }
 
 bool AVStreamOut::connect()
@@ -296,8 +717,25 @@ bool AVStreamOut::connect()
         return false;
     }
 
+    // Local files don't stall, and must not be cut before the trailer
+    const char *protocol = avio_find_protocol_name(m_url.c_str());
+    bool isNetwork = !protocol || strcmp(protocol, "file") != 0;
+    if (isNetwork) {
+        m_context->interrupt_callback.callback = interruptCallback;
+        m_context->interrupt_callback.opaque = this;
+    }
+
     if (!(m_context->oformat->flags & AVFMT_NOFILE)) {
-        int ret = avio_open(&m_context->pb, m_context->url, AVIO_FLAG_WRITE);
+        AVDictionary *options = NULL;
+        if (isNetwork) {
+            av_dict_set_int(&options, "rw_timeout", (int64_t)kIoTimeoutMs * 1000, 0);
+            // rtmp(s/t/e) takes `timeout' as listen timeout and would turn into a server
+            if (!protocol || strncmp(protocol, "rtmp", 4) != 0)
+                av_dict_set_int(&options, "timeout", (int64_t)kIoTimeoutMs * 1000, 0);
+        }
+
+        int ret = avio_open2(&m_context->pb, m_context->url, AVIO_FLAG_WRITE, &m_context->interrupt_callback, &options);
+        av_dict_free(&options);
         if (ret < 0) {
             ELOG_ERROR("Cannot open avio, %s", ff_err2str(ret));
 
@@ -327,9 +765,51 @@ void AVStreamOut::close()
 
     m_status = AVStreamOut::Context_CLOSED;
     m_frameQueue.cancel();
-    m_thread.join();
+    // Unblock network I/O stalled on a worker before waiting for it
+    m_interrupted = true;
+
+    if (m_strand) {
+        boost::mutex::scoped_lock lock(m_handlerMutex);
+
+        // Timer is only touched on the strand
+        m_pendingHandlers++;
+        m_strand->post([this]() {
+            boost::system::error_code ec;
+            m_timer->cancel(ec);
+            endHandler();
+        });
+
+        while (m_pendingHandlers > 0)
+            m_handlerCond.wait(lock);
+    }
+
+    m_interrupted = false;
 
+    // Trailer is written here if closed while still streaming
+    if (m_headerWritten) {
+        armIoDeadline();
+        av_write_trailer(m_context);
+        m_headerWritten = false;
+    }
     disconnect();
+
+    ELOG_DEBUG("Closed, written(%lu), dropped(%lu)", m_writtenFrames, (uint64_t)m_frameQueue.droppedCount());
+}
+
+void AVStreamOut::armIoDeadline()
+{
+    m_ioDeadline = currentTimeMs() + kIoTimeoutMs;
+}
+
+int AVStreamOut::interruptCallback(void *opaque)
+{
+    AVStreamOut *self = reinterpret_cast<AVStreamOut*>(opaque);
+
+    if (self->m_interrupted)
+        return 1;
+
+    int64_t deadline = self->m_ioDeadline;
+    return (deadline > 0 && currentTimeMs() > deadline) ? 1 : 0;
 }
 
 bool AVStreamOut::addAudioStream(FrameFormat format, uint32_t sampleRate, uint32_t channels)
@@ -405,22 +885,31 @@ bool AVStreamOut::addVideoStream(FrameFormat format, uint32_t width, uint32_t he
     par->width      = width;
     par->height     = height;
     if (codec_id == AV_CODEC_ID_H264 || codec_id == AV_CODEC_ID_H265) { //extradata
-        AVCodecParserContext *parser = av_parser_init(codec_id);
-        if (!parser) {
-            ELOG_ERROR("Cannot find video parser");
-            return false;
+        // Parameter sets of the key frame, in Annex-B
+        const Frame& keyFrame = m_videoKeyFrame->m_frame;
+        bool h265 = (codec_id == AV_CODEC_ID_H265);
+        NalSpan nals[NalScanner::MAX_NALS];
+        size_t count = NalScanner::scan(keyFrame.payload, keyFrame.length, h265, nals, NalScanner::MAX_NALS);
+        size_t size = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            if (h265 ? NalScanner::isH265ParameterSet(nals[i].type) : NalScanner::isH264ParameterSet(nals[i].type))
+                size += nals[i].length;
         }
 
-        int size = parser->parser->split(NULL, m_videoKeyFrame->m_frame.payload, m_videoKeyFrame->m_frame.length);
-        if (size > 0) {
+        if (size > 0 && NalScanner::hasParameterSets(nals, count, h265)) {
             par->extradata_size = size;
-            par->extradata      = (uint8_t *)av_malloc(par->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
-            memcpy(par->extradata, m_videoKeyFrame->m_frame.payload, par->extradata_size);
+            par->extradata      = (uint8_t *)av_mallocz(par->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+            size = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (h265 ? NalScanner::isH265ParameterSet(nals[i].type) : NalScanner::isH264ParameterSet(nals[i].type)) {
+                    memcpy(par->extradata + size, keyFrame.payload + nals[i].offset, nals[i].length);
+                    size += nals[i].length;
+                }
+            }
         } else {
             ELOG_WARN("Cannot find video extradata");
         }
-
-        av_parser_close(parser);
     }
 
     if (codec_id == AV_CODEC_ID_H265) {
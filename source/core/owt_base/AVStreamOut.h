@@ -5,7 +5,10 @@
 #ifndef AVStreamOut_h
 #define AVStreamOut_h
 
-#include <queue>
+#include <atomic>
+#include <deque>
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -34,6 +37,7 @@ public:
     MediaFrame(const owt_base::Frame& frame, int64_t timeStamp = 0)
         : m_timeStamp(timeStamp)
         , m_duration(0)
+        , m_pushTime(currentTimeMs())
     {
         m_frame = frame;
         if (frame.length > 0) {
@@ -67,94 +71,53 @@ public:
 
     int64_t m_timeStamp;
     int64_t m_duration;
+    int64_t m_pushTime;
     owt_base::Frame m_frame;
 };
 
+// Bounded once a capacity is set, what gives way on overflow is up to the policy
 class MediaFrameQueue {
-public:
-    MediaFrameQueue()
-        : m_valid(true)
-        , m_startTimeOffset(currentTimeMs())
-    {
-    }
-
-    virtual ~MediaFrameQueue()
-    {
-    }
-
-    void pushFrame(const owt_base::Frame& frame)
-    {
-        boost::mutex::scoped_lock lock(m_mutex);
-        if (!m_valid)
-            return;
-
-        boost::shared_ptr<MediaFrame> lastFrame;
-
-        boost::shared_ptr<MediaFrame> mediaFrame(new MediaFrame(frame, currentTimeMs() - m_startTimeOffset));
-        if (isAudioFrame(frame)) {
-            if (!m_lastAudioFrame) {
-                m_lastAudioFrame = mediaFrame;
-                return;
-            }
-
-            m_lastAudioFrame->m_duration = mediaFrame->m_timeStamp - m_lastAudioFrame->m_timeStamp;
-            if (m_lastAudioFrame->m_duration <= 0) {
-                m_lastAudioFrame->m_duration = 1;
-                mediaFrame->m_timeStamp = m_lastAudioFrame->m_timeStamp + 1;
-            }
-
-            lastFrame = m_lastAudioFrame;
-            m_lastAudioFrame = mediaFrame;
-        } else {
-            if (!m_lastVideoFrame) {
-                m_lastVideoFrame = mediaFrame;
-                return;
-            }
-
-            m_lastVideoFrame->m_duration = mediaFrame->m_timeStamp - m_lastVideoFrame->m_timeStamp;
-            if (m_lastVideoFrame->m_duration <= 0) {
-                m_lastVideoFrame->m_duration = 1;
-                mediaFrame->m_timeStamp = m_lastVideoFrame->m_timeStamp + 1;
-            }
+    DECLARE_LOGGER();
 
-            lastFrame = m_lastVideoFrame;
-            m_lastVideoFrame = mediaFrame;
-        }
+public:
+    enum DropPolicy {
+        // Drop audio and disposable video, otherwise as DROP_UNTIL_KEYFRAME
+        DROP_NON_REFERENCE,
+        // Flush queued video and drop it until next key frame
+        DROP_UNTIL_KEYFRAME,
+        // Refuse the frame, the owner is expected to close the output
+        DROP_DISCONNECT
+    };
 
-        m_queue.push(lastFrame);
-        if (m_queue.size() == 1)
-            m_cond.notify_one();
-    }
+    enum PushResult {
+        PUSH_OK,
+        PUSH_DROPPED,
+        PUSH_NEED_KEY_FRAME,
+        PUSH_OVERFLOW
+    };
 
-    boost::shared_ptr<MediaFrame> popFrame(int timeout = 0)
-    {
-        boost::mutex::scoped_lock lock(m_mutex);
-        boost::shared_ptr<MediaFrame> mediaFrame;
+    MediaFrameQueue();
+    virtual ~MediaFrameQueue();
 
-        if (!m_valid)
-            return NULL;
+    // 0 for unbounded
+    void setCapacity(size_t capacity, DropPolicy policy);
 
-        if (m_queue.size() == 0 && timeout > 0) {
-            m_cond.timed_wait(lock, boost::get_system_time() + boost::posix_time::milliseconds(timeout));
-        }
+    PushResult pushFrame(const owt_base::Frame& frame);
+    boost::shared_ptr<MediaFrame> popFrame(int timeout = 0);
+    void cancel();
 
-        if (m_queue.size() > 0) {
-            mediaFrame = m_queue.front();
-            m_queue.pop();
-        }
+    bool isValid();
+    size_t size();
+    uint64_t droppedCount() {return m_droppedCount;}
 
-        return mediaFrame;
-    }
+protected:
+    PushResult dropOnOverflow(const owt_base::Frame& frame);
+    void flushVideo();
 
-    void cancel()
-    {
-        boost::mutex::scoped_lock lock(m_mutex);
-        m_valid = false;
-        m_cond.notify_all();
-    }
+    static bool isDisposableFrame(const owt_base::Frame& frame);
 
 private:
-    std::queue<boost::shared_ptr<MediaFrame>> m_queue;
+    std::deque<boost::shared_ptr<MediaFrame>> m_queue;
     boost::mutex m_mutex;
     boost::condition_variable m_cond;
 
@@ -163,6 +126,19 @@ private:
 
     bool m_valid;
     int64_t m_startTimeOffset;
+
+    size_t m_capacity;
+    DropPolicy m_policy;
+    bool m_waitKeyFrame;
+    std::atomic<uint64_t> m_droppedCount;
+};
+
+struct AVStreamOutStats {
+    uint32_t queueDepth;
+    uint32_t avgLatencyMs;      // push to written
+    uint32_t maxLatencyMs;      // since last query
+    uint64_t writtenFrames;
+    uint64_t droppedFrames;
 };
 
 class AVStreamOut : public owt_base::FrameDestination, public EventRegistry {
@@ -183,6 +159,9 @@ public:
     virtual void onFrame(const Frame&);
     virtual void onVideoSourceChanged(void) {deliverFeedbackMsg(FeedbackMsg{.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME });}
 
+    void setQueueOptions(size_t capacity, MediaFrameQueue::DropPolicy policy);
+    void getStats(AVStreamOutStats& stats);
+
 protected:
     virtual bool isAudioFormatSupported(FrameFormat format) = 0;
     virtual bool isVideoFormatSupported(FrameFormat format) = 0;
@@ -220,14 +199,29 @@ protected:
 
     bool writeFrame(AVStream *stream, boost::shared_ptr<MediaFrame> mediaFrame);
 
-    void sendLoop(void);
+    void queueFrame(const owt_base::Frame& frame);
+
+    // Runs on the shared muxer pool, serialized by m_strand
+    bool open(void);
+    void teardown(void);
+    void onTimer(const boost::system::error_code& ec);
+    void onDrain(void);
+
+    void scheduleTimer(uint32_t waitMs);
+    void scheduleDrain(void);
+    bool beginHandler(void);
+    void endHandler(void);
+
+    // Bounds the next blocking network call, see interruptCallback()
+    void armIoDeadline(void);
+    static int interruptCallback(void *opaque);
 
     void setVideoSourceChanged() {m_videoSourceChanged = true;};
 
     char *ff_err2str(int errRet);
 
 private:
-    Status m_status;
+    std::atomic<Status> m_status;
 
     std::string m_url;
     bool m_hasAudio;
@@ -255,7 +249,28 @@ private:
 
     char m_errbuff[500];
 
-    boost::thread m_thread;
+    int64_t m_waitStartTime;
+    std::atomic<int64_t> m_lastPushTime;
+    uint32_t m_connectRetry;
+    bool m_headerWritten;
+
+    boost::mutex m_statsMutex;
+    uint32_t m_avgLatencyMs;
+    uint32_t m_maxLatencyMs;
+    uint64_t m_writtenFrames;
+
+    boost::scoped_ptr<boost::asio::io_service::strand> m_strand;
+    boost::scoped_ptr<boost::asio::deadline_timer> m_timer;
+    std::atomic<bool> m_drainScheduled;
+
+    // Handlers posted to the pool and not yet finished, close() waits for them
+    boost::mutex m_handlerMutex;
+    boost::condition_variable m_handlerCond;
+    uint32_t m_pendingHandlers;
+
+    // Checked by ffmpeg during network I/O, set by close()
+    std::atomic<bool> m_interrupted;
+    std::atomic<int64_t> m_ioDeadline;
 };
 
 } /* namespace owt_base */
@@ -17,7 +17,7 @@ AudioFramePacketizer::AudioFramePacketizer(AudioFramePacketizer::Config& config)
     , m_lastOriginSeqNo(0)
     , m_seqNo(0)
     , m_ssrc(0)
-    , m_rtcAdapter(RtcAdapterFactory::CreateRtcAdapter())
+    , m_rtcAdapter(RtcAdapterFactory::GetSharedRtcAdapter())
     , m_audioSend(nullptr)
     , m_firstFrame(false)
 {
@@ -0,0 +1,563 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "BitstreamInspector.h"
+#include "NalScanner.h"
+
+namespace owt_base {
+
+namespace {
+
+// MSB first reader. With skipEmulation it drops the 0x03 of 00 00 03 so
+// H.264/H.265 RBSP can be read straight from the NAL unit. Reads past the
+// end return zeros and set overrun.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size, bool skipEmulation)
+        : m_data(data)
+        , m_size(size)
+        , m_pos(0)
+        , m_bit(0)
+        , m_zeros(0)
+        , m_skipEmulation(skipEmulation)
+        , overrun(false)
+    {
+    }
+
+    uint32_t readBits(uint32_t n)
+    {
+        uint32_t value = 0;
+        while (n--) {
+            value = (value << 1) | readBit();
+        }
+        return value;
+    }
+
+    uint32_t readBit()
+    {
+        if (m_bit == 0 && !enterByte()) {
+            overrun = true;
+            return 0;
+        }
+        uint32_t bit = (m_data[m_pos] >> (7 - m_bit)) & 1;
+        if (++m_bit == 8) {
+            m_bit = 0;
+            m_pos++;
+        }
+        return bit;
+    }
+
+    void skipBits(uint32_t n)
+    {
+        while (n--) {
+            readBit();
+        }
+    }
+
+    // Exp-Golomb ue(v)
+    uint32_t readUe()
+    {
+        uint32_t leadingZeros = 0;
+        while (!readBit()) {
+            if (overrun || ++leadingZeros > 31) {
+                overrun = true;
+                return 0;
+            }
+        }
+        return ((1u << leadingZeros) - 1) + readBits(leadingZeros);
+    }
+
+    int32_t readSe()
+    {
+        uint32_t value = readUe();
+        return (value & 1) ? (int32_t)((value + 1) / 2) : -(int32_t)(value / 2);
+    }
+
+    // AV1 uvlc()
+    uint32_t readUvlc()
+    {
+        uint32_t leadingZeros = 0;
+        while (!readBit()) {
+            if (overrun || ++leadingZeros >= 32) {
+                overrun = true;
+                return 0;
+            }
+        }
+        return readBits(leadingZeros) + ((1u << leadingZeros) - 1);
+    }
+
+private:
+    // Called at a byte boundary, skips an emulation prevention byte
+    bool enterByte()
+    {
+        if (m_pos >= m_size) {
+            return false;
+        }
+        if (m_skipEmulation) {
+            if (m_zeros >= 2 && m_data[m_pos] == 3) {
+                m_zeros = 0;
+                if (++m_pos >= m_size) {
+                    return false;
+                }
+            }
+            m_zeros = m_data[m_pos] == 0 ? m_zeros + 1 : 0;
+        }
+        return true;
+    }
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+    uint32_t m_bit;
+    uint32_t m_zeros;
+    bool m_skipEmulation;
+
+public:
+    bool overrun;
+};
+
+bool isH264HighProfile(uint32_t profileIdc)
+{
+    switch (profileIdc) {
+    case 100: case 110: case 122: case 244: case 44:
+    case 83: case 86: case 118: case 128: case 138:
+    case 139: case 134: case 135:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// rbsp starts after the 1 byte NAL header
+bool parseH264Sps(const uint8_t* rbsp, size_t size, uint16_t& width, uint16_t& height)
+{
+    BitReader br(rbsp, size, true);
+    uint32_t profileIdc = br.readBits(8);
+    br.skipBits(16); // constraint flags, level_idc
+    br.readUe(); // seq_parameter_set_id
+
+    uint32_t chromaFormatIdc = 1;
+    uint32_t separateColourPlane = 0;
+    if (isH264HighProfile(profileIdc)) {
+        chromaFormatIdc = br.readUe();
+        if (chromaFormatIdc == 3) {
+            separateColourPlane = br.readBit();
+        }
+        br.readUe(); // bit_depth_luma_minus8
+        br.readUe(); // bit_depth_chroma_minus8
+        br.readBit(); // qpprime_y_zero_transform_bypass_flag
+        if (br.readBit()) { // seq_scaling_matrix_present_flag
+            int lists = chromaFormatIdc != 3 ? 8 : 12;
+            for (int i = 0; i < lists && !br.overrun; i++) {
+                if (!br.readBit()) {
+                    continue;
+                }
+                int sizeOfList = i < 6 ? 16 : 64;
+                int lastScale = 8;
+                int nextScale = 8;
+                for (int j = 0; j < sizeOfList && !br.overrun; j++) {
+                    if (nextScale != 0) {
+                        nextScale = (lastScale + br.readSe() + 256) % 256;
+                    }
+                    lastScale = nextScale == 0 ? lastScale : nextScale;
+                }
+            }
+        }
+    }
+
+    br.readUe(); // log2_max_frame_num_minus4
+    uint32_t pocType = br.readUe();
+    if (pocType == 0) {
+        br.readUe(); // log2_max_pic_order_cnt_lsb_minus4
+    } else if (pocType == 1) {
+        br.readBit(); // delta_pic_order_always_zero_flag
+        br.readSe(); // offset_for_non_ref_pic
+        br.readSe(); // offset_for_top_to_bottom_field
+        uint32_t cycle = br.readUe();
+        for (uint32_t i = 0; i < cycle && !br.overrun; i++) {
+            br.readSe();
+        }
+    }
+    br.readUe(); // max_num_ref_frames
+    br.readBit(); // gaps_in_frame_num_value_allowed_flag
+    uint32_t widthInMbs = br.readUe() + 1;
+    uint32_t heightInMapUnits = br.readUe() + 1;
+    uint32_t frameMbsOnly = br.readBit();
+    if (!frameMbsOnly) {
+        br.readBit(); // mb_adaptive_frame_field_flag
+    }
+    br.readBit(); // direct_8x8_inference_flag
+
+    uint32_t cropLeft = 0, cropRight = 0, cropTop = 0, cropBottom = 0;
+    if (br.readBit()) { // frame_cropping_flag
+        cropLeft = br.readUe();
+        cropRight = br.readUe();
+        cropTop = br.readUe();
+        cropBottom = br.readUe();
+    }
+    if (br.overrun) {
+        return false;
+    }
+
+    uint32_t cropUnitX = 1;
+    uint32_t cropUnitY = 2 - frameMbsOnly;
+    if (chromaFormatIdc != 0 && !separateColourPlane) {
+        cropUnitX = chromaFormatIdc == 3 ? 1 : 2;
+        cropUnitY *= chromaFormatIdc == 1 ? 2 : 1;
+    }
+    int64_t w = (int64_t)widthInMbs * 16 - (int64_t)cropUnitX * (cropLeft + cropRight);
+    int64_t h = (int64_t)(2 - frameMbsOnly) * heightInMapUnits * 16 - (int64_t)cropUnitY * (cropTop + cropBottom);
+    if (w <= 0 || h <= 0 || w > 0xFFFF || h > 0xFFFF) {
+        return false;
+    }
+    width = (uint16_t)w;
+    height = (uint16_t)h;
+    return true;
+}
+
+// rbsp starts after the 2 byte NAL header
+bool parseH265Sps(const uint8_t* rbsp, size_t size, uint16_t& width, uint16_t& height)
+{
+    BitReader br(rbsp, size, true);
+    br.skipBits(4); // sps_video_parameter_set_id
+    uint32_t maxSubLayersMinus1 = br.readBits(3);
+    br.readBit(); // sps_temporal_id_nesting_flag
+
+    // profile_tier_level(1, sps_max_sub_layers_minus1)
+    br.skipBits(96);
+    bool subLayerProfilePresent[8] = {};
+    bool subLayerLevelPresent[8] = {};
+    for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+        subLayerProfilePresent[i] = br.readBit();
+        subLayerLevelPresent[i] = br.readBit();
+    }
+    if (maxSubLayersMinus1 > 0) {
+        br.skipBits(2 * (8 - maxSubLayersMinus1));
+    }
+    for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+        if (subLayerProfilePresent[i]) {
+            br.skipBits(88);
+        }
+        if (subLayerLevelPresent[i]) {
+            br.skipBits(8);
+        }
+    }
+
+    br.readUe(); // sps_seq_parameter_set_id
+    uint32_t chromaFormatIdc = br.readUe();
+    uint32_t separateColourPlane = 0;
+    if (chromaFormatIdc == 3) {
+        separateColourPlane = br.readBit();
+    }
+    int64_t w = br.readUe();
+    int64_t h = br.readUe();
+    if (br.readBit()) { // conformance_window_flag
+        uint32_t subWidthC = 1;
+        uint32_t subHeightC = 1;
+        if (!separateColourPlane && (chromaFormatIdc == 1 || chromaFormatIdc == 2)) {
+            subWidthC = 2;
+            subHeightC = chromaFormatIdc == 1 ? 2 : 1;
+        }
+        uint32_t left = br.readUe();
+        uint32_t right = br.readUe();
+        uint32_t top = br.readUe();
+        uint32_t bottom = br.readUe();
+        w -= (int64_t)subWidthC * (left + right);
+        h -= (int64_t)subHeightC * (top + bottom);
+    }
+    if (br.overrun || w <= 0 || h <= 0 || w > 0xFFFF || h > 0xFFFF) {
+        return false;
+    }
+    width = (uint16_t)w;
+    height = (uint16_t)h;
+    return true;
+}
+
+bool inspectAnnexB(const uint8_t* data, size_t size, bool h265, BitstreamInfo& info)
+{
+    NalSpan nals[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(data, size, h265, nals, NalScanner::MAX_NALS);
+    if (count == 0) {
+        return false;
+    }
+
+    info.isKeyFrame = NalScanner::hasKeyFrame(nals, count, h265);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t spsType = h265 ? 33 : 7;
+        const uint32_t headerSize = h265 ? 2 : 1;
+        if (nals[i].type != spsType) {
+            continue;
+        }
+        uint32_t offset = nals[i].payloadOffset() + headerSize;
+        uint32_t end = nals[i].offset + nals[i].length;
+        if (offset >= end) {
+            break;
+        }
+        if (h265) {
+            parseH265Sps(data + offset, end - offset, info.width, info.height);
+        } else {
+            parseH264Sps(data + offset, end - offset, info.width, info.height);
+        }
+        break;
+    }
+    return true;
+}
+
+enum {
+    AV1_OBU_SEQUENCE_HEADER = 1,
+    AV1_OBU_FRAME_HEADER = 3,
+    AV1_OBU_FRAME = 6,
+};
+
+bool readLeb128(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int i = 0; i < 8; i++) {
+        if (pos >= size) {
+            return false;
+        }
+        uint8_t byte = data[pos++];
+        value |= (uint64_t)(byte & 0x7F) << (i * 7);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseAV1SequenceHeader(const uint8_t* data, size_t size, bool& reducedStillPicture, uint16_t& width, uint16_t& height)
+{
+    BitReader br(data, size, false);
+    br.skipBits(3); // seq_profile
+    br.readBit(); // still_picture
+    reducedStillPicture = br.readBit();
+    if (reducedStillPicture) {
+        br.skipBits(5); // seq_level_idx[0]
+    } else {
+        uint32_t bufferDelayLength = 0;
+        bool decoderModelInfoPresent = false;
+        if (br.readBit()) { // timing_info_present_flag
+            br.skipBits(64); // num_units_in_display_tick, time_scale
+            if (br.readBit()) { // equal_picture_interval
+                br.readUvlc();
+            }
+            decoderModelInfoPresent = br.readBit();
+            if (decoderModelInfoPresent) {
+                bufferDelayLength = br.readBits(5) + 1;
+                br.skipBits(32 + 5 + 5);
+            }
+        }
+        bool initialDisplayDelayPresent = br.readBit();
+        uint32_t operatingPoints = br.readBits(5) + 1;
+        for (uint32_t i = 0; i < operatingPoints && !br.overrun; i++) {
+            br.skipBits(12); // operating_point_idc
+            if (br.readBits(5) > 7) { // seq_level_idx
+                br.readBit(); // seq_tier
+            }
+            if (decoderModelInfoPresent && br.readBit()) {
+                br.skipBits(2 * bufferDelayLength + 1);
+            }
+            if (initialDisplayDelayPresent && br.readBit()) {
+                br.skipBits(4);
+            }
+        }
+    }
+    uint32_t widthBits = br.readBits(4) + 1;
+    uint32_t heightBits = br.readBits(4) + 1;
+    uint32_t w = br.readBits(widthBits) + 1;
+    uint32_t h = br.readBits(heightBits) + 1;
+    if (br.overrun || w > 0xFFFF || h > 0xFFFF) {
+        return false;
+    }
+    width = (uint16_t)w;
+    height = (uint16_t)h;
+    return true;
+}
+
+} // namespace
+
+bool BitstreamInspector::inspectVideo(FrameFormat format, const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    switch (format) {
+    case FRAME_FORMAT_H264:
+        return inspectH264(data, size, info);
+    case FRAME_FORMAT_H265:
+        return inspectH265(data, size, info);
+    case FRAME_FORMAT_VP8:
+        return inspectVP8(data, size, info);
+    case FRAME_FORMAT_VP9:
+        return inspectVP9(data, size, info);
+    case FRAME_FORMAT_AV1:
+        return inspectAV1(data, size, info);
+    default:
+        return false;
+    }
+}
+
+bool BitstreamInspector::inspectH264(const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    info = BitstreamInfo();
+    return inspectAnnexB(data, size, false, info);
+}
+
+bool BitstreamInspector::inspectH265(const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    info = BitstreamInfo();
+    return inspectAnnexB(data, size, true, info);
+}
+
+// RFC 6386 9.1, the 3 byte frame tag, then start code and size on key frames
+bool BitstreamInspector::inspectVP8(const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    info = BitstreamInfo();
+    if (size < 3) {
+        return false;
+    }
+    info.isKeyFrame = !(data[0] & 0x01);
+    if (!info.isKeyFrame) {
+        return true;
+    }
+    if (size < 10 || data[3] != 0x9D || data[4] != 0x01 || data[5] != 0x2A) {
+        return false;
+    }
+    info.width = (data[6] | (data[7] << 8)) & 0x3FFF;
+    info.height = (data[8] | (data[9] << 8)) & 0x3FFF;
+    return true;
+}
+
+// VP9 bitstream spec 6.2, uncompressed header up to frame_size(). A
+// superframe starts with its first frame, which is the one that matters.
+bool BitstreamInspector::inspectVP9(const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    info = BitstreamInfo();
+    BitReader br(data, size, false);
+    if (br.readBits(2) != 2) { // frame_marker
+        return false;
+    }
+    uint32_t profile = br.readBit();
+    profile |= br.readBit() << 1;
+    if (profile == 3) {
+        br.readBit(); // reserved_zero
+    }
+    if (br.readBit()) { // show_existing_frame
+        return !br.overrun;
+    }
+    uint32_t frameType = br.readBit();
+    br.skipBits(2); // show_frame, error_resilient_mode
+    if (frameType != 0) {
+        return !br.overrun;
+    }
+
+    info.isKeyFrame = true;
+    if (br.readBits(24) != 0x498342) { // frame_sync_code
+        return false;
+    }
+    // color_config()
+    if (profile >= 2) {
+        br.readBit(); // ten_or_twelve_bit
+    }
+    uint32_t colorSpace = br.readBits(3);
+    if (colorSpace != 7) { // CS_RGB
+        br.readBit(); // color_range
+        if (profile == 1 || profile == 3) {
+            br.skipBits(3); // subsampling_x, subsampling_y, reserved_zero
+        }
+    } else if (profile == 1 || profile == 3) {
+        br.readBit(); // reserved_zero
+    }
+    uint32_t w = br.readBits(16) + 1;
+    uint32_t h = br.readBits(16) + 1;
+    if (br.overrun || w > 0xFFFF || h > 0xFFFF) {
+        return false;
+    }
+    info.width = (uint16_t)w;
+    info.height = (uint16_t)h;
+    return true;
+}
+
+// A temporal unit is a random access point when it carries a sequence
+// header and its first frame header is a KEY_FRAME.
+bool BitstreamInspector::inspectAV1(const uint8_t* data, size_t size, BitstreamInfo& info)
+{
+    info = BitstreamInfo();
+    bool hasSequenceHeader = false;
+    bool reducedStillPicture = false;
+    size_t pos = 0;
+
+    while (pos < size) {
+        uint8_t header = data[pos++];
+        if (header & 0x80) { // obu_forbidden_bit
+            return false;
+        }
+        uint8_t type = (header >> 3) & 0x0F;
+        if (header & 0x04) { // obu_extension_flag
+            pos++;
+        }
+        uint64_t obuSize = size > pos ? size - pos : 0;
+        if ((header & 0x02) && !readLeb128(data, size, pos, obuSize)) { // obu_has_size_field
+            return false;
+        }
+        if (pos > size || obuSize > size - pos) {
+            return false;
+        }
+
+        const uint8_t* obu = data + pos;
+        pos += obuSize;
+        if (type == AV1_OBU_SEQUENCE_HEADER) {
+            hasSequenceHeader = parseAV1SequenceHeader(obu, obuSize, reducedStillPicture, info.width, info.height);
+        } else if (type == AV1_OBU_FRAME_HEADER || type == AV1_OBU_FRAME) {
+            if (reducedStillPicture) {
+                info.isKeyFrame = hasSequenceHeader;
+            } else if (obuSize > 0) {
+                BitReader br(obu, obuSize, false);
+                bool showExistingFrame = br.readBit();
+                info.isKeyFrame = hasSequenceHeader && !showExistingFrame && br.readBits(2) == 0;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+// RFC 6716 3.1, the TOC byte gives the frame duration and code 0-3 the count
+uint32_t BitstreamInspector::opusSamples(const uint8_t* data, size_t size)
+{
+    static const uint32_t kSilkSamples[] = { 480, 960, 1920, 2880 };
+    static const uint32_t kCeltSamples[] = { 120, 240, 480, 960 };
+
+    if (size < 1) {
+        return 0;
+    }
+    uint8_t config = data[0] >> 3;
+    uint32_t frameSamples;
+    if (config < 12) {
+        frameSamples = kSilkSamples[config & 0x03];
+    } else if (config < 16) {
+        frameSamples = (config & 0x01) ? 960 : 480;
+    } else {
+        frameSamples = kCeltSamples[config & 0x03];
+    }
+
+    uint32_t frames;
+    switch (data[0] & 0x03) {
+    case 0:
+        frames = 1;
+        break;
+    case 1:
+    case 2:
+        frames = 2;
+        break;
+    default:
+        if (size < 2) {
+            return 0;
+        }
+        frames = data[1] & 0x3F;
+        break;
+    }
+    // A packet holds at most 120ms
+    uint32_t samples = frames * frameSamples;
+    return samples <= 5760 ? samples : 0;
+}
+
+}
@@ -0,0 +1,44 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef BitstreamInspector_h
+#define BitstreamInspector_h
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MediaFramePipeline.h"
+
+namespace owt_base {
+
+struct BitstreamInfo {
+    bool isKeyFrame;
+    // Coded size, 0 when the frame doesn't carry it (delta frames,
+    // H.264/H.265 access units without SPS)
+    uint16_t width;
+    uint16_t height;
+};
+
+// Reads what the pipeline needs from an encoded frame without decoding it.
+// H.264/H.265 are Annex-B access units, VP8/VP9 are raw frames, AV1 is a
+// temporal unit of OBUs in low overhead format.
+class BitstreamInspector {
+public:
+    // Returns false if the format is unsupported or the frame can't be parsed
+    static bool inspectVideo(FrameFormat format, const uint8_t* data, size_t size, BitstreamInfo& info);
+
+    static bool inspectH264(const uint8_t* data, size_t size, BitstreamInfo& info);
+    static bool inspectH265(const uint8_t* data, size_t size, BitstreamInfo& info);
+    static bool inspectVP8(const uint8_t* data, size_t size, BitstreamInfo& info);
+    static bool inspectVP9(const uint8_t* data, size_t size, BitstreamInfo& info);
+    static bool inspectAV1(const uint8_t* data, size_t size, BitstreamInfo& info);
+
+    // Samples per channel at 48kHz in an Opus packet, from its TOC byte.
+    // 0 for an invalid packet.
+    static uint32_t opusSamples(const uint8_t* data, size_t size);
+};
+
+} /* namespace owt_base */
+
+#endif /* BitstreamInspector_h */
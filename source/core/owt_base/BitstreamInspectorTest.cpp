@@ -0,0 +1,356 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE BitstreamInspector
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "BitstreamInspector.h"
+
+using owt_base::BitstreamInfo;
+using owt_base::BitstreamInspector;
+
+// MSB first writer for building headers field by field
+class BitWriter {
+public:
+    BitWriter() : m_bits(0) {}
+
+    void bits(uint32_t value, uint32_t n)
+    {
+        while (n--) {
+            bit((value >> n) & 1);
+        }
+    }
+
+    void bit(uint32_t value)
+    {
+        if (m_bits % 8 == 0) {
+            m_data.push_back(0);
+        }
+        if (value) {
+            m_data.back() |= 0x80 >> (m_bits % 8);
+        }
+        m_bits++;
+    }
+
+    void ue(uint32_t value)
+    {
+        uint32_t code = value + 1;
+        uint32_t length = 0;
+        while ((code >> length) > 1) {
+            length++;
+        }
+        bits(0, length);
+        bits(code, length + 1);
+    }
+
+    // rbsp_trailing_bits()
+    void trailing()
+    {
+        bit(1);
+        while (m_bits % 8) {
+            bit(0);
+        }
+    }
+
+    std::vector<uint8_t>& data() { return m_data; }
+
+private:
+    std::vector<uint8_t> m_data;
+    uint32_t m_bits;
+};
+
+// Appends a NAL unit with emulation prevention applied to its payload
+static void appendNal(std::vector<uint8_t>& stream, std::initializer_list<uint8_t> header,
+                      const std::vector<uint8_t>& rbsp = std::vector<uint8_t>())
+{
+    stream.insert(stream.end(), {0, 0, 0, 1});
+    stream.insert(stream.end(), header);
+    int zeros = 0;
+    for (uint8_t byte : rbsp) {
+        if (zeros >= 2 && byte <= 3) {
+            stream.push_back(3);
+            zeros = 0;
+        }
+        stream.push_back(byte);
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+}
+
+static std::vector<uint8_t> h264Sps(uint32_t profileIdc, uint32_t widthInMbs, uint32_t heightInMbs, uint32_t cropBottom)
+{
+    BitWriter bw;
+    bw.bits(profileIdc, 8);
+    bw.bits(0, 8);      // constraint flags
+    bw.bits(40, 8);     // level_idc
+    bw.ue(0);           // seq_parameter_set_id
+    if (profileIdc == 100) {
+        bw.ue(1);       // chroma_format_idc
+        bw.ue(0);       // bit_depth_luma_minus8
+        bw.ue(0);       // bit_depth_chroma_minus8
+        bw.bit(0);      // qpprime_y_zero_transform_bypass_flag
+        bw.bit(0);      // seq_scaling_matrix_present_flag
+    }
+    bw.ue(0);           // log2_max_frame_num_minus4
+    bw.ue(0);           // pic_order_cnt_type
+    bw.ue(0);           // log2_max_pic_order_cnt_lsb_minus4
+    bw.ue(1);           // max_num_ref_frames
+    bw.bit(0);          // gaps_in_frame_num_value_allowed_flag
+    bw.ue(widthInMbs - 1);
+    bw.ue(heightInMbs - 1);
+    bw.bit(1);          // frame_mbs_only_flag
+    bw.bit(1);          // direct_8x8_inference_flag
+    bw.bit(cropBottom ? 1 : 0);
+    if (cropBottom) {
+        bw.ue(0);
+        bw.ue(0);
+        bw.ue(0);
+        bw.ue(cropBottom);
+    }
+    bw.bit(0);          // vui_parameters_present_flag
+    bw.trailing();
+    return bw.data();
+}
+
+BOOST_AUTO_TEST_SUITE(Video)
+
+BOOST_AUTO_TEST_CASE(H264KeyFrameWithSps)
+{
+    std::vector<uint8_t> frame;
+    // 1920x1088 coded, 8 rows cropped
+    appendNal(frame, {0x67}, h264Sps(66, 120, 68, 4));
+    appendNal(frame, {0x68}, {0xCE, 0x38, 0x80});
+    appendNal(frame, {0x65}, {0x88, 0x84, 0x00, 0x00, 0x01, 0x02});
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectVideo(owt_base::FRAME_FORMAT_H264, frame.data(), frame.size(), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 1920);
+    BOOST_CHECK_EQUAL(info.height, 1080);
+}
+
+BOOST_AUTO_TEST_CASE(H264HighProfileSps)
+{
+    std::vector<uint8_t> frame;
+    appendNal(frame, {0x67}, h264Sps(100, 80, 45, 0));
+    appendNal(frame, {0x65}, {0x88, 0x80});
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectH264(frame.data(), frame.size(), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 1280);
+    BOOST_CHECK_EQUAL(info.height, 720);
+}
+
+BOOST_AUTO_TEST_CASE(H264DeltaFrame)
+{
+    std::vector<uint8_t> frame;
+    appendNal(frame, {0x41}, {0x9A, 0x02, 0x04});
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectH264(frame.data(), frame.size(), info));
+    BOOST_CHECK(!info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 0);
+    BOOST_CHECK_EQUAL(info.height, 0);
+}
+
+BOOST_AUTO_TEST_CASE(H264NotAnnexB)
+{
+    uint8_t frame[] = {0x00, 0x00, 0x00, 0x05, 0x65, 0x88, 0x80, 0x10, 0x20};
+    BitstreamInfo info;
+    BOOST_CHECK(!BitstreamInspector::inspectH264(frame + 4, sizeof(frame) - 4, info));
+}
+
+BOOST_AUTO_TEST_CASE(H265IrapWithSps)
+{
+    BitWriter bw;
+    bw.bits(0, 4);      // sps_video_parameter_set_id
+    bw.bits(0, 3);      // sps_max_sub_layers_minus1
+    bw.bit(1);          // sps_temporal_id_nesting_flag
+    bw.bits(0x01600000, 32); // profile_tier_level, main profile
+    bw.bits(0, 32);
+    bw.bits(0x5D, 32);  // general_level_idc in the last byte
+    bw.ue(0);           // sps_seq_parameter_set_id
+    bw.ue(1);           // chroma_format_idc
+    bw.ue(1280);
+    bw.ue(720);
+    bw.bit(0);          // conformance_window_flag
+    bw.trailing();
+
+    std::vector<uint8_t> frame;
+    appendNal(frame, {0x42, 0x01}, bw.data());
+    appendNal(frame, {0x26, 0x01}, {0xAF, 0x00, 0x10});
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectH265(frame.data(), frame.size(), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 1280);
+    BOOST_CHECK_EQUAL(info.height, 720);
+
+    std::vector<uint8_t> delta;
+    appendNal(delta, {0x02, 0x01}, {0xD0, 0x10});
+    BOOST_REQUIRE(BitstreamInspector::inspectH265(delta.data(), delta.size(), info));
+    BOOST_CHECK(!info.isKeyFrame);
+}
+
+BOOST_AUTO_TEST_CASE(VP8)
+{
+    // 640x480 key frame, then an inter frame
+    uint8_t key[] = {0x50, 0x42, 0x00, 0x9D, 0x01, 0x2A, 0x80, 0x02, 0xE0, 0x01, 0x00};
+    uint8_t delta[] = {0x31, 0x10, 0x00, 0x00};
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectVP8(key, sizeof(key), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 640);
+    BOOST_CHECK_EQUAL(info.height, 480);
+
+    BOOST_REQUIRE(BitstreamInspector::inspectVP8(delta, sizeof(delta), info));
+    BOOST_CHECK(!info.isKeyFrame);
+
+    // Key frame without start code
+    key[3] = 0;
+    BOOST_CHECK(!BitstreamInspector::inspectVP8(key, sizeof(key), info));
+}
+
+BOOST_AUTO_TEST_CASE(VP9)
+{
+    BitWriter bw;
+    bw.bits(2, 2);      // frame_marker
+    bw.bits(0, 2);      // profile 0
+    bw.bit(0);          // show_existing_frame
+    bw.bit(0);          // frame_type KEY_FRAME
+    bw.bit(1);          // show_frame
+    bw.bit(0);          // error_resilient_mode
+    bw.bits(0x498342, 24);
+    bw.bits(1, 3);      // color_space
+    bw.bit(0);          // color_range
+    bw.bits(1279, 16);
+    bw.bits(719, 16);
+    bw.trailing();
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectVP9(bw.data().data(), bw.data().size(), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 1280);
+    BOOST_CHECK_EQUAL(info.height, 720);
+
+    BitWriter inter;
+    inter.bits(2, 2);
+    inter.bits(0, 2);
+    inter.bit(0);
+    inter.bit(1);       // frame_type NON_KEY_FRAME
+    inter.bits(0x20, 10);
+    BOOST_REQUIRE(BitstreamInspector::inspectVP9(inter.data().data(), inter.data().size(), info));
+    BOOST_CHECK(!info.isKeyFrame);
+
+    uint8_t broken[] = {0x00, 0x00};
+    BOOST_CHECK(!BitstreamInspector::inspectVP9(broken, sizeof(broken), info));
+}
+
+static void appendObu(std::vector<uint8_t>& tu, uint8_t type, const std::vector<uint8_t>& payload)
+{
+    tu.push_back((type << 3) | 0x02);
+    tu.push_back(payload.size());
+    tu.insert(tu.end(), payload.begin(), payload.end());
+}
+
+BOOST_AUTO_TEST_CASE(AV1)
+{
+    BitWriter seq;
+    seq.bits(0, 3);     // seq_profile
+    seq.bit(0);         // still_picture
+    seq.bit(0);         // reduced_still_picture_header
+    seq.bit(0);         // timing_info_present_flag
+    seq.bit(0);         // initial_display_delay_present_flag
+    seq.bits(0, 5);     // operating_points_cnt_minus_1
+    seq.bits(0, 12);    // operating_point_idc[0]
+    seq.bits(8, 5);     // seq_level_idx[0]
+    seq.bit(0);         // seq_tier[0]
+    seq.bits(10, 4);    // frame_width_bits_minus_1
+    seq.bits(10, 4);    // frame_height_bits_minus_1
+    seq.bits(1919, 11);
+    seq.bits(1079, 11);
+    seq.trailing();
+
+    BitWriter keyHeader;
+    keyHeader.bit(0);   // show_existing_frame
+    keyHeader.bits(0, 2); // KEY_FRAME
+    keyHeader.trailing();
+
+    BitWriter interHeader;
+    interHeader.bit(0);
+    interHeader.bits(1, 2); // INTER_FRAME
+    interHeader.trailing();
+
+    std::vector<uint8_t> key;
+    appendObu(key, 2, {});  // temporal delimiter
+    appendObu(key, 1, seq.data());
+    appendObu(key, 6, keyHeader.data());
+
+    BitstreamInfo info;
+    BOOST_REQUIRE(BitstreamInspector::inspectAV1(key.data(), key.size(), info));
+    BOOST_CHECK(info.isKeyFrame);
+    BOOST_CHECK_EQUAL(info.width, 1920);
+    BOOST_CHECK_EQUAL(info.height, 1080);
+
+    // A key frame without sequence header is no random access point
+    std::vector<uint8_t> noSeq;
+    appendObu(noSeq, 6, keyHeader.data());
+    BOOST_REQUIRE(BitstreamInspector::inspectAV1(noSeq.data(), noSeq.size(), info));
+    BOOST_CHECK(!info.isKeyFrame);
+
+    std::vector<uint8_t> inter;
+    appendObu(inter, 2, {});
+    appendObu(inter, 6, interHeader.data());
+    BOOST_REQUIRE(BitstreamInspector::inspectAV1(inter.data(), inter.size(), info));
+    BOOST_CHECK(!info.isKeyFrame);
+
+    // OBU size beyond the temporal unit
+    key[1] = 0x7F;
+    BOOST_CHECK(!BitstreamInspector::inspectAV1(key.data(), key.size(), info));
+}
+
+BOOST_AUTO_TEST_CASE(UnsupportedFormat)
+{
+    uint8_t frame[] = {0x00, 0x00, 0x01, 0x65};
+    BitstreamInfo info;
+    BOOST_CHECK(!BitstreamInspector::inspectVideo(owt_base::FRAME_FORMAT_I420, frame, sizeof(frame), info));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Opus)
+
+BOOST_AUTO_TEST_CASE(FrameDurations)
+{
+    // config 1, SILK NB 20ms, one frame
+    uint8_t silk[] = {(1 << 3) | 0};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(silk, sizeof(silk)), 960u);
+
+    // config 13, hybrid FB 20ms, two frames
+    uint8_t hybrid[] = {(13 << 3) | 1};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(hybrid, sizeof(hybrid)), 1920u);
+
+    // config 30, CELT FB 10ms, code 3 with 3 frames
+    uint8_t celt[] = {(30 << 3) | 3, 3};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(celt, sizeof(celt)), 1440u);
+
+    // config 3, SILK NB 60ms, two frames
+    uint8_t silk60[] = {(3 << 3) | 2};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(silk60, sizeof(silk60)), 5760u);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidPackets)
+{
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(nullptr, 0), 0u);
+
+    // Code 3 without the frame count byte
+    uint8_t truncated[] = {(31 << 3) | 3};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(truncated, sizeof(truncated)), 0u);
+
+    // Over 120ms
+    uint8_t tooLong[] = {(31 << 3) | 3, 7};
+    BOOST_CHECK_EQUAL(BitstreamInspector::opusSamples(tooLong, sizeof(tooLong)), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
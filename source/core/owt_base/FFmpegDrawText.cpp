@@ -28,6 +28,7 @@ FFmpegDrawText::FFmpegDrawText()
     , m_validConfig(false)
     , m_enabled(false)
 {
+    m_bufferManager.reset(new I420BufferManager(3));
 }
 
 FFmpegDrawText::~FFmpegDrawText()
@@ -112,8 +113,8 @@ bool FFmpegDrawText::init(int width, int height)
     }
 
     m_input_frame->format = AV_PIX_FMT_YUV420P;
-    m_input_frame->width  = m_width;
-    m_input_frame->height = m_height;
+    m_input_frame->width  = width;
+    m_input_frame->height = height;
     ret = av_frame_get_buffer(m_input_frame, 32);
     if (ret < 0) {
         ELOG_ERROR_T("Could not get  av frame buffer");
@@ -207,52 +208,105 @@ int FFmpegDrawText::configure(std::string arg)
 
 int FFmpegDrawText::setText(std::string arg)
 {
+    // Rasterize here, off the frame path
+    boost::shared_ptr<TextAtlas> atlas(TextAtlas::create(arg));
+    if (!atlas)
+        ELOG_INFO_T("Text spec needs the drawtext filter: %s", arg.c_str());
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_atlas = atlas;
+    m_lastSource = NULL;
+    m_lastDrawn = NULL;
     m_filter_desc = arg;
     m_reconfigured = true;
 
     return 1;
 }
 
-int FFmpegDrawText::drawFrame(Frame& frame)
+bool FFmpegDrawText::drawInPlace(webrtc::I420Buffer *buffer)
 {
-    return 0;//disable
+    if (!m_enabled || !buffer)
+        return false;
 
-    int ret;
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    return draw(buffer);
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> FFmpegDrawText::drawFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer)
+{
+    if (!m_enabled || !buffer)
+        return buffer;
 
-    switch (frame.format) {
-        case FRAME_FORMAT_I420:
-            break;
+    boost::mutex::scoped_lock lock(m_mutex);
 
-        default:
-            ELOG_TRACE_T("Unspported video frame format: %s", getFormatStr(frame.format));
-            return 0;
+    if (!m_atlas && m_filter_desc.empty())
+        return buffer;
+
+    // A repeated frame gets the copy already drawn, text is drawn once per source
+    if (buffer == m_lastSource && m_lastDrawn)
+        return m_lastDrawn;
+
+    // The source may be repeated or shared with other sinks, never draw on it
+    rtc::scoped_refptr<webrtc::I420Buffer> dstBuffer = m_bufferManager->getFreeBuffer(buffer->width(), buffer->height());
+    if (!dstBuffer) {
+        ELOG_WARN_T("No free buffer, skip text");
+        return buffer;
     }
 
-    if (frame.additionalInfo.video.width == 0
-        || frame.additionalInfo.video.height == 0) {
-        ELOG_ERROR_T("Invalid size: %dx%d",
-                frame.additionalInfo.video.width,
-                frame.additionalInfo.video.height
-                );
-        return 0;
+    int ret = libyuv::I420Copy(
+            buffer->DataY(), buffer->StrideY(),
+            buffer->DataU(), buffer->StrideU(),
+            buffer->DataV(), buffer->StrideV(),
+            dstBuffer->MutableDataY(), dstBuffer->StrideY(),
+            dstBuffer->MutableDataU(), dstBuffer->StrideU(),
+            dstBuffer->MutableDataV(), dstBuffer->StrideV(),
+            buffer->width(), buffer->height());
+    if (ret != 0) {
+        ELOG_ERROR_T("libyuv::I420Copy failed(%d)", ret);
+        return buffer;
     }
 
-    if (m_width == 0 || m_height == 0) {
-        m_width = frame.additionalInfo.video.width;
-        m_height = frame.additionalInfo.video.height;
+    if (!draw(dstBuffer.get()))
+        return buffer;
 
-        init(m_width, m_height);
+    m_lastSource = buffer;
+    m_lastDrawn = dstBuffer;
+    return dstBuffer;
+}
+
+bool FFmpegDrawText::draw(webrtc::I420Buffer *buffer)
+{
+    if (m_atlas) {
+        m_atlas->blend(
+                buffer->MutableDataY(), buffer->StrideY(),
+                buffer->MutableDataU(), buffer->StrideU(),
+                buffer->MutableDataV(), buffer->StrideV(),
+                buffer->width(), buffer->height());
+        return true;
     }
 
-    if (m_width != frame.additionalInfo.video.width
-            || m_height != frame.additionalInfo.video.height) {
+    if (m_filter_desc.empty())
+        return false;
+
+    return filterFrame(buffer);
+}
+
+bool FFmpegDrawText::filterFrame(webrtc::I420Buffer *buffer)
+{
+    int ret;
+
+    if (m_width != buffer->width() || m_height != buffer->height()) {
         ELOG_DEBUG_T("re-config size: %dx%d -> %dx%d",
                 m_width, m_height,
-                frame.additionalInfo.video.width,
-                frame.additionalInfo.video.height);
+                buffer->width(), buffer->height());
+
+        m_width = buffer->width();
+        m_height = buffer->height();
 
-        m_width = frame.additionalInfo.video.width;
-        m_height = frame.additionalInfo.video.height;
+        deinit();
+        init(m_width, m_height);
+        m_reconfigured = true;
     }
 
     if (m_reconfigured) {
@@ -268,114 +322,84 @@ int FFmpegDrawText::drawFrame(Frame& frame)
         m_reconfigured = false;
     }
 
-    if (!m_enabled || !m_validConfig) {
-        return 1;
-    }
+    if (!m_validConfig)
+        return false;
 
     if (!m_filter_graph) {
         ELOG_TRACE_T("filter graph not ready!");
-        return 0;
+        return false;
     }
 
-    ELOG_TRACE_T("do drawFrame");
+    ELOG_TRACE_T("do filterFrame");
 
-    if (!copyFrame(m_input_frame, frame)) {
-        return 0;
+    if (!copyFrame(m_input_frame, buffer)) {
+        return false;
     }
 
     if (av_buffersrc_add_frame_flags(m_buffersrc_ctx, m_input_frame, AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
         ELOG_ERROR_T("Error while feeding the filtergraph");
-        return 0;
+        return false;
     }
 
     ret = av_buffersink_get_frame(m_buffersink_ctx, m_filt_frame);
     if (ret < 0) {
-        ELOG_ERROR_T("av_buffersink_get_frame error");
-        return 0;
-    }
-
-    if (!copyFrame(frame, m_filt_frame)) {
-        return 0;
+        ELOG_ERROR_T("av_buffersink_get_frame error: %s", ff_err2str(ret));
+        return false;
     }
 
+    ret = copyFrame(buffer, m_filt_frame);
     av_frame_unref(m_filt_frame);
 
-    return 1;
+    return ret;
 }
 
-int FFmpegDrawText::copyFrame(AVFrame *dstAVFrame, Frame &srcFrame)
+int FFmpegDrawText::copyFrame(AVFrame *dstAVFrame, webrtc::I420Buffer *srcBuffer)
 {
     int ret;
-    VideoFrame *videoFrame = reinterpret_cast<VideoFrame*>(srcFrame.payload);
-    rtc::scoped_refptr<webrtc::VideoFrameBuffer> i420Buffer = videoFrame->video_frame_buffer();
-
-    if (i420Buffer->width() == dstAVFrame->width && i420Buffer->height() == dstAVFrame->height) {
-        ret = libyuv::I420Copy(
-                i420Buffer->DataY(), i420Buffer->StrideY(),
-                i420Buffer->DataU(), i420Buffer->StrideU(),
-                i420Buffer->DataV(), i420Buffer->StrideV(),
-                dstAVFrame->data[0], dstAVFrame->linesize[0],
-                dstAVFrame->data[1], dstAVFrame->linesize[1],
-                dstAVFrame->data[2], dstAVFrame->linesize[2],
-                i420Buffer->width(), i420Buffer->height());
-        if (ret != 0) {
-            ELOG_ERROR_T("libyuv::I420Copy failed(%d)", ret);
-            return false;
-        }
-    } else {
-        ret = libyuv::I420Scale(
-                i420Buffer->DataY(), i420Buffer->StrideY(),
-                i420Buffer->DataU(), i420Buffer->StrideU(),
-                i420Buffer->DataV(), i420Buffer->StrideV(),
-                i420Buffer->width(), i420Buffer->height(),
-                dstAVFrame->data[0], dstAVFrame->linesize[0],
-                dstAVFrame->data[1], dstAVFrame->linesize[1],
-                dstAVFrame->data[2], dstAVFrame->linesize[2],
-                dstAVFrame->width,   dstAVFrame->height,
-                libyuv::kFilterBox);
-        if (ret != 0) {
-            ELOG_ERROR_T("libyuv::I420Scale failed(%d)", ret);
-            return false;
-        }
+
+    if (av_frame_make_writable(dstAVFrame) < 0) {
+        ELOG_ERROR_T("av frame not writable");
+        return false;
+    }
+
+    ret = libyuv::I420Copy(
+            srcBuffer->DataY(), srcBuffer->StrideY(),
+            srcBuffer->DataU(), srcBuffer->StrideU(),
+            srcBuffer->DataV(), srcBuffer->StrideV(),
+            dstAVFrame->data[0], dstAVFrame->linesize[0],
+            dstAVFrame->data[1], dstAVFrame->linesize[1],
+            dstAVFrame->data[2], dstAVFrame->linesize[2],
+            srcBuffer->width(), srcBuffer->height());
+    if (ret != 0) {
+        ELOG_ERROR_T("libyuv::I420Copy failed(%d)", ret);
+        return false;
     }
 
     return true;
 }
 
-int FFmpegDrawText::copyFrame(Frame &dstFrame, AVFrame *srcAVFrame)
+int FFmpegDrawText::copyFrame(webrtc::I420Buffer *dstBuffer, AVFrame *srcAVFrame)
 {
     int ret;
-    VideoFrame *videoFrame = reinterpret_cast<VideoFrame*>(dstFrame.payload);
-    rtc::scoped_refptr<webrtc::VideoFrameBuffer> i420Buffer = videoFrame->video_frame_buffer();
-
-    if (i420Buffer->width() == srcAVFrame->width && i420Buffer->height() == srcAVFrame->height) {
-        ret = libyuv::I420Copy(
-                srcAVFrame->data[0], srcAVFrame->linesize[0],
-                srcAVFrame->data[1], srcAVFrame->linesize[1],
-                srcAVFrame->data[2], srcAVFrame->linesize[2],
-                const_cast< uint8_t*>(i420Buffer->DataY()), i420Buffer->StrideY(),
-                const_cast< uint8_t*>(i420Buffer->DataU()), i420Buffer->StrideU(),
-                const_cast< uint8_t*>(i420Buffer->DataV()), i420Buffer->StrideV(),
-                i420Buffer->width(), i420Buffer->height());
-        if (ret != 0) {
-            ELOG_ERROR_T("libyuv::I420Copy failed(%d)", ret);
-            return false;
-        }
-    } else {
-        ret = libyuv::I420Scale(
-                srcAVFrame->data[0], srcAVFrame->linesize[0],
-                srcAVFrame->data[1], srcAVFrame->linesize[1],
-                srcAVFrame->data[2], srcAVFrame->linesize[2],
+
+    if (dstBuffer->width() != srcAVFrame->width || dstBuffer->height() != srcAVFrame->height) {
+        ELOG_ERROR_T("Filtered size mismatch: %dx%d -> %dx%d",
                 srcAVFrame->width, srcAVFrame->height,
-                const_cast< uint8_t*>(i420Buffer->DataY()), i420Buffer->StrideY(),
-                const_cast< uint8_t*>(i420Buffer->DataU()), i420Buffer->StrideU(),
-                const_cast< uint8_t*>(i420Buffer->DataV()), i420Buffer->StrideV(),
-                i420Buffer->width(), i420Buffer->height(),
-                libyuv::kFilterBox);
-        if (ret != 0) {
-            ELOG_ERROR_T("libyuv::I420Scale failed(%d)", ret);
-            return false;
-        }
+                dstBuffer->width(), dstBuffer->height());
+        return false;
+    }
+
+    ret = libyuv::I420Copy(
+            srcAVFrame->data[0], srcAVFrame->linesize[0],
+            srcAVFrame->data[1], srcAVFrame->linesize[1],
+            srcAVFrame->data[2], srcAVFrame->linesize[2],
+            dstBuffer->MutableDataY(), dstBuffer->StrideY(),
+            dstBuffer->MutableDataU(), dstBuffer->StrideU(),
+            dstBuffer->MutableDataV(), dstBuffer->StrideV(),
+            dstBuffer->width(), dstBuffer->height());
+    if (ret != 0) {
+        ELOG_ERROR_T("libyuv::I420Copy failed(%d)", ret);
+        return false;
     }
 
     return true;
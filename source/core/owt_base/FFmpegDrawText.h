@@ -7,12 +7,15 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <logger.h>
 
 #include <webrtc/api/video/video_frame.h>
 #include <webrtc/api/video/i420_buffer.h>
 
+#include "I420BufferManager.h"
 #include "MediaFramePipeline.h"
+#include "TextAtlas.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -32,7 +35,10 @@ public:
     FFmpegDrawText();
     ~FFmpegDrawText();
 
-    int drawFrame(Frame&);
+    // Draws into `buffer', which nothing else may be reading or holding
+    bool drawInPlace(webrtc::I420Buffer *buffer);
+    // Returns `buffer' itself without text, or a copy owned here with the text drawn
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> drawFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer);
     int setText(std::string arg);
     void enable(bool enabled) {m_enabled = enabled;}
 
@@ -41,10 +47,23 @@ protected:
     int configure(std::string arg);
     void deinit();
 
-    int copyFrame(AVFrame *dstAVFrame, Frame &srcFrame);
-    int copyFrame(Frame &dstFrame, AVFrame *srcAVFrame);
+    // Both need m_mutex held
+    bool draw(webrtc::I420Buffer *buffer);
+    bool filterFrame(webrtc::I420Buffer *buffer);
+
+    int copyFrame(AVFrame *dstAVFrame, webrtc::I420Buffer *srcBuffer);
+    int copyFrame(webrtc::I420Buffer *dstBuffer, AVFrame *srcAVFrame);
 
 private:
+    boost::mutex m_mutex;
+    boost::shared_ptr<TextAtlas> m_atlas;
+
+    boost::scoped_ptr<I420BufferManager> m_bufferManager;
+    // Last drawn copy, reused while the same source is sent again,
+    // cleared when the text changes
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> m_lastSource;
+    rtc::scoped_refptr<webrtc::I420Buffer> m_lastDrawn;
+
     AVFilterGraph *m_filter_graph;
     AVFilterContext *m_buffersink_ctx;
     AVFilterContext *m_buffersrc_ctx;
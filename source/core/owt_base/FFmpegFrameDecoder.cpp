@@ -4,10 +4,49 @@
 
 #include "FFmpegFrameDecoder.h"
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include <sys/time.h>
+
 namespace owt_base {
 
+// Packets waiting for decoding, beyond it drop until next key frame
+static const uint32_t kMaxQueueDepth = 30;
+static const int64_t kStatsReportIntervalMs = 10000;
+
+static inline int64_t currentTimeMs()
+{
+    timeval time;
+    gettimeofday(&time, nullptr);
+    return ((time.tv_sec * 1000) + (time.tv_usec / 1000));
+}
+
 DEFINE_LOGGER(FFmpegFrameDecoder, "owt.FFmpegFrameDecoder");
 
+int FFmpegFrameDecoder::s_threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+uint32_t FFmpegFrameDecoder::s_threadsPerDecoder = 1;
+uint32_t FFmpegFrameDecoder::s_maxThreads = 0;
+std::atomic<uint32_t> FFmpegFrameDecoder::s_threadsInUse(0);
+
+void FFmpegFrameDecoder::setThreadingConfig(const std::string& threadType, uint32_t threadsPerDecoder, uint32_t maxThreads)
+{
+    if (threadType == "frame")
+        s_threadType = FF_THREAD_FRAME;
+    else if (threadType == "slice")
+        s_threadType = FF_THREAD_SLICE;
+    else
+        s_threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    s_threadsPerDecoder = threadsPerDecoder;
+    s_maxThreads = maxThreads;
+
+    ELOG_INFO("Threading config, type(%s), threadsPerDecoder(%u), maxThreads(%u)",
+            threadType.c_str(), threadsPerDecoder, maxThreads);
+}
+
 int FFmpegFrameDecoder::AVGetBuffer(AVCodecContext *s, AVFrame *frame, int flags)
 {
     FFmpegFrameDecoder *FFmpegDecoder = static_cast<FFmpegFrameDecoder *>(s->opaque);
@@ -16,7 +55,11 @@ int FFmpegFrameDecoder::AVGetBuffer(AVCodecContext *s, AVFrame *frame, int flags
 
     avcodec_align_dimensions(s, &width, &height);
 
-    rtc::scoped_refptr<webrtc::I420Buffer> frame_buffer = FFmpegDecoder->m_bufferManager->getFreeBuffer(width, height);
+    rtc::scoped_refptr<webrtc::I420Buffer> frame_buffer;
+    {
+        boost::unique_lock<boost::mutex> lock(FFmpegDecoder->m_bufferMutex);
+        frame_buffer = FFmpegDecoder->m_bufferManager->getFreeBuffer(width, height);
+    }
     if (!frame_buffer) {
         ELOG_ERROR("No free video buffer");
         return -1;
@@ -60,11 +103,35 @@ void FFmpegFrameDecoder::AVFreeBuffer(void* opaque, uint8_t* data)
 FFmpegFrameDecoder::FFmpegFrameDecoder()
     : m_decCtx(NULL)
     , m_decFrame(NULL)
+    , m_threads(0)
+    , m_waitingKeyFrame(false)
+    , m_maxQueueDepth(0)
+    , m_avgLatencyMs(0)
+    , m_maxLatencyMs(0)
+    , m_decodedFrames(0)
+    , m_droppedFrames(0)
+    , m_lastReportTime(0)
 {
+    m_srv       = boost::make_shared<boost::asio::io_service>();
+    m_srvWork   = boost::make_shared<boost::asio::io_service::work>(*m_srv);
+    m_thread    = boost::make_shared<boost::thread>(boost::bind(&boost::asio::io_service::run, m_srv));
 }
 
 FFmpegFrameDecoder::~FFmpegFrameDecoder()
 {
+    m_srvWork.reset();
+    m_srv->stop();
+    m_thread->join();
+    m_thread.reset();
+    m_srv.reset();
+
+    for (auto packet : m_packets) {
+        av_packet_free(&packet);
+    }
+    m_packets.clear();
+
+    s_threadsInUse -= m_threads;
+
     if (m_decFrame) {
         av_frame_free(&m_decFrame);
         m_decFrame = NULL;
@@ -120,6 +187,25 @@ bool FFmpegFrameDecoder::init(FrameFormat format)
 
     m_decCtx->get_buffer2 = AVGetBuffer;
     m_decCtx->opaque = this;
+
+    // Share the thread budget among all decoders of the process
+    uint32_t threads = s_threadsPerDecoder;
+    if (threads == 0)
+        threads = std::max(boost::thread::hardware_concurrency(), 1U);
+    if (s_maxThreads > 0) {
+        uint32_t inUse = s_threadsInUse;
+        uint32_t available = inUse < s_maxThreads ? s_maxThreads - inUse : 0;
+        threads = std::max(std::min(threads, available), 1U);
+    }
+    m_threads = threads;
+    s_threadsInUse += m_threads;
+
+    m_decCtx->thread_count = m_threads;
+    m_decCtx->thread_type = s_threadType;
+#if FF_API_THREAD_SAFE_CALLBACKS
+    m_decCtx->thread_safe_callbacks = 1;
+#endif
+
     ret = avcodec_open2(m_decCtx, dec , NULL);
     if (ret < 0) {
         ELOG_ERROR_T("Could not open ffmpeg decoder context, %s", ff_err2str(ret));
@@ -132,55 +218,159 @@ bool FFmpegFrameDecoder::init(FrameFormat format)
         return false;
     }
 
-    memset(&m_packet, 0, sizeof(m_packet));
-
-    m_bufferManager.reset(new I420BufferManager(50));
+    // Frame threading holds one frame per thread in flight
+    m_bufferManager.reset(new I420BufferManager(50 + m_threads));
 
+    ELOG_DEBUG_T("Decoding threads %u, type %d", m_threads, m_decCtx->thread_type);
     return true;
 }
 
 void FFmpegFrameDecoder::onFrame(const Frame& frame)
 {
-    int ret;
+    if (!m_decCtx) {
+        return;
+    }
+
+    AVPacket *packet = av_packet_alloc();
+    if (!packet || av_new_packet(packet, frame.length) < 0) {
+        ELOG_ERROR_T("Could not allocate packet");
+        av_packet_free(&packet);
+        return;
+    }
+    memcpy(packet->data, frame.payload, frame.length);
+    // Arrival time, carried to the decoded frame for latency
+    packet->pts = currentTimeMs();
+
+    {
+        boost::unique_lock<boost::mutex> lock(m_queueMutex);
+
+        if (m_waitingKeyFrame) {
+            if (!frame.additionalInfo.video.isKeyFrame) {
+                m_droppedFrames++;
+                av_packet_free(&packet);
+                return;
+            }
+            ELOG_INFO_T("Resume decoding on key frame");
+            m_waitingKeyFrame = false;
+        }
+
+        if (m_packets.size() >= kMaxQueueDepth) {
+            ELOG_WARN_T("Decoding falls behind, drop %zu queued packets", m_packets.size());
+            m_droppedFrames += m_packets.size() + 1;
+            for (auto p : m_packets) {
+                av_packet_free(&p);
+            }
+            m_packets.clear();
+            av_packet_free(&packet);
+
+            m_waitingKeyFrame = true;
+            FeedbackMsg msg {.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME};
+            deliverFeedbackMsg(msg);
+            return;
+        }
+
+        m_packets.push_back(packet);
+        if (m_packets.size() > m_maxQueueDepth)
+            m_maxQueueDepth = m_packets.size();
+    }
+
+    m_srv->post(boost::bind(&FFmpegFrameDecoder::decode, this));
+}
 
-    av_init_packet(&m_packet);
-    m_packet.data = frame.payload;
-    m_packet.size = frame.length;
+void FFmpegFrameDecoder::decode()
+{
+    AVPacket *packet = NULL;
+    {
+        boost::unique_lock<boost::mutex> lock(m_queueMutex);
+        // Queue may have been flushed
+        if (m_packets.empty())
+            return;
+        packet = m_packets.front();
+        m_packets.pop_front();
+    }
 
-    ret = avcodec_send_packet(m_decCtx, &m_packet);
+    int ret = avcodec_send_packet(m_decCtx, packet);
+    av_packet_free(&packet);
     if (ret < 0) {
         ELOG_ERROR_T("Error while send packet, %s", ff_err2str(ret));
         return;
     }
 
-    ret = avcodec_receive_frame(m_decCtx, m_decFrame);
-    if (ret == AVERROR(EAGAIN)) {
-        ELOG_DEBUG_T("Retry receive frame, %s", ff_err2str(ret));
-        return;
-    }else if (ret < 0) {
-        ELOG_ERROR_T("Error while receive frame, %s", ff_err2str(ret));
-        return;
-    }
+    receiveFrames();
+}
 
-    webrtc::VideoFrame *video_frame = static_cast<webrtc::VideoFrame*>(
-            av_buffer_get_opaque(m_decFrame->buf[0]));
+void FFmpegFrameDecoder::receiveFrames()
+{
+    while (true) {
+        int ret = avcodec_receive_frame(m_decCtx, m_decFrame);
+        if (ret == AVERROR(EAGAIN)) {
+            ELOG_TRACE_T("Retry receive frame, %s", ff_err2str(ret));
+            break;
+        } else if (ret < 0) {
+            ELOG_ERROR_T("Error while receive frame, %s", ff_err2str(ret));
+            break;
+        }
+
+        webrtc::VideoFrame *video_frame = static_cast<webrtc::VideoFrame*>(
+                av_buffer_get_opaque(m_decFrame->buf[0]));
+
+        int64_t now = currentTimeMs();
+        if (m_decFrame->pts != AV_NOPTS_VALUE) {
+            uint32_t latency = now - m_decFrame->pts;
+            m_avgLatencyMs = (m_avgLatencyMs * 15 + latency) / 16;
+            if (latency > m_maxLatencyMs)
+                m_maxLatencyMs = latency;
+        }
+        m_decodedFrames++;
+
+        {
+            Frame frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.format = FRAME_FORMAT_I420;
+            frame.payload = reinterpret_cast<uint8_t*>(video_frame);
+            frame.length = 0;
+            frame.timeStamp = video_frame->timestamp();
+            frame.additionalInfo.video.width = video_frame->width();
+            frame.additionalInfo.video.height = video_frame->height();
+
+            ELOG_TRACE_T("deliverFrame, %dx%d, timeStamp %d",
+                    frame.additionalInfo.video.width,
+                    frame.additionalInfo.video.height,
+                    frame.timeStamp);
+            deliverFrame(frame);
+        }
+        av_frame_unref(m_decFrame);
+
+        reportStats(now);
+    }
+}
 
+void FFmpegFrameDecoder::getStats(FFmpegFrameDecoderStats& stats)
+{
     {
-        Frame frame;
-        memset(&frame, 0, sizeof(frame));
-        frame.format = FRAME_FORMAT_I420;
-        frame.payload = reinterpret_cast<uint8_t*>(video_frame);
-        frame.length = 0;
-        frame.timeStamp = video_frame->timestamp();
-        frame.additionalInfo.video.width = video_frame->width();
-        frame.additionalInfo.video.height = video_frame->height();
-
-        ELOG_TRACE_T("deliverFrame, %dx%d, timeStamp %d",
-                frame.additionalInfo.video.width,
-                frame.additionalInfo.video.height,
-                frame.timeStamp);
-        deliverFrame(frame);
+        boost::unique_lock<boost::mutex> lock(m_queueMutex);
+        stats.queueDepth = m_packets.size();
     }
+    stats.threads = m_threads;
+    stats.maxQueueDepth = m_maxQueueDepth;
+    stats.avgLatencyMs = m_avgLatencyMs;
+    stats.maxLatencyMs = m_maxLatencyMs;
+    stats.decodedFrames = m_decodedFrames;
+    stats.droppedFrames = m_droppedFrames;
+}
+
+void FFmpegFrameDecoder::reportStats(int64_t now)
+{
+    if (now - m_lastReportTime < kStatsReportIntervalMs)
+        return;
+    m_lastReportTime = now;
+
+    FFmpegFrameDecoderStats stats;
+    getStats(stats);
+    ELOG_DEBUG_T("Stats, threads %u, queue %u(max %u), latency %ums(max %ums), decoded %lu, dropped %lu",
+            stats.threads, stats.queueDepth, stats.maxQueueDepth,
+            stats.avgLatencyMs, stats.maxLatencyMs,
+            (unsigned long)stats.decodedFrames, (unsigned long)stats.droppedFrames);
 }
 
 char *FFmpegFrameDecoder::ff_err2str(int errRet)
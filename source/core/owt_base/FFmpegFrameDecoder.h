@@ -5,8 +5,15 @@
 #ifndef FFmpegFrameDecoder_h
 #define FFmpegFrameDecoder_h
 
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include <boost/asio.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <logger.h>
 
 #include "MediaFramePipeline.h"
@@ -18,6 +25,20 @@ extern "C" {
 
 namespace owt_base {
 
+struct FFmpegFrameDecoderStats {
+    uint32_t threads;
+    uint32_t queueDepth;
+    uint32_t maxQueueDepth;
+    uint32_t avgLatencyMs;      // from onFrame to delivery
+    uint32_t maxLatencyMs;
+    uint64_t decodedFrames;
+    uint64_t droppedFrames;
+};
+
+/**
+ * Software decoder, packets are queued in onFrame and decoded on the
+ * decoder's own thread with FFmpeg frame and/or slice threading.
+ */
 class FFmpegFrameDecoder : public VideoFrameDecoder {
     DECLARE_LOGGER();
 
@@ -27,20 +48,53 @@ public:
 
     static bool supportFormat(FrameFormat format) {return true;}
 
+    // Process wide threading config, applies to decoders created afterwards
+    // threadType: "frame", "slice" or "auto"(both)
+    // threadsPerDecoder: "0" by CPU cores
+    // maxThreads: cap of all decoders in the process, "0" unlimited
+    static void setThreadingConfig(const std::string& threadType, uint32_t threadsPerDecoder, uint32_t maxThreads);
+
     void onFrame(const Frame&);
     bool init(FrameFormat);
 
+    void getStats(FFmpegFrameDecoderStats& stats);
+
 protected:
     static int AVGetBuffer(AVCodecContext *s, AVFrame *frame, int flags);
     static void AVFreeBuffer(void* opaque, uint8_t* data);
 
+    void decode();
+    void receiveFrames();
+    void reportStats(int64_t now);
+
 private:
+    static int s_threadType;
+    static uint32_t s_threadsPerDecoder;
+    static uint32_t s_maxThreads;
+    static std::atomic<uint32_t> s_threadsInUse;
+
     AVCodecContext *m_decCtx;
     AVFrame *m_decFrame;
-
-    AVPacket m_packet;
+    uint32_t m_threads;
 
     boost::scoped_ptr<owt_base::I420BufferManager> m_bufferManager;
+    // get_buffer2 is called from FFmpeg worker threads
+    boost::mutex m_bufferMutex;
+
+    boost::shared_ptr<boost::asio::io_service> m_srv;
+    boost::shared_ptr<boost::asio::io_service::work> m_srvWork;
+    boost::shared_ptr<boost::thread> m_thread;
+
+    boost::mutex m_queueMutex;
+    std::deque<AVPacket *> m_packets;
+    bool m_waitingKeyFrame;
+
+    std::atomic<uint32_t> m_maxQueueDepth;
+    std::atomic<uint32_t> m_avgLatencyMs;
+    std::atomic<uint32_t> m_maxLatencyMs;
+    std::atomic<uint64_t> m_decodedFrames;
+    std::atomic<uint64_t> m_droppedFrames;
+    int64_t m_lastReportTime;
 
     char m_errbuff[500];
     char *ff_err2str(int errRet);
@@ -226,6 +226,8 @@ void FrameProcesser::onFrame(const Frame& frame)
 #endif
 
         if (!m_outFrameRate) {
+            // Converted just now and sent once, the text goes straight into it
+            m_textDrawer->drawInPlace(i420Buffer.get());
             SendFrame(i420Buffer, frame.timeStamp);
         } else {
             boost::shared_lock<boost::shared_mutex> lock(m_mutex);
@@ -269,7 +271,7 @@ void FrameProcesser::SendFrame(boost::shared_ptr<owt_base::MsdkFrame> msdkFrame,
 }
 #endif
 
-void FrameProcesser::SendFrame(rtc::scoped_refptr<webrtc::I420Buffer> i420Buffer, uint32_t timeStamp)
+void FrameProcesser::SendFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> i420Buffer, uint32_t timeStamp)
 {
     owt_base::Frame outFrame;
     memset(&outFrame, 0, sizeof(outFrame));
@@ -283,8 +285,6 @@ void FrameProcesser::SendFrame(rtc::scoped_refptr<webrtc::I420Buffer> i420Buffer
     outFrame.additionalInfo.video.height = i420Frame.height();
     outFrame.timeStamp = timeStamp;
 
-    m_textDrawer->drawFrame(outFrame);
-
     ELOG_TRACE_T("sendI420Frame, %dx%d",
             outFrame.additionalInfo.video.width,
             outFrame.additionalInfo.video.height);
@@ -326,8 +326,9 @@ void FrameProcesser::onTimeout()
             boost::shared_lock<boost::shared_mutex> lock(m_mutex);
             i420Buffer = m_activeI420Buffer;
         }
+        // Resent until the next input, the drawer keeps the copy with the text
         if (i420Buffer)
-            SendFrame(i420Buffer, timeStamp);
+            SendFrame(m_textDrawer->drawFrame(i420Buffer), timeStamp);
         return;
     }
 }
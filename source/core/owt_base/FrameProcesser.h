@@ -52,7 +52,7 @@ protected:
 
     void SendFrame(boost::shared_ptr<owt_base::MsdkFrame> msdkFrame, uint32_t timeStamp);
 #endif
-    void SendFrame(rtc::scoped_refptr<webrtc::I420Buffer> i420Buffer, uint32_t timeStamp);
+    void SendFrame(rtc::scoped_refptr<webrtc::VideoFrameBuffer> i420Buffer, uint32_t timeStamp);
 
 private:
     uint32_t m_lastWidth;
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <sys/time.h>
 #include <memory>
+#include <mutex>
 
 #include "MediaUtilities.h"
 
@@ -23,6 +24,55 @@ static inline void notifyAsyncEvent(EventRegistry* handle, const std::string& ev
         handle->notifyAsyncEvent(event, data);
 }
 
+namespace {
+
+// Release timers of all jitter buffers in the process,
+// each buffer is serialized on its own strand
+class JitterBufferTimerPool {
+public:
+    JitterBufferTimerPool(uint32_t workers)
+    : m_service{}
+    , m_work{m_service}
+    {
+        for (uint32_t i = 0; i < workers; i++)
+            m_threads.create_thread(boost::bind(&boost::asio::io_service::run, &m_service));
+    }
+
+    ~JitterBufferTimerPool()
+    {
+        m_service.stop();
+        m_threads.join_all();
+    }
+
+    boost::asio::io_service& service()
+    {
+        return m_service;
+    }
+
+private:
+    boost::asio::io_service m_service;
+    boost::asio::io_service::work m_work;
+    boost::thread_group m_threads;
+};
+
+boost::scoped_ptr<JitterBufferTimerPool> g_timerPool;
+std::once_flag g_timerPoolOnce;
+
+const uint32_t kMaxTimerWorkers = 4;
+
+void startTimerPool()
+{
+    uint32_t workers = boost::thread::hardware_concurrency() / 2;
+    if (workers < 1)
+        workers = 1;
+    if (workers > kMaxTimerWorkers)
+        workers = kMaxTimerWorkers;
+
+    g_timerPool.reset(new JitterBufferTimerPool(workers));
+}
+
+}
+
 namespace owt_base {
 
 static int filterNALs(uint8_t *data, int size, const std::vector<int> &remove_types, const std::vector<int> &pass_types)
@@ -84,12 +134,33 @@ FramePacket::~FramePacket()
     }
 }
 
+DEFINE_LOGGER(FramePacketBuffer, "owt.LiveStreamIn.FramePacketBuffer");
+
+FramePacketBuffer::FramePacketBuffer(uint32_t capacity)
+    : m_ring(capacity)
+    , m_head(0)
+    , m_size(0)
+    , m_droppedCount(0)
+{
+}
+
 void FramePacketBuffer::pushPacket(boost::shared_ptr<FramePacket> &FramePacket)
 {
     boost::mutex::scoped_lock lock(m_queueMutex);
-    m_queue.push_back(FramePacket);
 
-    if (m_queue.size() == 1)
+    if (m_size == m_ring.size()) {
+        if (m_droppedCount++ % 100 == 0)
+            ELOG_WARN("Buffer full(%zu), drop oldest packet, dropped %ld", m_ring.size(), m_droppedCount);
+
+        m_ring[m_head].reset();
+        m_head = (m_head + 1) % m_ring.size();
+        m_size--;
+    }
+
+    m_ring[(m_head + m_size) % m_ring.size()] = FramePacket;
+    m_size++;
+
+    if (m_size == 1)
         m_queueCond.notify_one();
 }
 
@@ -98,13 +169,15 @@ boost::shared_ptr<FramePacket> FramePacketBuffer::popPacket(bool noWait)
     boost::mutex::scoped_lock lock(m_queueMutex);
     boost::shared_ptr<FramePacket> packet;
 
-    while (!noWait && m_queue.empty()) {
+    while (!noWait && m_size == 0) {
         m_queueCond.wait(lock);
     }
 
-    if (!m_queue.empty()) {
-        packet = m_queue.front();
-        m_queue.pop_front();
+    if (m_size > 0) {
+        packet.swap(m_ring[m_head]);
+        m_head = (m_head + 1) % m_ring.size();
+        m_size--;
+        m_spaceCond.notify_all();
     }
 
     return packet;
@@ -115,12 +188,12 @@ boost::shared_ptr<FramePacket> FramePacketBuffer::frontPacket(bool noWait)
     boost::mutex::scoped_lock lock(m_queueMutex);
     boost::shared_ptr<FramePacket> packet;
 
-    while (!noWait && m_queue.empty()) {
+    while (!noWait && m_size == 0) {
         m_queueCond.wait(lock);
     }
 
-    if (!m_queue.empty()) {
-        packet = m_queue.front();
+    if (m_size > 0) {
+        packet = m_ring[m_head];
     }
 
     return packet;
@@ -131,12 +204,12 @@ boost::shared_ptr<FramePacket> FramePacketBuffer::backPacket(bool noWait)
     boost::mutex::scoped_lock lock(m_queueMutex);
     boost::shared_ptr<FramePacket> packet;
 
-    while (!noWait && m_queue.empty()) {
+    while (!noWait && m_size == 0) {
         m_queueCond.wait(lock);
     }
 
-    if (!m_queue.empty()) {
-        packet = m_queue.back();
+    if (m_size > 0) {
+        packet = m_ring[(m_head + m_size - 1) % m_ring.size()];
     }
 
     return packet;
@@ -145,16 +218,46 @@ boost::shared_ptr<FramePacket> FramePacketBuffer::backPacket(bool noWait)
 uint32_t FramePacketBuffer::size()
 {
     boost::mutex::scoped_lock lock(m_queueMutex);
-    return m_queue.size();
+    return m_size;
 }
 
 void FramePacketBuffer::clear()
 {
     boost::mutex::scoped_lock lock(m_queueMutex);
-    m_queue.clear();
+    for (auto& packet : m_ring)
+        packet.reset();
+    m_head = 0;
+    m_size = 0;
+    m_spaceCond.notify_all();
     return;
 }
 
+int64_t FramePacketBuffer::durationMsLocked()
+{
+    if (m_size < 2)
+        return 0;
+
+    AVPacket *front = m_ring[m_head]->getAVPacket();
+    AVPacket *back = m_ring[(m_head + m_size - 1) % m_ring.size()]->getAVPacket();
+    return back->dts - front->dts;
+}
+
+int64_t FramePacketBuffer::durationMs()
+{
+    boost::mutex::scoped_lock lock(m_queueMutex);
+    return durationMsLocked();
+}
+
+bool FramePacketBuffer::waitForDuration(int64_t maxMs, uint32_t timeoutMs)
+{
+    boost::mutex::scoped_lock lock(m_queueMutex);
+
+    if (durationMsLocked() > maxMs)
+        m_spaceCond.timed_wait(lock, boost::get_system_time() + boost::posix_time::milliseconds(timeoutMs));
+
+    return durationMsLocked() <= maxMs;
+}
+
 DEFINE_LOGGER(JitterBuffer, "owt.LiveStreamIn.JitterBuffer");
 
 JitterBuffer::JitterBuffer(std::string name, SyncMode syncMode, JitterBufferListener *listener, int64_t maxBufferingMs)
@@ -165,10 +268,14 @@ JitterBuffer::JitterBuffer(std::string name, SyncMode syncMode, JitterBufferList
     , m_lastInterval(5)
     , m_isFirstFramePacket(true)
     , m_listener(listener)
+    , m_pendingHandlers(0)
     , m_syncTimestamp(AV_NOPTS_VALUE)
     , m_firstTimestamp(AV_NOPTS_VALUE)
     , m_maxBufferingMs(maxBufferingMs)
 {
+    // Start the shared timer pool once
+    std::call_once(g_timerPoolOnce, startTimerPool);
+    m_strand.reset(new boost::asio::io_service::strand(g_timerPool->service()));
 }
 
 JitterBuffer::~JitterBuffer()
@@ -181,10 +288,9 @@ void JitterBuffer::start(uint32_t delay)
     if (!m_isRunning) {
         ELOG_DEBUG_T("(%s)start", m_name.c_str());
 
-        m_timer.reset(new boost::asio::deadline_timer(m_ioService));
+        m_timer.reset(new boost::asio::deadline_timer(g_timerPool->service()));
         m_timer->expires_from_now(boost::posix_time::milliseconds(delay));
-        m_timer->async_wait(boost::bind(&JitterBuffer::onTimeout, this, boost::asio::placeholders::error));
-        m_timingThread.reset(new boost::thread(boost::bind(&boost::asio::io_service::run, &m_ioService)));
+        scheduleTimer();
         m_isRunning = true;
     }
 }
@@ -194,12 +300,23 @@ void JitterBuffer::stop()
     if (m_isRunning) {
         ELOG_DEBUG_T("(%s)stop", m_name.c_str());
 
-        m_timer->cancel();
+        {
+            boost::mutex::scoped_lock lock(m_handlerMutex);
+            m_isClosing = true;
+
+            // Timer is only touched on the strand
+            m_pendingHandlers++;
+            m_strand->post([this]() {
+                boost::system::error_code ec;
+                m_timer->cancel(ec);
+                endHandler();
+            });
+
+            while (m_pendingHandlers > 0)
+                m_handlerCond.wait(lock);
+        }
 
-        m_isClosing = true;
-        m_timingThread->join();
         m_buffer.clear();
-        m_ioService.reset();
         m_isRunning = false;
         m_isClosing = false;
 
@@ -223,14 +340,12 @@ void JitterBuffer::drain()
 
 uint32_t JitterBuffer::sizeInMs()
 {
-    int64_t bufferingMs = 0;
-    boost::shared_ptr<FramePacket> frontPacket = m_buffer.frontPacket();
-    boost::shared_ptr<FramePacket> backPacket = m_buffer.backPacket();
+    return m_buffer.durationMs();
+}
 
-    if (frontPacket && backPacket) {
-        bufferingMs = backPacket->getAVPacket()->dts - frontPacket->getAVPacket()->dts;
-    }
-    return bufferingMs;
+bool JitterBuffer::waitForBuffering(uint32_t maxMs, uint32_t timeoutMs)
+{
+    return m_buffer.waitForDuration(maxMs, timeoutMs);
 }
 
 void JitterBuffer::onTimeout(const boost::system::error_code& ec)
@@ -241,6 +356,34 @@ void JitterBuffer::onTimeout(const boost::system::error_code& ec)
     }
 }
 
+bool JitterBuffer::beginHandler()
+{
+    boost::mutex::scoped_lock lock(m_handlerMutex);
+    if (m_isClosing)
+        return false;
+
+    m_pendingHandlers++;
+    return true;
+}
+
+void JitterBuffer::endHandler()
+{
+    boost::mutex::scoped_lock lock(m_handlerMutex);
+    if (--m_pendingHandlers == 0)
+        m_handlerCond.notify_all();
+}
+
+void JitterBuffer::scheduleTimer()
+{
+    if (!beginHandler())
+        return;
+
+    m_timer->async_wait(m_strand->wrap([this](const boost::system::error_code& ec) {
+        onTimeout(ec);
+        endHandler();
+    }));
+}
+
 void JitterBuffer::insert(AVPacket &pkt)
 {
     boost::shared_ptr<FramePacket> framePacket(new FramePacket(&pkt));
@@ -399,7 +542,7 @@ void JitterBuffer::handleJob()
 
     ELOG_TRACE_T("(%s)buffer size %d, next time %d", m_name.c_str(), m_buffer.size(), interval);
 
-    m_timer->async_wait(boost::bind(&JitterBuffer::onTimeout, this, boost::asio::placeholders::error));
+    scheduleTimer();
 }
 
 DEFINE_LOGGER(LiveStreamIn, "owt.LiveStreamIn");
@@ -903,14 +1046,11 @@ void LiveStreamIn::receiveLoop()
     memset(&m_avPacket, 0, sizeof(m_avPacket));
     while (m_running) {
         if (m_isFileInput) {
-            if (m_videoJitterBuffer && m_videoJitterBuffer->sizeInMs() > 500) {
-                usleep(1000);
+            // Sleep until the jitter buffers release enough, instead of polling
+            if (m_videoJitterBuffer && !m_videoJitterBuffer->waitForBuffering(500, 10))
                 continue;
-            }
-            if (m_audioJitterBuffer && m_audioJitterBuffer->sizeInMs() > 500) {
-                usleep(1000);
+            if (m_audioJitterBuffer && !m_audioJitterBuffer->waitForBuffering(500, 10))
                 continue;
-            }
         }
 
         av_init_packet(&m_avPacket);
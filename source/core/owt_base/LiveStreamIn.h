@@ -21,6 +21,7 @@ extern "C" {
 
 #include <fstream>
 #include <memory>
+#include <vector>
 
 namespace owt_base {
 
@@ -75,9 +76,13 @@ private:
     AVPacket *m_packet;
 };
 
+// Fixed capacity ring, the oldest packet is dropped when full
 class FramePacketBuffer {
+    DECLARE_LOGGER();
+
+    static const uint32_t DEFAULT_CAPACITY = 1024;
 public:
-    FramePacketBuffer () { }
+    FramePacketBuffer (uint32_t capacity = DEFAULT_CAPACITY);
     virtual ~FramePacketBuffer() { }
 
     void pushPacket(boost::shared_ptr<FramePacket> &FramePacket);
@@ -89,10 +94,21 @@ public:
     uint32_t size();
     void clear();
 
+    // Dts distance between the oldest and newest packet
+    int64_t durationMs();
+    // Returns false if still above maxMs after timeoutMs
+    bool waitForDuration(int64_t maxMs, uint32_t timeoutMs);
+
 private:
+    int64_t durationMsLocked();
+
     boost::mutex m_queueMutex;
     boost::condition_variable m_queueCond;
-    std::deque<boost::shared_ptr<FramePacket>> m_queue;
+    boost::condition_variable m_spaceCond;
+    std::vector<boost::shared_ptr<FramePacket>> m_ring;
+    uint32_t m_head;
+    uint32_t m_size;
+    uint64_t m_droppedCount;
 };
 
 class JitterBufferListener {
@@ -116,6 +132,7 @@ public:
     void stop();
     void drain();
     uint32_t sizeInMs();
+    bool waitForBuffering(uint32_t maxMs, uint32_t timeoutMs);
 
     void insert(AVPacket &pkt);
     void setSyncTime(int64_t &syncTimestamp, boost::posix_time::ptime &syncLocalTime);
@@ -124,6 +141,10 @@ protected:
     void onTimeout(const boost::system::error_code& ec);
     int64_t getNextTime(AVPacket *pkt);
     void handleJob();
+    void scheduleTimer();
+
+    bool beginHandler();
+    void endHandler();
 
 private:
     std::string m_name;
@@ -137,9 +158,12 @@ private:
 
     FramePacketBuffer m_buffer;
 
-    boost::scoped_ptr<boost::thread> m_timingThread;
-    boost::asio::io_service m_ioService;
+    // Timers of all jitter buffers run on a shared pool, serialized per buffer
+    boost::scoped_ptr<boost::asio::io_service::strand> m_strand;
     boost::scoped_ptr<boost::asio::deadline_timer> m_timer;
+    boost::mutex m_handlerMutex;
+    boost::condition_variable m_handlerCond;
+    uint32_t m_pendingHandlers;
 
     boost::scoped_ptr<boost::posix_time::ptime> m_syncLocalTime;
     int64_t m_syncTimestamp;
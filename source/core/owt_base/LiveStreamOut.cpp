@@ -13,10 +13,15 @@ namespace owt_base {
 
 DEFINE_LOGGER(LiveStreamOut, "owt.LiveStreamOut");
 
+// About 3s of audio and video, viewers prefer a glitch to a growing delay
+static const size_t kQueueCapacity = 256;
+
 LiveStreamOut::LiveStreamOut(const std::string& url, bool hasAudio, bool hasVideo, EventRegistry* handle, int streamingTimeout, StreamingOptions& options)
     : AVStreamOut(url, hasAudio, hasVideo, handle, streamingTimeout)
     , m_options(options)
 {
+    setQueueOptions(kQueueCapacity, MediaFrameQueue::DROP_NON_REFERENCE);
+
     switch(m_options.format) {
         case STREAMING_FORMAT_RTSP:
             ELOG_DEBUG("format %s", "rtsp");
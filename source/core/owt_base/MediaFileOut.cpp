@@ -8,9 +8,13 @@ namespace owt_base {
 
 DEFINE_LOGGER(MediaFileOut, "owt.media.MediaFileOut");
 
+// Disk stalls are usually short, give them more room than live streaming
+static const size_t kQueueCapacity = 1024;
+
 MediaFileOut::MediaFileOut(const std::string& url, bool hasAudio, bool hasVideo, EventRegistry* handle, int recordingTimeout)
     : AVStreamOut(url, hasAudio, hasVideo, handle, recordingTimeout)
 {
+    setQueueOptions(kQueueCapacity, MediaFrameQueue::DROP_UNTIL_KEYFRAME);
 }
 
 MediaFileOut::~MediaFileOut()
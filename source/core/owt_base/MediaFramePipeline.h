@@ -63,6 +63,8 @@ struct VideoFrameSpecificInfo {
     uint16_t width;
     uint16_t height;
     bool isKeyFrame;
+    uint8_t temporalId;     // 0 for streams without temporal layers
+    bool layerSync;         // Decodable when switching up to temporalId
 };
 
 struct AudioFrameSpecificInfo {
@@ -299,7 +299,7 @@ public:
 
         boost::shared_ptr<mfxBitstream> bsBuffer = getBitstreamBuffer();
         if (!bsBuffer) {
-            ELOG_INFO_T("Drop frame, no bitstream buffer available");
+            ELOG_INFO_RATE(10, "(%p)Drop frame, no bitstream buffer available", this);
             return;
         }
 
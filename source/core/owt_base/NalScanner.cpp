@@ -0,0 +1,152 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "NalScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NAL_SCANNER_X86 1
+#endif
+
+namespace owt_base {
+
+typedef size_t (*FindStartCodeFunc)(const uint8_t* data, size_t size, size_t from);
+
+static size_t findStartCodeC(const uint8_t* data, size_t size, size_t from)
+{
+    for (size_t i = from; i + 2 < size; i++) {
+        if (data[i + 2] > 1) {
+            i += 2;
+        } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#ifdef NAL_SCANNER_X86
+// Compares data[i], data[i + 1], data[i + 2] against 0, 0, 1 in one pass
+static size_t findStartCodeSSE2(const uint8_t* data, size_t size, size_t from)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    size_t i = from;
+
+    for (; i + 2 + 16 <= size; i += 16) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(data + i + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(data + i + 2));
+        __m128i match = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+            _mm_cmpeq_epi8(b2, one));
+        int mask = _mm_movemask_epi8(match);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return findStartCodeC(data, size, i);
+}
+
+__attribute__((target("avx2")))
+static size_t findStartCodeAVX2(const uint8_t* data, size_t size, size_t from)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = from;
+
+    for (; i + 2 + 32 <= size; i += 32) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+        __m256i b2 = _mm256_loadu_si256((const __m256i*)(data + i + 2));
+        __m256i match = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+            _mm256_cmpeq_epi8(b2, one));
+        uint32_t mask = _mm256_movemask_epi8(match);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return findStartCodeSSE2(data, size, i);
+}
+#endif
+
+static FindStartCodeFunc selectFindStartCode()
+{
+#ifdef NAL_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findStartCodeAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return findStartCodeSSE2;
+    }
+#endif
+    return findStartCodeC;
+}
+
+static const FindStartCodeFunc g_findStartCode = selectFindStartCode();
+
+size_t NalScanner::findStartCode(const uint8_t* data, size_t size, size_t from)
+{
+    if (!data || from >= size) {
+        return size;
+    }
+    return g_findStartCode(data, size, from);
+}
+
+size_t NalScanner::scan(const uint8_t* data, size_t size, bool h265, NalSpan* spans, size_t maxSpans)
+{
+    size_t count = 0;
+    size_t pos = findStartCode(data, size, 0);
+
+    while (pos < size && count < maxSpans) {
+        size_t header = pos + 3;
+        if (header >= size) {
+            break;
+        }
+
+        NalSpan& span = spans[count];
+        // Leading zero of a 4 bytes start code, trailing zeros before it stay with the previous NAL
+        span.scLen = (pos > 0 && data[pos - 1] == 0) ? 4 : 3;
+        span.offset = pos + 3 - span.scLen;
+        span.type = h265 ? ((data[header] >> 1) & 0x3f) : (data[header] & 0x1f);
+        if (count > 0) {
+            spans[count - 1].length = span.offset - spans[count - 1].offset;
+        }
+        count++;
+
+        pos = findStartCode(data, size, header);
+    }
+
+    if (count > 0) {
+        // Truncated scan leaves the remaining NALs in the last span
+        spans[count - 1].length = size - spans[count - 1].offset;
+    }
+    return count;
+}
+
+bool NalScanner::hasKeyFrame(const NalSpan* spans, size_t count, bool h265)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint8_t type = spans[i].type;
+        if (h265 ? (isH265ParameterSet(type) || (type >= 16 && type <= 21))
+                : (isH264ParameterSet(type) || type == 5)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NalScanner::hasParameterSets(const NalSpan* spans, size_t count, bool h265)
+{
+    for (size_t i = 0; i < count; i++) {
+        // SPS is required, PPS follows it in practice
+        if (spans[i].type == (h265 ? 33 : 7)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} /* namespace owt_base */
@@ -0,0 +1,45 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NalScanner_h
+#define NalScanner_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace owt_base {
+
+// NAL unit in an Annex-B buffer, offsets are relative to the buffer
+struct NalSpan {
+    uint32_t offset;    // Start code position
+    uint32_t length;    // Including start code
+    uint8_t scLen;      // 3 or 4
+    uint8_t type;       // nal_unit_type
+
+    uint32_t payloadOffset() const {return offset + scLen;}
+};
+
+// Start code search runs 32/16 bytes at a time with AVX2/SSE2, picked at runtime.
+// Spans are written to a caller-owned array, nothing is allocated.
+class NalScanner {
+public:
+    static const size_t MAX_NALS = 128;
+
+    // Position of the next 00 00 01 at or after from, size if none
+    static size_t findStartCode(const uint8_t* data, size_t size, size_t from = 0);
+
+    // Returns number of NALs written to spans, at most maxSpans
+    static size_t scan(const uint8_t* data, size_t size, bool h265, NalSpan* spans, size_t maxSpans);
+
+    static bool isH264ParameterSet(uint8_t type) {return type == 7 || type == 8;}
+    static bool isH265ParameterSet(uint8_t type) {return type >= 32 && type <= 34;}
+
+    // IDR/IRAP slice or parameter set present
+    static bool hasKeyFrame(const NalSpan* spans, size_t count, bool h265);
+    static bool hasParameterSets(const NalSpan* spans, size_t count, bool h265);
+};
+
+} /* namespace owt_base */
+
+#endif /* NalScanner_h */
@@ -0,0 +1,167 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE NalScanner
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+#include "NalScanner.h"
+
+using owt_base::NalScanner;
+using owt_base::NalSpan;
+
+static size_t naiveFindStartCode(const std::vector<uint8_t>& data, size_t from)
+{
+    for (size_t i = from; i + 2 < data.size(); i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+            return i;
+    }
+    return data.size();
+}
+
+static void append(std::vector<uint8_t>& data, std::initializer_list<uint8_t> bytes)
+{
+    data.insert(data.end(), bytes);
+}
+
+BOOST_AUTO_TEST_SUITE(StartCode)
+
+BOOST_AUTO_TEST_CASE(NoStartCode)
+{
+    std::vector<uint8_t> data(100, 0x55);
+    BOOST_CHECK_EQUAL(NalScanner::findStartCode(data.data(), data.size()), data.size());
+    BOOST_CHECK_EQUAL(NalScanner::findStartCode(nullptr, 0), 0u);
+    // 00 00 00 is not a start code
+    std::vector<uint8_t> zeros(64, 0);
+    BOOST_CHECK_EQUAL(NalScanner::findStartCode(zeros.data(), zeros.size()), zeros.size());
+}
+
+BOOST_AUTO_TEST_CASE(EveryOffset)
+{
+    // Across 16/32 byte blocks and the scalar tail
+    for (size_t size = 3; size < 80; size++) {
+        for (size_t pos = 0; pos + 3 <= size; pos++) {
+            std::vector<uint8_t> data(size, 0xff);
+            data[pos] = 0;
+            data[pos + 1] = 0;
+            data[pos + 2] = 1;
+            BOOST_REQUIRE_EQUAL(NalScanner::findStartCode(data.data(), data.size()), pos);
+            BOOST_REQUIRE_EQUAL(NalScanner::findStartCode(data.data(), data.size(), pos + 1), size);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MatchesNaiveSearch)
+{
+    // Mostly 0/1 bytes so start codes are frequent
+    std::srand(1);
+    std::vector<uint8_t> data(4096);
+    for (auto& b : data)
+        b = std::rand() % 3;
+
+    size_t from = 0;
+    size_t expected;
+    do {
+        expected = naiveFindStartCode(data, from);
+        BOOST_REQUIRE_EQUAL(NalScanner::findStartCode(data.data(), data.size(), from), expected);
+        from = expected + 1;
+    } while (expected < data.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Scan)
+
+BOOST_AUTO_TEST_CASE(H264AccessUnit)
+{
+    std::vector<uint8_t> au;
+    append(au, {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1f});  // SPS, 4 bytes start code
+    append(au, {0, 0, 1, 0x68, 0xce, 0x3c, 0x80});      // PPS, 3 bytes start code
+    append(au, {0, 0, 0, 1, 0x65, 0x88, 0x84, 0x00, 0x33}); // IDR
+
+    NalSpan spans[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(au.data(), au.size(), false, spans, NalScanner::MAX_NALS);
+
+    BOOST_REQUIRE_EQUAL(count, 3u);
+    BOOST_CHECK_EQUAL(spans[0].type, 7);
+    BOOST_CHECK_EQUAL(spans[0].offset, 0u);
+    BOOST_CHECK_EQUAL(spans[0].scLen, 4);
+    BOOST_CHECK_EQUAL(spans[0].length, 8u);
+    BOOST_CHECK_EQUAL(spans[1].type, 8);
+    BOOST_CHECK_EQUAL(spans[1].offset, 8u);
+    BOOST_CHECK_EQUAL(spans[1].scLen, 3);
+    BOOST_CHECK_EQUAL(spans[1].length, 7u);
+    BOOST_CHECK_EQUAL(spans[2].type, 5);
+    BOOST_CHECK_EQUAL(spans[2].payloadOffset(), 19u);
+    BOOST_CHECK_EQUAL(spans[2].offset + spans[2].length, au.size());
+
+    BOOST_CHECK(NalScanner::hasKeyFrame(spans, count, false));
+    BOOST_CHECK(NalScanner::hasParameterSets(spans, count, false));
+}
+
+BOOST_AUTO_TEST_CASE(H264DeltaFrame)
+{
+    std::vector<uint8_t> au;
+    append(au, {0, 0, 0, 1, 0x09, 0xf0});              // AUD
+    append(au, {0, 0, 0, 1, 0x41, 0x9a, 0x02, 0x03});  // non-IDR slice
+
+    NalSpan spans[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(au.data(), au.size(), false, spans, NalScanner::MAX_NALS);
+
+    BOOST_REQUIRE_EQUAL(count, 2u);
+    BOOST_CHECK_EQUAL(spans[0].type, 9);
+    BOOST_CHECK_EQUAL(spans[1].type, 1);
+    BOOST_CHECK(!NalScanner::hasKeyFrame(spans, count, false));
+    BOOST_CHECK(!NalScanner::hasParameterSets(spans, count, false));
+}
+
+BOOST_AUTO_TEST_CASE(H265AccessUnit)
+{
+    std::vector<uint8_t> au;
+    append(au, {0, 0, 0, 1, 0x40, 0x01, 0x0c});  // VPS
+    append(au, {0, 0, 0, 1, 0x42, 0x01, 0x01});  // SPS
+    append(au, {0, 0, 0, 1, 0x44, 0x01, 0xc1});  // PPS
+    append(au, {0, 0, 0, 1, 0x26, 0x01, 0xaf});  // IDR_W_RADL
+
+    NalSpan spans[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(au.data(), au.size(), true, spans, NalScanner::MAX_NALS);
+
+    BOOST_REQUIRE_EQUAL(count, 4u);
+    BOOST_CHECK_EQUAL(spans[0].type, 32);
+    BOOST_CHECK_EQUAL(spans[1].type, 33);
+    BOOST_CHECK_EQUAL(spans[2].type, 34);
+    BOOST_CHECK_EQUAL(spans[3].type, 19);
+    BOOST_CHECK(NalScanner::hasKeyFrame(spans + 3, 1, true));
+    BOOST_CHECK(NalScanner::hasParameterSets(spans, count, true));
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedScan)
+{
+    std::vector<uint8_t> au;
+    for (int i = 0; i < 5; i++)
+        append(au, {0, 0, 1, 0x41, 0x00, 0x11});
+
+    NalSpan spans[2];
+    size_t count = NalScanner::scan(au.data(), au.size(), false, spans, 2);
+
+    // The last span keeps the rest of the buffer
+    BOOST_REQUIRE_EQUAL(count, 2u);
+    BOOST_CHECK_EQUAL(spans[0].length, 6u);
+    BOOST_CHECK_EQUAL(spans[1].offset, 6u);
+    BOOST_CHECK_EQUAL(spans[1].length, au.size() - 6);
+}
+
+BOOST_AUTO_TEST_CASE(StartCodeAtEnd)
+{
+    std::vector<uint8_t> au;
+    append(au, {0, 0, 1, 0x65, 0x88, 0, 0, 1});
+
+    NalSpan spans[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(au.data(), au.size(), false, spans, NalScanner::MAX_NALS);
+
+    // A start code without a header byte is not a NAL
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_CHECK_EQUAL(spans[0].length, au.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
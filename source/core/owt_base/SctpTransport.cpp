@@ -4,6 +4,10 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <future>
 
 #include "SctpTransport.h"
 
@@ -21,6 +25,19 @@ enum PreservedErrno {
 // Initialize with a large send space size currently
 const int MAX_MSGSIZE = 1024 * 1024;
 
+// Datagrams per recvmmsg/sendmmsg call
+const size_t kIoBatch = 32;
+// recvmmsg calls per readable wakeup, leaves the shared thread to others
+const int kMaxReadRounds = 8;
+// Messages passed to usrsctp per wakeup
+const int kMaxDrainPerWakeup = 64;
+// usrsctp datagrams stay below the path MTU
+const size_t kReceiveSlotSize = 9216;
+// Reused buffers kept per transport
+const size_t kMaxPooledPackets = 256;
+const size_t kMaxPooledMessages = 16;
+const size_t kMaxPooledMessageSize = 256 * 1024;
+
 int usrsctp_ref_count = 0;
 boost::mutex usrsctp_ref_mutex;
 
@@ -93,12 +110,19 @@ SctpTransport::SctpTransport(RawTransportListener* listener, size_t initialBuffe
     , m_remoteSctpPort(0)
     , m_tag(tag)
     , m_ready(false)
-    , m_bufferSize(initialBufferSize)
+    , m_bufferSize(std::min(initialBufferSize, kReceiveSlotSize))
     , m_fragBufferSize(initialBufferSize)
     , m_receivedBytes(0)
     , m_currentTsn(0)
+    , m_flushScheduled(false)
+    , m_waitingWritable(false)
+    , m_udpConnected(false)
+    , m_ioService(getIOService())
+    , m_alive(std::make_shared<bool>(true))
+    , m_aliveToken(m_alive)
     , m_sctpSocket(NULL)
     , m_sending(false)
+    , m_drainScheduled(false)
     , m_listener(listener)
 {
 }
@@ -108,26 +132,33 @@ SctpTransport::~SctpTransport()
     ELOG_DEBUG("SctpTransport Destructor");
     m_isClosing = true;
 
+    // No outbound packets from usrsctp after this
     destroySctpSocket();
 
-    m_ioService.stop();
-    // We need to wait for the work thread to finish its job.
-    m_workThread.join();
-
-    m_work.reset();
-    m_senderService.stop();
-    m_senderThread.join();
-
-    // Close the socket after it has no work left
-    if (m_udpSocket && m_udpSocket->is_open()) {
-        boost::system::error_code ec;
-        m_udpSocket->shutdown(boost::asio::ip::udp::socket::shutdown_both, ec);
-        m_udpSocket->close();
-    }
+    // Handlers still queued on the shared thread find the token gone,
+    // close the socket after it has no work left
+    runOnIOService([this]() {
+        m_alive.reset();
+        if (m_udpSocket && m_udpSocket->is_open()) {
+            boost::system::error_code ec;
+            m_udpSocket->shutdown(boost::asio::ip::udp::socket::shutdown_both, ec);
+            m_udpSocket->close(ec);
+        }
+    });
 
     ELOG_DEBUG("SctpTransport Destructor END");
 }
 
+void SctpTransport::runOnIOService(std::function<void()> task)
+{
+    std::promise<void> done;
+    m_ioService->service().dispatch([&task, &done]() {
+        task();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
 void SctpTransport::close()
 {
     ELOG_DEBUG("Start Closing...");
@@ -390,8 +421,10 @@ bool SctpTransport::setupSctpPeer() {
         ELOG_WARN("UDP transport existed, ignoring the setupSctpPeer");
         return false;
     }
-    m_udpSocket.reset(new boost::asio::ip::udp::socket(m_ioService,
+    m_udpSocket.reset(new boost::asio::ip::udp::socket(m_ioService->service(),
         boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0)));
+    // Datagrams are moved with recvmmsg/sendmmsg on readiness
+    m_udpSocket->non_blocking(true);
     m_localUdpPort = m_udpSocket->local_endpoint().port();
 
     ELOG_DEBUG("Udp bind local port:%u", m_localUdpPort);
@@ -460,13 +493,9 @@ void SctpTransport::startSctpConnection() {
         return;
     }
 
-    m_work.reset(new boost::asio::io_service::work(m_senderService));
     m_ready = true;
     m_sending = true;
 
-    if (m_senderThread.get_id() == boost::thread::id()) // Not-A-Thread
-        m_senderThread = boost::thread(boost::bind(&boost::asio::io_service::run, &m_senderService));
-
     // Set the MTU and disable MTU discovery.
     // We can only do this after usrsctp_connect or it has no effect.
     /*
@@ -480,97 +509,229 @@ void SctpTransport::startSctpConnection() {
     }
     */
 
-    boost::asio::ip::udp::resolver resolver(m_ioService);
+    boost::asio::ip::udp::resolver resolver(m_ioService->service());
     boost::asio::ip::udp::resolver::query query(
         boost::asio::ip::udp::v4(), m_remoteIp.c_str(),
         boost::to_string(m_remoteUdpPort).c_str());
     boost::asio::ip::udp::resolver::iterator iterator = resolver.resolve(query);
 
+    std::weak_ptr<bool> alive = m_aliveToken;
     m_udpSocket->async_connect(*iterator,
-        [this] (const boost::system::error_code& error) {
-            // Start receving on udp port
+        [this, alive] (const boost::system::error_code& error) {
+            if (alive.expired()) {
+                return;
+            }
+            if (error) {
+                ELOG_WARN("Udp async connect error: %s", error.message().c_str());
+            }
+            // Start receving on udp port, send what usrsctp queued meanwhile
             ELOG_DEBUG("Udp async connect callback");
+            {
+                boost::lock_guard<boost::mutex> lock(m_packetMutex);
+                m_udpConnected = true;
+            }
             receiveData();
+            flushPackets();
         });
-
-    if (m_workThread.get_id() == boost::thread::id()) // Not-A-Thread
-        m_workThread = boost::thread(boost::bind(&boost::asio::io_service::run, &m_ioService));
 }
 
 void SctpTransport::postPacket(const char* buf, int len)
 {
-    TransportData data;
-    data.buffer.reset(new char[len]);
-    memcpy(data.buffer.get(), buf, len);
-    data.length = len;
-
-    // Make doSend all in workThread
-    m_ioService.post([this, data]() {
-        boost::lock_guard<boost::mutex> lock(m_sendQueueMutex);
-        ELOG_DEBUG("m_sendQueue size: %zu", m_sendQueue.size());
-        m_sendQueue.push(data);
-        if (m_sendQueue.size() == 1)
-            doSend();
-    });
+    // Called in usrsctp threads, the packet is copied into a pooled buffer
+    bool schedule = false;
+    {
+        boost::lock_guard<boost::mutex> lock(m_packetMutex);
+        Buffer packet;
+        if (!m_packetPool.empty()) {
+            packet.swap(m_packetPool.back());
+            m_packetPool.pop_back();
+        }
+        packet.assign(buf, buf + len);
+        m_packetQueue.push_back(std::move(packet));
+
+        if (!m_flushScheduled && !m_waitingWritable) {
+            m_flushScheduled = true;
+            schedule = true;
+        }
+    }
+
+    if (schedule) {
+        std::weak_ptr<bool> alive = m_aliveToken;
+        m_ioService->service().post([this, alive]() {
+            if (!alive.expired()) {
+                flushPackets();
+            }
+        });
+    }
 }
 
-void SctpTransport::doSend()
+void SctpTransport::flushPackets()
 {
-    TransportData& data = m_sendQueue.front();
+    // Called in IO thread, sends everything queued so far in sendmmsg batches
+    {
+        boost::lock_guard<boost::mutex> lock(m_packetMutex);
+        m_flushScheduled = false;
+        if (!m_udpConnected || m_waitingWritable || m_packetQueue.empty()) {
+            return;
+        }
+        m_packetsInFlight.swap(m_packetQueue);
+    }
+
+    ELOG_DEBUG("Send %zu packets to remote udp port %d->%d",
+        m_packetsInFlight.size(), m_localUdpPort, m_remoteUdpPort);
+
+    const int fd = m_udpSocket->native_handle();
+    struct mmsghdr msgs[kIoBatch];
+    struct iovec iovs[kIoBatch];
+    size_t sent = 0;
+    bool blocked = false;
+
+    while (sent < m_packetsInFlight.size()) {
+        size_t n = std::min(kIoBatch, m_packetsInFlight.size() - sent);
+        memset(msgs, 0, sizeof(struct mmsghdr) * n);
+        for (size_t i = 0; i < n; i++) {
+            Buffer& packet = m_packetsInFlight[sent + i];
+            iovs[i].iov_base = packet.data();
+            iovs[i].iov_len = packet.size();
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
 
-    assert(m_udpSocket);
-    assert(m_remoteUdpPort);
-    ELOG_DEBUG("Send to remote udp port %d->%d", m_localUdpPort, m_remoteUdpPort);
+        int ret = sendmmsg(fd, msgs, n, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                blocked = true;
+                break;
+            }
+            ELOG_WARN("sendmmsg error: %s", strerror(errno));
+            m_listener->onTransportError();
+            // Drop the datagram that failed, SCTP retransmits
+            ret = 1;
+        }
+        sent += ret;
+    }
 
-    m_udpSocket->async_send(boost::asio::buffer(data.buffer.get(), data.length),
-        [this] (const boost::system::error_code& ec, std::size_t bytes) {
-            if (ec) {
-                ELOG_WARN("wrote data error: %s", ec.message().c_str());
-                m_listener->onTransportError();
+    {
+        boost::lock_guard<boost::mutex> lock(m_packetMutex);
+        for (size_t i = 0; i < sent; i++) {
+            if (m_packetPool.size() >= kMaxPooledPackets) {
+                break;
             }
+            m_packetsInFlight[i].clear();
+            m_packetPool.push_back(std::move(m_packetsInFlight[i]));
+        }
+        if (blocked) {
+            // Unsent ones go before packets queued meanwhile
+            m_packetQueue.insert(m_packetQueue.begin(),
+                std::make_move_iterator(m_packetsInFlight.begin() + sent),
+                std::make_move_iterator(m_packetsInFlight.end()));
+            m_waitingWritable = true;
+        }
+        m_packetsInFlight.clear();
+    }
 
-            boost::lock_guard<boost::mutex> lock(m_sendQueueMutex);
-            assert(m_sendQueue.size() > 0);
-            m_sendQueue.pop();
+    if (blocked) {
+        waitWritable();
+    }
+}
 
-            if (m_sendQueue.size() > 0)
-                doSend();
+void SctpTransport::waitWritable()
+{
+    std::weak_ptr<bool> alive = m_aliveToken;
+    m_udpSocket->async_send(boost::asio::null_buffers(),
+        [this, alive] (const boost::system::error_code& ec, std::size_t) {
+            if (alive.expired()) {
+                return;
+            }
+            {
+                boost::lock_guard<boost::mutex> lock(m_packetMutex);
+                m_waitingWritable = false;
+            }
+            if (ec == boost::asio::error::operation_aborted) {
+                return;
+            }
+            if (ec) {
+                ELOG_WARN("udp wait writable error: %s", ec.message().c_str());
+            }
+            flushPackets();
         });
 }
 
 void SctpTransport::receiveData()
 {
-    // The receiveData is only called in workThread
-    if (!m_receiveData.buffer)
-        m_receiveData.buffer.reset(new char[m_bufferSize]);
-
+    // The receiveData is only called in IO thread
     assert(m_udpSocket);
     assert(m_remoteUdpPort);
 
     ELOG_DEBUG("!!! %d start udp receive data from:%d", m_localUdpPort, m_remoteUdpPort);
 
-    m_udpSocket->async_receive(boost::asio::buffer(m_receiveData.buffer.get(), m_bufferSize),
-        [this] (const boost::system::error_code& ec, std::size_t bytes) {
+    std::weak_ptr<bool> alive = m_aliveToken;
+    m_udpSocket->async_receive(boost::asio::null_buffers(),
+        [this, alive] (const boost::system::error_code& ec, std::size_t) {
+            if (alive.expired() || ec == boost::asio::error::operation_aborted) {
+                return;
+            }
             if (ec) {
                 ELOG_WARN("udp async receive error:%s", ec.message().c_str());
                 m_listener->onTransportError();
+            } else {
+                readDatagrams();
             }
 
-            // char *dump_buf;
-
-            // if ((dump_buf = usrsctp_dumppacket(m_receiveData.buffer.get(), (size_t)bytes, SCTP_DUMP_INBOUND)) != NULL) {
-            //     ELOG_DEBUG("in dump_buf %s\n", dump_buf);
-            //     usrsctp_freedumpbuffer(dump_buf);
-            // }
-
-            // Pass received udp packets back to usrsctp
-            usrsctp_conninput(this, m_receiveData.buffer.get(), (size_t)bytes, 0);
-
             // Continue to receive
             receiveData();
         });
 }
 
+void SctpTransport::readDatagrams()
+{
+    if (m_receiveSlots.empty()) {
+        m_receiveSlots.resize(kIoBatch * m_bufferSize);
+    }
+
+    const int fd = m_udpSocket->native_handle();
+    struct mmsghdr msgs[kIoBatch];
+    struct iovec iovs[kIoBatch];
+
+    for (int round = 0; round < kMaxReadRounds; round++) {
+        memset(msgs, 0, sizeof(msgs));
+        for (size_t i = 0; i < kIoBatch; i++) {
+            iovs[i].iov_base = m_receiveSlots.data() + i * m_bufferSize;
+            iovs[i].iov_len = m_bufferSize;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int ret = recvmmsg(fd, msgs, kIoBatch, MSG_DONTWAIT, NULL);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ELOG_WARN("recvmmsg error: %s", strerror(errno));
+                m_listener->onTransportError();
+            }
+            return;
+        }
+
+        // Pass received udp packets back to usrsctp
+        for (int i = 0; i < ret; i++) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                ELOG_WARN_RATE(10, "Drop truncated udp datagram, slot size %zu", m_bufferSize);
+                continue;
+            }
+            usrsctp_conninput(this, iovs[i].iov_base, msgs[i].msg_len, 0);
+        }
+
+        if (ret < static_cast<int>(kIoBatch)) {
+            return;
+        }
+    }
+}
+
 void SctpTransport::processPacket(const char* data, int len, uint32_t tsn)
 {
     // Called in usrsctp's receive callback thread
@@ -580,7 +741,7 @@ void SctpTransport::processPacket(const char* data, int len, uint32_t tsn)
 
     const int INT_SIZE = sizeof(uint32_t);
     if (len < INT_SIZE) {
-        ELOG_ERROR("Packet with length less than %d is incorrect, drop it, length:%d", INT_SIZE, len);
+        ELOG_ERROR_RATE(10, "Packet with length less than %d is incorrect, drop it, length:%d", INT_SIZE, len);
         return;
     }
 
@@ -687,30 +848,29 @@ void SctpTransport::sendData(const char* header, int headerLength, const char* d
         return;
     }
 
-    TransportData tData;
+    const size_t total = headerLength + len + (m_tag ? INT_SIZE : 0);
+
+    boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
+    // One copy into a pooled buffer, usrsctp_sendv takes a single buffer
+    Buffer message;
+    if (!m_messagePool.empty()) {
+        message.swap(m_messagePool.back());
+        m_messagePool.pop_back();
+    }
+    message.reserve(total);
     if (m_tag) {
-        tData.buffer.reset(new char[headerLength + len + INT_SIZE]);
         uint32_t msglen = htonl(headerLength + len);
-        memcpy(tData.buffer.get(), &msglen, INT_SIZE);
-        if (headerLength) {
-            memcpy(tData.buffer.get() + INT_SIZE, header, headerLength);
-        }
-        memcpy(tData.buffer.get() + INT_SIZE + headerLength, data, len);
-        tData.length = headerLength + len + INT_SIZE;
-    } else {
-        tData.buffer.reset(new char[headerLength + len]);
-        if (headerLength) {
-            memcpy(tData.buffer.get(), header, headerLength);
-        }
-        memcpy(tData.buffer.get() + headerLength, data, len);
-        memcpy(tData.buffer.get(), data, len);
-        tData.length = headerLength + len;
+        const char* prefix = reinterpret_cast<const char*>(&msglen);
+        message.insert(message.end(), prefix, prefix + INT_SIZE);
+    }
+    if (headerLength) {
+        message.insert(message.end(), header, header + headerLength);
     }
+    message.insert(message.end(), data, data + len);
 
-    ELOG_DEBUG("SCTP send length: %d", tData.length);
+    ELOG_DEBUG("SCTP send length: %zu", message.size());
 
-    boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
-    m_sendBuffer.push(tData);
+    m_sendBuffer.push_back(std::move(message));
     trySending();
 }
 
@@ -719,62 +879,98 @@ void SctpTransport::trySending() {
     if (!m_sending || !m_ready || m_isClosing)
         return;
 
-    if (m_sendBuffer.empty())
+    if (m_sendBuffer.empty() || m_drainScheduled)
         return;
 
-    TransportData& tData = m_sendBuffer.front();
+    // Make sending all in IO thread, one wakeup drains the buffer
+    m_drainScheduled = true;
+    std::weak_ptr<bool> alive = m_aliveToken;
+    m_ioService->service().post([this, alive]() {
+        if (!alive.expired()) {
+            drainSendBuffer();
+        }
+    });
+}
 
-    // Make sending all in senderThread
-    m_senderService.post([this, tData]() {
-        // Send data using SCTP.
-        struct sctp_sndinfo sndinfo;
-        sndinfo.snd_sid = 1;
-        sndinfo.snd_flags = 0;
-        sndinfo.snd_ppid = htonl(233);
-        sndinfo.snd_context = 0;
-        sndinfo.snd_assoc_id = 0;
+void SctpTransport::drainSendBuffer()
+{
+    // Send data using SCTP.
+    struct sctp_sndinfo sndinfo;
+    sndinfo.snd_sid = 1;
+    sndinfo.snd_flags = 0;
+    sndinfo.snd_ppid = htonl(233);
+    sndinfo.snd_context = 0;
+    sndinfo.snd_assoc_id = 0;
+
+    Buffer message;
+    for (int count = 0; ; count++) {
+        {
+            boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
+            if (!m_sending || !m_ready || m_isClosing || m_sendBuffer.empty()) {
+                m_drainScheduled = false;
+                return;
+            }
+            if (count == kMaxDrainPerWakeup) {
+                // Let other transports on this thread run
+                m_drainScheduled = false;
+                trySending();
+                return;
+            }
+            message.swap(m_sendBuffer.front());
+            m_sendBuffer.pop_front();
+        }
 
+        // usrsctp may call back into onSctpOutboundPacket from here, no lock held
         int send_res = usrsctp_sendv(
-            m_sctpSocket, tData.buffer.get(), static_cast<size_t>(tData.length), NULL, 0, &sndinfo,
+            m_sctpSocket, message.data(), message.size(), NULL, 0, &sndinfo,
             static_cast<socklen_t>(sizeof(struct sctp_sndinfo)), SCTP_SENDV_SNDINFO, 0);
-        if (send_res < 0) {
-            if (errno == SCTP_EWOULDBLOCK) {
-                ELOG_WARN("usrsctp_sendv: EWOULDBLOCK returned");
+        int send_errno = errno;
+
+        if (send_res < 0 && send_errno == SCTP_EWOULDBLOCK) {
+            ELOG_WARN("usrsctp_sendv: EWOULDBLOCK returned");
 
+            {
+                boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
+                // Retried on SCTP_SENDER_DRY_EVENT
+                m_sendBuffer.push_front(std::move(message));
                 m_sending = false;
+                m_drainScheduled = false;
+            }
 
-                // Double the send buffer size
-                int sndbufsize = MAX_MSGSIZE;
-                int intlen = sizeof(int);
-                if (usrsctp_getsockopt(m_sctpSocket, SOL_SOCKET, SO_SNDBUF, &sndbufsize,
-                                       (socklen_t *)&intlen) < 0) {
-                    ELOG_INFO("usrsctp_getsockopt: Can not get SNDBUF");
-                } else {
-                    ELOG_DEBUG("Send buffer size origin: %d", sndbufsize);
-                    if (sndbufsize < MAX_MSGSIZE * 16) {
-                        sndbufsize *= 2;
-                        if (usrsctp_setsockopt(m_sctpSocket, SOL_SOCKET, SO_SNDBUF, &sndbufsize,
-                                               sizeof(int)) < 0) {
-                            ELOG_WARN("SCTP set SO_SNDBUF fail.");
-                        }
-                    } else {
-                        ELOG_WARN("Send buffer size already max.");
+            // Double the send buffer size
+            int sndbufsize = MAX_MSGSIZE;
+            int intlen = sizeof(int);
+            if (usrsctp_getsockopt(m_sctpSocket, SOL_SOCKET, SO_SNDBUF, &sndbufsize,
+                                   (socklen_t *)&intlen) < 0) {
+                ELOG_INFO("usrsctp_getsockopt: Can not get SNDBUF");
+            } else {
+                ELOG_DEBUG("Send buffer size origin: %d", sndbufsize);
+                if (sndbufsize < MAX_MSGSIZE * 16) {
+                    sndbufsize *= 2;
+                    if (usrsctp_setsockopt(m_sctpSocket, SOL_SOCKET, SO_SNDBUF, &sndbufsize,
+                                           sizeof(int)) < 0) {
+                        ELOG_WARN("SCTP set SO_SNDBUF fail.");
                     }
-                    ELOG_DEBUG("Send buffer size after: %d", sndbufsize);
+                } else {
+                    ELOG_WARN("Send buffer size already max.");
                 }
-
-            } else {
-                ELOG_ERROR("usrsctp_sendv: %d", errno);
+                ELOG_DEBUG("Send buffer size after: %d", sndbufsize);
             }
-        } else {
-            boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
-            assert(m_sendBuffer.size() > 0);
-            m_sendBuffer.pop();
+            return;
+        }
 
-            if (m_sendBuffer.size() > 0)
-                trySending();
+        if (send_res < 0) {
+            ELOG_ERROR("usrsctp_sendv: %d, drop message", send_errno);
         }
-    });
+
+        boost::lock_guard<boost::mutex> lock(m_sendBufferMutex);
+        if (m_messagePool.size() < kMaxPooledMessages
+                && message.capacity() <= kMaxPooledMessageSize) {
+            message.clear();
+            m_messagePool.push_back(std::move(message));
+        }
+        message = Buffer();
+    }
 }
 
 
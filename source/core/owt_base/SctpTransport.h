@@ -12,7 +12,10 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/atomic.hpp>
 #include <logger.h>
-#include <queue>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "IOService.h"
 #include "RawTransport.h"
 #include "usrsctp.h"
 
@@ -51,11 +54,17 @@ private:
     void startSctpConnection();
 
     void postPacket(const char* buf, int len);
-    void doSend();
+    void flushPackets();
+    void waitWritable();
     void receiveData();
+    void readDatagrams();
     void processPacket(const char* data, int len, uint32_t tsn);
 
     void trySending();
+    void drainSendBuffer();
+
+    // Runs task on the IO thread and waits for it
+    void runOnIOService(std::function<void()> task);
 
     bool m_isClosing;
 
@@ -74,8 +83,10 @@ private:
         unsigned int length;
     } TransportData;
 
-    // Receive data buffer
-    TransportData m_receiveData;
+    typedef std::vector<char> Buffer;
+
+    // Receive slots for one recvmmsg batch
+    std::vector<char> m_receiveSlots;
     size_t m_bufferSize;
 
     // Fragments buffer
@@ -84,23 +95,29 @@ private:
     uint32_t m_receivedBytes;
     uint32_t m_currentTsn;
 
-    // Send queue data for packet
-    std::queue<TransportData> m_sendQueue;
-    boost::mutex m_sendQueueMutex;
-
-    boost::thread m_workThread;
-
-    boost::asio::io_service m_ioService;
+    // Datagrams from usrsctp waiting for sendmmsg, filled from usrsctp threads
+    std::vector<Buffer> m_packetQueue;
+    std::vector<Buffer> m_packetsInFlight;
+    std::vector<Buffer> m_packetPool;
+    boost::mutex m_packetMutex;
+    bool m_flushScheduled;
+    bool m_waitingWritable;
+    bool m_udpConnected;
+
+    // Shared IO thread running UDP and usrsctp sends of this transport
+    std::shared_ptr<IOService> m_ioService;
+    // Handlers queued on the shared thread check it before touching this
+    std::shared_ptr<bool> m_alive;
+    std::weak_ptr<bool> m_aliveToken;
     boost::scoped_ptr<boost::asio::ip::udp::socket> m_udpSocket;
     struct socket* m_sctpSocket;
 
-    // Send queue data for buffer
+    // Messages waiting for usrsctp_sendv
     boost::atomic<bool> m_sending;
-    boost::thread m_senderThread;
-    std::queue<TransportData> m_sendBuffer;
+    std::deque<Buffer> m_sendBuffer;
+    std::vector<Buffer> m_messagePool;
     boost::mutex m_sendBufferMutex;
-    boost::asio::io_service m_senderService;
-    boost::scoped_ptr<boost::asio::io_service::work> m_work;
+    bool m_drainScheduled;
 
     RawTransportListener* m_listener;
 };
@@ -0,0 +1,82 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "StreamStatsRing.h"
+
+#include <algorithm>
+
+namespace owt_base {
+
+// Enough for several seconds of per second records of a large agent
+static const size_t kRingCapacity = 16384;
+
+DEFINE_LOGGER(StreamStatsRing, "owt.StreamStatsRing");
+
+StreamStatsRing* StreamStatsRing::get()
+{
+    static StreamStatsRing ring(kRingCapacity);
+    return &ring;
+}
+
+StreamStatsRing::StreamStatsRing(size_t capacity)
+    : m_nextStatsId(0)
+    , m_subscriptions(0)
+    , m_records(capacity)
+    , m_head(0)
+    , m_size(0)
+    , m_overwritten(0)
+{
+}
+
+void StreamStatsRing::subscribe(uint32_t statsId)
+{
+    boost::mutex::scoped_lock lock(m_subscribeMutex);
+    m_subscribed.insert(statsId);
+    m_subscriptions = m_subscribed.size();
+}
+
+void StreamStatsRing::unsubscribe(uint32_t statsId)
+{
+    boost::mutex::scoped_lock lock(m_subscribeMutex);
+    m_subscribed.erase(statsId);
+    m_subscriptions = m_subscribed.size();
+}
+
+bool StreamStatsRing::isSubscribed(uint32_t statsId)
+{
+    if (m_subscriptions == 0) {
+        return false;
+    }
+    boost::mutex::scoped_lock lock(m_subscribeMutex);
+    return m_subscribed.count(statsId) > 0;
+}
+
+void StreamStatsRing::write(const StreamStatsRecord& record)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    size_t tail = (m_head + m_size) % m_records.size();
+    m_records[tail] = record;
+    if (m_size < m_records.size()) {
+        m_size++;
+    } else {
+        m_head = (m_head + 1) % m_records.size();
+        if (m_overwritten++ == 0) {
+            ELOG_WARN("Stats reader falls behind, overwriting records");
+        }
+    }
+}
+
+size_t StreamStatsRing::read(StreamStatsRecord* out, size_t maxRecords)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    size_t count = std::min(maxRecords, m_size);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = m_records[(m_head + i) % m_records.size()];
+    }
+    m_head = (m_head + count) % m_records.size();
+    m_size -= count;
+    return count;
+}
+
+} /* namespace owt_base */
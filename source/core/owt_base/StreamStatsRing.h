@@ -0,0 +1,89 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef StreamStatsRing_h
+#define StreamStatsRing_h
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <logger.h>
+
+namespace owt_base {
+
+enum StreamStatsKind {
+    STREAM_STATS_VIDEO_IN = 1,
+};
+
+/**
+ * Fixed layout stats record, read as is by the JS side, do not reorder
+ * fields without updating agent/webrtc/streamStats.js.
+ */
+struct StreamStatsRecord {
+    uint32_t statsId;
+    uint32_t kind;
+    uint64_t timestampMs;
+    uint32_t bitrateKbps;
+    uint32_t frameRate;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t packetsReceived;
+    uint32_t packetsLost;
+    uint32_t fractionLost;      // Q8 of the last interval
+    uint32_t jitterMs;
+    uint32_t rttMs;
+    uint32_t keyFrameRequests;  // PLI and FIR sent
+    uint32_t reserved;
+};
+
+static_assert(sizeof(StreamStatsRecord) == 64, "StreamStatsRecord layout changed");
+
+/**
+ * Process wide ring of stats records, streams write periodically and
+ * the addon reads them in batches. The oldest records are overwritten
+ * if the reader falls behind.
+ */
+class StreamStatsRing {
+    DECLARE_LOGGER();
+
+public:
+    static StreamStatsRing* get();
+
+    uint32_t registerStream() { return ++m_nextStatsId; }
+
+    // Streams write records only while a reader is subscribed to them
+    void subscribe(uint32_t statsId);
+    void unsubscribe(uint32_t statsId);
+    bool isSubscribed(uint32_t statsId);
+
+    void write(const StreamStatsRecord& record);
+    // Returns number of records copied to out
+    size_t read(StreamStatsRecord* out, size_t maxRecords);
+
+    uint64_t overwrittenCount() const { return m_overwritten; }
+
+protected:
+    StreamStatsRing(size_t capacity);
+
+private:
+    std::atomic<uint32_t> m_nextStatsId;
+
+    boost::mutex m_subscribeMutex;
+    std::set<uint32_t> m_subscribed;
+    // Size of m_subscribed, checked without the lock
+    std::atomic<size_t> m_subscriptions;
+
+    boost::mutex m_mutex;
+    std::vector<StreamStatsRecord> m_records;
+    size_t m_head;
+    size_t m_size;
+    std::atomic<uint64_t> m_overwritten;
+};
+
+} /* namespace owt_base */
+
+#endif /* StreamStatsRing_h */
@@ -0,0 +1,153 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE StreamStatsRing
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstring>
+#include <set>
+
+#include "StreamStatsRing.h"
+
+using owt_base::StreamStatsRecord;
+
+class TestRing : public owt_base::StreamStatsRing {
+public:
+    TestRing(size_t capacity) : StreamStatsRing(capacity) {}
+};
+
+static StreamStatsRecord makeRecord(uint32_t statsId, uint64_t timestampMs)
+{
+    StreamStatsRecord record;
+    memset(&record, 0, sizeof(record));
+    record.statsId = statsId;
+    record.kind = owt_base::STREAM_STATS_VIDEO_IN;
+    record.timestampMs = timestampMs;
+    return record;
+}
+
+BOOST_AUTO_TEST_SUITE(Ring)
+
+BOOST_AUTO_TEST_CASE(EmptyRead)
+{
+    TestRing ring(4);
+    StreamStatsRecord out[4];
+    BOOST_CHECK_EQUAL(ring.read(out, 4), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(ReadInWriteOrder)
+{
+    TestRing ring(8);
+    for (uint32_t i = 1; i <= 3; i++) {
+        ring.write(makeRecord(i, i * 1000));
+    }
+
+    StreamStatsRecord out[8];
+    BOOST_REQUIRE_EQUAL(ring.read(out, 8), 3u);
+    for (uint32_t i = 0; i < 3; i++) {
+        BOOST_CHECK_EQUAL(out[i].statsId, i + 1);
+        BOOST_CHECK_EQUAL(out[i].timestampMs, (i + 1) * 1000u);
+    }
+    BOOST_CHECK_EQUAL(ring.read(out, 8), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(PartialReads)
+{
+    TestRing ring(8);
+    for (uint32_t i = 1; i <= 5; i++) {
+        ring.write(makeRecord(i, i));
+    }
+
+    StreamStatsRecord out[8];
+    BOOST_REQUIRE_EQUAL(ring.read(out, 2), 2u);
+    BOOST_CHECK_EQUAL(out[0].statsId, 1u);
+    BOOST_CHECK_EQUAL(out[1].statsId, 2u);
+
+    // Wraps past the end of the storage
+    for (uint32_t i = 6; i <= 9; i++) {
+        ring.write(makeRecord(i, i));
+    }
+    BOOST_REQUIRE_EQUAL(ring.read(out, 8), 7u);
+    for (uint32_t i = 0; i < 7; i++) {
+        BOOST_CHECK_EQUAL(out[i].statsId, i + 3);
+    }
+    BOOST_CHECK_EQUAL(ring.overwrittenCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(OverwriteOldest)
+{
+    TestRing ring(4);
+    for (uint32_t i = 1; i <= 6; i++) {
+        ring.write(makeRecord(i, i));
+    }
+    BOOST_CHECK_EQUAL(ring.overwrittenCount(), 2u);
+
+    StreamStatsRecord out[4];
+    BOOST_REQUIRE_EQUAL(ring.read(out, 4), 4u);
+    for (uint32_t i = 0; i < 4; i++) {
+        BOOST_CHECK_EQUAL(out[i].statsId, i + 3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UniqueStatsIds)
+{
+    TestRing ring(4);
+    std::set<uint32_t> ids;
+    for (int i = 0; i < 100; i++) {
+        uint32_t id = ring.registerStream();
+        BOOST_CHECK(id != 0);
+        ids.insert(id);
+    }
+    BOOST_CHECK_EQUAL(ids.size(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentWriters)
+{
+    const uint32_t kWriters = 4;
+    const uint32_t kRecords = 1000;
+    TestRing ring(kWriters * kRecords);
+
+    boost::thread_group writers;
+    for (uint32_t w = 1; w <= kWriters; w++) {
+        writers.create_thread([&ring, w, kRecords]() {
+            for (uint32_t i = 0; i < kRecords; i++) {
+                ring.write(makeRecord(w, i));
+            }
+        });
+    }
+    writers.join_all();
+
+    // Every record arrives once and per writer order is kept
+    std::vector<StreamStatsRecord> out(kWriters * kRecords);
+    BOOST_REQUIRE_EQUAL(ring.read(out.data(), out.size()), out.size());
+    std::vector<uint64_t> next(kWriters + 1, 0);
+    for (auto& record : out) {
+        BOOST_REQUIRE(record.statsId >= 1 && record.statsId <= kWriters);
+        BOOST_CHECK_EQUAL(record.timestampMs, next[record.statsId]++);
+    }
+    BOOST_CHECK_EQUAL(ring.overwrittenCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Subscriptions)
+{
+    TestRing ring(4);
+    uint32_t first = ring.registerStream();
+    uint32_t second = ring.registerStream();
+    BOOST_CHECK(!ring.isSubscribed(first));
+    BOOST_CHECK(!ring.isSubscribed(second));
+
+    ring.subscribe(first);
+    ring.subscribe(first);
+    BOOST_CHECK(ring.isSubscribed(first));
+    BOOST_CHECK(!ring.isSubscribed(second));
+
+    ring.subscribe(second);
+    ring.unsubscribe(first);
+    BOOST_CHECK(!ring.isSubscribed(first));
+    BOOST_CHECK(ring.isSubscribed(second));
+
+    ring.unsubscribe(second);
+    ring.unsubscribe(second);
+    BOOST_CHECK(!ring.isSubscribed(second));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,24 @@
 
 #include "TaskRunnerPool.h"
 
+#include <algorithm>
+#include <boost/thread.hpp>
+#include <cstdlib>
+
 namespace owt_base {
 
-static constexpr int kTaskRunnerPoolSize = 4;
+static constexpr uint32_t kMinTaskRunnerNum = 4;
+static constexpr uint32_t kMaxTaskRunnerNum = 16;
+
+static uint32_t taskRunnerNum()
+{
+    const char* env = std::getenv("OWT_TASK_RUNNERS");
+    if (env && std::atoi(env) > 0) {
+        return std::min<uint32_t>(std::atoi(env), kMaxTaskRunnerNum);
+    }
+    uint32_t cores = boost::thread::hardware_concurrency();
+    return std::min(std::max(cores / 2, kMinTaskRunnerNum), kMaxTaskRunnerNum);
+}
 
 TaskRunnerPool& TaskRunnerPool::GetInstance()
 {
@@ -16,15 +31,29 @@ TaskRunnerPool& TaskRunnerPool::GetInstance()
 
 boost::shared_ptr<WebRTCTaskRunner> TaskRunnerPool::GetTaskRunner()
 {
-    // This function would always be called in Node's main thread
-    boost::shared_ptr<WebRTCTaskRunner> runner = m_taskRunners[m_nextRunner];
-    m_nextRunner = (m_nextRunner + 1) % m_taskRunners.size();
-    return runner;
+    // This function would always be called in Node's main thread.
+    // ProcessThread doesn't expose its thread, so the load is the number of users.
+    size_t best = 0;
+    for (size_t i = 1; i < m_taskRunners.size(); i++) {
+        if (m_taskRunners[i].use_count() < m_taskRunners[best].use_count()) {
+            best = i;
+        }
+    }
+    return m_taskRunners[best];
+}
+
+std::vector<long> TaskRunnerPool::GetTaskRunnerUsers()
+{
+    std::vector<long> users;
+    for (auto& runner : m_taskRunners) {
+        // The pool holds one reference
+        users.push_back(runner.use_count() - 1);
+    }
+    return users;
 }
 
 TaskRunnerPool::TaskRunnerPool()
-    : m_nextRunner(0)
-    , m_taskRunners(kTaskRunnerPoolSize)
+    : m_taskRunners(taskRunnerNum())
 {
     for (size_t i = 0; i < m_taskRunners.size(); i++) {
         m_taskRunners[i].reset(new WebRTCTaskRunner("TaskRunner"));
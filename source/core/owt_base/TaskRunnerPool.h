@@ -12,19 +12,20 @@
 namespace owt_base {
 
 /**
- * `TaskRunnerPool` contains a fixed number of TaskRunners,
- * `GetTaskRunner` function will get one with round robin.
+ * `TaskRunnerPool` contains a number of TaskRunners sized from available cores,
+ * `GetTaskRunner` function will get the one with the fewest users.
  */
 class TaskRunnerPool {
 public:
     static TaskRunnerPool& GetInstance();
     boost::shared_ptr<WebRTCTaskRunner> GetTaskRunner();
+    // Users holding each TaskRunner
+    std::vector<long> GetTaskRunnerUsers();
 
 private:
     TaskRunnerPool();
     ~TaskRunnerPool();
 
-    int m_nextRunner;
     std::vector<boost::shared_ptr<WebRTCTaskRunner> > m_taskRunners;
 };
 
@@ -0,0 +1,408 @@
+// Copyright (C) <2019> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TextAtlas.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <strings.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace owt_base {
+
+DEFINE_LOGGER(TextAtlas, "owt.TextAtlas");
+
+static const char kDefaultFontFile[] = "/usr/share/fonts/gnu-free/FreeSerif.ttf"; //centos, same as drawtext filter
+static const int kDefaultFontSize = 16;
+
+static const struct {
+    const char *name;
+    uint8_t rgb[3];
+} kColorNames[] = {
+    {"black",   {0x00, 0x00, 0x00}},
+    {"white",   {0xff, 0xff, 0xff}},
+    {"red",     {0xff, 0x00, 0x00}},
+    {"green",   {0x00, 0x80, 0x00}},
+    {"lime",    {0x00, 0xff, 0x00}},
+    {"blue",    {0x00, 0x00, 0xff}},
+    {"yellow",  {0xff, 0xff, 0x00}},
+    {"cyan",    {0x00, 0xff, 0xff}},
+    {"magenta", {0xff, 0x00, 0xff}},
+    {"gray",    {0x80, 0x80, 0x80}},
+    {"grey",    {0x80, 0x80, 0x80}},
+    {"orange",  {0xff, 0xa5, 0x00}},
+};
+
+static std::vector<uint32_t> decodeUtf8(const std::string& text)
+{
+    std::vector<uint32_t> codes;
+
+    for (size_t i = 0; i < text.size();) {
+        uint8_t c = text[i];
+        uint32_t code;
+        size_t n;
+
+        if (c < 0x80) {
+            code = c;
+            n = 1;
+        } else if ((c & 0xe0) == 0xc0) {
+            code = c & 0x1f;
+            n = 2;
+        } else if ((c & 0xf0) == 0xe0) {
+            code = c & 0x0f;
+            n = 3;
+        } else if ((c & 0xf8) == 0xf0) {
+            code = c & 0x07;
+            n = 4;
+        } else {
+            i++;
+            continue;
+        }
+
+        if (i + n > text.size())
+            break;
+
+        for (size_t k = 1; k < n; k++)
+            code = (code << 6) | (text[i + k] & 0x3f);
+
+        codes.push_back(code);
+        i += n;
+    }
+
+    return codes;
+}
+
+static inline void blendRow(uint8_t *dst, const uint8_t *mask, int length, uint8_t color)
+{
+    for (int i = 0; i < length; i++) {
+        int a = mask[i] + (mask[i] >> 7);
+        dst[i] = dst[i] + (((color - dst[i]) * a) >> 8);
+    }
+}
+
+TextAtlas::TextAtlas()
+    : m_fontFile(kDefaultFontFile)
+    , m_fontSize(kDefaultFontSize)
+    , m_x(0)
+    , m_y(0)
+    , m_colorY(16)
+    , m_colorU(128)
+    , m_colorV(128)
+    , m_alpha(255)
+    , m_width(0)
+    , m_height(0)
+{
+}
+
+TextAtlas::~TextAtlas()
+{
+}
+
+TextAtlas* TextAtlas::create(const std::string& spec)
+{
+    TextAtlas *atlas = new TextAtlas();
+
+    if (!atlas->parse(spec) || !atlas->rasterize()) {
+        delete atlas;
+        return NULL;
+    }
+
+    ELOG_DEBUG("create: %dx%d at (%d, %d), spec: %s", atlas->m_width, atlas->m_height, atlas->m_x, atlas->m_y, spec.c_str());
+    return atlas;
+}
+
+bool TextAtlas::parseOptions(const std::string& spec, std::map<std::string, std::string>& options)
+{
+    std::string key;
+    std::string value;
+    bool inKey = true;
+    bool quoted = false;
+
+    for (size_t i = 0; i < spec.size(); i++) {
+        char c = spec[i];
+        std::string& token = inKey ? key : value;
+
+        if (quoted) {
+            if (c == '\'')
+                quoted = false;
+            else
+                token += c;
+        } else if (c == '\'') {
+            quoted = true;
+        } else if (c == '\\' && i + 1 < spec.size()) {
+            token += spec[++i];
+        } else if (c == '=' && inKey) {
+            inKey = false;
+        } else if (c == ':') {
+            if (key.empty())
+                return false;
+
+            options[key] = value;
+            key.clear();
+            value.clear();
+            inKey = true;
+        } else {
+            token += c;
+        }
+    }
+
+    if (quoted)
+        return false;
+
+    if (!key.empty())
+        options[key] = value;
+
+    return true;
+}
+
+bool TextAtlas::parseInt(const std::string& value, int *out)
+{
+    char *end = NULL;
+    long n;
+
+    if (value.empty())
+        return false;
+
+    n = strtol(value.c_str(), &end, 10);
+    if (*end != '\0')
+        return false;
+
+    *out = n;
+    return true;
+}
+
+bool TextAtlas::parseColor(const std::string& value, uint8_t rgba[4])
+{
+    std::string color = value;
+    size_t at = color.find('@');
+
+    rgba[3] = 0xff;
+    if (at != std::string::npos) {
+        char *end = NULL;
+        double alpha = strtod(color.c_str() + at + 1, &end);
+        if (*end != '\0' || alpha < 0 || alpha > 1)
+            return false;
+
+        rgba[3] = alpha * 255 + 0.5;
+        color = color.substr(0, at);
+    }
+
+    for (auto& named : kColorNames) {
+        if (strcasecmp(color.c_str(), named.name) == 0) {
+            rgba[0] = named.rgb[0];
+            rgba[1] = named.rgb[1];
+            rgba[2] = named.rgb[2];
+            return true;
+        }
+    }
+
+    if (color.compare(0, 2, "0x") == 0 || color.compare(0, 2, "0X") == 0)
+        color = color.substr(2);
+    else if (color.compare(0, 1, "#") == 0)
+        color = color.substr(1);
+
+    if (color.size() != 6 && color.size() != 8)
+        return false;
+
+    char *end = NULL;
+    unsigned long hex = strtoul(color.c_str(), &end, 16);
+    if (*end != '\0')
+        return false;
+
+    if (color.size() == 8) {
+        rgba[3] = hex & 0xff;
+        hex >>= 8;
+    }
+    rgba[0] = (hex >> 16) & 0xff;
+    rgba[1] = (hex >> 8) & 0xff;
+    rgba[2] = hex & 0xff;
+    return true;
+}
+
+bool TextAtlas::parse(const std::string& spec)
+{
+    std::map<std::string, std::string> options;
+    uint8_t rgba[4] = {0, 0, 0, 0xff};
+
+    if (!parseOptions(spec, options)) {
+        ELOG_DEBUG("Invalid spec: %s", spec.c_str());
+        return false;
+    }
+
+    for (auto& option : options) {
+        const std::string& key = option.first;
+        const std::string& value = option.second;
+        bool valid = true;
+
+        if (key == "text") {
+            // Text expansion is left to the filter
+            valid = (value.find('%') == std::string::npos);
+            m_text = value;
+        } else if (key == "fontfile") {
+            m_fontFile = value;
+        } else if (key == "fontsize") {
+            valid = parseInt(value, &m_fontSize) && m_fontSize > 0;
+        } else if (key == "fontcolor") {
+            valid = parseColor(value, rgba);
+        } else if (key == "x") {
+            valid = parseInt(value, &m_x);
+        } else if (key == "y") {
+            valid = parseInt(value, &m_y);
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            ELOG_DEBUG("Option not expressible by atlas, %s=%s", key.c_str(), value.c_str());
+            return false;
+        }
+    }
+
+    // Even position keeps the chroma mask aligned
+    m_x = std::max(m_x, 0) & ~1;
+    m_y = std::max(m_y, 0) & ~1;
+
+    m_colorY = ((66 * rgba[0] + 129 * rgba[1] + 25 * rgba[2] + 128) >> 8) + 16;
+    m_colorU = ((-38 * rgba[0] - 74 * rgba[1] + 112 * rgba[2] + 128) >> 8) + 128;
+    m_colorV = ((112 * rgba[0] - 94 * rgba[1] - 18 * rgba[2] + 128) >> 8) + 128;
+    m_alpha = rgba[3];
+
+    return true;
+}
+
+bool TextAtlas::rasterize()
+{
+    FT_Library library;
+    FT_Face face;
+    std::vector<uint32_t> codes = decodeUtf8(m_text);
+
+    if (FT_Init_FreeType(&library)) {
+        ELOG_ERROR("Cannot init freetype");
+        return false;
+    }
+
+    if (FT_New_Face(library, m_fontFile.c_str(), 0, &face)) {
+        ELOG_ERROR("Cannot load font: %s", m_fontFile.c_str());
+        FT_Done_FreeType(library);
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(face, 0, m_fontSize);
+
+    int ascent = face->size->metrics.ascender >> 6;
+    int lineHeight = face->size->metrics.height >> 6;
+    int lines = 1;
+    int lineWidth = 0;
+    int maxWidth = 0;
+
+    for (uint32_t code : codes) {
+        if (code == '\n') {
+            maxWidth = std::max(maxWidth, lineWidth);
+            lineWidth = 0;
+            lines++;
+            continue;
+        }
+
+        if (FT_Load_Char(face, code, FT_LOAD_DEFAULT))
+            continue;
+
+        lineWidth += face->glyph->advance.x >> 6;
+    }
+    maxWidth = std::max(maxWidth, lineWidth);
+
+    m_width = (maxWidth + 1) & ~1;
+    m_height = (lineHeight * lines + 1) & ~1;
+    m_mask.assign(m_width * m_height, 0);
+
+    int penX = 0;
+    int baseline = ascent;
+    for (uint32_t code : codes) {
+        if (code == '\n') {
+            penX = 0;
+            baseline += lineHeight;
+            continue;
+        }
+
+        if (FT_Load_Char(face, code, FT_LOAD_RENDER))
+            continue;
+
+        FT_GlyphSlot glyph = face->glyph;
+        FT_Bitmap& bitmap = glyph->bitmap;
+        int left = penX + glyph->bitmap_left;
+        int top = baseline - glyph->bitmap_top;
+
+        for (int row = 0; row < (int)bitmap.rows; row++) {
+            int y = top + row;
+            if (y < 0 || y >= m_height)
+                continue;
+
+            for (int col = 0; col < (int)bitmap.width; col++) {
+                int x = left + col;
+                if (x < 0 || x >= m_width)
+                    continue;
+
+                uint8_t value = bitmap.buffer[row * bitmap.pitch + col];
+                uint8_t& dst = m_mask[y * m_width + x];
+                if (value > dst)
+                    dst = value;
+            }
+        }
+
+        penX += glyph->advance.x >> 6;
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    if (m_alpha != 0xff) {
+        for (auto& a : m_mask)
+            a = a * m_alpha / 0xff;
+    }
+
+    int chromaWidth = m_width / 2;
+    int chromaHeight = m_height / 2;
+    m_chromaMask.resize(chromaWidth * chromaHeight);
+    for (int row = 0; row < chromaHeight; row++) {
+        const uint8_t *top = &m_mask[row * 2 * m_width];
+        const uint8_t *bottom = top + m_width;
+
+        for (int col = 0; col < chromaWidth; col++) {
+            m_chromaMask[row * chromaWidth + col] =
+                (top[col * 2] + top[col * 2 + 1] + bottom[col * 2] + bottom[col * 2 + 1] + 2) >> 2;
+        }
+    }
+
+    return true;
+}
+
+void TextAtlas::blend(uint8_t *dataY, int strideY,
+        uint8_t *dataU, int strideU,
+        uint8_t *dataV, int strideV,
+        int width, int height)
+{
+    int w = std::min(m_width, width - m_x);
+    int h = std::min(m_height, height - m_y);
+
+    if (w <= 0 || h <= 0)
+        return;
+
+    for (int row = 0; row < h; row++) {
+        blendRow(dataY + (m_y + row) * strideY + m_x, &m_mask[row * m_width], w, m_colorY);
+    }
+
+    int chromaWidth = m_width / 2;
+    int cw = std::min(chromaWidth, (width + 1) / 2 - m_x / 2);
+    int ch = std::min(m_height / 2, (height + 1) / 2 - m_y / 2);
+
+    for (int row = 0; row < ch; row++) {
+        const uint8_t *mask = &m_chromaMask[row * chromaWidth];
+
+        blendRow(dataU + (m_y / 2 + row) * strideU + m_x / 2, mask, cw, m_colorU);
+        blendRow(dataV + (m_y / 2 + row) * strideV + m_x / 2, mask, cw, m_colorV);
+    }
+}
+
+} /* namespace owt_base */
@@ -0,0 +1,66 @@
+// Copyright (C) <2019> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef TextAtlas_h
+#define TextAtlas_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+
+namespace owt_base {
+
+// Text rasterized once into an alpha mask, blended into writable I420 planes.
+// Only plain drawtext options are expressible, see create().
+class TextAtlas {
+    DECLARE_LOGGER();
+
+public:
+    // Returns NULL if the drawtext spec needs the filter path
+    static TextAtlas* create(const std::string& spec);
+
+    ~TextAtlas();
+
+    int width() {return m_width;}
+    int height() {return m_height;}
+
+    // Touches only the text rectangle, clipped to the frame
+    void blend(uint8_t *dataY, int strideY,
+            uint8_t *dataU, int strideU,
+            uint8_t *dataV, int strideV,
+            int width, int height);
+
+protected:
+    TextAtlas();
+
+    bool parse(const std::string& spec);
+    bool rasterize();
+
+    static bool parseOptions(const std::string& spec, std::map<std::string, std::string>& options);
+    static bool parseColor(const std::string& value, uint8_t rgba[4]);
+    static bool parseInt(const std::string& value, int *out);
+
+private:
+    std::string m_text;
+    std::string m_fontFile;
+    int m_fontSize;
+    int m_x;
+    int m_y;
+
+    uint8_t m_colorY;
+    uint8_t m_colorU;
+    uint8_t m_colorV;
+    uint8_t m_alpha;
+
+    int m_width;
+    int m_height;
+    std::vector<uint8_t> m_mask;
+    std::vector<uint8_t> m_chromaMask;
+};
+
+} /* namespace owt_base */
+
+#endif /* TextAtlas_h */
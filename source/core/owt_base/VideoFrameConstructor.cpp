@@ -4,6 +4,7 @@
 
 #include "VideoFrameConstructor.h"
 
+#include <chrono>
 #include <future>
 #include <random>
 #include <rtputils.h>
@@ -14,13 +15,18 @@ namespace owt_base {
 
 DEFINE_LOGGER(VideoFrameConstructor, "owt.VideoFrameConstructor");
 
+// About one second of frames waiting for destinations
+static const uint32_t kMaxPendingFrames = 30;
+// Interval to look for a less loaded deliver service
+static const std::chrono::seconds kRebalanceInterval(10);
+
 VideoFrameConstructor::VideoFrameConstructor(VideoInfoListener* vil, uint32_t transportccExtId)
     : m_enabled(true)
     , m_ssrc(0)
     , m_transport(nullptr)
     , m_pendingKeyFrameRequests(0)
     , m_videoInfoListener(vil)
-    , m_rtcAdapter(RtcAdapterFactory::CreateRtcAdapter())
+    , m_rtcAdapter(RtcAdapterFactory::GetSharedRtcAdapter())
     , m_videoReceive(nullptr)
 {
     m_config.transport_cc = transportccExtId;
@@ -51,7 +57,7 @@ VideoFrameConstructor::VideoFrameConstructor(KeyFrameRequester* requester)
     , m_transport(nullptr)
     , m_pendingKeyFrameRequests(0)
     , m_videoInfoListener(nullptr)
-    , m_rtcAdapter(RtcAdapterFactory::CreateRtcAdapter())
+    , m_rtcAdapter(RtcAdapterFactory::GetSharedRtcAdapter())
     , m_videoReceive(nullptr)
     , m_requester(requester)
 {
@@ -62,6 +68,13 @@ VideoFrameConstructor::VideoFrameConstructor(KeyFrameRequester* requester)
 
 VideoFrameConstructor::~VideoFrameConstructor()
 {
+    {
+        boost::mutex::scoped_lock lock(m_deliverMutex);
+        m_closing = true;
+        while (m_pendingFrames > 0) {
+            m_deliverCond.wait(lock);
+        }
+    }
     m_feedbackTimer->removeListener(this);
     unbindTransport();
     if (m_videoReceive) {
@@ -169,11 +182,60 @@ bool VideoFrameConstructor::removeChildProcessor(std::string id)
     return false;
 }
 
-void VideoFrameConstructor::onAdapterFrame(const Frame& frame)
+void VideoFrameConstructor::onAdapterFrame(const Frame& frame,
+                                           std::shared_ptr<rtc_adapter::AdapterFrameBuffer> buffer)
 {
-    if (m_enabled) {
-        deliverFrame(frame);
+    if (!m_enabled) {
+        return;
+    }
+
+    bool idle = false;
+    {
+        boost::mutex::scoped_lock lock(m_deliverMutex);
+        if (m_closing) {
+            return;
+        }
+        idle = (m_pendingFrames == 0);
+        if (m_waitingKeyFrame) {
+            if (!frame.additionalInfo.video.isKeyFrame) {
+                return;
+            }
+            m_waitingKeyFrame = false;
+        }
+        if (m_pendingFrames >= kMaxPendingFrames) {
+            // Destinations fall behind, resume from next key frame
+            ELOG_WARN("Pending frames exceed %u, wait for key frame", kMaxPendingFrames);
+            m_waitingKeyFrame = true;
+        } else {
+            m_pendingFrames++;
+        }
+    }
+
+    if (m_waitingKeyFrame) {
+        RequestKeyFrame();
+        return;
+    }
+
+    // Only this thread adds pending frames, so none is on the old service
+    // when switching and the frame order is kept
+    if (idle && frame.additionalInfo.video.isKeyFrame) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - m_lastRebalance >= kRebalanceInterval) {
+            m_lastRebalance = now;
+            m_deliverService = rebalanceIOService(m_deliverService);
+        }
     }
+
+    // The buffer keeps payload valid until destinations return
+    m_deliverService->post([this, frame, buffer]() {
+        if (m_enabled) {
+            deliverFrame(frame);
+        }
+        boost::mutex::scoped_lock lock(m_deliverMutex);
+        if (--m_pendingFrames == 0) {
+            m_deliverCond.notify_all();
+        }
+    });
 }
 
 void VideoFrameConstructor::onAdapterStats(const AdapterStats& stats)
@@ -189,6 +251,34 @@ void VideoFrameConstructor::onAdapterStats(const AdapterStats& stats)
     }
 }
 
+void VideoFrameConstructor::onAdapterPeriodicStats(const AdapterStats& stats)
+{
+    if (!StreamStatsRing::get()->isSubscribed(m_statsId)) {
+        return;
+    }
+
+    // Binary record for the stats channel, JSON is rendered on JS side on demand
+    StreamStatsRecord record;
+    memset(&record, 0, sizeof(record));
+    record.statsId = m_statsId;
+    record.kind = STREAM_STATS_VIDEO_IN;
+    // Wall clock to be comparable with Date.now() in JS
+    record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.bitrateKbps = stats.bitrateBps / 1000;
+    record.frameRate = stats.frameRate;
+    record.width = stats.width;
+    record.height = stats.height;
+    record.format = stats.format;
+    record.packetsReceived = stats.packetsReceived;
+    record.packetsLost = stats.packetsLost;
+    record.fractionLost = stats.fractionLost;
+    record.jitterMs = stats.jitterMs;
+    record.rttMs = stats.rttMs;
+    record.keyFrameRequests = stats.keyFrameRequests;
+    StreamStatsRing::get()->write(record);
+}
+
 void VideoFrameConstructor::onAdapterData(char* data, int len)
 {
     // Data come from video receive stream is RTCP
@@ -10,12 +10,18 @@
 #include <MediaDefinitionExtra.h>
 #include <MediaDefinitions.h>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <chrono>
 #include <logger.h>
 
+#include <IOService.h>
 #include <JobTimer.h>
 
 #include <RtcAdapter.h>
 
+#include "StreamStatsRing.h"
+
 namespace owt_base {
 
 class VideoInfoListener {
@@ -67,9 +73,11 @@ public:
     void onFeedback(const FeedbackMsg& msg) override;
 
     // Implements the AdapterFrameListener interfaces.
-    void onAdapterFrame(const Frame& frame) override;
+    void onAdapterFrame(const Frame& frame,
+                        std::shared_ptr<rtc_adapter::AdapterFrameBuffer> buffer) override;
     // Implements the AdapterStatsListener interfaces.
     void onAdapterStats(const rtc_adapter::AdapterStats& stats) override;
+    void onAdapterPeriodicStats(const rtc_adapter::AdapterStats& stats) override;
     // Implements the AdapterDataListener interfaces.
     void onAdapterData(char* data, int len) override;
 
@@ -83,6 +91,9 @@ public:
     bool addChildProcessor(std::string id, erizo::MediaSink* sink);
     bool removeChildProcessor(std::string id);
 
+    // Identifies this stream's records in StreamStatsRing
+    uint32_t statsId() const { return m_statsId; }
+
 private:
     Config m_config;
 
@@ -111,6 +122,19 @@ private:
     int m_currentSpatialLayer = -1;
     int m_currentTemporalLayer = -1;
     KeyFrameRequester* m_requester = nullptr;
+
+    // Frames reach destinations on this service instead of the call thread,
+    // one service thread keeps them in order. It may be switched to a less
+    // loaded one only while no frame is pending on it.
+    std::shared_ptr<IOService> m_deliverService = getIOService();
+    std::chrono::steady_clock::time_point m_lastRebalance = std::chrono::steady_clock::now();
+    boost::mutex m_deliverMutex;
+    boost::condition_variable m_deliverCond;
+    uint32_t m_pendingFrames = 0;
+    bool m_closing = false;
+    bool m_waitingKeyFrame = false;
+
+    uint32_t m_statsId = StreamStatsRing::get()->registerStream();
 };
 
 } // namespace owt_base
@@ -31,8 +31,8 @@ VideoFramePacketizer::VideoFramePacketizer(VideoFramePacketizer::Config& config)
 {
     video_sink_ = nullptr;
     if (!m_rtcAdapter) {
-        ELOG_DEBUG("Create RtcAdapter");
-        m_rtcAdapter.reset(RtcAdapterFactory::CreateRtcAdapter());
+        ELOG_DEBUG("Use shared RtcAdapter");
+        m_rtcAdapter = RtcAdapterFactory::GetSharedRtcAdapter();
     }
     if (config.enableBandwidthEstimation) {
         m_feedbackTimer = SharedJobTimer::GetSharedFrequencyTimer(
@@ -129,7 +129,7 @@ void InternalServer::onSessionData(int id, uint8_t* data, uint32_t len)
             }
         }
     } else {
-        ELOG_WARN("Receive unexpected data from:%d", id);
+        ELOG_WARN_RATE(10, "Receive unexpected data from:%d", id);
     }
 }
 
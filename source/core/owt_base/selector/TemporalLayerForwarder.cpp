@@ -0,0 +1,96 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TemporalLayerForwarder.h"
+#include "NalScanner.h"
+
+namespace owt_base {
+
+DEFINE_LOGGER(TemporalLayerForwarder, "owt.TemporalLayerForwarder");
+
+TemporalLayerForwarder::TemporalLayerForwarder(int targetTemporalId)
+    : m_target(targetTemporalId)
+    , m_current(targetTemporalId)
+    , m_keyFrameArrived(false)
+{
+    ELOG_DEBUG("Init with target temporal layer: %d", targetTemporalId);
+}
+
+TemporalLayerForwarder::~TemporalLayerForwarder()
+{
+}
+
+void TemporalLayerForwarder::setTargetTemporalId(int temporalId)
+{
+    ELOG_DEBUG("setTargetTemporalId %d %p", temporalId, this);
+    m_target = temporalId;
+}
+
+void TemporalLayerForwarder::onFrame(const Frame& frame)
+{
+    uint8_t temporalId = frame.additionalInfo.video.temporalId;
+    bool layerSync = frame.additionalInfo.video.layerSync;
+    if (frame.format == FRAME_FORMAT_H264) {
+        // Temporal structure of H.264 SVC is nested, every frame is a switching point
+        layerSync = parseH264TemporalId(frame, temporalId);
+    }
+
+    int target = m_target;
+    if (frame.additionalInfo.video.isKeyFrame) {
+        m_keyFrameArrived = true;
+        m_current = target;
+    } else if (!m_keyFrameArrived) {
+        return;
+    }
+
+    if (m_current > target) {
+        m_current = target;
+    } else if (layerSync && temporalId == m_current + 1 && temporalId <= target) {
+        ELOG_DEBUG("Switch up to temporal layer %d", temporalId);
+        m_current = temporalId;
+    }
+
+    if (temporalId > m_current) {
+        ELOG_TRACE("Drop frame of temporal layer %d", temporalId);
+        return;
+    }
+    deliverFrame(frame);
+}
+
+void TemporalLayerForwarder::onMetaData(const MetaData& metadata)
+{
+    deliverMetaData(metadata);
+}
+
+void TemporalLayerForwarder::onFeedback(const FeedbackMsg& msg)
+{
+    deliverFeedbackMsg(msg);
+}
+
+bool TemporalLayerForwarder::parseH264TemporalId(const Frame& frame, uint8_t& temporalId)
+{
+    const uint8_t* data = frame.payload;
+    size_t size = frame.length;
+    size_t pos = NalScanner::findStartCode(data, size, 0);
+
+    while (pos + 3 < size) {
+        size_t header = pos + 3;
+        uint8_t type = data[header] & 0x1f;
+        if (type == 14 || type == 20) {
+            // Prefix NAL or coded slice extension, 3 bytes nal_unit_header_svc_extension
+            // follow with temporal_id in the top bits of the last one
+            if (header + 3 < size && (data[header + 1] & 0x80)) {
+                temporalId = data[header + 3] >> 5;
+                return true;
+            }
+        } else if (type >= 1 && type <= 5) {
+            // Prefix NAL precedes the base layer slice
+            break;
+        }
+        pos = NalScanner::findStartCode(data, size, header);
+    }
+    return false;
+}
+
+} // namespace owt_base
@@ -0,0 +1,48 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OWT_BASE_SELECTOR_TEMPORAL_LAYER_FORWARDER_H
+#define OWT_BASE_SELECTOR_TEMPORAL_LAYER_FORWARDER_H
+
+#include "MediaFramePipeline.h"
+#include <logger.h>
+
+#include <atomic>
+
+namespace owt_base {
+
+// Forwards encoded frames of a temporally layered stream up to a target
+// layer and drops the higher ones, so a lower frame rate is served without
+// transcoding. Temporal IDs of VP8/VP9 come with the frame from payload
+// descriptors, H.264 ones are read from the SVC extension of prefix NALs.
+class TemporalLayerForwarder : public FrameSource,
+                               public FrameDestination {
+    DECLARE_LOGGER();
+public:
+    TemporalLayerForwarder(int targetTemporalId);
+    ~TemporalLayerForwarder();
+
+    // Lowering takes effect on next frame, raising at next switching point
+    void setTargetTemporalId(int temporalId);
+
+    // Implements FrameDestination
+    void onFrame(const Frame&) override;
+    void onMetaData(const MetaData&) override;
+
+    // Implements FrameSource
+    void onFeedback(const FeedbackMsg&) override;
+
+    // Returns false if frame has no SVC extension
+    static bool parseH264TemporalId(const Frame& frame, uint8_t& temporalId);
+
+private:
+    std::atomic<int> m_target;
+    // Highest layer being forwarded
+    int m_current;
+    bool m_keyFrameArrived;
+};
+
+} // namespace owt_base
+
+#endif // OWT_BASE_SELECTOR_TEMPORAL_LAYER_FORWARDER_H
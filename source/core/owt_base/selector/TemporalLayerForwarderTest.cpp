@@ -0,0 +1,276 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE TemporalLayerForwarder
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include "TemporalLayerForwarder.h"
+
+using owt_base::Frame;
+using owt_base::TemporalLayerForwarder;
+
+// Builds an Annex B access unit NAL by NAL
+class AccessUnit {
+public:
+    AccessUnit& nal(uint8_t header, std::vector<uint8_t> body = {}, bool longStartCode = false)
+    {
+        if (longStartCode) {
+            m_data.push_back(0);
+        }
+        m_data.insert(m_data.end(), {0, 0, 1, header});
+        m_data.insert(m_data.end(), body.begin(), body.end());
+        return *this;
+    }
+
+    // nal_unit_header_svc_extension with only temporal_id set
+    AccessUnit& prefix(uint8_t type, uint8_t temporalId, bool svcExtension = true)
+    {
+        return nal(0x60 | type, {uint8_t(svcExtension ? 0x80 : 0), 0x00, uint8_t(temporalId << 5), 0x00});
+    }
+
+    AccessUnit& slice(bool idr = false)
+    {
+        return nal(idr ? 0x65 : 0x61, {0x88, 0x84});
+    }
+
+    Frame frame()
+    {
+        Frame f;
+        memset(&f, 0, sizeof(f));
+        f.format = owt_base::FRAME_FORMAT_H264;
+        f.payload = m_data.data();
+        f.length = m_data.size();
+        return f;
+    }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+BOOST_AUTO_TEST_SUITE(ParseH264TemporalId)
+
+BOOST_AUTO_TEST_CASE(PrefixNal)
+{
+    for (uint8_t tid = 0; tid < 4; tid++) {
+        AccessUnit au;
+        au.prefix(14, tid).slice();
+        Frame frame = au.frame();
+        uint8_t temporalId = 0xff;
+        BOOST_CHECK(TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+        BOOST_CHECK_EQUAL(temporalId, tid);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SliceExtension)
+{
+    AccessUnit au;
+    au.prefix(20, 2);
+    Frame frame = au.frame();
+    uint8_t temporalId = 0xff;
+    BOOST_CHECK(TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+    BOOST_CHECK_EQUAL(temporalId, 2);
+}
+
+BOOST_AUTO_TEST_CASE(AfterParameterSets)
+{
+    // SPS, PPS and SEI are skipped, four byte start codes too
+    AccessUnit au;
+    au.nal(0x67, {0x42, 0x00, 0x1f}, true)
+      .nal(0x68, {0xce, 0x3c, 0x80}, true)
+      .nal(0x06, {0x05, 0x01, 0x00})
+      .prefix(14, 3)
+      .slice(true);
+    Frame frame = au.frame();
+    uint8_t temporalId = 0xff;
+    BOOST_CHECK(TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+    BOOST_CHECK_EQUAL(temporalId, 3);
+}
+
+BOOST_AUTO_TEST_CASE(NoSvcExtension)
+{
+    AccessUnit au;
+    au.prefix(14, 2, false).slice();
+    Frame frame = au.frame();
+    uint8_t temporalId = 0xff;
+    BOOST_CHECK(!TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+    BOOST_CHECK_EQUAL(temporalId, 0xff);
+}
+
+BOOST_AUTO_TEST_CASE(PrefixAfterSlice)
+{
+    // Only a prefix ahead of the base layer slice counts
+    AccessUnit au;
+    au.slice().prefix(14, 1);
+    Frame frame = au.frame();
+    uint8_t temporalId = 0xff;
+    BOOST_CHECK(!TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+}
+
+BOOST_AUTO_TEST_CASE(Truncated)
+{
+    AccessUnit au;
+    au.nal(0x6e, {0x80, 0x00});
+    Frame frame = au.frame();
+    uint8_t temporalId = 0xff;
+    BOOST_CHECK(!TemporalLayerForwarder::parseH264TemporalId(frame, temporalId));
+
+    Frame empty = AccessUnit().frame();
+    BOOST_CHECK(!TemporalLayerForwarder::parseH264TemporalId(empty, temporalId));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+class FrameCollector : public owt_base::FrameDestination {
+public:
+    void onFrame(const Frame& frame) override
+    {
+        temporalIds.push_back(frame.additionalInfo.video.temporalId);
+    }
+
+    std::vector<uint8_t> temporalIds;
+};
+
+// L1T3 pattern 0 2 1 2, sync frames switch up from the layer below
+struct ForwarderFixture
+{
+    TemporalLayerForwarder forwarder;
+    FrameCollector collector;
+
+    ForwarderFixture() : forwarder(0)
+    {
+        forwarder.addVideoDestination(&collector);
+    }
+
+    ~ForwarderFixture()
+    {
+        forwarder.removeVideoDestination(&collector);
+    }
+
+    void send(uint8_t temporalId, bool layerSync = false, bool keyFrame = false)
+    {
+        Frame frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.format = owt_base::FRAME_FORMAT_VP8;
+        frame.additionalInfo.video.temporalId = temporalId;
+        frame.additionalInfo.video.layerSync = layerSync;
+        frame.additionalInfo.video.isKeyFrame = keyFrame;
+        forwarder.onFrame(frame);
+    }
+
+    void sendPattern(bool layerSync = false)
+    {
+        send(0);
+        send(2, layerSync);
+        send(1, layerSync);
+        send(2, layerSync);
+    }
+
+    std::vector<uint8_t> delivered()
+    {
+        std::vector<uint8_t> ids;
+        ids.swap(collector.temporalIds);
+        return ids;
+    }
+};
+
+#define CHECK_DELIVERED(...) do { \
+        std::vector<uint8_t> expected = {__VA_ARGS__}; \
+        std::vector<uint8_t> actual = delivered(); \
+        BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end()); \
+    } while (0)
+
+BOOST_FIXTURE_TEST_SUITE(Switching, ForwarderFixture)
+
+BOOST_AUTO_TEST_CASE(WaitsForKeyFrame)
+{
+    forwarder.setTargetTemporalId(2);
+    sendPattern(true);
+    CHECK_DELIVERED();
+
+    send(0, false, true);
+    sendPattern();
+    CHECK_DELIVERED(0, 0, 2, 1, 2);
+}
+
+BOOST_AUTO_TEST_CASE(LowerAtOnce)
+{
+    forwarder.setTargetTemporalId(2);
+    send(0, false, true);
+    sendPattern();
+    CHECK_DELIVERED(0, 0, 2, 1, 2);
+
+    forwarder.setTargetTemporalId(0);
+    sendPattern();
+    CHECK_DELIVERED(0);
+}
+
+BOOST_AUTO_TEST_CASE(RaiseAtKeyFrame)
+{
+    send(0, false, true);
+    sendPattern();
+    CHECK_DELIVERED(0, 0);
+
+    // No sync frames, only a key frame switches up
+    forwarder.setTargetTemporalId(2);
+    sendPattern();
+    CHECK_DELIVERED(0);
+
+    send(0, false, true);
+    sendPattern();
+    CHECK_DELIVERED(0, 0, 2, 1, 2);
+}
+
+BOOST_AUTO_TEST_CASE(RaiseAtSyncPoint)
+{
+    send(0, false, true);
+    CHECK_DELIVERED(0);
+
+    forwarder.setTargetTemporalId(2);
+    // Layer 2 is not reachable from 0 in one step
+    send(0);
+    send(2, true);
+    CHECK_DELIVERED(0);
+
+    // Sync frame of layer 1, then of layer 2
+    send(1, true);
+    send(2);
+    send(0);
+    send(2, true);
+    send(1);
+    CHECK_DELIVERED(1, 0, 2, 1);
+}
+
+BOOST_AUTO_TEST_CASE(NotAboveTarget)
+{
+    send(0, false, true);
+    forwarder.setTargetTemporalId(1);
+    sendPattern(true);
+    CHECK_DELIVERED(0, 0, 1);
+}
+
+BOOST_AUTO_TEST_CASE(H264PrefixNal)
+{
+    // Every H.264 frame with a prefix NAL is a switching point
+    AccessUnit key, t1, t2;
+    key.nal(0x67, {0x42}).prefix(14, 0).slice(true);
+    t1.prefix(14, 1).slice();
+    t2.prefix(14, 2).slice();
+
+    Frame keyFrame = key.frame();
+    keyFrame.additionalInfo.video.isKeyFrame = true;
+    Frame frame1 = t1.frame();
+    Frame frame2 = t2.frame();
+
+    forwarder.onFrame(keyFrame);
+    forwarder.onFrame(frame2);
+    forwarder.onFrame(frame1);
+    BOOST_CHECK_EQUAL(delivered().size(), 1u);
+
+    forwarder.setTargetTemporalId(2);
+    forwarder.onFrame(frame1);
+    forwarder.onFrame(frame2);
+    BOOST_CHECK_EQUAL(delivered().size(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
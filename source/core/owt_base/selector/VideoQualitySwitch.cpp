@@ -4,8 +4,11 @@
 
 #include "VideoQualitySwitch.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 
 namespace owt_base {
@@ -13,31 +16,55 @@ namespace owt_base {
 // Treat streams frames in a certain period(ms)
 static constexpr uint32_t kBitrateCountPeriod = 5000;
 static constexpr uint32_t kBucketNum = 50;
-// Minimal period for switching(ms)
-static constexpr uint64_t kMinimalUpdatePeriod = 5000;
 static constexpr uint64_t kActiveTimeout = 2000;
-// Only change source when difference exceed threshold
-static constexpr double kBitrateChangeThreshold = 0.1;
+// Period for checking bandwidth against layers(ms)
+static constexpr uint64_t kEvaluatePeriod = 100;
+// Switch down when current layer exceeds this part of bandwidth for a short while
+static constexpr double kDownUtilization = 0.9;
+static constexpr uint64_t kDownHoldPeriod = 500;
+// Switch up only when a higher layer fits in this part of bandwidth for long enough
+static constexpr double kUpUtilization = 0.75;
+static constexpr uint64_t kUpHoldPeriod = 4000;
+// Waiting for key frame of target layer(ms)
+static constexpr uint64_t kKeyFrameRetryPeriod = 1000;
+static constexpr uint64_t kSwitchTimeout = 3000;
+// Gap between forwarded frames counted as freeze(ms)
+static constexpr uint64_t kFreezeGap = 200;
 
 DEFINE_LOGGER(VideoQualitySwitch, "owt.VideoQualitySwitch");
 
+static uint64_t currentTimeMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 VideoQualitySwitch::VideoQualitySwitch(std::vector<FrameSource*> sources)
     : m_sources(sources)
     , m_bitrateCounters(m_sources.size())
     , m_current(-1)
-    , m_keyFrameArrived(false)
-    , m_lastUpdateTime(0)
+    , m_pending(-1)
+    , m_pendingSince(0)
+    , m_lastKeyFrameRequest(0)
+    , m_lastEvaluateTime(0)
+    , m_downSince(0)
+    , m_upSince(0)
+    , m_lastForwardTime(0)
+    , m_totalSwitchLatencyMs(0)
+    , m_feedbackLayer(-1)
+    , m_estimatedBps(0)
 {
     ELOG_DEBUG("Init with sources size: %zu", m_sources.size());
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_stats.currentLayer = -1;
     for (size_t i = 0; i < m_sources.size(); i++) {
         if (m_sources[i]) {
-            m_bitrateCounters[i] = std::make_shared<BitrateCounter>(this);
+            m_bitrateCounters[i] = std::make_shared<BitrateCounter>(this, i);
             m_sources[i]->addVideoDestination(m_bitrateCounters[i].get());
         } else {
             ELOG_WARN("Empty source for quality switch %zu", i);
         }
     }
-    setTargetBitrate(0);
 }
 
 VideoQualitySwitch::~VideoQualitySwitch()
@@ -49,97 +76,207 @@ VideoQualitySwitch::~VideoQualitySwitch()
     }
 }
 
-void VideoQualitySwitch::onFrame(const Frame& frame)
+void VideoQualitySwitch::onFeedback(const owt_base::FeedbackMsg& msg)
 {
-    if (frame.additionalInfo.video.isKeyFrame) {
-        m_keyFrameArrived = true;
-    }
-    if (m_keyFrameArrived) {
-        deliverFrame(frame);
+    if (msg.type == owt_base::VIDEO_FEEDBACK && msg.cmd == SET_BITRATE) {
+        setTargetBitrate(msg.data.kbps * 1000);
+    } else {
+        int layer = m_feedbackLayer;
+        if (layer >= 0) {
+            m_bitrateCounters[layer]->sendFeedback(msg);
+        }
     }
 }
 
-void VideoQualitySwitch::onMetaData(const MetaData& metadata)
+void VideoQualitySwitch::setTargetBitrate(uint32_t targetBps)
 {
-    deliverMetaData(metadata);
+    ELOG_TRACE("setTargetBitrate %u %p", targetBps, this);
+    // Decisions are made on frame arrival
+    m_estimatedBps = targetBps;
 }
 
-void VideoQualitySwitch::onFeedback(const owt_base::FeedbackMsg& msg)
+void VideoQualitySwitch::getStats(VideoQualitySwitchStats& stats)
 {
-    if (msg.type == owt_base::VIDEO_FEEDBACK && msg.cmd == SET_BITRATE) {
-        setTargetBitrate(msg.data.kbps * 1000);
-    } else {
-        deliverFeedbackMsg(msg);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats = m_stats;
+    stats.currentLayer = m_current;
+    stats.estimatedBps = m_estimatedBps;
+    stats.avgSwitchLatencyMs = m_stats.switchCount ?
+        (m_totalSwitchLatencyMs / m_stats.switchCount) : 0;
+}
+
+void VideoQualitySwitch::onLayerFrame(int index, const Frame& frame)
+{
+    uint64_t tsNow = currentTimeMs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_bitrateCounters[index]->count(frame, tsNow);
+    evaluate(tsNow);
+
+    if (index == m_pending) {
+        if (!frame.additionalInfo.video.isKeyFrame) {
+            return;
+        }
+        // Swap exactly at the key frame of target layer
+        uint32_t latency = tsNow - m_pendingSince;
+        ELOG_DEBUG("Switched layer %d -> %d, latency %u ms %p", m_current, m_pending, latency, this);
+        m_current = m_pending;
+        m_feedbackLayer = m_current;
+        m_pending = -1;
+        m_stats.switchCount++;
+        m_stats.lastSwitchLatencyMs = latency;
+        m_stats.maxSwitchLatencyMs = std::max(m_stats.maxSwitchLatencyMs, latency);
+        m_totalSwitchLatencyMs += latency;
+    } else if (index != m_current) {
+        return;
     }
+
+    if (m_lastForwardTime > 0 && tsNow - m_lastForwardTime > kFreezeGap) {
+        m_stats.freezeCount++;
+        m_stats.totalFreezeMs += tsNow - m_lastForwardTime;
+    }
+    m_lastForwardTime = tsNow;
+    deliverFrame(frame);
 }
 
-void VideoQualitySwitch::setTargetBitrate(uint32_t targetBps)
+void VideoQualitySwitch::onLayerMetaData(int index, const MetaData& metadata)
 {
-    ELOG_DEBUG("setTargetBitrate %u %p", targetBps, this);
-    uint64_t tsNow = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
-    if (tsNow - m_lastUpdateTime < kMinimalUpdatePeriod) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index == m_current) {
+        deliverMetaData(metadata);
+    }
+}
+
+void VideoQualitySwitch::evaluate(uint64_t tsNow)
+{
+    if (tsNow - m_lastEvaluateTime < kEvaluatePeriod) {
         return;
     }
-    m_lastUpdateTime = tsNow;
+    m_lastEvaluateTime = tsNow;
 
-    int current = -1;
-    int currentBitrate = 0;
-    for (size_t i = 0; i < m_sources.size(); i++) {
-        int bitrate = m_bitrateCounters[i]->bitrate();
-        ELOG_DEBUG("BitrateCounter bitrate %zu: %d %p", i, bitrate, this);
-        if (current < 0) {
-            current = i;
-            currentBitrate = bitrate;
-        } else {
-            if (std::abs(bitrate - (int) targetBps) <
-                std::abs(currentBitrate - (int) targetBps)) {
-                current = i;
-                currentBitrate = bitrate;
+    if (m_pending >= 0) {
+        if (tsNow - m_pendingSince >= kSwitchTimeout) {
+            ELOG_WARN("No key frame from layer %d, keep layer %d", m_pending, m_current);
+            m_stats.failedSwitchCount++;
+            m_pending = -1;
+        } else if (tsNow - m_lastKeyFrameRequest >= kKeyFrameRetryPeriod) {
+            requestKeyFrame(m_pending, tsNow);
+        }
+    }
+
+    uint32_t availableBps = m_estimatedBps;
+    if (m_current < 0) {
+        if (m_pending < 0) {
+            // Lowest layer if bandwidth is not known yet
+            int target = selectLayer(tsNow, availableBps * kDownUtilization);
+            if (target >= 0) {
+                startSwitch(target, tsNow);
             }
         }
+        return;
     }
-    if (current != m_current) {
-        if (current >= 0 && m_current >= 0) {
-            int newBitrate = m_bitrateCounters[current]->bitrate();
-            int oldBitrate = m_bitrateCounters[m_current]->bitrate() + 1;
-            double diff = std::abs(newBitrate - oldBitrate);
-            diff = diff / oldBitrate;
-            if (diff < kBitrateChangeThreshold) {
-                ELOG_DEBUG("No change when less than threshold: %f", diff);
-                return;
+    if (availableBps == 0) {
+        return;
+    }
+
+    uint32_t currentBps = m_bitrateCounters[m_current]->bitrate(tsNow);
+    int target = -1;
+    if (currentBps > availableBps * kDownUtilization) {
+        m_upSince = 0;
+        if (m_downSince == 0) {
+            m_downSince = tsNow;
+        }
+        if (tsNow - m_downSince >= kDownHoldPeriod) {
+            target = selectLayer(tsNow, availableBps * kDownUtilization);
+        }
+    } else {
+        m_downSince = 0;
+        int candidate = selectLayer(tsNow, availableBps * kUpUtilization);
+        if (candidate >= 0 && m_bitrateCounters[candidate]->bitrate(tsNow) > currentBps) {
+            if (m_upSince == 0) {
+                m_upSince = tsNow;
+            }
+            if (tsNow - m_upSince >= kUpHoldPeriod) {
+                target = candidate;
             }
+        } else {
+            m_upSince = 0;
+        }
+    }
+
+    if (target >= 0 && target != m_current && target != m_pending) {
+        ELOG_DEBUG("Bandwidth %u, layer %d bitrate %u, switch to %d",
+                   availableBps, m_current, currentBps, target);
+        startSwitch(target, tsNow);
+    }
+}
+
+int VideoQualitySwitch::selectLayer(uint64_t tsNow, uint32_t budgetBps)
+{
+    // Highest active layer within budget, or the lowest one if none fits
+    int best = -1;
+    uint32_t bestBps = 0;
+    int lowest = -1;
+    uint32_t lowestBps = 0;
+    for (size_t i = 0; i < m_bitrateCounters.size(); i++) {
+        if (!m_bitrateCounters[i]) {
+            continue;
         }
-        if (m_current >= 0 && m_sources[m_current]) {
-            ELOG_DEBUG("Disable source index %u", m_current);
-            m_sources[m_current]->removeVideoDestination(this);
+        uint32_t bitrate = m_bitrateCounters[i]->bitrate(tsNow);
+        if (bitrate == 0) {
+            continue;
         }
-        m_current = current;
-        if (m_current >= 0 && m_sources[m_current]) {
-            ELOG_DEBUG("Enable source index %u", m_current);
-            m_keyFrameArrived = false;
-            m_sources[m_current]->addVideoDestination(this);
-            ELOG_DEBUG("Request key frame ");
-            // Request key frame
-            FeedbackMsg feedback = {.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME };
-            deliverFeedbackMsg(feedback);
+        if (bitrate <= budgetBps && (best < 0 || bitrate > bestBps)) {
+            best = i;
+            bestBps = bitrate;
+        }
+        if (lowest < 0 || bitrate < lowestBps) {
+            lowest = i;
+            lowestBps = bitrate;
         }
     }
+    return (best >= 0) ? best : lowest;
+}
+
+void VideoQualitySwitch::startSwitch(int target, uint64_t tsNow)
+{
+    ELOG_DEBUG("Start switching layer %d -> %d %p", m_current, target, this);
+    m_pending = target;
+    m_pendingSince = tsNow;
+    m_downSince = 0;
+    m_upSince = 0;
+    requestKeyFrame(target, tsNow);
+}
+
+void VideoQualitySwitch::requestKeyFrame(int index, uint64_t tsNow)
+{
+    ELOG_DEBUG("Request key frame from layer %d", index);
+    m_lastKeyFrameRequest = tsNow;
+    FeedbackMsg feedback = {.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME };
+    m_bitrateCounters[index]->sendFeedback(feedback);
 }
 
 void VideoQualitySwitch::BitrateCounter::onFrame(const Frame& frame)
 {
     ELOG_TRACE("BitrateCounter onFrame %u %p", frame.length, this);
-    uint64_t tsNow = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
+    m_parent->onLayerFrame(m_index, frame);
+}
+
+void VideoQualitySwitch::BitrateCounter::onMetaData(const MetaData& metadata)
+{
+    m_parent->onLayerMetaData(m_index, metadata);
+}
+
+void VideoQualitySwitch::BitrateCounter::count(const Frame& frame, uint64_t tsNow)
+{
     const uint32_t bucketInterval = kBitrateCountPeriod / kBucketNum;
     if (m_timeFrames.empty() ||
         (tsNow - m_timeFrames.back().timeStamp) >= bucketInterval) {
         Bucket bucket(tsNow);
         m_timeFrames.push_back(bucket);
     }
-    m_timeFrames.back().total += frame.length * 8;
-    m_totalBits += frame.length * 8;
+    m_timeFrames.back().total += static_cast<uint64_t>(frame.length) * 8;
+    m_totalBits += static_cast<uint64_t>(frame.length) * 8;
 
     while (m_timeFrames.size() > kBucketNum) {
         m_totalBits -= m_timeFrames.front().total;
@@ -147,21 +284,22 @@ void VideoQualitySwitch::BitrateCounter::onFrame(const Frame& frame)
     }
 }
 
-uint32_t VideoQualitySwitch::BitrateCounter::bitrate()
+uint32_t VideoQualitySwitch::BitrateCounter::bitrate(uint64_t tsNow)
 {
     if (m_timeFrames.size() == 0) {
         return 0;
     }
-    uint64_t tsNow = std::chrono::duration_cast<std::chrono::milliseconds>(
-       std::chrono::steady_clock::now().time_since_epoch()).count();
     uint64_t tsLast = m_timeFrames.back().timeStamp;
     if ((tsNow - tsLast) > kActiveTimeout) {
         ELOG_DEBUG("Not active %p", this);
         return 0;
     }
     uint32_t countedMs = m_timeFrames.size() * (kBitrateCountPeriod / kBucketNum);
-    uint32_t bitrate = m_totalBits * 1000 / countedMs;
-    return bitrate;
+    if (countedMs == 0) {
+        return 0;
+    }
+    uint64_t bitrate = static_cast<uint64_t>(m_totalBits) * 1000 / countedMs;
+    return std::min<uint64_t>(bitrate, UINT32_MAX);
 }
 
 } // namespace owt_base
@@ -8,72 +8,100 @@
 #include "MediaFramePipeline.h"
 #include <logger.h>
 
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace owt_base {
 
-class VideoQualitySwitch : public FrameSource,
-                           public FrameDestination {
+struct VideoQualitySwitchStats {
+    int currentLayer;
+    uint32_t estimatedBps;
+    uint32_t switchCount;
+    uint32_t failedSwitchCount;     // no key frame of target layer in time
+    uint32_t lastSwitchLatencyMs;   // decision to key frame of target layer
+    uint32_t maxSwitchLatencyMs;
+    uint32_t avgSwitchLatencyMs;
+    uint32_t freezeCount;
+    uint64_t totalFreezeMs;         // gaps between forwarded frames
+};
+
+// Forwards one layer out of several sources. Layer changes follow the
+// subscriber's estimated bandwidth, dropping quickly and rising only after
+// the bandwidth stays sufficient. The current layer keeps being forwarded
+// until a key frame of the target layer arrives, output swaps at that frame.
+class VideoQualitySwitch : public FrameSource {
     DECLARE_LOGGER();
 public:
     VideoQualitySwitch(std::vector<FrameSource*> sources);
     ~VideoQualitySwitch();
 
-    // Implements FrameDestination
-    void onFrame(const Frame&) override;
-    void onMetaData(const MetaData&) override;
-
-    // Implements FrameDestination
+    // Implements FrameSource
     void onFeedback(const owt_base::FeedbackMsg& msg) override;
 
+    // Estimated available bandwidth of the subscriber, 0 if unknown
     void setTargetBitrate(uint32_t targetBps);
+    void getStats(VideoQualitySwitchStats& stats);
 
+    // Attached to each source, counts its bitrate and passes frames to the switch
     class BitrateCounter : public FrameDestination {
     public:
-        BitrateCounter(): m_totalBits  (0) {}
-        BitrateCounter(VideoQualitySwitch* parent)
+        BitrateCounter(VideoQualitySwitch* parent, int index)
             : m_totalBits(0)
-            , m_parent(parent) {}
+            , m_parent(parent)
+            , m_index(index) {}
         ~BitrateCounter() = default;
 
         // Implements FrameDestination
         void onFrame(const Frame&) override;
+        void onMetaData(const MetaData&) override;
 
-        uint32_t bitrate();
+        void count(const Frame&, uint64_t tsNow);
+        uint32_t bitrate(uint64_t tsNow);
+        void sendFeedback(const FeedbackMsg& msg) { deliverFeedbackMsg(msg); }
     private:
         struct Bucket {
             Bucket(uint64_t ts) : timeStamp(ts), total(0) {}
             uint64_t timeStamp;
-            uint32_t total;
+            uint64_t total;
         };
         std::deque<Bucket> m_timeFrames;
-        uint32_t m_totalBits;
+        uint64_t m_totalBits;
 
         VideoQualitySwitch* m_parent;
+        int m_index;
     };
 
-    // class KeyFrameDetector : public FrameDestination {
-    // public:
-    //     KeyFrameDetector(VideoQualitySwitch* parent)
-    //         : m_targetIdx(-1)
-    //         , m_parent(parent) {}
-    //     ~KeyFrameDetector() = default;
+private:
+    void onLayerFrame(int index, const Frame& frame);
+    void onLayerMetaData(int index, const MetaData& metadata);
 
-    //     // Implements FrameDestination
-    //     void onFrame(const Frame&) override;
-    // private:
-    //     int m_targetIdx;
-    //     VideoQualitySwitch* m_parent;
-    // };
+    // Following are called with m_mutex held
+    void evaluate(uint64_t tsNow);
+    int selectLayer(uint64_t tsNow, uint32_t budgetBps);
+    void startSwitch(int target, uint64_t tsNow);
+    void requestKeyFrame(int index, uint64_t tsNow);
 
-private:
     std::vector<FrameSource*> m_sources;
     std::vector<std::shared_ptr<BitrateCounter>> m_bitrateCounters;
+
+    std::mutex m_mutex;
     int m_current;
-    bool m_keyFrameArrived;
-    uint64_t m_lastUpdateTime;
+    int m_pending;
+    uint64_t m_pendingSince;
+    uint64_t m_lastKeyFrameRequest;
+    uint64_t m_lastEvaluateTime;
+    uint64_t m_downSince;
+    uint64_t m_upSince;
+    uint64_t m_lastForwardTime;
+    uint64_t m_totalSwitchLatencyMs;
+    VideoQualitySwitchStats m_stats;
+
+    // Read without m_mutex by feedback path
+    std::atomic<int> m_feedbackLayer;
+    std::atomic<uint32_t> m_estimatedBps;
 };
 
 } // namespace owt_base
@@ -0,0 +1,81 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE VideoQualitySwitch
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+
+#include "VideoQualitySwitch.h"
+
+using owt_base::Frame;
+using owt_base::VideoQualitySwitch;
+
+struct CounterFixture
+{
+    VideoQualitySwitch::BitrateCounter counter;
+    Frame frame;
+
+    CounterFixture() : counter(nullptr, 0)
+    {
+        memset(&frame, 0, sizeof(frame));
+        frame.format = owt_base::FRAME_FORMAT_H264;
+    }
+
+    // Feeds |seconds| of a stream at |bps| as 50fps frames, returns the end time
+    uint64_t feed(uint64_t start, uint32_t bps, uint32_t seconds)
+    {
+        frame.length = bps / 8 / 50;
+        uint64_t ts = start;
+        for (uint32_t i = 0; i < seconds * 50; i++) {
+            counter.count(frame, ts);
+            ts += 20;
+        }
+        return ts;
+    }
+};
+
+static bool near(uint32_t value, uint32_t expected)
+{
+    return value > expected * 0.95 && value < expected * 1.05;
+}
+
+BOOST_FIXTURE_TEST_SUITE(BitrateCounter, CounterFixture)
+
+BOOST_AUTO_TEST_CASE(EmptyCounter)
+{
+    BOOST_CHECK_EQUAL(counter.bitrate(1000), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(LowBitrate)
+{
+    uint64_t ts = feed(1000, 500000, 6);
+    BOOST_CHECK(near(counter.bitrate(ts), 500000));
+}
+
+BOOST_AUTO_TEST_CASE(MultiMegabit)
+{
+    // Bits in the window times 1000 no longer fits 32 bits from ~860kbps
+    uint64_t ts = feed(1000, 8000000, 6);
+    BOOST_CHECK(near(counter.bitrate(ts), 8000000));
+}
+
+BOOST_AUTO_TEST_CASE(HighBitrate)
+{
+    uint64_t ts = feed(1000, 40000000, 6);
+    BOOST_CHECK(near(counter.bitrate(ts), 40000000));
+}
+
+BOOST_AUTO_TEST_CASE(WindowFollowsRateChange)
+{
+    uint64_t ts = feed(1000, 6000000, 6);
+    ts = feed(ts, 1500000, 6);
+    BOOST_CHECK(near(counter.bitrate(ts), 1500000));
+}
+
+BOOST_AUTO_TEST_CASE(InactiveSource)
+{
+    uint64_t ts = feed(1000, 4000000, 2);
+    BOOST_CHECK(counter.bitrate(ts) > 0);
+    BOOST_CHECK_EQUAL(counter.bitrate(ts + 3000), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "PacedSender.h"
+
+#include <algorithm>
+
+#include <rtc_base/logging.h>
+
+namespace rtc_adapter {
+
+static constexpr int64_t kDefaultFrameIntervalMs = 33;
+static constexpr int64_t kMinFrameIntervalMs = 10;
+static constexpr int64_t kMaxFrameIntervalMs = 100;
+static constexpr int64_t kMaxElapsedMs = 30;
+static constexpr size_t kMaxPacketSize = 1500;
+
+PacedSender::PacedSender(const Config& config, webrtc::Clock* clock, Observer* observer)
+    : m_config(config)
+    , m_clock(clock)
+    , m_observer(observer)
+    , m_rtpRtcp(nullptr)
+    , m_queuedBytes(0)
+    , m_targetBps(0)
+    , m_drainRateBps(0)
+    , m_lastCaptureMs(-1)
+    , m_frameIntervalMs(kDefaultFrameIntervalMs)
+    , m_droppedPackets(0)
+    , m_lastProcessMs(-1)
+    , m_budgetBytes(0)
+{
+    m_batch.reserve(m_config.maxBatchPackets);
+}
+
+PacedSender::~PacedSender()
+{
+}
+
+void PacedSender::setTargetBitrate(uint32_t bps)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_targetBps = bps;
+}
+
+uint32_t PacedSender::queueDelayMs()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    int64_t oldest = -1;
+    if (!m_retransmissions.empty()) {
+        oldest = m_retransmissions.front().enqueueMs;
+    }
+    if (!m_media.empty() && (oldest < 0 || m_media.front().enqueueMs < oldest)) {
+        oldest = m_media.front().enqueueMs;
+    }
+    return (oldest < 0) ? 0 : (m_clock->TimeInMilliseconds() - oldest);
+}
+
+void PacedSender::EnqueuePackets(
+    std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> packets)
+{
+    int64_t nowMs = m_clock->TimeInMilliseconds();
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto& packet : packets) {
+        m_queuedBytes += packet->size();
+        if (packet->packet_type() == webrtc::RtpPacketMediaType::kRetransmission) {
+            m_retransmissions.push_back({std::move(packet), nowMs});
+            continue;
+        }
+        if (packet->capture_time_ms() != m_lastCaptureMs) {
+            // New frame
+            if (m_lastCaptureMs >= 0) {
+                int64_t interval = std::min(std::max(packet->capture_time_ms() - m_lastCaptureMs,
+                    kMinFrameIntervalMs), kMaxFrameIntervalMs);
+                m_frameIntervalMs = (m_frameIntervalMs * 7 + interval) / 8;
+            }
+            m_lastCaptureMs = packet->capture_time_ms();
+        }
+        m_media.push_back({std::move(packet), nowMs});
+    }
+    // Drain what is queued within one frame interval
+    m_drainRateBps = m_queuedBytes * 8 * 1000 / m_frameIntervalMs;
+}
+
+int64_t PacedSender::TimeUntilNextProcess()
+{
+    if (m_lastProcessMs < 0) {
+        return 0;
+    }
+    return std::max<int64_t>(m_lastProcessMs + m_config.tickMs - m_clock->TimeInMilliseconds(), 0);
+}
+
+uint32_t PacedSender::pacingRateBps()
+{
+    uint32_t rate = std::max<uint32_t>(m_targetBps * m_config.pacingFactor, m_config.minRateBps);
+    return std::max(rate, m_drainRateBps);
+}
+
+uint32_t PacedSender::dropExpired(int64_t nowMs)
+{
+    if (m_media.empty() || nowMs - m_media.front().enqueueMs <= m_config.maxQueueMs) {
+        return 0;
+    }
+
+    // Part of a frame is useless, drop the whole media queue
+    uint32_t dropped = m_media.size();
+    for (auto& queued : m_media) {
+        m_queuedBytes -= queued.packet->size();
+    }
+    m_media.clear();
+    m_droppedPackets += dropped;
+    RTC_LOG(LS_WARNING) << "Pacing queue over " << m_config.maxQueueMs
+                        << "ms, drop packets: " << dropped;
+    return dropped;
+}
+
+void PacedSender::Process()
+{
+    int64_t nowMs = m_clock->TimeInMilliseconds();
+    int64_t elapsedMs = (m_lastProcessMs < 0) ? m_config.tickMs : (nowMs - m_lastProcessMs);
+    m_lastProcessMs = nowMs;
+    uint32_t dropped = 0;
+
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        dropped = dropExpired(nowMs);
+
+        uint32_t rate = pacingRateBps();
+        int64_t maxBudget = std::max<int64_t>(rate * m_config.burstMs / 8000, kMaxPacketSize);
+        m_budgetBytes = std::min(m_budgetBytes + rate * std::min(elapsedMs, kMaxElapsedMs) / 8000, maxBudget);
+
+        while (m_budgetBytes > 0 && m_batch.size() < m_config.maxBatchPackets) {
+            std::deque<QueuedPacket>& queue = !m_retransmissions.empty() ? m_retransmissions : m_media;
+            if (queue.empty()) {
+                break;
+            }
+            m_budgetBytes -= queue.front().packet->size();
+            m_queuedBytes -= queue.front().packet->size();
+            m_batch.push_back(std::move(queue.front().packet));
+            queue.pop_front();
+        }
+
+        if (m_retransmissions.empty() && m_media.empty()) {
+            m_drainRateBps = 0;
+        }
+    }
+
+    // Outside the lock, the observer may call back into the pacer
+    if (dropped && m_observer) {
+        m_observer->onPacingDrop(dropped);
+    }
+
+    if (!m_batch.empty()) {
+        sendBatch(m_batch);
+        m_batch.clear();
+    }
+}
+
+void PacedSender::sendBatch(std::vector<std::unique_ptr<webrtc::RtpPacketToSend>>& batch)
+{
+    if (!m_rtpRtcp) {
+        return;
+    }
+
+    // Released back to back, so the transport can write them together
+    webrtc::PacedPacketInfo pacingInfo;
+    std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> fecPackets;
+    for (auto& packet : batch) {
+        m_rtpRtcp->TrySendPacket(packet.get(), pacingInfo);
+        for (auto& fec : m_rtpRtcp->FetchFecPackets()) {
+            fecPackets.push_back(std::move(fec));
+        }
+    }
+
+    if (!fecPackets.empty()) {
+        EnqueuePackets(std::move(fecPackets));
+    }
+}
+
+} // namespace rtc_adapter
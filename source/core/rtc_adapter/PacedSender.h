@@ -0,0 +1,102 @@
+// Copyright (C) <2021> Intel Corporation
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef RTC_ADAPTER_PACED_SENDER_
+#define RTC_ADAPTER_PACED_SENDER_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <modules/include/module.h>
+#include <modules/rtp_rtcp/include/rtp_packet_sender.h>
+#include <modules/rtp_rtcp/include/rtp_rtcp.h>
+#include <modules/rtp_rtcp/source/rtp_packet_to_send.h>
+#include <system_wrappers/include/clock.h>
+
+namespace rtc_adapter {
+
+// Paces one video stream without a transport controller. Packets of a
+// frame are spread over the frame interval at a multiple of the send
+// bitrate, and released once per tick in bounded batches.
+class PacedSender : public webrtc::RtpPacketSender,
+                    public webrtc::Module {
+public:
+    struct Config {
+        int64_t tickMs = 5;
+        // Budget that may accumulate while idle
+        int64_t burstMs = 20;
+        // Queued media older than this is dropped
+        int64_t maxQueueMs = 1000;
+        double pacingFactor = 2.5;
+        uint32_t minRateBps = 300000;
+        size_t maxBatchPackets = 64;
+    };
+
+    class Observer {
+    public:
+        virtual void onPacingDrop(uint32_t packets) = 0;
+    };
+
+    PacedSender(const Config& config, webrtc::Clock* clock, Observer* observer);
+    ~PacedSender();
+
+    // Must be set before the pacer is registered to a process thread
+    void setRtpRtcp(webrtc::RtpRtcp* rtpRtcp) { m_rtpRtcp = rtpRtcp; }
+    void setTargetBitrate(uint32_t bps);
+
+    // Age of the oldest queued packet
+    uint32_t queueDelayMs();
+    uint32_t droppedPackets() { return m_droppedPackets; }
+
+    // Implements webrtc::RtpPacketSender
+    void EnqueuePackets(
+        std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> packets) override;
+
+    // Implements webrtc::Module
+    int64_t TimeUntilNextProcess() override;
+    void Process() override;
+
+protected:
+    // Called on the process thread without the lock, FEC generated for
+    // the batch is queued again
+    virtual void sendBatch(std::vector<std::unique_ptr<webrtc::RtpPacketToSend>>& batch);
+
+private:
+    struct QueuedPacket {
+        std::unique_ptr<webrtc::RtpPacketToSend> packet;
+        int64_t enqueueMs;
+    };
+
+    // Returns the number of packets dropped, m_mutex held
+    uint32_t dropExpired(int64_t nowMs);
+    uint32_t pacingRateBps();
+
+    const Config m_config;
+    webrtc::Clock* m_clock;
+    Observer* m_observer;
+    webrtc::RtpRtcp* m_rtpRtcp;
+
+    std::mutex m_mutex;
+    // Retransmissions go before media
+    std::deque<QueuedPacket> m_retransmissions;
+    std::deque<QueuedPacket> m_media;
+    size_t m_queuedBytes;
+    uint32_t m_targetBps;
+    uint32_t m_drainRateBps;
+    int64_t m_lastCaptureMs;
+    int64_t m_frameIntervalMs;
+    std::atomic<uint32_t> m_droppedPackets;
+
+    // Process thread only
+    int64_t m_lastProcessMs;
+    int64_t m_budgetBytes;
+    std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> m_batch;
+};
+
+} // namespace rtc_adapter
+
+#endif
@@ -0,0 +1,169 @@
+// Built with webrtc's libc++, so the test runner is compiled in
+#define BOOST_TEST_MODULE PacedSender
+#include <boost/test/included/unit_test.hpp>
+
+#include "PacedSender.h"
+
+using rtc_adapter::PacedSender;
+
+class TestPacedSender : public PacedSender {
+public:
+    TestPacedSender(const Config& config, webrtc::Clock* clock, Observer* observer)
+        : PacedSender(config, clock, observer)
+    {
+    }
+
+    std::vector<webrtc::RtpPacketMediaType> sent;
+    std::vector<size_t> batches;
+
+protected:
+    void sendBatch(std::vector<std::unique_ptr<webrtc::RtpPacketToSend>>& batch) override
+    {
+        batches.push_back(batch.size());
+        for (auto& packet : batch) {
+            sent.push_back(*packet->packet_type());
+        }
+    }
+};
+
+class KeyFrameRequester : public PacedSender::Observer {
+public:
+    // Stands in for VideoSendAdapterImpl, which requests a key frame here
+    void onPacingDrop(uint32_t packets) override
+    {
+        dropped += packets;
+        keyFrameRequests++;
+        // Deadlocks if the pacer still holds its lock
+        queueDelayMs = pacer->queueDelayMs();
+    }
+
+    PacedSender* pacer = nullptr;
+    uint32_t dropped = 0;
+    uint32_t keyFrameRequests = 0;
+    uint32_t queueDelayMs = 0;
+};
+
+struct Pacing
+{
+    static const size_t kPacketSize = 1000;
+
+    Pacing()
+        : clock(1000000)
+        , pacer(PacedSender::Config(), &clock, &observer)
+    {
+        observer.pacer = &pacer;
+    }
+
+    std::unique_ptr<webrtc::RtpPacketToSend> packet(webrtc::RtpPacketMediaType type, int64_t captureMs)
+    {
+        std::unique_ptr<webrtc::RtpPacketToSend> p(new webrtc::RtpPacketToSend(nullptr));
+        p->SetPayloadSize(kPacketSize - p->headers_size());
+        p->set_packet_type(type);
+        p->set_capture_time_ms(captureMs);
+        return p;
+    }
+
+    void enqueue(webrtc::RtpPacketMediaType type, size_t count, int64_t captureMs)
+    {
+        std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> packets;
+        for (size_t i = 0; i < count; i++) {
+            packets.push_back(packet(type, captureMs));
+        }
+        pacer.EnqueuePackets(std::move(packets));
+    }
+
+    void tick()
+    {
+        clock.AdvanceTimeMilliseconds(PacedSender::Config().tickMs);
+        pacer.Process();
+    }
+
+    // Lets the idle budget fill up to the burst limit
+    void idle()
+    {
+        for (int i = 0; i < 20; i++) {
+            tick();
+        }
+        pacer.batches.clear();
+    }
+
+    webrtc::SimulatedClock clock;
+    KeyFrameRequester observer;
+    TestPacedSender pacer;
+};
+
+BOOST_FIXTURE_TEST_SUITE(pacedSender, Pacing)
+
+BOOST_AUTO_TEST_CASE(burstBudget)
+{
+    // 2.5Mbps pacing rate, 20ms burst of 6250 bytes, 1562 bytes per tick
+    pacer.setTargetBitrate(1000000);
+    idle();
+
+    enqueue(webrtc::RtpPacketMediaType::kVideo, 10, 0);
+    tick();
+    BOOST_REQUIRE_EQUAL(pacer.batches.size(), 1);
+    BOOST_CHECK_EQUAL(pacer.batches[0], 7);
+
+    tick();
+    BOOST_REQUIRE_EQUAL(pacer.batches.size(), 2);
+    BOOST_CHECK_EQUAL(pacer.batches[1], 1);
+}
+
+BOOST_AUTO_TEST_CASE(retransmissionsFirst)
+{
+    pacer.setTargetBitrate(1000000);
+    idle();
+
+    enqueue(webrtc::RtpPacketMediaType::kVideo, 3, 0);
+    enqueue(webrtc::RtpPacketMediaType::kRetransmission, 2, 0);
+    tick();
+
+    BOOST_REQUIRE_EQUAL(pacer.sent.size(), 5);
+    BOOST_CHECK(pacer.sent[0] == webrtc::RtpPacketMediaType::kRetransmission);
+    BOOST_CHECK(pacer.sent[1] == webrtc::RtpPacketMediaType::kRetransmission);
+    for (size_t i = 2; i < pacer.sent.size(); i++) {
+        BOOST_CHECK(pacer.sent[i] == webrtc::RtpPacketMediaType::kVideo);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dropAfterOneSecond)
+{
+    enqueue(webrtc::RtpPacketMediaType::kVideo, 5, 0);
+    clock.AdvanceTimeMilliseconds(999);
+    BOOST_CHECK_EQUAL(pacer.queueDelayMs(), 999);
+
+    clock.AdvanceTimeMilliseconds(2);
+    pacer.Process();
+
+    BOOST_CHECK_EQUAL(observer.keyFrameRequests, 1);
+    BOOST_CHECK_EQUAL(observer.dropped, 5);
+    BOOST_CHECK_EQUAL(observer.queueDelayMs, 0);
+    BOOST_CHECK_EQUAL(pacer.droppedPackets(), 5);
+    BOOST_CHECK(pacer.sent.empty());
+
+    // Nothing left to drop
+    tick();
+    BOOST_CHECK_EQUAL(observer.keyFrameRequests, 1);
+}
+
+BOOST_AUTO_TEST_CASE(minRateFloor)
+{
+    // 2.5 x 10kbps is far below the 300kbps floor
+    pacer.setTargetBitrate(10000);
+
+    int64_t captureMs = 0;
+    for (int i = 0; i < 200; i++) {
+        if (pacer.queueDelayMs() == 0) {
+            enqueue(webrtc::RtpPacketMediaType::kVideo, 1, captureMs);
+            captureMs += 33;
+        }
+        tick();
+    }
+
+    // One second at 300kbps is 37500 bytes
+    BOOST_CHECK_GE(pacer.sent.size(), 35);
+    BOOST_CHECK_LE(pacer.sent.size(), 40);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,22 +5,28 @@
 #include <AdapterInternalDefinitions.h>
 #include <AudioSendAdapter.h>
 #include <RtcAdapter.h>
+#include <TaskRunnerPool.h>
 #include <VideoReceiveAdapter.h>
 #include <VideoSendAdapter.h>
 #include <thread/ProcessThreadProxy.h>
 #include <thread/StaticTaskQueueFactory.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <thread>
 
 #include <call/rtp_transport_controller_send.h>
+#include <rtc_base/time_utils.h>
 #include <system_wrappers/include/clock.h>
 #include <system_wrappers/include/field_trial.h>
 
 namespace rtc_adapter {
 
-static rtc::scoped_refptr<webrtc::SharedModuleThread> g_moduleThread;
-
 static std::unique_ptr<webrtc::FieldTrialBasedConfig> g_fieldTrial= []()
 {
     auto config = std::make_unique<webrtc::FieldTrialBasedConfig>();
@@ -36,15 +42,99 @@ static std::unique_ptr<webrtc::FieldTrialBasedConfig> g_fieldTrial= []()
 static std::shared_ptr<webrtc::RtcEventLog> g_eventLog =
     std::make_shared<webrtc::RtcEventLogNull>();
 
-static std::shared_ptr<webrtc::TaskQueueFactory> g_taskQueueFactory =
-    createStaticTaskQueueFactory();
-static std::shared_ptr<rtc::TaskQueue> g_taskQueue =
-    std::make_shared<rtc::TaskQueue>(g_taskQueueFactory->CreateTaskQueue(
-        "CallTaskQueue",
-        webrtc::TaskQueueFactory::Priority::NORMAL));
-
 static constexpr int kStartBitrateBps = 800000;
 
+static constexpr uint32_t kMaxCallShards = 8;
+static constexpr uint32_t kProbeIntervalMs = 1000;
+static constexpr uint32_t kQueueDelayWarningMs = 50;
+static constexpr uint32_t kMaxStreamsPerCall = 32;
+
+// Call work of the assigned adapters is serialized on the shard's task queues
+struct CallShard {
+    uint32_t id = 0;
+    std::shared_ptr<webrtc::TaskQueueFactory> taskQueueFactory;
+    std::shared_ptr<rtc::TaskQueue> taskQueue;
+    // Only touched on taskQueue
+    rtc::scoped_refptr<webrtc::SharedModuleThread> moduleThread;
+
+    std::atomic<uint32_t> adapters{0};
+    std::atomic<uint32_t> queueDelayMs{0};
+    std::atomic<uint32_t> maxQueueDelayMs{0};
+};
+
+// Reposts itself, how late it runs is the queue delay of the shard
+static void probeCallShard(std::shared_ptr<CallShard> shard, int64_t expectedMs)
+{
+    int64_t now = rtc::TimeMillis();
+    uint32_t delay = now > expectedMs ? now - expectedMs : 0;
+
+    shard->queueDelayMs = delay;
+    if (delay > shard->maxQueueDelayMs)
+        shard->maxQueueDelayMs = delay;
+    if (delay > kQueueDelayWarningMs) {
+        RTC_LOG(LS_WARNING) << "CallTaskQueue shard " << shard->id << " delayed "
+                            << delay << "ms, adapters: " << shard->adapters;
+    }
+
+    shard->taskQueue->PostDelayedTask([shard, now]() {
+        probeCallShard(shard, now + kProbeIntervalMs);
+    }, kProbeIntervalMs);
+}
+
+static uint32_t callShardNum()
+{
+    const char* env = std::getenv("OWT_CALL_SHARDS");
+    uint32_t num = env ? std::atoi(env) : std::thread::hardware_concurrency() / 2;
+
+    if (num < 1)
+        num = 1;
+    if (num > kMaxCallShards) {
+        RTC_LOG(LS_WARNING) << "Call shards " << num << (env ? " from OWT_CALL_SHARDS" : "")
+                            << " clamped to " << kMaxCallShards;
+        num = kMaxCallShards;
+    }
+    return num;
+}
+
+static std::vector<std::shared_ptr<CallShard>>& callShards()
+{
+    static std::vector<std::shared_ptr<CallShard>> shards = []()
+    {
+        std::vector<std::shared_ptr<CallShard>> shards;
+        uint32_t num = callShardNum();
+
+        RTC_LOG(LS_INFO) << "Call shards: " << num;
+        for (uint32_t i = 0; i < num; i++) {
+            auto shard = std::make_shared<CallShard>();
+            shard->id = i;
+            shard->taskQueueFactory = createStaticTaskQueueFactory(num > 1 ? "-" + std::to_string(i) : "");
+            shard->taskQueue = std::make_shared<rtc::TaskQueue>(shard->taskQueueFactory->CreateTaskQueue(
+                "CallTaskQueue",
+                webrtc::TaskQueueFactory::Priority::NORMAL));
+            shard->taskQueue->PostTask([shard]() {
+                probeCallShard(shard, rtc::TimeMillis());
+            });
+            shards.push_back(shard);
+        }
+        return shards;
+    }();
+    return shards;
+}
+
+static std::shared_ptr<CallShard> acquireCallShard()
+{
+    static std::mutex shardMutex;
+    std::lock_guard<std::mutex> guard(shardMutex);
+
+    std::shared_ptr<CallShard> shard;
+    for (auto& candidate : callShards()) {
+        if (!shard || candidate->adapters < shard->adapters)
+            shard = candidate;
+    }
+    shard->adapters++;
+    return shard;
+}
+
 class RtcAdapterImpl : public RtcAdapter,
                        public CallOwner,
                        public webrtc::TargetTransferRateObserver,
@@ -74,9 +164,9 @@ public:
     }
     std::shared_ptr<webrtc::TaskQueueFactory> taskQueueFactory() override
     {
-        return g_taskQueueFactory;
+        return m_shard->taskQueueFactory;
     }
-    std::shared_ptr<rtc::TaskQueue> taskQueue() override { return g_taskQueue; }
+    std::shared_ptr<rtc::TaskQueue> taskQueue() override { return m_shard->taskQueue; }
     std::shared_ptr<webrtc::RtcEventLog> eventLog() override { return g_eventLog; }
     webrtc::WebRtcKeyValueConfig* trial() override { return g_fieldTrial.get(); }
     ControllerSendPtr rtpTransportController() override
@@ -99,6 +189,7 @@ private:
     void initCall();
     void initRtpTransportController();
 
+    std::shared_ptr<CallShard> m_shard;
     std::shared_ptr<CallPtr> m_callPtr;
 
     // For sender
@@ -111,6 +202,7 @@ private:
 };
 
 RtcAdapterImpl::RtcAdapterImpl()
+    : m_shard(acquireCallShard())
 {
 }
 
@@ -119,12 +211,13 @@ RtcAdapterImpl::~RtcAdapterImpl()
     if (m_callPtr) {
         std::shared_ptr<CallPtr> pCallPtr = m_callPtr;
         m_callPtr.reset();
-        g_taskQueue->PostTask([pCallPtr]() {
+        m_shard->taskQueue->PostTask([pCallPtr]() {
             if (*pCallPtr) {
                 (*pCallPtr).reset();
             }
         });
     }
+    m_shard->adapters--;
 }
 
 void RtcAdapterImpl::initCall()
@@ -134,15 +227,16 @@ void RtcAdapterImpl::initCall()
     }
     m_callPtr.reset(new CallPtr());
     std::shared_ptr<CallPtr> pCallPtr = m_callPtr;
-    g_taskQueue->PostTask([pCallPtr]() {
+    std::shared_ptr<CallShard> shard = m_shard;
+    shard->taskQueue->PostTask([pCallPtr, shard]() {
         // Initialize call
         if (!(*pCallPtr)) {
             webrtc::Call::Config call_config(g_eventLog.get());
-            call_config.task_queue_factory = g_taskQueueFactory.get();
+            call_config.task_queue_factory = shard->taskQueueFactory.get();
             call_config.trials = g_fieldTrial.get();
 
-            if (!g_moduleThread) {
-                g_moduleThread = webrtc::SharedModuleThread::Create(
+            if (!shard->moduleThread) {
+                shard->moduleThread = webrtc::SharedModuleThread::Create(
                     webrtc::ProcessThread::Create("ModuleProcessThread"), nullptr);
             }
 
@@ -152,7 +246,7 @@ void RtcAdapterImpl::initCall()
 
             (*pCallPtr).reset(webrtc::Call::Create(
                 call_config, webrtc::Clock::GetRealTimeClock(),
-                g_moduleThread,
+                shard->moduleThread,
                 std::move(pacerThreadProxy)));
         }
     });
@@ -173,7 +267,7 @@ void RtcAdapterImpl::initRtpTransportController()
             webrtc::Clock::GetRealTimeClock(), g_eventLog.get(),
             nullptr/*network_state_predicator_factory*/,
             nullptr/*network_controller_factory*/, bitrateConstraints,
-            std::move(pacerThreadProxy)/*pacer_thread*/, g_taskQueueFactory.get(), g_fieldTrial.get());
+            std::move(pacerThreadProxy)/*pacer_thread*/, m_shard->taskQueueFactory.get(), g_fieldTrial.get());
         m_transportControllerSend->RegisterTargetTransferRateObserver(this);
     }
 }
@@ -294,6 +388,179 @@ void RtcAdapterImpl::destoryAudioSender(AudioSendAdapter* audio_send_adapter)
     delete impl;
 }
 
+// Spreads standalone streams over a few RtcAdapterImpl, so receivers
+// share one Call instead of creating a Call each.
+// Streams with transport wide state (transport-cc feedback, bandwidth
+// estimation) still get an adapter of their own.
+class PooledRtcAdapter : public RtcAdapter {
+public:
+    // Implement RtcAdapter
+    VideoReceiveAdapter* createVideoReceiver(const Config& config) override
+    {
+        return createStream<VideoReceiveAdapter>(config.transport_cc > 0, config.ssrc,
+            [&config](RtcAdapterImpl* adapter) { return adapter->createVideoReceiver(config); });
+    }
+    void destoryVideoReceiver(VideoReceiveAdapter* stream) override
+    {
+        destroyStream(stream,
+            [stream](RtcAdapterImpl* adapter) { adapter->destoryVideoReceiver(stream); });
+    }
+    VideoSendAdapter* createVideoSender(const Config& config) override
+    {
+        return createStream<VideoSendAdapter>(config.bandwidth_estimation, 0,
+            [&config](RtcAdapterImpl* adapter) { return adapter->createVideoSender(config); });
+    }
+    void destoryVideoSender(VideoSendAdapter* stream) override
+    {
+        destroyStream(stream,
+            [stream](RtcAdapterImpl* adapter) { adapter->destoryVideoSender(stream); });
+    }
+    AudioReceiveAdapter* createAudioReceiver(const Config& config) override
+    {
+        return nullptr;
+    }
+    void destoryAudioReceiver(AudioReceiveAdapter* stream) override {}
+    AudioSendAdapter* createAudioSender(const Config& config) override
+    {
+        return createStream<AudioSendAdapter>(false, 0,
+            [&config](RtcAdapterImpl* adapter) { return adapter->createAudioSender(config); });
+    }
+    void destoryAudioSender(AudioSendAdapter* stream) override
+    {
+        destroyStream(stream,
+            [stream](RtcAdapterImpl* adapter) { adapter->destoryAudioSender(stream); });
+    }
+
+private:
+    struct Backing {
+        // Serializes streams created on or destroyed from the adapter
+        std::mutex mutex;
+        std::unique_ptr<RtcAdapterImpl> adapter;
+        bool exclusive = false;
+        // Reserved slots, including streams still being created
+        uint32_t streams = 0;
+        // Remote SSRCs received on this call, must not collide
+        std::set<uint32_t> receiveSsrcs;
+    };
+
+    struct StreamEntry {
+        std::shared_ptr<Backing> backing;
+        uint32_t receiveSsrc;
+    };
+
+    // Only the slot bookkeeping runs under m_mutex, the Call and its
+    // streams are set up and torn down outside it
+    template <typename Stream, typename Create>
+    Stream* createStream(bool exclusive, uint32_t receiveSsrc, Create create)
+    {
+        std::shared_ptr<Backing> backing;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            backing = exclusive ? addBacking(true) : acquireBacking(receiveSsrc);
+            reserveSlot(backing, receiveSsrc);
+        }
+
+        Stream* stream = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(backing->mutex);
+            stream = create(backing->adapter.get());
+        }
+
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (stream) {
+            m_streams[stream] = {backing, receiveSsrc};
+        } else {
+            releaseSlot(backing, receiveSsrc);
+        }
+        return stream;
+    }
+
+    // A released SSRC is never reused on a call before its old stream is
+    // gone, the slot is given back only after destroy
+    template <typename Destroy>
+    void destroyStream(void* stream, Destroy destroy)
+    {
+        StreamEntry entry;
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            auto it = m_streams.find(stream);
+            if (it == m_streams.end()) {
+                return;
+            }
+            entry = it->second;
+            m_streams.erase(it);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(entry.backing->mutex);
+            destroy(entry.backing->adapter.get());
+        }
+
+        // A dropped backing is freed with entry, after the guard is released
+        std::lock_guard<std::mutex> guard(m_mutex);
+        releaseSlot(entry.backing, entry.receiveSsrc);
+    }
+
+    std::shared_ptr<Backing> addBacking(bool exclusive)
+    {
+        std::shared_ptr<Backing> backing = std::make_shared<Backing>();
+        backing->adapter.reset(new RtcAdapterImpl());
+        backing->exclusive = exclusive;
+        m_backings.push_back(backing);
+        RTC_LOG(LS_INFO) << "Add pooled call, exclusive: " << exclusive
+                         << ", calls: " << m_backings.size();
+        return backing;
+    }
+
+    // First fit, keeps the number of calls low
+    std::shared_ptr<Backing> acquireBacking(uint32_t receiveSsrc)
+    {
+        for (auto& backing : m_backings) {
+            if (backing->exclusive || backing->streams >= kMaxStreamsPerCall) {
+                continue;
+            }
+            if (receiveSsrc && backing->receiveSsrcs.count(receiveSsrc) > 0) {
+                continue;
+            }
+            return backing;
+        }
+        return addBacking(false);
+    }
+
+    void reserveSlot(std::shared_ptr<Backing> backing, uint32_t receiveSsrc)
+    {
+        backing->streams++;
+        if (receiveSsrc) {
+            backing->receiveSsrcs.insert(receiveSsrc);
+        }
+    }
+
+    void releaseSlot(std::shared_ptr<Backing> backing, uint32_t receiveSsrc)
+    {
+        if (receiveSsrc) {
+            backing->receiveSsrcs.erase(receiveSsrc);
+        }
+
+        // Keep one idle shared call around to absorb stream churn
+        if (--backing->streams == 0) {
+            bool keep = !backing->exclusive;
+            for (auto& other : m_backings) {
+                if (other != backing && !other->exclusive && other->streams < kMaxStreamsPerCall) {
+                    keep = false;
+                    break;
+                }
+            }
+            if (!keep) {
+                m_backings.remove(backing);
+            }
+        }
+    }
+
+    std::mutex m_mutex;
+    std::list<std::shared_ptr<Backing>> m_backings;
+    std::map<void*, StreamEntry> m_streams;
+};
+
 RtcAdapter* RtcAdapterFactory::CreateRtcAdapter()
 {
     return new RtcAdapterImpl();
@@ -301,4 +568,28 @@ RtcAdapter* RtcAdapterFactory::CreateRtcAdapter()
 
 void RtcAdapterFactory::DestroyRtcAdapter(RtcAdapter* adapter) {}
 
+std::shared_ptr<RtcAdapter> RtcAdapterFactory::GetSharedRtcAdapter()
+{
+    static std::shared_ptr<RtcAdapter> sharedAdapter = std::make_shared<PooledRtcAdapter>();
+    return sharedAdapter;
+}
+
+std::vector<CallShardStats> RtcAdapterFactory::GetCallShardStats()
+{
+    std::vector<CallShardStats> stats;
+    for (auto& shard : callShards()) {
+        CallShardStats shardStats;
+        shardStats.adapters = shard->adapters;
+        shardStats.queueDelayMs = shard->queueDelayMs;
+        shardStats.maxQueueDelayMs = shard->maxQueueDelayMs.exchange(0);
+        stats.push_back(shardStats);
+    }
+    return stats;
+}
+
+std::vector<long> RtcAdapterFactory::GetTaskRunnerUsers()
+{
+    return owt_base::TaskRunnerPool::GetInstance().GetTaskRunnerUsers();
+}
+
 } // namespace rtc_adapter
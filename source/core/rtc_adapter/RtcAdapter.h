@@ -7,6 +7,9 @@
 
 #include <MediaFramePipeline.h>
 
+#include <memory>
+#include <vector>
+
 namespace rtc_adapter {
 
 class AdapterDataListener {
@@ -14,9 +17,20 @@ public:
     virtual void onAdapterData(char* data, int len) = 0;
 };
 
+// Received frame payload, retained without copying. Consumers that
+// need the data beyond the buffer's lifetime take an owned copy.
+class AdapterFrameBuffer {
+public:
+    virtual ~AdapterFrameBuffer() {}
+    virtual const uint8_t* data() const = 0;
+    virtual size_t size() const = 0;
+};
+
 class AdapterFrameListener {
 public:
-    virtual void onAdapterFrame(const owt_base::Frame& frame) = 0;
+    // frame.payload points into buffer, which may be kept after return
+    virtual void onAdapterFrame(const owt_base::Frame& frame,
+                                std::shared_ptr<AdapterFrameBuffer> buffer) = 0;
 };
 
 class AdapterFeedbackListener {
@@ -28,11 +42,23 @@ struct AdapterStats {
     int width = 0;
     int height = 0;
     owt_base::FrameFormat format = owt_base::FRAME_FORMAT_UNKNOWN;
+    // Filled in periodic stats only
+    uint32_t bitrateBps = 0;
+    uint32_t frameRate = 0;
+    uint32_t packetsReceived = 0;
+    uint32_t packetsLost = 0;
+    uint32_t fractionLost = 0;
+    uint32_t jitterMs = 0;
+    uint32_t rttMs = 0;
+    uint32_t keyFrameRequests = 0;
 };
 
 class AdapterStatsListener {
 public:
+    // Called on format or resolution change
     virtual void onAdapterStats(const AdapterStats& stat) = 0;
+    // Called about every second from the call task queue
+    virtual void onAdapterPeriodicStats(const AdapterStats& stat) {}
 };
 
 class VideoReceiveAdapter {
@@ -48,6 +74,8 @@ public:
         uint32_t total_bitrate_bps = 0;
         uint32_t retransmit_bitrate_bps = 0;
         uint32_t estimated_bandwidth = 0;
+        uint32_t pacing_queue_delay_ms = 0;
+        uint32_t pacing_dropped_packets = 0;
     };
     virtual void onFrame(const owt_base::Frame&) = 0;
     virtual int onRtcpData(const char* data, int len) = 0;
@@ -83,6 +111,8 @@ public:
         int mid_ext = 0;
         // Bandwidth estimation
         bool bandwidth_estimation = false;
+        // Burst allowance of the pacer used without bandwidth estimation, 0 disables pacing
+        int pacing_burst_ms = 20;
         AdapterDataListener* rtp_listener = nullptr;
         AdapterStatsListener* stats_listener = nullptr;
         AdapterFrameListener* frame_listener = nullptr;
@@ -100,11 +130,32 @@ public:
     virtual ~RtcAdapter(){}
 };
 
+struct CallShardStats {
+    // RtcAdapters assigned to the shard
+    uint32_t adapters = 0;
+    // Lateness of the last periodic probe task
+    uint32_t queueDelayMs = 0;
+    // Since last query
+    uint32_t maxQueueDelayMs = 0;
+};
+
 class RtcAdapterFactory {
 public:
+    // Each adapter is placed on the least loaded call shard, a shard
+    // has its own call task queue, shard number is taken from
+    // OWT_CALL_SHARDS or half of the cores
     static RtcAdapter* CreateRtcAdapter();
     // Use delete instead of this function
     static void DestroyRtcAdapter(RtcAdapter*);
+
+    // Agent wide adapter for standalone streams, receivers share a
+    // Call up to a bounded number of streams, streams using transport-cc
+    // or bandwidth estimation are kept on a Call of their own
+    static std::shared_ptr<RtcAdapter> GetSharedRtcAdapter();
+
+    static std::vector<CallShardStats> GetCallShardStats();
+    // Users of each pooled TaskRunner the send adapters run on
+    static std::vector<long> GetTaskRunnerUsers();
 };
 
 } // namespace rtc_adapter
@@ -4,7 +4,10 @@
 
 #include "VideoReceiveAdapter.h"
 
+#include <algorithm>
 #include <future>
+#include <vector>
+#include <modules/rtp_rtcp/source/video_rtp_depacketizer_vp8.h>
 #include <modules/rtp_rtcp/source/video_rtp_depacketizer_vp9.h>
 #include <modules/video_coding/include/video_error_codes.h>
 #include <modules/video_coding/timing.h>
@@ -16,13 +19,46 @@ using namespace owt_base;
 
 namespace rtc_adapter {
 
-const uint32_t kBufferSize = 8192;
 // Local SSRC has no meaning for receive stream here
 const uint32_t kLocalSsrc = 1;
 
+const int64_t kPeriodicStatsIntervalMs = 1000;
+
 const uint32_t kMaxSpatialLayers = 5;
 const uint32_t kMaxTemporalLayers = 4;
 
+// Holds the encoded image's buffer, received frames are not copied
+class EncodedImageFrameBuffer : public AdapterFrameBuffer {
+public:
+    EncodedImageFrameBuffer(rtc::scoped_refptr<webrtc::EncodedImageBufferInterface> buffer, size_t size)
+        : m_buffer(buffer)
+        , m_size(size)
+    {
+    }
+
+    const uint8_t* data() const override { return m_buffer->data(); }
+    size_t size() const override { return m_size; }
+
+private:
+    rtc::scoped_refptr<webrtc::EncodedImageBufferInterface> m_buffer;
+    size_t m_size;
+};
+
+// For images not backed by a refcounted buffer
+class OwnedFrameBuffer : public AdapterFrameBuffer {
+public:
+    OwnedFrameBuffer(const uint8_t* data, size_t size)
+        : m_data(data, data + size)
+    {
+    }
+
+    const uint8_t* data() const override { return m_data.data(); }
+    size_t size() const override { return m_data.size(); }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
 static void dump(void* index, FrameFormat format, uint8_t* buf, int len)
 {
     char dumpFileName[128];
@@ -42,10 +78,6 @@ int32_t VideoReceiveAdapterImpl::AdapterDecoder::InitDecode(const webrtc::VideoC
     if (config) {
         m_codec = config->codecType;
     }
-    if (!m_frameBuffer) {
-        m_bufferSize = kBufferSize;
-        m_frameBuffer.reset(new uint8_t[m_bufferSize]);
-    }
     return 0;
 }
 
@@ -77,23 +109,24 @@ int32_t VideoReceiveAdapterImpl::AdapterDecoder::Decode(const webrtc::EncodedIma
         return 0;
     }
 
-    if (encodedImage.size() > m_bufferSize) {
-        m_bufferSize = encodedImage.size() * 2;
-        m_frameBuffer.reset(new uint8_t[m_bufferSize]);
-        RTC_DLOG(LS_INFO) << "AdapterDecoder increase buffer size: " << m_bufferSize;
-    }
-
     if (encodedImage._encodedWidth > 0 && encodedImage._encodedHeight > 0) {
         m_width = encodedImage._encodedWidth;
         m_height = encodedImage._encodedHeight;
     }
 
-    memcpy(m_frameBuffer.get(), encodedImage.data(), encodedImage.size());
+    std::shared_ptr<AdapterFrameBuffer> buffer;
+    rtc::scoped_refptr<webrtc::EncodedImageBufferInterface> encodedData = encodedImage.GetEncodedData();
+    if (encodedData && encodedData->data() == encodedImage.data()) {
+        buffer = std::make_shared<EncodedImageFrameBuffer>(encodedData, encodedImage.size());
+    } else {
+        buffer = std::make_shared<OwnedFrameBuffer>(encodedImage.data(), encodedImage.size());
+    }
+
     Frame frame;
     memset(&frame, 0, sizeof(frame));
     frame.format = format;
-    frame.payload = m_frameBuffer.get();
-    frame.length = encodedImage.size();
+    frame.payload = const_cast<uint8_t*>(buffer->data());
+    frame.length = buffer->size();
     frame.timeStamp = encodedImage.Timestamp();
     frame.additionalInfo.video.width = m_width;
     frame.additionalInfo.video.height = m_height;
@@ -101,8 +134,11 @@ int32_t VideoReceiveAdapterImpl::AdapterDecoder::Decode(const webrtc::EncodedIma
         (encodedImage._frameType == webrtc::VideoFrameType::kVideoFrameKey);
 
     if (m_parent) {
+        if (format == FRAME_FORMAT_VP8 || format == FRAME_FORMAT_VP9) {
+            m_parent->lookupTemporalLayer(frame.timeStamp, frame);
+        }
         if (m_parent->m_frameListener) {
-            m_parent->m_frameListener->onAdapterFrame(frame);
+            m_parent->m_frameListener->onAdapterFrame(frame, buffer);
         }
         // Check video update
         if (m_parent->m_statsListener) {
@@ -168,6 +204,7 @@ VideoReceiveAdapterImpl::~VideoReceiveAdapterImpl()
             call()->DestroyVideoReceiveStream(m_videoRecvStream);
             m_videoRecvStream = nullptr;
         }
+        m_statsToken.reset();
         p.set_value(0);
     });
     f.wait();
@@ -249,10 +286,59 @@ void VideoReceiveAdapterImpl::CreateReceiveVideo()
             m_videoRecvStream = call()->CreateVideoReceiveStream(std::move(video_recv_config));
             m_videoRecvStream->Start();
             call()->SignalChannelNetworkState(webrtc::MediaType::VIDEO, webrtc::NetworkState::kNetworkUp);
+            if (m_statsListener) {
+                schedulePeriodicStats();
+            }
         }
     });
 }
 
+void VideoReceiveAdapterImpl::collectPeriodicStats()
+{
+    if (!m_videoRecvStream) {
+        return;
+    }
+
+    webrtc::VideoReceiveStream::Stats recvStats = m_videoRecvStream->GetStats();
+    webrtc::Call::Stats callStats = call()->GetStats();
+
+    AdapterStats stats;
+    stats.width = recvStats.width;
+    stats.height = recvStats.height;
+    stats.format = m_format;
+    stats.bitrateBps = recvStats.total_bitrate_bps;
+    stats.frameRate = recvStats.network_frame_rate;
+    stats.packetsReceived = recvStats.rtp_stats.packet_counter.packets;
+    stats.packetsLost = std::max(recvStats.rtp_stats.packets_lost, 0);
+    // Jitter in RTP timestamp units of 90kHz clock
+    stats.jitterMs = recvStats.rtp_stats.jitter / 90;
+    stats.rttMs = callStats.rtt_ms > 0 ? callStats.rtt_ms : 0;
+    stats.keyFrameRequests = recvStats.rtcp_packet_type_counts.pli_packets +
+        recvStats.rtcp_packet_type_counts.fir_packets;
+
+    uint32_t received = stats.packetsReceived - m_lastPacketsReceived;
+    int32_t lost = recvStats.rtp_stats.packets_lost - m_lastPacketsLost;
+    if (lost > 0 && received + lost > 0) {
+        stats.fractionLost = (lost << 8) / (received + lost);
+    }
+    m_lastPacketsReceived = stats.packetsReceived;
+    m_lastPacketsLost = recvStats.rtp_stats.packets_lost;
+
+    m_statsListener->onAdapterPeriodicStats(stats);
+    schedulePeriodicStats();
+}
+
+void VideoReceiveAdapterImpl::schedulePeriodicStats()
+{
+    std::weak_ptr<int> token = m_statsToken;
+    taskQueue()->PostDelayedTask([this, token]() {
+        // Adapter is gone if token expired
+        if (token.lock()) {
+            collectPeriodicStats();
+        }
+    }, kPeriodicStatsIntervalMs);
+}
+
 void VideoReceiveAdapterImpl::requestKeyFrame()
 {
     // m_videoRecvStream->GenerateKeyFrame();
@@ -287,21 +373,69 @@ std::unique_ptr<webrtc::VideoDecoder> VideoReceiveAdapterImpl::CreateVideoDecode
     return std::make_unique<AdapterDecoder>(this);
 }
 
+void VideoReceiveAdapterImpl::recordTemporalLayer(uint32_t timestamp, uint8_t temporalId, bool layerSync)
+{
+    std::lock_guard<std::mutex> lock(m_temporalLayerMutex);
+    if (m_temporalLayerInfoCount > 0) {
+        const TemporalLayerInfo& last =
+            m_temporalLayerInfo[(m_temporalLayerInfoCount - 1) % kTemporalLayerInfoSize];
+        if (last.timestamp == timestamp) {
+            return;
+        }
+    }
+    m_temporalLayerInfo[m_temporalLayerInfoCount % kTemporalLayerInfoSize] =
+        {timestamp, temporalId, layerSync};
+    m_temporalLayerInfoCount++;
+}
+
+void VideoReceiveAdapterImpl::lookupTemporalLayer(uint32_t timestamp, owt_base::Frame& frame)
+{
+    std::lock_guard<std::mutex> lock(m_temporalLayerMutex);
+    size_t count = std::min(m_temporalLayerInfoCount, kTemporalLayerInfoSize);
+    for (size_t i = 1; i <= count; i++) {
+        const TemporalLayerInfo& info =
+            m_temporalLayerInfo[(m_temporalLayerInfoCount - i) % kTemporalLayerInfoSize];
+        if (info.timestamp == timestamp) {
+            frame.additionalInfo.video.temporalId = info.temporalId;
+            frame.additionalInfo.video.layerSync = info.layerSync;
+            return;
+        }
+    }
+}
+
 int VideoReceiveAdapterImpl::onRtpData(char* data, int len)
 {
     rtc::CopyOnWriteBuffer buffer(data, len);
-    if (m_format == FRAME_FORMAT_VP9 &&
-        (m_preferredTemporalId >= 0 || m_preferredSpatialId >= 0)) {
+    uint8_t payloadType = (len > 1) ? (data[1] & 0x7f) : 0;
+    if (payloadType == VP8_90000_PT) {
+        webrtc::RtpPacket rtpPacket;
+        webrtc::RTPVideoHeader video_header;
+        if (rtpPacket.Parse((const uint8_t*) data, len) &&
+            webrtc::VideoRtpDepacketizerVp8::ParseRtpPayload(
+            rtpPacket.PayloadBuffer(), &video_header) > 0) {
+            webrtc::RTPVideoHeaderVP8* vp8_header =
+                absl::get_if<webrtc::RTPVideoHeaderVP8>(
+                    &(video_header.video_type_header));
+            if (vp8_header && vp8_header->temporalIdx <= kMaxTemporalLayers) {
+                recordTemporalLayer(rtpPacket.Timestamp(),
+                    vp8_header->temporalIdx, vp8_header->layerSync);
+            }
+        }
+    } else if (payloadType == VP9_90000_PT) {
         webrtc::RtpPacket rtpPacket;
         webrtc::RTPVideoHeader video_header;
         if (rtpPacket.Parse((const uint8_t*) data, len)) {
-            if (rtpPacket.PayloadType() == VP9_90000_PT &&
-                webrtc::VideoRtpDepacketizerVp9::ParseRtpPayload(
+            if (webrtc::VideoRtpDepacketizerVp9::ParseRtpPayload(
                 rtpPacket.PayloadBuffer(), &video_header) > 0) {
                 webrtc::RTPVideoHeaderVP9* vp9_header =
                     absl::get_if<webrtc::RTPVideoHeaderVP9>(
                         &(video_header.video_type_header));
-                if (vp9_header) {
+                if (vp9_header && vp9_header->temporal_idx <= kMaxTemporalLayers) {
+                    recordTemporalLayer(rtpPacket.Timestamp(),
+                        vp9_header->temporal_idx, vp9_header->temporal_up_switch);
+                }
+                if (vp9_header &&
+                    (m_preferredTemporalId >= 0 || m_preferredSpatialId >= 0)) {
                     if ((m_preferredSpatialId >= 0 &&
                         vp9_header->spatial_idx <= kMaxSpatialLayers &&
                         vp9_header->spatial_idx > m_preferredSpatialId) ||
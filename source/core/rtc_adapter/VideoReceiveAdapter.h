@@ -14,6 +14,10 @@
 #include <call/call.h>
 #include <rtc_base/task_queue.h>
 
+#include <array>
+#include <memory>
+#include <mutex>
+
 namespace rtc_adapter {
 
 class VideoReceiveAdapterImpl : public VideoReceiveAdapter,
@@ -66,11 +70,13 @@ private:
         webrtc::VideoCodecType m_codec;
         uint16_t m_width;
         uint16_t m_height;
-        std::unique_ptr<uint8_t[]> m_frameBuffer;
-        uint32_t m_bufferSize;
     };
 
     void CreateReceiveVideo();
+    void collectPeriodicStats();
+    void schedulePeriodicStats();
+    void recordTemporalLayer(uint32_t timestamp, uint8_t temporalId, bool layerSync);
+    void lookupTemporalLayer(uint32_t timestamp, owt_base::Frame& frame);
 
     std::shared_ptr<webrtc::Call> call()
     {
@@ -96,8 +102,25 @@ private:
     CallOwner* m_owner;
 
     webrtc::VideoReceiveStream* m_videoRecvStream = nullptr;
+    // Counters of the last periodic stats, accessed on task queue
+    uint32_t m_lastPacketsReceived = 0;
+    int32_t m_lastPacketsLost = 0;
+    // Reset on task queue at destruction, pending stats tasks check it
+    std::shared_ptr<int> m_statsToken = std::make_shared<int>(0);
     int m_preferredSpatialId = -1;
     int m_preferredTemporalId = -1;
+
+    // Temporal layer of recent frames from payload descriptors,
+    // recorded on packet arrival and looked up by decoder
+    struct TemporalLayerInfo {
+        uint32_t timestamp;
+        uint8_t temporalId;
+        bool layerSync;
+    };
+    static const size_t kTemporalLayerInfoSize = 32;
+    std::array<TemporalLayerInfo, kTemporalLayerInfoSize> m_temporalLayerInfo {};
+    size_t m_temporalLayerInfoCount = 0;
+    std::mutex m_temporalLayerMutex;
 };
 
 } // namespace rtc_adapter
@@ -4,6 +4,7 @@
 
 #include "VideoSendAdapter.h"
 #include "MediaUtilities.h"
+#include "NalScanner.h"
 #include "TaskRunnerPool.h"
 
 #include <api/rtc_event_log/rtc_event_log.h>
@@ -26,101 +27,48 @@ static const int TRANSMISSION_MAXBITRATE_MULTIPLIER = 2;
 static const int kMaxRtpPacketSize = 1200;
 static const double kBitrateNotifyDiffer = 0.2;
 
-static int getNextNaluPosition(uint8_t* buffer, int buffer_size, bool& is_aud_or_sei, int& sc_len)
+static inline bool isAUDorSEI(uint8_t type)
 {
-    if (buffer_size < 3) {
-        return -1;
-    }
-    is_aud_or_sei = false;
-    uint8_t* head = buffer;
-    uint8_t* end = buffer + buffer_size - 3;
-    while (head < end) {
-        if (head[0]) {
-            head++;
-            continue;
-        }
-        if (head[1]) {
-            head += 2;
-            continue;
-        }
-        if (head[2]) {
-            if (head[2] == 0x01) {
-                if (((head[3] & 0x1F) == 9) || ((head[3] & 0x1F) == 6)) {
-                    is_aud_or_sei = true;
-                }
-                sc_len = 3;
-                return static_cast<int>(head - buffer);
-            }
-            head += 3;
-            continue;
-        }
-        if (head[3] != 0x01) {
-            head++;
-            continue;
-        }
-        if (head + 1 == end) {
-            break;
-        }
-        if (((head[4] & 0x1F) == 9) || ((head[4] & 0x1F) == 6)) {
-            is_aud_or_sei = true;
-        }
-        sc_len = 4;
-        return static_cast<int>(head - buffer);
-    }
-    return -1;
+    return type == 9 || type == 6;
 }
 
-#define MAX_NALS_PER_FRAME 128
-static int dropAUDandSEI(uint8_t* framePayload, int frameLength)
+// Returns the frame without AUD and SEI NALs. Leading ones are skipped
+// in place, otherwise the kept NALs are gathered into scratch.
+static rtc::ArrayView<const uint8_t> dropAUDandSEI(const uint8_t* payload, size_t length, std::vector<uint8_t>& scratch)
 {
-    uint8_t* origin_pkt_data = framePayload;
-    int origin_pkt_length = frameLength;
-    uint8_t* head = origin_pkt_data;
-
-    std::vector<int> nal_offset;
-    std::vector<bool> nal_type_is_aud_or_sei;
-    std::vector<int> nal_size;
-    bool is_aud_or_sei = false, has_aud_or_sei = false;
-
-    int sc_positions_length = 0;
-    int sc_position = 0;
-    int sc_len = 4;
-    while (sc_positions_length < MAX_NALS_PER_FRAME) {
-        int nalu_position = getNextNaluPosition(origin_pkt_data + sc_position,
-            origin_pkt_length - sc_position, is_aud_or_sei, sc_len);
-        if (nalu_position < 0) {
+    NalSpan nals[NalScanner::MAX_NALS];
+    size_t count = NalScanner::scan(payload, length, false, nals, NalScanner::MAX_NALS);
+
+    size_t first = 0;
+    while (first < count && isAUDorSEI(nals[first].type)) {
+        first++;
+    }
+    if (first == count) {
+        return rtc::ArrayView<const uint8_t>(payload, length);
+    }
+
+    bool interleaved = false;
+    for (size_t i = first + 1; i < count; i++) {
+        if (isAUDorSEI(nals[i].type)) {
+            interleaved = true;
             break;
         }
-        sc_position += nalu_position;
-        nal_offset.push_back(sc_position); //include start code.
-        sc_position += sc_len;
-        sc_positions_length++;
-        if (is_aud_or_sei) {
-            has_aud_or_sei = true;
-            nal_type_is_aud_or_sei.push_back(true);
-        } else {
-            nal_type_is_aud_or_sei.push_back(false);
-        }
     }
-    if (sc_positions_length == 0 || !has_aud_or_sei)
-        return frameLength;
-    // Calculate size of each NALs
-    for (unsigned int count = 0; count < nal_offset.size(); count++) {
-        if (count + 1 == nal_offset.size()) {
-            nal_size.push_back(origin_pkt_length - nal_offset[count]);
-        } else {
-            nal_size.push_back(nal_offset[count + 1] - nal_offset[count]);
+    if (!interleaved) {
+        if (first == 0) {
+            return rtc::ArrayView<const uint8_t>(payload, length);
         }
+        return rtc::ArrayView<const uint8_t>(payload + nals[first].offset, length - nals[first].offset);
     }
-    // remove in place the AUD NALs
-    int new_size = 0;
-    for (unsigned int i = 0; i < nal_offset.size(); i++) {
-        if (!nal_type_is_aud_or_sei[i]) {
-            memmove(head + new_size, head + nal_offset[i], nal_size[i]);
-            new_size += nal_size[i];
+
+    scratch.clear();
+    for (size_t i = first; i < count; i++) {
+        if (!isAUDorSEI(nals[i].type)) {
+            const uint8_t* nal = payload + nals[i].offset;
+            scratch.insert(scratch.end(), nal, nal + nals[i].length);
         }
     }
-    return new_size;
+    return rtc::ArrayView<const uint8_t>(scratch.data(), scratch.size());
 }
 
 static void dump(void* index, FrameFormat format, uint8_t* buf, int len)
@@ -135,27 +83,6 @@ static void dump(void* index, FrameFormat format, uint8_t* buf, int len)
     }
 }
 
-// PacedSender without pacing
-class NonPacedSender : public webrtc::RtpPacketSender {
-public:
-    NonPacedSender(webrtc::PacketRouter* sender)
-    : m_packetRouter(sender) {}
-    virtual ~NonPacedSender() {}
-
-    // Implements webrtc::RtpPacketSender
-    virtual void EnqueuePackets(
-        std::vector<std::unique_ptr<webrtc::RtpPacketToSend>> packets) override
-    {
-        webrtc::PacedPacketInfo pacing_info;
-        for (auto& packet : packets) {
-            m_packetRouter->SendPacket(std::move(packet), pacing_info);
-            EnqueuePackets(m_packetRouter->FetchFec());
-        }
-    }
-private:
-    webrtc::PacketRouter* m_packetRouter;
-};
-
 VideoSendAdapterImpl::VideoSendAdapterImpl(
     CallOwner* owner,
     const RtcAdapter::Config& config,
@@ -193,6 +120,9 @@ VideoSendAdapterImpl::~VideoSendAdapterImpl()
             ->RemoveSendRtpModule(m_rtpRtcp.get());
         m_owner->deregisterVideoSender(m_ssrc);
     }
+    if (m_pacedSender) {
+        m_taskRunner->DeRegisterModule(m_pacedSender.get());
+    }
     m_taskRunner->DeRegisterModule(m_rtpRtcp.get());
     m_ssrcGenerator->ReturnSsrc(m_ssrc);
     boost::unique_lock<boost::shared_mutex> lock(m_rtpRtcpMutex);
@@ -232,12 +162,14 @@ bool VideoSendAdapterImpl::init()
         configuration.transport_feedback_callback =
           m_transportControllerSend->transport_feedback_observer();
 
-        // m_pacedSender = std::make_shared<NonPacedSender>(
-        //     m_transportControllerSend->packet_router());
-        // configuration.paced_sender = m_pacedSender.get();
         configuration.paced_sender = m_transportControllerSend->packet_sender();
-        configuration.send_bitrate_observer = this;
+    } else if (m_config.pacing_burst_ms > 0) {
+        PacedSender::Config pacingConfig;
+        pacingConfig.burstMs = m_config.pacing_burst_ms;
+        m_pacedSender = std::make_shared<PacedSender>(pacingConfig, m_clock, this);
+        configuration.paced_sender = m_pacedSender.get();
     }
+    configuration.send_bitrate_observer = this;
 
     m_rtpRtcp = webrtc::RtpRtcp::Create(configuration);
     m_rtpRtcp->SetSendingStatus(true);
@@ -276,6 +208,10 @@ bool VideoSendAdapterImpl::init()
 
     m_senderVideo = std::make_unique<webrtc::RTPSenderVideo>(video_config);
     m_taskRunner->RegisterModule(m_rtpRtcp.get());
+    if (m_pacedSender) {
+        m_pacedSender->setRtpRtcp(m_rtpRtcp.get());
+        m_taskRunner->RegisterModule(m_pacedSender.get());
+    }
 
     return true;
 }
@@ -357,24 +293,17 @@ void VideoSendAdapterImpl::onFrame(const Frame& frame)
             0);
 
     } else if (frame.format == FRAME_FORMAT_H264 || frame.format == FRAME_FORMAT_H265) {
-        int frame_length = frame.length;
+        rtc::ArrayView<const uint8_t> payload(frame.payload, frame.length);
         if (m_enableDump) {
-            dump(this, frame.format, frame.payload, frame_length);
+            dump(this, frame.format, frame.payload, frame.length);
         }
 
         //FIXME: temporarily filter out AUD because chrome M59 could NOT handle it correctly.
         //FIXME: temporarily filter out SEI because safari could NOT handle it correctly.
         if (frame.format == FRAME_FORMAT_H264) {
-            frame_length = dropAUDandSEI(frame.payload, frame_length);
+            payload = dropAUDandSEI(frame.payload, frame.length, m_filterBuffer);
         }
 
-        int nalu_found_length = 0;
-        uint8_t* buffer_start = frame.payload;
-        int buffer_length = frame_length;
-        int nalu_start_offset = 0;
-        int nalu_end_offset = 0;
-        int sc_len = 0;
-
         h.codec = (frame.format == FRAME_FORMAT_H264) ?
             webrtc::VideoCodecType::kVideoCodecH264 :
             webrtc::VideoCodecType::kVideoCodecH265;
@@ -387,7 +316,7 @@ void VideoSendAdapterImpl::onFrame(const Frame& frame)
                 webrtc::kVideoCodecH264,
                 timeStamp,
                 timeStamp,
-                rtc::ArrayView<const uint8_t>(frame.payload, frame.length),
+                payload,
                 h,
                 m_rtpRtcp->ExpectedRetransmissionTimeMs(),
                 0);
@@ -398,7 +327,7 @@ void VideoSendAdapterImpl::onFrame(const Frame& frame)
                 webrtc::kVideoCodecH265,
                 timeStamp,
                 timeStamp,
-                rtc::ArrayView<const uint8_t>(frame.payload, frame.length),
+                payload,
                 h,
                 m_rtpRtcp->ExpectedRetransmissionTimeMs(),
                 0);
@@ -478,8 +407,11 @@ void VideoSendAdapterImpl::Notify(uint32_t total_bitrate_bps,
                                   uint32_t ssrc)
 {
   if (m_ssrc == ssrc) {
-    RTC_LOG(LS_INFO) << "total_bitrate_bps:" << total_bitrate_bps
-                     << " retransmit_bitrate_bps:" << retransmit_bitrate_bps;
+    RTC_LOG(LS_VERBOSE) << "total_bitrate_bps:" << total_bitrate_bps
+                        << " retransmit_bitrate_bps:" << retransmit_bitrate_bps;
+    if (m_pacedSender) {
+        m_pacedSender->setTargetBitrate(total_bitrate_bps);
+    }
     double diff = std::abs(double(m_stats.total_bitrate_bps - total_bitrate_bps));
     if (m_stats.total_bitrate_bps > 0) {
         diff = diff / m_stats.total_bitrate_bps;
@@ -505,7 +437,20 @@ VideoSendAdapter::Stats VideoSendAdapterImpl::getStats()
     if (m_owner) {
         m_stats.estimated_bandwidth = m_owner->estimatedBandwidth(m_ssrc);
     }
+    if (m_pacedSender) {
+        m_stats.pacing_queue_delay_ms = m_pacedSender->queueDelayMs();
+        m_stats.pacing_dropped_packets = m_pacedSender->droppedPackets();
+    }
     return m_stats;
 }
 
+void VideoSendAdapterImpl::onPacingDrop(uint32_t packets)
+{
+    // Receiver can not recover the dropped frames by NACK
+    if (m_feedbackListener) {
+        FeedbackMsg feedback = {.type = VIDEO_FEEDBACK, .cmd = REQUEST_KEY_FRAME };
+        m_feedbackListener->onFeedback(feedback);
+    }
+}
+
 } // namespace rtc_adapter
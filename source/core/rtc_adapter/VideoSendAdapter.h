@@ -6,8 +6,11 @@
 #define RTC_ADAPTER_VIDEO_SEND_ADAPTER_
 
 #include <AdapterInternalDefinitions.h>
+#include <PacedSender.h>
 #include <RtcAdapter.h>
 
+#include <vector>
+
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp>
@@ -30,7 +33,8 @@ namespace rtc_adapter {
 class VideoSendAdapterImpl : public VideoSendAdapter,
                              public webrtc::Transport,
                              public webrtc::RtcpIntraFrameObserver,
-                             public webrtc::BitrateStatisticsObserver {
+                             public webrtc::BitrateStatisticsObserver,
+                             public PacedSender::Observer {
 public:
     class SendBitrateObserver {
     public:
@@ -67,6 +71,9 @@ public:
                 uint32_t retransmit_bitrate_bps,
                 uint32_t ssrc) override;
 
+    //Implements PacedSender::Observer
+    void onPacingDrop(uint32_t packets) override;
+
 private:
     bool init();
 
@@ -100,7 +107,10 @@ private:
     VideoSendAdapter::Stats m_stats;
     SendBitrateObserver* m_bitrateObserver;
 
-    std::shared_ptr<webrtc::RtpPacketSender> m_pacedSender;
+    // Only for senders without transport controller
+    std::shared_ptr<PacedSender> m_pacedSender;
+    // Reused for H.264 frames with interleaved AUD/SEI
+    std::vector<uint8_t> m_filterBuffer;
 
     // Listeners
     AdapterFeedbackListener* m_feedbackListener;
@@ -96,41 +96,40 @@ private:
     std::shared_ptr<int> m_sp;
 };
 
-// Provide static TaskQueues
+// Provide static TaskQueues, each factory owns its own set of threads
 class StaticTaskQueueFactory final : public webrtc::TaskQueueFactory {
  public:
+    StaticTaskQueueFactory(const std::string& suffix)
+    {
+        static std::unique_ptr<webrtc::TaskQueueFactory> defaultTaskQueueFactory =
+            webrtc::CreateDefaultTaskQueueFactory();
+        m_callTaskQueue = defaultTaskQueueFactory->CreateTaskQueue(
+            "CallTaskQueue" + suffix, webrtc::TaskQueueFactory::Priority::NORMAL);
+        m_decodingQueue = defaultTaskQueueFactory->CreateTaskQueue(
+            "DecodingQueue" + suffix, webrtc::TaskQueueFactory::Priority::HIGH);
+        m_rtpSendCtrlQueue = defaultTaskQueueFactory->CreateTaskQueue(
+            "rtp_send_controller" + suffix, webrtc::TaskQueueFactory::Priority::NORMAL);
+        m_tempQueue = defaultTaskQueueFactory->CreateTaskQueue(
+            "TaskQueuePacedSender" + suffix, webrtc::TaskQueueFactory::Priority::NORMAL);
+    }
+
     // Implements webrtc::TaskQueueFactory
     std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> CreateTaskQueue(
         absl::string_view name,
         webrtc::TaskQueueFactory::Priority priority) const override
     {
-        // Use a pool if following threads take too heavy load
-        static std::unique_ptr<webrtc::TaskQueueFactory> defaultTaskQueueFactory =
-            webrtc::CreateDefaultTaskQueueFactory();
-        static std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> callTaskQueue =
-            defaultTaskQueueFactory->CreateTaskQueue(
-                "CallTaskQueue", webrtc::TaskQueueFactory::Priority::NORMAL);
-        static std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> decodingQueue =
-            defaultTaskQueueFactory->CreateTaskQueue(
-                "DecodingQueue", webrtc::TaskQueueFactory::Priority::HIGH);
-        static std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> rtpSendCtrlQueue =
-            defaultTaskQueueFactory->CreateTaskQueue(
-                "rtp_send_controller", webrtc::TaskQueueFactory::Priority::NORMAL);
-        static std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> tempQueue =
-            defaultTaskQueueFactory->CreateTaskQueue(
-                "TaskQueuePacedSender", webrtc::TaskQueueFactory::Priority::NORMAL);
         if (name == absl::string_view("CallTaskQueue")) {
             return std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter>(
-                new TaskQueueProxy(callTaskQueue.get()));
+                new TaskQueueProxy(m_callTaskQueue.get()));
         } else if (name == absl::string_view("DecodingQueue")) {
             return std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter>(
-                new TaskQueueProxy(decodingQueue.get()));
+                new TaskQueueProxy(m_decodingQueue.get()));
         } else if (name == absl::string_view("rtp_send_controller")) {
             return std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter>(
-                new TaskQueueProxy(rtpSendCtrlQueue.get()));
+                new TaskQueueProxy(m_rtpSendCtrlQueue.get()));
         } else if (name == absl::string_view("TaskQueuePacedSender")) {
             return std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter>(
-                new TaskQueueProxy(tempQueue.get()));
+                new TaskQueueProxy(m_tempQueue.get()));
         } else {
             // Return dummy task queue for other names like "IncomingVideoStream"
             RTC_DLOG(LS_INFO) << "Dummy TaskQueue for " << name;
@@ -138,11 +137,17 @@ class StaticTaskQueueFactory final : public webrtc::TaskQueueFactory {
                 new TaskQueueDummy());
         }
     }
+
+private:
+    std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> m_callTaskQueue;
+    std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> m_decodingQueue;
+    std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> m_rtpSendCtrlQueue;
+    std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> m_tempQueue;
 };
 
-std::unique_ptr<webrtc::TaskQueueFactory> createStaticTaskQueueFactory()
+std::unique_ptr<webrtc::TaskQueueFactory> createStaticTaskQueueFactory(const std::string& suffix)
 {
-    return std::unique_ptr<webrtc::TaskQueueFactory>(new StaticTaskQueueFactory());
+    return std::unique_ptr<webrtc::TaskQueueFactory>(new StaticTaskQueueFactory(suffix));
 }
 
 } // namespace rtc_adapter
@@ -6,12 +6,14 @@
 #define RTC_ADAPTER_THREAD_STATIC_TASK_QUEUE_FACTORY_
 
 #include <memory>
+#include <string>
 
 #include "api/task_queue/task_queue_factory.h"
 
 namespace rtc_adapter {
 
-std::unique_ptr<webrtc::TaskQueueFactory> createStaticTaskQueueFactory();
+// Suffix is appended to thread names, to tell factories apart
+std::unique_ptr<webrtc::TaskQueueFactory> createStaticTaskQueueFactory(const std::string& suffix = "");
 
 }  // namespace webrtc
 